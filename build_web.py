@@ -0,0 +1,145 @@
+#!/usr/bin/env python3
+"""
+Builds the LittleFS image contents for the web UI from data/.
+
+Each page's scripts are bundled in load order into one file and the stylesheet is
+renamed after its content hash. Both go under /assets/, so the server can mark them
+immutable. Text files are stored gzip-compressed only. The server sends the .gz with
+Content-Encoding: gzip, and the pages are rewritten to point at the hashed names.
+asset-manifest.json records each page's ETag for the server.
+
+Runs automatically before 'pio run -t buildfs' / 'uploadfs' (see platformio.ini),
+or standalone:
+    python3 build_web.py [--source data] [--output .pio/webdata]
+"""
+
+import argparse
+import gzip
+import hashlib
+import json
+import os
+import re
+import shutil
+
+SOURCE_DIR = "data"
+OUTPUT_DIR = os.path.join(".pio", "webdata")
+ASSETS_DIR = "assets"
+MANIFEST_FILE = "asset-manifest.json"
+
+PAGE_EXTENSIONS = (".html",)
+COMPRESS_EXTENSIONS = (".html", ".js", ".css", ".json", ".svg", ".txt")
+
+SCRIPT_TAG = re.compile(r'^[ \t]*<script src="([^"/:]+\.js)"></script>[ \t]*\n', re.MULTILINE)
+STYLE_TAG = re.compile(r'<link rel="stylesheet" href="([^"/:]+\.css)">')
+
+
+def content_hash(data):
+    return hashlib.sha256(data).hexdigest()[:10]
+
+
+def write_output(output_dir, name, data, compress):
+    """Writes name (or name.gz) and returns the stored size."""
+    path = os.path.join(output_dir, name)
+    os.makedirs(os.path.dirname(path), exist_ok=True)
+    if compress:
+        # mtime=0 keeps the image byte-identical between builds of the same sources
+        data = gzip.compress(data, compresslevel=9, mtime=0)
+        path += ".gz"
+    with open(path, "wb") as f:
+        f.write(data)
+    return len(data)
+
+
+def read_source(source_dir, name):
+    with open(os.path.join(source_dir, name), "rb") as f:
+        return f.read()
+
+
+def build_page(source_dir, output_dir, page, hashed_styles, stats):
+    """Bundles a page's scripts and rewrites its asset references. Returns the files it used."""
+    html = read_source(source_dir, page).decode("utf-8")
+    used = set()
+
+    scripts = SCRIPT_TAG.findall(html)
+    if scripts:
+        # Files already share one global scope in load order, so concatenation is equivalent
+        bundle = b"".join(b"// " + s.encode() + b"\n" + read_source(source_dir, s) + b"\n;\n" for s in scripts)
+        bundle_name = "%s/%s.%s.js" % (ASSETS_DIR, os.path.splitext(page)[0], content_hash(bundle))
+        stats.append((bundle_name, len(bundle), write_output(output_dir, bundle_name, bundle, True)))
+        used.update(scripts)
+
+        # Replace the first tag with the bundle and drop the rest
+        first = [True]
+
+        def replace_script(match):
+            if first[0]:
+                first[0] = False
+                indent = re.match(r"[ \t]*", match.group(0)).group(0)
+                return '%s<script src="%s"></script>\n' % (indent, bundle_name)
+            return ""
+        html = SCRIPT_TAG.sub(replace_script, html)
+
+    def replace_style(match):
+        style = match.group(1)
+        if style not in hashed_styles:
+            data = read_source(source_dir, style)
+            name = "%s/%s.%s.css" % (ASSETS_DIR, os.path.splitext(style)[0], content_hash(data))
+            stats.append((name, len(data), write_output(output_dir, name, data, True)))
+            hashed_styles[style] = name
+        used.add(style)
+        return '<link rel="stylesheet" href="%s">' % hashed_styles[style]
+    html = STYLE_TAG.sub(replace_style, html)
+
+    data = html.encode("utf-8")
+    stats.append((page, len(data), write_output(output_dir, page, data, True)))
+    return used, '"%s"' % content_hash(data)
+
+
+def build(source_dir, output_dir):
+    if os.path.exists(output_dir):
+        shutil.rmtree(output_dir)
+    os.makedirs(output_dir)
+
+    stats = []
+    hashed_styles = {}
+    used = set()
+    etags = {}
+
+    files = sorted(f for f in os.listdir(source_dir) if os.path.isfile(os.path.join(source_dir, f)))
+    for page in (f for f in files if f.endswith(PAGE_EXTENSIONS)):
+        page_used, etag = build_page(source_dir, output_dir, page, hashed_styles, stats)
+        used |= page_used
+        etags["/" + page] = etag
+
+    # Everything no page bundled is stored under its own name, e.g. offline_config.json
+    for name in files:
+        if name in used or name.endswith(PAGE_EXTENSIONS):
+            continue
+        data = read_source(source_dir, name)
+        # The firmware opens config files by name, so only web text is compressed
+        compress = name.endswith(COMPRESS_EXTENSIONS) and not name.endswith(".json")
+        stats.append((name, len(data), write_output(output_dir, name, data, compress)))
+
+    with open(os.path.join(output_dir, MANIFEST_FILE), "w") as f:
+        json.dump({"pages": etags}, f, indent=2)
+
+    total_in = sum(s[1] for s in stats)
+    total_out = sum(s[2] for s in stats)
+    for name, size_in, size_out in stats:
+        print("[WEB] %-40s %7d -> %7d bytes" % (name, size_in, size_out))
+    print("[WEB] %d files, %d -> %d bytes into %s" % (len(stats), total_in, total_out, output_dir))
+
+
+try:
+    Import("env")
+    # Running as a PlatformIO pre-script: rebuild only for filesystem targets
+    if any(t in COMMAND_LINE_TARGETS for t in ("buildfs", "uploadfs", "uploadfsota")):
+        project_dir = env.subst("$PROJECT_DIR")
+        build(os.path.join(project_dir, SOURCE_DIR), env.subst("$PROJECT_DATA_DIR"))
+except NameError:
+    if __name__ == "__main__":
+        parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+        parser.add_argument("--source", default=SOURCE_DIR, help="web sources (default: data)")
+        parser.add_argument("--output", default=OUTPUT_DIR, help="filesystem image directory")
+        args = parser.parse_args()
+        build(args.source, args.output)
@@ -41,6 +41,60 @@ function loadConfiguration() {
     });
 }
 
+// Poll for configuration changes made by other clients, the console or scripts.
+// Only servos changed since our version come back, so an idle poll is a few dozen bytes.
+function startConfigSync() {
+    if (configSyncInterval) {
+        clearInterval(configSyncInterval);
+    }
+    
+    configSyncInterval = setInterval(() => {
+        if (configuration.version === undefined || document.hidden) {
+            return;
+        }
+        
+        fetch(`/api/config/changes?since=${configuration.version}&boot=${configuration.boot}`)
+        .then(response => response.json())
+        .then(data => {
+            if (!data.success) {
+                return;
+            }
+            
+            if (data.since === undefined) {
+                // Device rebooted or version went backwards - full document came back
+                configuration = data;
+                renderConfiguration();
+                return;
+            }
+            
+            let changed = false;
+            data.boards.forEach(board => {
+                const localBoard = configuration.boards.find(b => b.index === board.index);
+                if (!localBoard) {
+                    return;
+                }
+                board.servos.forEach(servo => {
+                    localBoard.servos[servo.index] = servo;
+                    changed = true;
+                });
+            });
+            if (data.scripts) {
+                configuration.scripts = data.scripts;
+            }
+            configuration.version = data.version;
+            
+            // Do not rebuild the form under the user's cursor
+            const container = document.getElementById('boardsContainer');
+            if (changed && !container.contains(document.activeElement)) {
+                renderConfiguration();
+            }
+        })
+        .catch(error => {
+            console.error('Config sync error:', error);
+        });
+    }, 2000);
+}
+
 function updateServoConfig(boardIndex, servoIndex, field, value) {
     const data = {
         board: boardIndex,
@@ -62,6 +116,10 @@ function updateServoConfig(boardIndex, servoIndex, field, value) {
     .then(data => {
         if (data.success) {
             showStatus(`Updated ${field} for Board ${boardIndex} Servo ${servoIndex}`);
+            // Our own edit is already applied locally, so skip it on the next sync
+            if (data.version === configuration.version + 1) {
+                configuration.version = data.version;
+            }
             // Update local configuration
             if (configuration.boards && configuration.boards[boardIndex] && 
                 configuration.boards[boardIndex].servos && configuration.boards[boardIndex].servos[servoIndex]) {
@@ -4,6 +4,7 @@
 let systemInfo = {};
 let configuration = {};
 let debugPollingInterval = null;
+let configSyncInterval = null;
 
 // Initialize the page when DOM is loaded
 document.addEventListener('DOMContentLoaded', function() {
@@ -185,7 +185,8 @@ class ServoConfigComponent {
         if (this.configuration.boards) {
             this.configuration.boards.forEach(board => {
                 const selected = board.index === selectedBoard ? 'selected' : '';
-                options += `<option value="${board.index}" ${selected}>Board ${board.index} (0x${board.address.toString(16).toUpperCase()})</option>`;
+                const mux = board.mux >= 0 ? `, mux ${board.mux}.${board.channel}` : '';
+                options += `<option value="${board.index}" ${selected}>Board ${board.index} (0x${board.address.toString(16).toUpperCase()}${mux})</option>`;
             });
         }
         return options;
@@ -1,7 +1,43 @@
 // Servo Testing Functions
 // Handles position testing, sliders, and test buttons
 
+// Slider moves go over a persistent WebSocket when it is open. Targets are coalesced
+// per animation frame on the client and per motion tick on the server, so only the
+// newest position for each servo is ever sent or applied.
+let controlSocket = null;
+let pendingTargets = new Map();
+let targetFlushScheduled = false;
+
+function connectControlSocket() {
+    controlSocket = new WebSocket(`ws://${location.host}/ws`);
+    controlSocket.onopen = () => addDebugMessage('Control WebSocket connected', 'success');
+    controlSocket.onclose = () => {
+        controlSocket = null;
+        setTimeout(connectControlSocket, 2000);
+    };
+}
+
+function flushPendingTargets() {
+    targetFlushScheduled = false;
+    if (!controlSocket || controlSocket.readyState !== WebSocket.OPEN || pendingTargets.size === 0) {
+        return;
+    }
+    const lines = [];
+    pendingTargets.forEach((position, key) => lines.push(`${key} ${position.toFixed(2)}`));
+    pendingTargets.clear();
+    controlSocket.send(lines.join('\n'));
+}
+
 function testServoPosition(boardIndex, servoIndex, position) {
+    if (controlSocket && controlSocket.readyState === WebSocket.OPEN) {
+        pendingTargets.set(`${boardIndex} ${servoIndex}`, position);
+        if (!targetFlushScheduled) {
+            targetFlushScheduled = true;
+            requestAnimationFrame(flushPendingTargets);
+        }
+        return;
+    }
+    
     const data = {
         board: boardIndex,
         servo: servoIndex,
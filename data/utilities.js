@@ -86,5 +86,7 @@ function initializePage() {
     loadSystemInfo();
     loadConfiguration();
     startDebugPolling();
+    startConfigSync();
     initializeCommandInterface();
+    connectControlSocket();
 }
\ No newline at end of file
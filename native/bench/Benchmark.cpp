@@ -0,0 +1,155 @@
+#include "Benchmark.h"
+#include <ArduinoJson.h>
+#include <chrono>
+
+// ---------------------------------------------------------------------------------------
+// Allocation counting
+// ---------------------------------------------------------------------------------------
+
+static uint64_t allocationCount = 0;
+static uint64_t allocationBytes = 0;
+
+#ifdef __GLIBC__
+// Interposing the malloc family also covers operator new, ArduinoJson's default
+// allocator and the JSON slab fallbacks, which all end up here
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* pointer, size_t size);
+void __libc_free(void* pointer);
+
+void* malloc(size_t size) {
+  allocationCount++;
+  allocationBytes += size;
+  return __libc_malloc(size);
+}
+
+void* calloc(size_t count, size_t size) {
+  allocationCount++;
+  allocationBytes += count * size;
+  return __libc_calloc(count, size);
+}
+
+void* realloc(void* pointer, size_t size) {
+  allocationCount++;
+  allocationBytes += size;
+  return __libc_realloc(pointer, size);
+}
+
+void free(void* pointer) {
+  __libc_free(pointer);
+}
+}
+#else
+#include <new>
+
+// Elsewhere only C++ allocations can be seen
+void* operator new(size_t size) {
+  allocationCount++;
+  allocationBytes += size;
+  if (void* pointer = malloc(size)) return pointer;
+  throw std::bad_alloc();
+}
+
+void operator delete(void* pointer) noexcept {
+  free(pointer);
+}
+
+void operator delete(void* pointer, size_t) noexcept {
+  free(pointer);
+}
+#endif
+
+AllocationCounts getAllocationCounts() {
+  return {allocationCount, allocationBytes};
+}
+
+// ---------------------------------------------------------------------------------------
+// BenchmarkRunner
+// ---------------------------------------------------------------------------------------
+
+void BenchmarkRunner::add(const String& name, std::function<void()> op, std::function<void()> before) {
+  cases.push_back({name, op, before});
+}
+
+double BenchmarkRunner::timeBatch(const Case& benchmark, uint64_t iterations) {
+  if (benchmark.before) benchmark.before();
+  
+  auto start = std::chrono::steady_clock::now();
+  for (uint64_t i = 0; i < iterations; i++) {
+    benchmark.op();
+  }
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  return std::chrono::duration<double, std::nano>(elapsed).count();
+}
+
+std::vector<BenchmarkResult> BenchmarkRunner::run(const BenchmarkOptions& options) {
+  std::vector<BenchmarkResult> results;
+  
+  for (const Case& benchmark : cases) {
+    if (options.filter.length() > 0 && benchmark.name.indexOf(options.filter) < 0) continue;
+    fprintf(stderr, "[BENCH] %s\n", benchmark.name.c_str());
+    
+    // Double the batch until it is measurable, then size it to the sample time
+    uint64_t iterations = 1;
+    double elapsed = timeBatch(benchmark, iterations);
+    while (elapsed < options.minSampleMicros * 100.0 && iterations < (1ULL << 30)) {
+      iterations *= 2;
+      elapsed = timeBatch(benchmark, iterations);
+    }
+    iterations = std::max<uint64_t>(1, (uint64_t)(iterations * (options.minSampleMicros * 1000.0 / elapsed)));
+    
+    std::vector<double> samples;
+    AllocationCounts before = getAllocationCounts();
+    for (int s = 0; s < options.samples; s++) {
+      samples.push_back(timeBatch(benchmark, iterations) / iterations);
+    }
+    AllocationCounts after = getAllocationCounts();
+    std::sort(samples.begin(), samples.end());
+    
+    // Counts include anything 'before' allocates, so cases keep it allocation-free
+    double ops = (double)iterations * options.samples;
+    BenchmarkResult result;
+    result.name = benchmark.name;
+    result.iterations = iterations;
+    result.nsPerOp = samples[samples.size() / 2];
+    result.nsPerOpMin = samples.front();
+    result.allocsPerOp = (after.count - before.count) / ops;
+    result.bytesPerOp = (after.bytes - before.bytes) / ops;
+    results.push_back(result);
+  }
+  
+  return results;
+}
+
+String BenchmarkRunner::toJson(const std::vector<BenchmarkResult>& results, const BenchmarkOptions& options) {
+  JsonDocument doc;
+  doc["compiler"] = __VERSION__;
+#ifdef __OPTIMIZE__
+  doc["optimized"] = true;
+#else
+  doc["optimized"] = false;
+#endif
+#ifdef __GLIBC__
+  doc["allocationHook"] = "malloc";
+#else
+  doc["allocationHook"] = "operator new";
+#endif
+  doc["samples"] = options.samples;
+  doc["minSampleMs"] = options.minSampleMicros / 1000;
+  
+  JsonArray benchmarks = doc["benchmarks"].to<JsonArray>();
+  for (const BenchmarkResult& result : results) {
+    JsonObject entry = benchmarks.add<JsonObject>();
+    entry["name"] = result.name;
+    entry["iterations"] = result.iterations;
+    entry["nsPerOp"] = serialized(String(result.nsPerOp, 1));
+    entry["nsPerOpMin"] = serialized(String(result.nsPerOpMin, 1));
+    entry["allocsPerOp"] = serialized(String(result.allocsPerOp, 2));
+    entry["bytesPerOp"] = serialized(String(result.bytesPerOp, 1));
+  }
+  
+  String json;
+  serializeJsonPretty(doc, json);
+  return json;
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <Arduino.h>
+#include <functional>
+#include <vector>
+
+// Host microbenchmark harness. Each case runs in batches sized to fill a minimum sample
+// time; ns/op is the median batch, and allocations are counted by the malloc hooks in
+// Benchmark.cpp across every timed iteration.
+
+struct AllocationCounts {
+  uint64_t count;  // malloc/calloc/realloc calls
+  uint64_t bytes;  // Bytes requested by those calls
+};
+
+AllocationCounts getAllocationCounts();
+
+struct BenchmarkOptions {
+  int samples = 5;
+  unsigned long minSampleMicros = 100000;
+  String filter;  // Only cases whose name contains this
+};
+
+struct BenchmarkResult {
+  String name;
+  uint64_t iterations;  // Per sample
+  double nsPerOp;       // Median sample
+  double nsPerOpMin;    // Fastest sample
+  double allocsPerOp;
+  double bytesPerOp;
+};
+
+class BenchmarkRunner {
+public:
+  // 'before' runs untimed ahead of every sample, for cases that accumulate state
+  void add(const String& name, std::function<void()> op, std::function<void()> before = nullptr);
+  
+  std::vector<BenchmarkResult> run(const BenchmarkOptions& options);
+  static String toJson(const std::vector<BenchmarkResult>& results, const BenchmarkOptions& options);
+
+private:
+  struct Case {
+    String name;
+    std::function<void()> op;
+    std::function<void()> before;
+  };
+  
+  std::vector<Case> cases;
+  
+  static double timeBatch(const Case& benchmark, uint64_t iterations);
+};
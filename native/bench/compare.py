@@ -0,0 +1,59 @@
+#!/usr/bin/env python3
+"""
+Compares two native_bench result files and fails on regressions.
+
+    python3 native/bench/compare.py baseline.json current.json [--threshold 10]
+
+A case regresses when its median ns/op grows by more than --threshold percent, or
+when it allocates more per op than the baseline. Exits 1 if any case regressed.
+"""
+
+import argparse
+import json
+import sys
+
+
+def load(path):
+    with open(path) as f:
+        return {b["name"]: b for b in json.load(f)["benchmarks"]}
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("baseline")
+    parser.add_argument("current")
+    parser.add_argument("--threshold", type=float, default=10.0, help="allowed ns/op growth in percent (default: 10)")
+    args = parser.parse_args()
+
+    baseline = load(args.baseline)
+    current = load(args.current)
+    regressions = 0
+
+    print("%-44s %12s %12s %8s %10s %10s" % ("benchmark", "base ns/op", "ns/op", "change", "base allocs", "allocs"))
+    for name, result in current.items():
+        if name not in baseline:
+            print("%-44s %12s %12.1f %8s %10s %10.2f  new" % (name, "-", result["nsPerOp"], "-", "-", result["allocsPerOp"]))
+            continue
+
+        base = baseline[name]
+        change = (result["nsPerOp"] / base["nsPerOp"] - 1) * 100 if base["nsPerOp"] > 0 else 0
+        slower = change > args.threshold
+        # Allocation counts are deterministic, so any increase is real
+        more_allocs = result["allocsPerOp"] > base["allocsPerOp"] + 0.005
+        flag = "  REGRESSION" if slower or more_allocs else ""
+        regressions += bool(flag)
+        print("%-44s %12.1f %12.1f %+7.1f%% %10.2f %10.2f%s" % (
+            name, base["nsPerOp"], result["nsPerOp"], change, base["allocsPerOp"], result["allocsPerOp"], flag))
+
+    for name in baseline:
+        if name not in current:
+            print("%-44s missing from %s" % (name, args.current))
+
+    if regressions:
+        print("%d regression(s) beyond %.1f%%" % (regressions, args.threshold))
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,137 @@
+// Microbenchmarks for the controller hot paths, run on the host against eight simulated
+// PCA9685 boards. Results go to stdout (or --out) as JSON; compare two runs with
+// native/bench/compare.py to catch regressions before flashing.
+//
+//   pio run -e native_bench
+//   .pio/build/native_bench/program [--filter NAME] [--samples N] [--min-time MS] [--out FILE]
+
+#include <Arduino.h>
+#include <Wire.h>
+#include <LittleFS.h>
+#include <VirtualPCA9685.h>
+#include <memory>
+#include <vector>
+#include "Benchmark.h"
+#include "JsonArena.h"
+#include "ServoController.h"
+
+static const char* BENCH_SCRIPT_COMMANDS =
+  "servo 0 0 10; servo 0 1 20; servo 0 2 30; sweep 0 3 0 100 1000; servo 1 0 40;\n"
+  "servo 1 1 50; pair 1 2 1 3; sleep 100; servo 1 4 60; servo 1 5 70";
+
+static void startSweeps(ServoController& controller, int count) {
+  controller.stopAllSweeps();
+  for (int i = 0; i < count; i++) {
+    // Long enough that none complete while a sample runs
+    controller.startSweep(i / SERVOS_PER_BOARD, i % SERVOS_PER_BOARD, 0, 100, 60000);
+  }
+}
+
+static void addCommandCases(BenchmarkRunner& runner, ServoController& controller) {
+  // One representative invocation of each verb executeCommand routes
+  static const char* const commands[][2] = {
+    {"servo", "servo 0 5 42.5"},
+    {"sweep", "sweep 0 6 10 90 5000"},
+    {"config", "config 0 7 center 55"},
+    {"pair", "pair 2 0 2 1"},
+    {"repeat", "repeat 10 servo 0 8 25"},
+    {"stream", "stream status"},
+    {"script", "script bench"},
+    {"sleep", "sleep 50"},
+    {"system", "system info"},
+    {"help", "help"},
+  };
+  
+  for (const auto& command : commands) {
+    String line = command[1];
+    std::function<void()> before = nullptr;
+    // Sleeps queue a command each time; drop them between samples so the queue stays small
+    if (strcmp(command[0], "sleep") == 0) before = [&controller]() { controller.clearQueue(); };
+    runner.add(String("executeCommand/") + command[0], [&controller, line]() { controller.executeCommand(line); }, before);
+  }
+}
+
+int main(int argc, char** argv) {
+  BenchmarkOptions options;
+  const char* outputPath = nullptr;
+  for (int i = 1; i < argc; i++) {
+    String arg = argv[i];
+    if (arg == "--filter" && i + 1 < argc) {
+      options.filter = argv[++i];
+    } else if (arg == "--samples" && i + 1 < argc) {
+      options.samples = constrain(atoi(argv[++i]), 1, 100);
+    } else if (arg == "--min-time" && i + 1 < argc) {
+      options.minSampleMicros = constrain(atol(argv[++i]), 1L, 10000L) * 1000;
+    } else if (arg == "--out" && i + 1 < argc) {
+      outputPath = argv[++i];
+    } else {
+      fprintf(stderr, "Usage: %s [--filter NAME] [--samples N] [--min-time MS] [--out FILE]\n", argv[0]);
+      return 1;
+    }
+  }
+  
+  std::vector<std::unique_ptr<VirtualPCA9685>> chips;
+  for (int b = 0; b < BOARD_ADDRESSES; b++) {
+    chips.emplace_back(new VirtualPCA9685(0x40 + b));
+  }
+  
+  Wire.begin();
+  LittleFS.begin(true);
+  JsonArenaPool::getInstance().begin();
+  
+  ServoController controller;
+  controller.scanForBoards();
+  controller.initializeBoards();
+  controller.loadConfiguration();
+  for (int b = 0; b < BOARD_ADDRESSES; b++) {
+    for (int s = 0; s < SERVOS_PER_BOARD; s++) {
+      controller.updateServoConfig(b, s, "enabled", "true");
+    }
+  }
+  controller.addScript("bench", "Benchmark script", BENCH_SCRIPT_COMMANDS);
+  controller.executeCommand("pair 3 0 4 0");
+  controller.saveConfiguration();
+  
+  BenchmarkRunner runner;
+  addCommandCases(runner, controller);
+  
+  runner.add("executeScript/parse", [&controller]() { controller.executeScript("bench"); });
+  
+  for (int count : {1, 16, 128}) {
+    runner.add("updateSweeps/" + String(count), [&controller]() { controller.updateSweeps(); },
+               [&controller, count]() { startSweeps(controller, count); });
+  }
+  
+  float position = 0;
+  runner.add("setServoToConfiguredPosition/single", [&controller, &position]() {
+    controller.setServoToConfiguredPosition(5, 0, position);
+    position = position >= 100 ? 0 : position + 0.5f;
+  });
+  runner.add("setServoToConfiguredPosition/pair", [&controller, &position]() {
+    controller.setServoToConfiguredPosition(3, 0, position);
+    position = position >= 100 ? 0 : position + 0.5f;
+  });
+  
+  runner.add("getConfigurationJson", [&controller]() { controller.getConfigurationJson(); });
+  runner.add("saveConfiguration", [&controller]() { controller.saveConfiguration(); });
+  runner.add("loadConfiguration", [&controller]() { controller.loadConfiguration(); });
+  
+  String message = "Benchmark message of typical length for a servo move";
+  runner.add("DebugConsole::log", [&message]() { DebugConsole::getInstance().log(message, "info"); });
+  
+  // Cost the profiler adds to every timed section (host cycle counter included)
+  runner.add("LoopProfiler/phase", []() { LoopProfiler::PhaseScope phase(PROFILE_QUEUE); });
+  
+  std::vector<BenchmarkResult> results = runner.run(options);
+  String json = BenchmarkRunner::toJson(results, options);
+  
+  FILE* output = outputPath ? fopen(outputPath, "w") : stdout;
+  if (!output) {
+    fprintf(stderr, "Could not open %s\n", outputPath);
+    return 1;
+  }
+  fwrite(json.c_str(), 1, json.length(), output);
+  fputc('\n', output);
+  if (output != stdout) fclose(output);
+  return 0;
+}
@@ -0,0 +1,233 @@
+// Host console for the controller core. Runs the serial command interface on stdin
+// against simulated PCA9685 boards, with LittleFS kept in a host directory.
+//
+//   pio run -e native
+//   .pio/build/native/program [--boards N] [--mux N] [--fs DIR] [--clock HZ] [--i2c-overhead US] [--serial TTY]
+//
+// --serial attaches a tty (such as the pty stream_serial.py --selftest creates) as the
+// UART: it carries the text console and the binary stream exactly as on the board, while
+// logs and host commands stay on stdout.
+//
+// Lines starting with '.' are host commands:
+//   .pulses [board]  pulse each simulated channel is producing
+//   .bus             I2C load per motion frame and frame-rate limits per board count
+//   .bus reset       clear the frame statistics
+//   .clock HZ        change the simulated I2C clock
+//   .quit            exit
+
+#include <Arduino.h>
+#include <Wire.h>
+#include <LittleFS.h>
+#include <VirtualPCA9685.h>
+#include <VirtualTCA9548A.h>
+#include <BusTiming.h>
+#include <sys/select.h>
+#include <unistd.h>
+#include <memory>
+#include <vector>
+#include "ServoController.h"
+#include "SerialStream.h"
+
+static std::unique_ptr<VirtualTCA9548A> mux;  // Declared first so it outlives the chips behind it
+static std::vector<std::unique_ptr<VirtualPCA9685>> chips;
+
+// Main-bus boards at 0x40 up, then muxBoards behind a TCA9548A at 0x70, channel by channel
+// on the addresses the main bus leaves free (as scanForBoards() requires)
+static void attachChips(int boardCount, int muxBoards) {
+  for (int b = 0; b < boardCount; b++) {
+    chips.emplace_back(new VirtualPCA9685(0x40 + b));
+  }
+  if (muxBoards == 0) return;
+  
+  mux.reset(new VirtualTCA9548A(MUX_BASE_ADDRESS));
+  int perChannel = BOARD_ADDRESSES - boardCount;
+  for (int k = 0; k < muxBoards && perChannel > 0 && k / perChannel < VirtualTCA9548A::CHANNELS; k++) {
+    chips.emplace_back(new VirtualPCA9685(0x40 + boardCount + k % perChannel, mux->channel(k / perChannel)));
+  }
+}
+static BusTiming busTiming;
+
+static const uint32_t BUS_CLOCKS[] = {100000, 400000, 1000000};
+
+static void printPulses(int board) {
+  for (size_t b = 0; b < chips.size(); b++) {
+    if (board >= 0 && (int)b != board) continue;
+    const VirtualPCA9685& chip = *chips[b];
+    Serial.printf("Board %d @0x%02X, %.1f Hz:", (int)b, chip.getAddress(), chip.outputFrequency(PCA9685_OSC_FREQ));
+    for (int channel = 0; channel < VirtualPCA9685::CHANNELS; channel++) {
+      Serial.printf(" %.0f", chip.pulseMicroseconds(channel, PCA9685_OSC_FREQ));
+    }
+    Serial.println();
+  }
+}
+
+static void printBusReport() {
+  const I2CBusStats& stats = Wire.getStats();
+  Serial.printf("Clock %lu Hz, %.1f us per transaction overhead\n", (unsigned long)Wire.getClock(), Wire.getTransactionOverhead());
+  Serial.printf("Totals: %lu transactions (%lu NACK), %llu bytes, %.1f ms busy\n", (unsigned long)stats.transactions,
+                (unsigned long)stats.nacks, (unsigned long long)stats.bytes, stats.busyMicros / 1000.0);
+  Serial.printf("Frames: %lu, busy avg %.1f us / max %.1f us, utilization avg %.1f%% / max %.1f%%, overruns %lu\n",
+                (unsigned long)busTiming.getFrameCount(), busTiming.getAverageBusyMicros(), busTiming.getMaxBusyMicros(),
+                busTiming.getAverageUtilization() * 100, busTiming.getMaxUtilization() * 100,
+                (unsigned long)busTiming.getOverrunCount());
+  if (mux) Serial.printf("Multiplexer 0x%02X: %lu control writes\n", mux->getAddress(), (unsigned long)mux->getControlWrites());
+  
+  // Capacity when every channel changes each frame; PWM output caps what a servo sees
+  float pwmFrequency = chips.empty() ? SERVO_FREQ : chips[0]->outputFrequency(PCA9685_OSC_FREQ);
+  Serial.printf("Max full-frame rate (Hz), batched / one transaction per channel; servos see at most %.1f Hz:\n", pwmFrequency);
+  Serial.print("boards");
+  for (uint32_t clock : BUS_CLOCKS) Serial.printf("  %18lu Hz", (unsigned long)clock);
+  Serial.println();
+  for (int boards = 1; boards <= MAX_BOARDS; boards = boards < BOARD_ADDRESSES ? boards + 1 : boards * 2) {
+    Serial.printf("%6d", boards);
+    for (uint32_t clock : BUS_CLOCKS) {
+      double overhead = Wire.getTransactionOverhead();
+      Serial.printf("  %10.1f / %7.1f", BusTiming::maxFrameRate(BusTiming::fullFrameMicros(boards, clock, overhead)),
+                    BusTiming::maxFrameRate(BusTiming::unbatchedFrameMicros(boards, clock, overhead)));
+    }
+    Serial.println();
+  }
+}
+
+static void executeHostCommand(const String& line) {
+  if (line.startsWith(".pulses")) {
+    printPulses(line.length() > 8 ? line.substring(8).toInt() : -1);
+  } else if (line == ".bus") {
+    printBusReport();
+  } else if (line == ".bus reset") {
+    busTiming.reset();
+    Wire.resetStats();
+    Serial.println("Bus statistics cleared");
+  } else if (line.startsWith(".clock ") && line.substring(7).toInt() > 0) {
+    Wire.setClock(line.substring(7).toInt());
+    busTiming.reset();
+    Serial.printf("I2C clock set to %lu Hz\n", (unsigned long)Wire.getClock());
+  } else {
+    Serial.println("Host commands: .pulses [board], .bus [reset], .clock <hz>, .quit");
+  }
+}
+
+static HardwareSerial uart;
+
+// The firmware's processSerialInput(): text commands until the entry magic, then frames
+// until the host exits or goes quiet
+static void pollUart(SerialStream& stream, String& command, ServoController& controller) {
+  if (stream.isActive()) {
+    stream.poll();
+    return;
+  }
+  
+  while (uart.available() > 0) {
+    uint8_t c = uart.read();
+    if (stream.matchEntryMagic(c)) {
+      command = "";
+      stream.begin();
+      return;
+    }
+    if (c == '\n' || c == '\r') {
+      command.trim();
+      if (command.length() > 0) uart.println("Result: " + controller.executeCommand(command));
+      command = "";
+    } else if (c >= 32 && c <= 126) {
+      command += (char)c;
+    }
+  }
+}
+
+static bool stdinReady(long timeoutMicros) {
+  fd_set readable;
+  FD_ZERO(&readable);
+  FD_SET(STDIN_FILENO, &readable);
+  timeval timeout = {0, timeoutMicros};
+  return select(STDIN_FILENO + 1, &readable, nullptr, nullptr, &timeout) > 0;
+}
+
+// pio test links each test/ suite against this build, and the suite supplies main()
+#ifndef PIO_UNIT_TESTING
+int main(int argc, char** argv) {
+  int boardCount = 2;
+  int muxBoards = 0;
+  for (int i = 1; i < argc; i++) {
+    String arg = argv[i];
+    if (arg == "--boards" && i + 1 < argc) {
+      boardCount = constrain(atoi(argv[++i]), 0, BOARD_ADDRESSES);
+    } else if (arg == "--mux" && i + 1 < argc) {
+      muxBoards = constrain(atoi(argv[++i]), 0, MAX_BOARDS);
+    } else if (arg == "--fs" && i + 1 < argc) {
+      LittleFS.setRoot(argv[++i]);
+    } else if (arg == "--clock" && i + 1 < argc) {
+      Wire.setClock(atol(argv[++i]));
+    } else if (arg == "--i2c-overhead" && i + 1 < argc) {
+      Wire.setTransactionOverhead(atof(argv[++i]));
+    } else if (arg == "--serial" && i + 1 < argc) {
+      if (!uart.open(argv[++i])) {
+        fprintf(stderr, "Cannot open %s\n", argv[i]);
+        return 1;
+      }
+    } else {
+      fprintf(stderr, "Usage: %s [--boards N] [--mux N] [--fs DIR] [--clock HZ] [--i2c-overhead US] [--serial TTY]\n", argv[0]);
+      return 1;
+    }
+  }
+  
+  attachChips(boardCount, muxBoards);
+  
+  Wire.begin();
+  LittleFS.begin(true);
+  Serial.printf("LittleFS at %s\n", LittleFS.getRoot().c_str());
+  
+  ServoController controller;
+  controller.scanForBoards();
+  controller.initializeBoards();
+  controller.loadConfiguration();
+  controller.startPersistence();
+  controller.applyInitialPositions();
+  controller.update();
+  
+  uart.begin(SerialStream::CONSOLE_BAUD);
+  SerialStream serialStream(uart, controller);
+  String uartCommand;
+  // Report only motion traffic, not the scan and initialisation
+  Wire.resetStats();
+  
+  Serial.print("servo> ");
+  Serial.flush();
+  
+  String line;
+  unsigned long lastTick = micros();
+  for (;;) {
+    // The motion loop keeps ticking while waiting for input, as loop() does on the board
+    if (stdinReady(1000)) {
+      char buffer[512];
+      ssize_t count = read(STDIN_FILENO, buffer, sizeof(buffer));
+      if (count <= 0) break;
+      
+      for (ssize_t i = 0; i < count; i++) {
+        if (buffer[i] != '\n' && buffer[i] != '\r') {
+          line += buffer[i];
+          continue;
+        }
+        line.trim();
+        if (line == ".quit") return 0;
+        if (line.startsWith(".")) {
+          executeHostCommand(line);
+        } else if (line.length() > 0) {
+          Serial.println("Result: " + controller.executeCommand(line));
+        }
+        line = "";
+        Serial.print("servo> ");
+        Serial.flush();
+      }
+    }
+    if (uart.isOpen()) pollUart(serialStream, uartCommand, controller);
+    
+    unsigned long tickStart = micros();
+    busTiming.beginFrame();
+    controller.update();
+    busTiming.endFrame(tickStart - lastTick);
+    lastTick = tickStart;
+  }
+  
+  return 0;
+}
+#endif
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "Wire.h"
+
+// PCA9685 registers, as defined by the Adafruit library
+#define PCA9685_MODE1 0x00
+#define PCA9685_MODE2 0x01
+#define PCA9685_LED0_ON_L 0x06
+#define PCA9685_ALLLED_ON_L 0xFA
+#define PCA9685_PRESCALE 0xFE
+
+#define MODE1_ALLCALL 0x01
+#define MODE1_SLEEP 0x10
+#define MODE1_AI 0x20
+#define MODE1_EXTCLK 0x40
+#define MODE1_RESTART 0x80
+#define MODE2_OUTDRV 0x04
+
+#define FREQUENCY_OSCILLATOR 25000000
+#define PCA9685_PRESCALE_MIN 3
+#define PCA9685_PRESCALE_MAX 255
+
+// Host version of Adafruit_PWMServoDriver. It issues the same register writes as the
+// library, over the host Wire bus, so a simulated PCA9685 sees what real hardware would.
+class Adafruit_PWMServoDriver {
+public:
+  Adafruit_PWMServoDriver(uint8_t address = 0x40, TwoWire& i2c = Wire) : address(address), i2c(&i2c) {}
+  
+  bool begin(uint8_t prescale = 0);
+  void reset();
+  void sleep();
+  void wakeup();
+  void setExtClk(uint8_t prescale);
+  void setPWMFreq(float frequency);
+  void setOutputMode(bool totempole);
+  uint8_t getPWM(uint8_t num, bool off = false);
+  uint8_t setPWM(uint8_t num, uint16_t on, uint16_t off);
+  void setPin(uint8_t num, uint16_t value, bool invert = false);
+  uint8_t readPrescale();
+  void writeMicroseconds(uint8_t num, uint16_t microseconds);
+  
+  void setOscillatorFrequency(uint32_t frequency) { oscillatorFrequency = frequency; }
+  uint32_t getOscillatorFrequency() const { return oscillatorFrequency; }
+
+private:
+  uint8_t address;
+  TwoWire* i2c;
+  uint32_t oscillatorFrequency = FREQUENCY_OSCILLATOR;
+  
+  uint8_t read8(uint8_t reg);
+  void write8(uint8_t reg, uint8_t value);
+};
@@ -0,0 +1,232 @@
+#pragma once
+
+// Host stand-in for the parts of the ESP32 Arduino core the controller uses, so the
+// ServoController sources build unchanged under 'pio run -e native'.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <math.h>
+#include <algorithm>
+#include <string>
+
+using std::min;
+using std::max;
+
+// ---------------------------------------------------------------------------------------
+// String
+// ---------------------------------------------------------------------------------------
+
+class String {
+public:
+  String(const char* text = "") : value(text ? text : "") {}
+  String(const String& other) = default;
+  String(String&& other) = default;
+  explicit String(char c) : value(1, c) {}
+  explicit String(unsigned char number, unsigned char base = 10);
+  explicit String(int number, unsigned char base = 10);
+  explicit String(unsigned int number, unsigned char base = 10);
+  explicit String(long number, unsigned char base = 10);
+  explicit String(unsigned long number, unsigned char base = 10);
+  explicit String(long long number, unsigned char base = 10);
+  explicit String(unsigned long long number, unsigned char base = 10);
+  explicit String(float number, unsigned int decimals = 2);
+  explicit String(double number, unsigned int decimals = 2);
+  
+  String& operator=(const String& other) = default;
+  String& operator=(String&& other) = default;
+  String& operator=(const char* text) { value = text ? text : ""; return *this; }
+  
+  String& operator+=(const String& other) { value += other.value; return *this; }
+  String& operator+=(const char* text) { if (text) value += text; return *this; }
+  String& operator+=(char c) { value += c; return *this; }
+  template <typename T> String& operator+=(T number) { return *this += String(number); }
+  
+  bool concat(const String& other) { value += other.value; return true; }
+  bool concat(const char* text) { if (text) value += text; return true; }
+  bool concat(const char* text, unsigned int length) { if (text) value.append(text, length); return true; }
+  bool concat(char c) { value += c; return true; }
+  
+  unsigned int length() const { return value.length(); }
+  bool isEmpty() const { return value.empty(); }
+  const char* c_str() const { return value.c_str(); }
+  bool reserve(unsigned int size) { value.reserve(size); return true; }
+  
+  char operator[](unsigned int index) const { return index < value.length() ? value[index] : 0; }
+  char& operator[](unsigned int index) { return value[index]; }
+  char charAt(unsigned int index) const { return (*this)[index]; }
+  void setCharAt(unsigned int index, char c) { if (index < value.length()) value[index] = c; }
+  
+  bool equals(const String& other) const { return value == other.value; }
+  bool equalsIgnoreCase(const String& other) const;
+  bool operator==(const String& other) const { return value == other.value; }
+  bool operator==(const char* text) const { return value == (text ? text : ""); }
+  bool operator!=(const String& other) const { return value != other.value; }
+  bool operator!=(const char* text) const { return !(*this == text); }
+  bool operator<(const String& other) const { return value < other.value; }
+  
+  int indexOf(char c, unsigned int from = 0) const { return position(value.find(c, from)); }
+  int indexOf(const String& text, unsigned int from = 0) const { return position(value.find(text.value, from)); }
+  int lastIndexOf(char c) const { return position(value.rfind(c)); }
+  int lastIndexOf(const String& text) const { return position(value.rfind(text.value)); }
+  bool startsWith(const String& prefix) const { return value.compare(0, prefix.value.length(), prefix.value) == 0; }
+  bool endsWith(const String& suffix) const;
+  
+  String substring(unsigned int from) const { return substring(from, value.length()); }
+  String substring(unsigned int from, unsigned int to) const;
+  
+  void trim();
+  void toLowerCase();
+  void toUpperCase();
+  void replace(char find, char with);
+  void replace(const String& find, const String& with);
+  void remove(unsigned int index) { if (index < value.length()) value.erase(index); }
+  void remove(unsigned int index, unsigned int count) { if (index < value.length()) value.erase(index, count); }
+  
+  long toInt() const { return strtol(value.c_str(), nullptr, 10); }
+  float toFloat() const { return strtof(value.c_str(), nullptr); }
+  double toDouble() const { return strtod(value.c_str(), nullptr); }
+  void toCharArray(char* buffer, unsigned int size) const;
+  
+  friend String operator+(const String& a, const String& b) { String s(a); s += b; return s; }
+  friend String operator+(const String& a, const char* b) { String s(a); s += b; return s; }
+  friend String operator+(const char* a, const String& b) { String s(a); s += b; return s; }
+  friend String operator+(const String& a, char b) { String s(a); s += b; return s; }
+
+private:
+  std::string value;
+  
+  static int position(size_t found) { return found == std::string::npos ? -1 : (int)found; }
+};
+
+// The Arduino core's type for chained '+' expressions; ArduinoJson's String support names it
+class StringSumHelper : public String {
+public:
+  StringSumHelper(const String& s) : String(s) {}
+};
+
+// ---------------------------------------------------------------------------------------
+// Print / Stream / Serial
+// ---------------------------------------------------------------------------------------
+
+class Print {
+public:
+  virtual ~Print() {}
+  virtual size_t write(uint8_t c) = 0;
+  virtual size_t write(const uint8_t* buffer, size_t size);
+  size_t write(const char* text) { return write((const uint8_t*)text, strlen(text)); }
+  
+  size_t print(const String& s) { return write((const uint8_t*)s.c_str(), s.length()); }
+  size_t print(const char* text) { return write(text); }
+  size_t print(char c) { return write((uint8_t)c); }
+  size_t print(int n, int base = 10) { return print(String(n, (unsigned char)base)); }
+  size_t print(unsigned int n, int base = 10) { return print(String(n, (unsigned char)base)); }
+  size_t print(long n, int base = 10) { return print(String(n, (unsigned char)base)); }
+  size_t print(unsigned long n, int base = 10) { return print(String(n, (unsigned char)base)); }
+  size_t print(double n, int decimals = 2) { return print(String(n, (unsigned int)decimals)); }
+  
+  size_t println() { return write((const uint8_t*)"\r\n", 2); }
+  template <typename T> size_t println(const T& value) { size_t n = print(value); return n + println(); }
+  template <typename T> size_t println(const T& value, int format) { size_t n = print(value, format); return n + println(); }
+  
+  size_t printf(const char* format, ...) __attribute__((format(printf, 2, 3)));
+};
+
+class Stream : public Print {
+public:
+  virtual int available() = 0;
+  virtual int read() = 0;
+  virtual int peek() { return -1; }
+  size_t readBytes(char* buffer, size_t length);
+  size_t readBytes(uint8_t* buffer, size_t length) { return readBytes((char*)buffer, length); }
+  void setTimeout(unsigned long) {}
+};
+
+// stdout for output; input is left to the host program, so available() reports nothing.
+// open() attaches a tty instead (a pty from stream_serial.py --selftest), so a second
+// instance can stand in for the UART with both directions and the baud rate it was set to.
+class HardwareSerial : public Stream {
+public:
+  HardwareSerial() {}
+  ~HardwareSerial();
+  HardwareSerial(const HardwareSerial&) = delete;
+  HardwareSerial& operator=(const HardwareSerial&) = delete;
+  
+  bool open(const char* path);
+  bool isOpen() const { return fd >= 0; }
+  
+  void begin(unsigned long baud) { baudRate = baud; }
+  size_t setRxBufferSize(size_t size) { return size; }
+  void updateBaudRate(unsigned long baud) { baudRate = baud; }
+  unsigned long getBaudRate() const { return baudRate; }
+  int available() override;
+  int read() override;
+  size_t read(uint8_t* buffer, size_t size);
+  int availableForWrite() { return 4096; }
+  size_t write(uint8_t c) override { return write(&c, 1); }
+  size_t write(const uint8_t* buffer, size_t size) override;
+  void flush();
+  operator bool() const { return true; }
+
+private:
+  int fd = -1;
+  unsigned long baudRate = 0;
+};
+
+extern HardwareSerial Serial;
+
+// ---------------------------------------------------------------------------------------
+// Time, randomness and heap
+// ---------------------------------------------------------------------------------------
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void yield();
+
+template <typename T, typename L, typename H>
+T constrain(T value, L low, H high) { return value < low ? low : (value > high ? high : value); }
+
+uint32_t esp_random();
+long random(long max);
+long random(long min, long max);
+
+class EspClass {
+public:
+  uint32_t getFreeHeap();
+  uint32_t getMinFreeHeap();
+  uint32_t getMaxAllocHeap();
+  uint32_t getHeapSize();
+  uint32_t getCpuFreqMHz() { return 240; }
+  uint32_t getCycleCount();  // Host time scaled to getCpuFreqMHz(), wrapping like CCOUNT
+  void restart();
+};
+
+extern EspClass ESP;
+
+// ---------------------------------------------------------------------------------------
+// FreeRTOS
+// ---------------------------------------------------------------------------------------
+
+// No scheduler on the host: task creation fails, so ServoController::requestSave() takes its
+// synchronous fallback and every save happens before the call returns.
+typedef void* TaskHandle_t;
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+
+#define pdTRUE 1
+#define pdFALSE 0
+#define pdPASS 1
+#define pdFAIL 0
+#define portMAX_DELAY 0xffffffffu
+#define pdMS_TO_TICKS(ms) ((TickType_t)(ms))
+
+BaseType_t xTaskCreatePinnedToCore(void (*task)(void*), const char* name, uint32_t stackDepth, void* parameter,
+                                   unsigned priority, TaskHandle_t* handle, int core);
+uint32_t ulTaskNotifyTake(BaseType_t clearOnExit, TickType_t ticksToWait);
+BaseType_t xTaskNotifyGive(TaskHandle_t task);
+void vTaskDelay(TickType_t ticks);
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "Arduino.h"
+#include "IPAddress.h"
+#include <atomic>
+#include <functional>
+#include <thread>
+
+class AsyncUDPPacket {
+public:
+  AsyncUDPPacket(uint8_t* data, size_t length, const IPAddress& remoteIP, uint16_t remotePort, bool multicast)
+    : packetData(data), packetLength(length), remoteAddress(remoteIP), port(remotePort), multicast(multicast) {}
+  
+  uint8_t* data() { return packetData; }
+  size_t length() { return packetLength; }
+  IPAddress remoteIP() { return remoteAddress; }
+  uint16_t remotePort() { return port; }
+  bool isMulticast() { return multicast; }
+
+private:
+  uint8_t* packetData;
+  size_t packetLength;
+  IPAddress remoteAddress;
+  uint16_t port;
+  bool multicast;
+};
+
+typedef std::function<void(AsyncUDPPacket& packet)> AuPacketHandlerFunction;
+
+// UDP receiver on a host socket. Packets are handed to the callback on a receive thread
+// of their own, as the ESP32's async_udp task does, so the firmware sees the same
+// concurrency with the motion loop. Only receiving is supported.
+class AsyncUDP {
+public:
+  AsyncUDP() {}
+  ~AsyncUDP() { close(); }
+  AsyncUDP(const AsyncUDP&) = delete;
+  AsyncUDP& operator=(const AsyncUDP&) = delete;
+  
+  bool listen(uint16_t port);
+  bool listenMulticast(const IPAddress& group, uint16_t port, uint8_t ttl = 1);
+  void onPacket(AuPacketHandlerFunction callback);
+  void close();
+  
+  bool connected() const { return socketFd >= 0; }
+
+private:
+  int socketFd = -1;
+  std::atomic<bool> running{false};
+  std::thread receiver;
+  AuPacketHandlerFunction handler;
+  bool multicast = false;  // Joined a group; its packets are reported as multicast
+  
+  bool open(uint16_t port);
+  // The thread starts once there is both a socket and a callback
+  void startReceiver();
+  void receiveLoop();
+};
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "Wire.h"
+
+// Motion-frame view of the host I2C bus timing. It reports how much of each frame interval
+// the output writes occupy, and how fast frames could run for a given board count and
+// clock.
+class BusTiming {
+public:
+  static const int CHANNELS_PER_BOARD = 16;
+  static const int CHANNEL_BYTES = 4;  // LEDn_ON_L/ON_H/OFF_L/OFF_H
+  
+  explicit BusTiming(TwoWire& bus = Wire) : bus(bus) {}
+  
+  // Bracket one motion tick; intervalMicros is the time since the previous tick started.
+  // Ticks that write nothing are not counted as frames.
+  void beginFrame();
+  void endFrame(double intervalMicros);
+  void reset();
+  
+  uint32_t getFrameCount() const { return frames; }
+  uint32_t getOverrunCount() const { return overruns; }  // Frames whose writes outlasted the interval
+  double getLastBusyMicros() const { return lastBusyMicros; }
+  double getAverageBusyMicros() const { return frames ? totalBusyMicros / frames : 0; }
+  double getMaxBusyMicros() const { return maxBusyMicros; }
+  double getAverageUtilization() const { return frames ? totalUtilization / frames : 0; }
+  double getMaxUtilization() const { return maxUtilization; }
+  
+  // Every channel of every board changed, written as flushOutputs() does: one
+  // auto-increment burst per board
+  static double fullFrameMicros(int boards, uint32_t clock, double overheadMicros = 0);
+  // The same frame with one transaction per channel, i.e. without burst batching
+  static double unbatchedFrameMicros(int boards, uint32_t clock, double overheadMicros = 0);
+  // Frames per second the bus can carry; a servo still only sees one per PWM period
+  static double maxFrameRate(double frameMicros) { return frameMicros > 0 ? 1000000.0 / frameMicros : 0; }
+
+private:
+  TwoWire& bus;
+  double frameStartBusy = 0;
+  uint32_t frameStartTransactions = 0;
+  
+  uint32_t frames = 0;
+  uint32_t overruns = 0;
+  double lastBusyMicros = 0;
+  double totalBusyMicros = 0;
+  double maxBusyMicros = 0;
+  double totalUtilization = 0;
+  double maxUtilization = 0;
+};
@@ -0,0 +1,307 @@
+#pragma once
+
+#include "Arduino.h"
+#include "FS.h"
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Host implementation of the part of ESPAsyncWebServer the firmware uses, over POSIX
+// sockets. Route tables, handlers and responses are written against the same API as on the
+// ESP32, so the WebServer*.cpp files build unchanged.
+//
+// As on the device:
+// - every handler runs on one server thread (async_tcp), concurrently with loop()
+// - body callbacks get each chunk as it arrives from the socket
+// - a handler matches its URI exactly or as a prefix followed by '/'
+// - the first matching handler in registration order wins
+// - each connection carries one request and is closed after the response ("Connection: close")
+// WebSocket upgrades are refused with 501; multipart uploads and POST form parameters are
+// not parsed.
+
+typedef enum {
+  HTTP_GET     = 0b00000001,
+  HTTP_POST    = 0b00000010,
+  HTTP_DELETE  = 0b00000100,
+  HTTP_PUT     = 0b00001000,
+  HTTP_PATCH   = 0b00010000,
+  HTTP_HEAD    = 0b00100000,
+  HTTP_OPTIONS = 0b01000000,
+  HTTP_ANY     = 0b01111111,
+} WebRequestMethod;
+typedef uint8_t WebRequestMethodComposite;
+
+class AsyncWebServer;
+class AsyncWebServerRequest;
+class AsyncWebHandler;
+
+class AsyncWebParameter {
+public:
+  AsyncWebParameter(const String& name, const String& value) : paramName(name), paramValue(value) {}
+  const String& name() const { return paramName; }
+  const String& value() const { return paramValue; }
+
+private:
+  String paramName;
+  String paramValue;
+};
+
+class AsyncWebHeader {
+public:
+  AsyncWebHeader(const String& name, const String& value) : headerName(name), headerValue(value) {}
+  const String& name() const { return headerName; }
+  const String& value() const { return headerValue; }
+
+private:
+  String headerName;
+  String headerValue;
+};
+
+typedef std::function<size_t(uint8_t* buffer, size_t maxLen, size_t index)> AwsResponseFiller;
+
+// Status, headers and a body produced piece by piece as the socket drains
+class AsyncWebServerResponse {
+public:
+  AsyncWebServerResponse(int code, const String& contentType) : code(code), contentType(contentType) {}
+  virtual ~AsyncWebServerResponse() {}
+  
+  void addHeader(const String& name, const String& value) { headers.emplace_back(name, value); }
+  void setCode(int value) { code = value; }
+  void setContentLength(size_t length) { contentLength = length; }
+  void setContentType(const String& type) { contentType = type; }
+  
+  // Host server internals
+  virtual bool sourceValid() const { return true; }
+  std::string head() const;
+  // Next body bytes at offset index; 0 once the body is complete
+  virtual size_t fill(uint8_t* buffer, size_t maxLen, size_t index) = 0;
+  bool isChunked() const { return contentLength < 0; }
+
+protected:
+  int code;
+  String contentType;
+  long contentLength = 0;  // -1: unknown, sent with chunked transfer encoding
+  std::vector<AsyncWebHeader> headers;
+};
+
+// Response body written through Print before it is sent
+class AsyncResponseStream : public AsyncWebServerResponse, public Print {
+public:
+  AsyncResponseStream(const String& contentType, size_t bufferSize);
+  size_t write(uint8_t data) override;
+  size_t write(const uint8_t* data, size_t length) override;
+  size_t fill(uint8_t* buffer, size_t maxLen, size_t index) override;
+
+private:
+  std::string content;
+};
+
+class AsyncWebServerRequest {
+public:
+  // Handlers may park a malloc'd buffer here; it is freed with the request
+  void* _tempObject = nullptr;
+  
+  AsyncWebServerRequest(AsyncWebServer* server, int clientFd);
+  ~AsyncWebServerRequest();
+  
+  const String& url() const { return requestUrl; }
+  WebRequestMethodComposite method() const { return requestMethod; }
+  const char* methodToString() const;
+  size_t contentLength() const { return bodyLength; }
+  
+  void send(int code, const String& contentType = String(), const String& content = String());
+  void send(AsyncWebServerResponse* response);
+  AsyncWebServerResponse* beginResponse(int code, const String& contentType = String(), const String& content = String());
+  AsyncWebServerResponse* beginResponse(fs::FS& fs, const String& path, const String& contentType = String(), bool download = false);
+  AsyncWebServerResponse* beginResponse(const String& contentType, size_t length, AwsResponseFiller callback);
+  AsyncWebServerResponse* beginChunkedResponse(const String& contentType, AwsResponseFiller callback);
+  AsyncResponseStream* beginResponseStream(const String& contentType, size_t bufferSize = 1460);
+  
+  // Query string parameters; post=true asks for form fields, which are not parsed here
+  bool hasParam(const String& name, bool post = false, bool file = false) const;
+  AsyncWebParameter* getParam(const String& name, bool post = false, bool file = false) const;
+  size_t params() const { return parameters.size(); }
+  
+  bool hasHeader(const String& name) const;
+  AsyncWebHeader* getHeader(const String& name) const;
+  String header(const char* name) const;
+  
+  void onDisconnect(std::function<void()> callback) { disconnectCallback = callback; }
+
+private:
+  friend class AsyncWebServer;
+  
+  AsyncWebServer* server;
+  int clientFd;
+  
+  String requestUrl;
+  WebRequestMethodComposite requestMethod = 0;
+  std::vector<std::unique_ptr<AsyncWebParameter>> parameters;
+  std::vector<std::unique_ptr<AsyncWebHeader>> requestHeaders;
+  size_t bodyLength = 0;
+  size_t bodyReceived = 0;
+  AsyncWebHandler* handler = nullptr;
+  
+  // Parsing and sending state, owned by the server thread
+  std::string input;
+  bool headerParsed = false;
+  bool handled = false;
+  std::unique_ptr<AsyncWebServerResponse> response;
+  std::string output;
+  size_t outputSent = 0;
+  size_t bodyIndex = 0;
+  bool bodyDone = false;
+  std::function<void()> disconnectCallback;
+  
+  bool parseHead(size_t headLength);
+  void addParameters(const String& query);
+};
+
+typedef std::function<void(AsyncWebServerRequest* request)> ArRequestHandlerFunction;
+typedef std::function<void(AsyncWebServerRequest* request, const String& filename, size_t index, uint8_t* data, size_t len, bool final)> ArUploadHandlerFunction;
+typedef std::function<void(AsyncWebServerRequest* request, uint8_t* data, size_t len, size_t index, size_t total)> ArBodyHandlerFunction;
+
+class AsyncWebHandler {
+public:
+  virtual ~AsyncWebHandler() {}
+  virtual bool canHandle(AsyncWebServerRequest* request) { return false; }
+  virtual void handleRequest(AsyncWebServerRequest* request) {}
+  virtual void handleBody(AsyncWebServerRequest* request, uint8_t* data, size_t len, size_t index, size_t total) {}
+};
+
+class AsyncCallbackWebHandler : public AsyncWebHandler {
+public:
+  AsyncCallbackWebHandler(const String& uri, WebRequestMethodComposite method) : uri(uri), method(method) {}
+  
+  void onRequest(ArRequestHandlerFunction callback) { requestCallback = callback; }
+  void onUpload(ArUploadHandlerFunction callback) { uploadCallback = callback; }
+  void onBody(ArBodyHandlerFunction callback) { bodyCallback = callback; }
+  
+  bool canHandle(AsyncWebServerRequest* request) override;
+  void handleRequest(AsyncWebServerRequest* request) override;
+  void handleBody(AsyncWebServerRequest* request, uint8_t* data, size_t len, size_t index, size_t total) override;
+
+private:
+  String uri;
+  WebRequestMethodComposite method;
+  ArRequestHandlerFunction requestCallback;
+  ArUploadHandlerFunction uploadCallback;
+  ArBodyHandlerFunction bodyCallback;
+};
+
+// Files under a filesystem directory; a missing file falls back to its .gz sibling
+class AsyncStaticWebHandler : public AsyncWebHandler {
+public:
+  AsyncStaticWebHandler(const char* uri, fs::FS& fs, const char* path, const char* cacheControl);
+  
+  AsyncStaticWebHandler& setDefaultFile(const char* filename) { defaultFile = filename; return *this; }
+  AsyncStaticWebHandler& setCacheControl(const char* value) { cacheControl = value; return *this; }
+  
+  bool canHandle(AsyncWebServerRequest* request) override;
+  void handleRequest(AsyncWebServerRequest* request) override;
+
+private:
+  String uri;
+  fs::FS& fs;
+  String path;
+  String cacheControl;
+  String defaultFile = "index.htm";
+  
+  String filePath(const String& url) const;
+};
+
+class AsyncWebSocket;
+
+class AsyncWebSocketClient {
+public:
+  explicit AsyncWebSocketClient(uint32_t id) : clientId(id) {}
+  uint32_t id() const { return clientId; }
+
+private:
+  uint32_t clientId;
+};
+
+typedef enum { WS_EVT_CONNECT, WS_EVT_DISCONNECT, WS_EVT_PONG, WS_EVT_ERROR, WS_EVT_DATA } AwsEventType;
+typedef enum { WS_CONTINUATION, WS_TEXT, WS_BINARY, WS_DISCONNECT = 0x08, WS_PING, WS_PONG } AwsFrameType;
+
+struct AwsFrameInfo {
+  uint8_t message_opcode;
+  uint32_t num;
+  uint8_t final;
+  uint8_t masked;
+  uint8_t opcode;
+  uint64_t len;
+  uint8_t mask[4];
+  uint64_t index;
+};
+
+typedef std::function<void(AsyncWebSocket* server, AsyncWebSocketClient* client, AwsEventType type, void* arg, uint8_t* data, size_t len)> AwsEventHandler;
+
+// Registers like the device's socket, but the host server answers upgrades with 501
+class AsyncWebSocket : public AsyncWebHandler {
+public:
+  explicit AsyncWebSocket(const String& url) : url(url) {}
+  
+  void onEvent(AwsEventHandler handler) { eventHandler = handler; }
+  void cleanupClients(uint16_t maxClients = 8) {}
+  void textAll(const char* message) {}
+  void textAll(const String& message) {}
+  size_t count() const { return 0; }
+  
+  bool canHandle(AsyncWebServerRequest* request) override;
+  void handleRequest(AsyncWebServerRequest* request) override;
+
+private:
+  String url;
+  AwsEventHandler eventHandler;
+};
+
+class AsyncWebServer {
+public:
+  explicit AsyncWebServer(uint16_t port);
+  ~AsyncWebServer();
+  
+  // Host builds: listen here instead of the port given to the constructor (80 needs root)
+  static void setPortOverride(uint16_t port) { portOverride = port; }
+  
+  void begin();
+  void end();
+  uint16_t getPort() const { return port; }
+  
+  AsyncCallbackWebHandler& on(const char* uri, WebRequestMethodComposite method, ArRequestHandlerFunction onRequest);
+  AsyncCallbackWebHandler& on(const char* uri, WebRequestMethodComposite method, ArRequestHandlerFunction onRequest,
+                              ArUploadHandlerFunction onUpload, ArBodyHandlerFunction onBody = nullptr);
+  AsyncStaticWebHandler& serveStatic(const char* uri, fs::FS& fs, const char* path, const char* cacheControl = NULL);
+  void onNotFound(ArRequestHandlerFunction callback) { notFoundCallback = callback; }
+  AsyncWebHandler& addHandler(AsyncWebHandler* handler);
+
+private:
+  static uint16_t portOverride;
+  static const size_t MAX_CLIENTS = 16;        // lwIP's default active TCP connections; more wait in the backlog
+  static const size_t MAX_HEAD_SIZE = 8192;    // Request line and headers
+  static const size_t RESPONSE_CHUNK_SIZE = 1460;  // One TCP segment, as AsyncTCP fills them
+  
+  uint16_t port;
+  int listenFd = -1;
+  std::atomic<bool> running{false};
+  std::thread serverThread;
+  
+  // Matched in order. addHandler() leaves ownership with the caller, as the firmware
+  // deletes its own WebSocket; handlers made by on() and serveStatic() are owned here.
+  std::vector<AsyncWebHandler*> handlers;
+  std::vector<std::unique_ptr<AsyncWebHandler>> ownedHandlers;
+  ArRequestHandlerFunction notFoundCallback;
+  std::vector<std::unique_ptr<AsyncWebServerRequest>> clients;
+  
+  void serve();
+  void accept();
+  // Each returns false once the connection should be closed
+  bool receive(AsyncWebServerRequest* request);
+  bool transmit(AsyncWebServerRequest* request);
+  void dispatchBody(AsyncWebServerRequest* request, const uint8_t* data, size_t length);
+  void complete(AsyncWebServerRequest* request);
+  void close(AsyncWebServerRequest* request);
+};
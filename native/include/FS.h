@@ -0,0 +1,76 @@
+#pragma once
+
+#include "Arduino.h"
+#include <memory>
+#include <vector>
+
+namespace fs {
+
+enum SeekMode { SeekSet = 0, SeekCur = 1, SeekEnd = 2 };
+
+// File on the host filesystem, with the ESP32 core's fs::File interface
+class File : public Stream {
+public:
+  File() {}
+  File(FILE* handle, const std::string& path);
+  File(const std::string& directory, std::vector<std::string> entries);
+  
+  explicit operator bool() const { return handle != nullptr || isDir; }
+  
+  size_t write(uint8_t c) override;
+  size_t write(const uint8_t* buffer, size_t size) override;
+  int available() override;
+  int read() override;
+  int peek() override;
+  size_t read(uint8_t* buffer, size_t size);
+  void flush();
+  bool seek(uint32_t position, SeekMode mode = SeekSet);
+  size_t position() const;
+  size_t size() const;
+  void close();
+  
+  const char* path() const { return fullPath.c_str(); }
+  const char* name() const;
+  bool isDirectory() const { return isDir; }
+  File openNextFile(const char* mode = "r");
+  void rewindDirectory() { nextEntry = 0; }
+
+private:
+  std::shared_ptr<FILE> handle;
+  std::string fullPath;  // Path as the firmware sees it, e.g. "/servo_config_a.cfg"
+  bool isDir = false;
+  std::vector<std::string> entries;
+  size_t nextEntry = 0;
+};
+
+// Filesystem rooted at a host directory; firmware paths are resolved beneath it
+class FS {
+public:
+  File open(const char* path, const char* mode = "r", bool create = false);
+  File open(const String& path, const char* mode = "r", bool create = false) { return open(path.c_str(), mode, create); }
+  bool exists(const char* path);
+  bool exists(const String& path) { return exists(path.c_str()); }
+  bool remove(const char* path);
+  bool remove(const String& path) { return remove(path.c_str()); }
+  bool rename(const char* from, const char* to);
+  bool rename(const String& from, const String& to) { return rename(from.c_str(), to.c_str()); }
+  bool mkdir(const char* path);
+  bool mkdir(const String& path) { return mkdir(path.c_str()); }
+  bool rmdir(const char* path);
+  
+  const std::string& getRoot() const { return root; }
+
+protected:
+  std::string root;
+  
+  std::string hostPath(const char* path) const;
+};
+
+}  // namespace fs
+
+using fs::File;
+using fs::FS;
+using fs::SeekMode;
+using fs::SeekSet;
+using fs::SeekCur;
+using fs::SeekEnd;
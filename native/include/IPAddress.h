@@ -0,0 +1,18 @@
+#pragma once
+
+#include "Arduino.h"
+
+// IPv4 address with the Arduino core's interface; octets are stored in network order
+class IPAddress {
+public:
+  IPAddress() {}
+  IPAddress(uint8_t first, uint8_t second, uint8_t third, uint8_t fourth) : octets{first, second, third, fourth} {}
+  
+  uint8_t operator[](int index) const { return octets[index]; }
+  bool operator==(const IPAddress& other) const { return memcmp(octets, other.octets, sizeof(octets)) == 0; }
+  bool isMulticast() const { return octets[0] >= 224 && octets[0] <= 239; }
+  String toString() const;
+
+private:
+  uint8_t octets[4] = {};
+};
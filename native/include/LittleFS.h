@@ -0,0 +1,20 @@
+#pragma once
+
+#include "FS.h"
+
+// LittleFS for host builds, kept in a directory. NATIVE_FS_ROOT picks the directory so a
+// run can reuse earlier files; otherwise begin() creates a fresh temporary one.
+class LittleFSFS : public fs::FS {
+public:
+  bool begin(bool formatOnFail = false, const char* basePath = "/littlefs", uint8_t maxOpenFiles = 10,
+             const char* partitionLabel = "spiffs");
+  void end() {}
+  bool format();
+  size_t totalBytes() { return 1408 * 1024; }  // min_spiffs.csv partition size
+  size_t usedBytes();
+  
+  // Points the filesystem at a host directory, creating it if needed
+  bool setRoot(const std::string& directory);
+};
+
+extern LittleFSFS LittleFS;
@@ -0,0 +1,20 @@
+#pragma once
+
+#include "Clock.h"
+
+// Clock that only moves when told to. Install it with Clock::install() before the
+// controller runs, then step it once per simulated motion tick.
+class VirtualClock : public Clock {
+public:
+  explicit VirtualClock(unsigned long startMillis = 0) : now(startMillis * 1000ULL) {}
+  
+  unsigned long millis() override { return (unsigned long)(now / 1000); }
+  unsigned long micros() override { return (unsigned long)now; }
+  
+  void advance(unsigned long ms) { now += ms * 1000ULL; }
+  void advanceMicros(uint64_t us) { now += us; }
+  void setMillis(unsigned long ms) { now = ms * 1000ULL; }
+
+private:
+  uint64_t now;  // Microseconds
+};
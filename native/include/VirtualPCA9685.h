@@ -0,0 +1,45 @@
+#pragma once
+
+#include "Adafruit_PWMServoDriver.h"
+
+// Register model of a PCA9685 for host builds. Attach one to the host Wire bus per
+// simulated board; it decodes the driver's writes like the real chip, including MODE1
+// auto-increment and PRESCALE being write-protected while the oscillator runs.
+class VirtualPCA9685 : public I2CDevice {
+public:
+  static const int CHANNELS = 16;
+  
+  explicit VirtualPCA9685(uint8_t address, TwoWire& bus = Wire);
+  ~VirtualPCA9685();
+  
+  void powerOn();  // Datasheet reset values
+  
+  void receive(const uint8_t* data, size_t length) override;
+  size_t transmit(uint8_t* data, size_t length) override;
+  
+  uint8_t getAddress() const { return address; }
+  uint8_t getRegister(uint8_t reg) const { return registers[reg]; }
+  uint8_t getPrescale() const { return registers[PCA9685_PRESCALE]; }
+  bool isSleeping() const { return registers[PCA9685_MODE1] & MODE1_SLEEP; }
+  
+  uint16_t getOn(int channel) const;
+  uint16_t getOff(int channel) const;
+  
+  // High time of a channel's output in microseconds, or 0 when off or asleep
+  float pulseMicroseconds(int channel, uint32_t oscillatorFrequency) const;
+  float outputFrequency(uint32_t oscillatorFrequency) const;
+  
+  uint32_t getWriteCount() const { return writeCount; }
+  uint32_t getChannelWrites(int channel) const { return channelWrites[channel]; }
+
+private:
+  uint8_t address;
+  TwoWire& bus;
+  uint8_t registers[256];
+  uint8_t pointer = 0;
+  uint32_t writeCount = 0;
+  uint32_t channelWrites[CHANNELS] = {};
+  
+  void writeRegister(uint8_t reg, uint8_t value);
+  uint8_t nextPointer(uint8_t reg) const;
+};
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "Wire.h"
+
+// Model of a TCA9548A I2C switch for host builds. Devices attach to one of its downstream
+// buses (channel(n)); while that channel is enabled in the control register, transactions
+// on the upstream bus reach them, as on the real part. Several channels may be enabled at
+// once, in which case the lowest one answering an address wins.
+class VirtualTCA9548A : public I2CDevice {
+public:
+  static const int CHANNELS = 8;
+  
+  explicit VirtualTCA9548A(uint8_t address, TwoWire& bus = Wire);
+  ~VirtualTCA9548A();
+  
+  void receive(const uint8_t* data, size_t length) override;
+  size_t transmit(uint8_t* data, size_t length) override;
+  bool isSwitch() const override { return true; }
+  I2CDevice* route(uint8_t address) override;
+  
+  TwoWire& channel(int index) { return channels[index]; }
+  uint8_t getAddress() const { return address; }
+  uint8_t getControl() const { return control; }
+  uint32_t getControlWrites() const { return controlWrites; }
+
+private:
+  uint8_t address;
+  TwoWire& bus;
+  uint8_t control = 0;  // Bit n enables channel n; all off at power-on
+  uint32_t controlWrites = 0;
+  TwoWire channels[CHANNELS];
+};
@@ -0,0 +1,88 @@
+#pragma once
+
+#include "Arduino.h"
+#include <mutex>
+#include <vector>
+
+// A device on the host I2C bus. Writes arrive as one buffer per transaction; reads ask
+// the device for the next bytes.
+class I2CDevice {
+public:
+  virtual ~I2CDevice() {}
+  virtual void receive(const uint8_t* data, size_t length) = 0;
+  virtual size_t transmit(uint8_t* data, size_t length) = 0;
+  // Switches such as the TCA9548A pass other addresses on to the bus they have selected
+  virtual bool isSwitch() const { return false; }
+  virtual I2CDevice* route(uint8_t address) { return nullptr; }
+};
+
+// Bus time spent on transactions since the last resetStats()
+struct I2CBusStats {
+  uint32_t transactions = 0;
+  uint32_t nacks = 0;
+  uint64_t bytes = 0;      // Every byte clocked, address bytes included
+  double busyMicros = 0;
+};
+
+// Host I2C bus. Transactions go to devices attached by address; anything else NACKs,
+// exactly as an empty socket would on the real bus. Each transaction is also timed at the
+// configured clock, so bus load can be measured without hardware.
+//
+// As in the ESP32 core, a transaction holds the bus lock from beginTransmission() to
+// endTransmission(), so threads of the host web server cannot interleave their writes.
+class TwoWire : public Stream {
+public:
+  static const int MAX_DEVICES = 128;
+  static constexpr size_t BUFFER_LENGTH = 128;  // Same transmit buffer as the ESP32 core
+  
+  bool begin() { return true; }
+  bool begin(int sda, int scl, uint32_t frequency = 0);
+  void setClock(uint32_t frequency) { clock = frequency; }
+  uint32_t getClock() const { return clock; }
+  
+  void beginTransmission(uint8_t address);
+  uint8_t endTransmission(bool sendStop = true);
+  size_t write(uint8_t data) override;
+  size_t write(const uint8_t* data, size_t length) override;
+  
+  uint8_t requestFrom(uint8_t address, uint8_t quantity, bool sendStop = true);
+  int available() override { return (int)(rxLength - rxIndex); }
+  int read() override { return rxIndex < rxLength ? rxBuffer[rxIndex++] : -1; }
+  int peek() override { return rxIndex < rxLength ? rxBuffer[rxIndex] : -1; }
+  
+  // START, address byte, data bytes (8 bits + ACK each) and STOP at the given clock, plus
+  // a fixed per-transaction cost for driver and interrupt latency
+  static double transactionMicros(size_t dataBytes, uint32_t frequency, double overheadMicros = 0);
+  void setTransactionOverhead(double micros) { overheadMicros = micros; }
+  double getTransactionOverhead() const { return overheadMicros; }
+  const I2CBusStats& getStats() const { return stats; }
+  void resetStats() { stats = I2CBusStats(); }
+  
+  void attach(uint8_t address, I2CDevice* device);
+  void detach(uint8_t address);
+  I2CDevice* device(uint8_t address) const { return address < MAX_DEVICES ? devices[address] : nullptr; }
+  // The device answering an address: one attached here, or one behind a switch's selected bus
+  I2CDevice* resolve(uint8_t address) const;
+
+private:
+  I2CDevice* devices[MAX_DEVICES] = {};
+  std::vector<I2CDevice*> switches;  // Attached devices for which isSwitch()
+  uint32_t clock = 100000;
+  double overheadMicros = 0;
+  I2CBusStats stats;
+  
+  uint8_t txAddress = 0;
+  uint8_t txBuffer[BUFFER_LENGTH];
+  size_t txLength = 0;
+  bool txOverflow = false;
+  
+  uint8_t rxBuffer[BUFFER_LENGTH];
+  size_t rxLength = 0;
+  size_t rxIndex = 0;
+  
+  std::recursive_mutex busLock;
+  
+  void recordTransaction(size_t dataBytes, bool acknowledged);
+};
+
+extern TwoWire Wire;
@@ -0,0 +1,398 @@
+// HTTP load generator for the controller API: native_web on the host, or a device.
+// Clients replay a weighted mix of the requests the web UI makes (slider moves on
+// /api/test, console commands on /api/command, /api/config loads and /api/debug polling),
+// then report requests/s and latency percentiles per endpoint. Motion-tick jitter is
+// taken from the server's own profiler (/api/profile 'tickInterval'), measured idle
+// first and then under load.
+//
+//   pio run -e native_loadgen
+//   .pio/build/native_loadgen/program [--host H] [--port N] [--clients N] [--duration S]
+//       [--rate R] [--mix test=60,debug=25,command=10,config=5] [--boards N] [--servos N]
+//       [--settle S] [--out FILE]
+//
+// Without --rate each client sends its next request as soon as the last one completes.
+// With --rate the clients share a fixed schedule of R requests/s, and latency counts from
+// when a request was due, so a stalled server is not hidden by clients that wait for it.
+
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+enum RequestKind { REQUEST_TEST, REQUEST_COMMAND, REQUEST_CONFIG, REQUEST_DEBUG, REQUEST_KIND_COUNT };
+
+struct Endpoint {
+  const char* name;     // --mix key
+  const char* route;    // Handler name in /api/profile
+};
+
+static const Endpoint ENDPOINTS[REQUEST_KIND_COUNT] = {
+  {"test", "POST /api/test"},
+  {"command", "POST /api/command"},
+  {"config", "GET /api/config"},
+  {"debug", "GET /api/debug"},
+};
+
+struct Options {
+  std::string host = "127.0.0.1";
+  std::string port = "8080";
+  int clients = 4;
+  double duration = 10;
+  double rate = 0;  // Requests/s across all clients; 0 runs closed loop
+  double settle = 2;
+  int boards = 1;
+  int servos = 16;
+  int weights[REQUEST_KIND_COUNT] = {60, 10, 5, 25};
+  std::string out;
+};
+
+struct Sample {
+  uint8_t kind;
+  bool ok;
+  uint32_t micros;
+};
+
+struct Response {
+  int status = 0;  // 0: no response
+  std::string body;
+};
+
+// One request on its own connection, as the device closes each one after responding
+static Response httpRequest(const addrinfo* address, const std::string& method, const std::string& path,
+                            const std::string& body = "") {
+  Response response;
+  int fd = socket(address->ai_family, SOCK_STREAM, 0);
+  if (fd < 0) return response;
+  
+  timeval timeout = {5, 0};
+  setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+  setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+  int noDelay = 1;
+  setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+  if (connect(fd, address->ai_addr, address->ai_addrlen) < 0) {
+    close(fd);
+    return response;
+  }
+  
+  std::string request = method + " " + path + " HTTP/1.1\r\nHost: controller\r\nConnection: close\r\n";
+  if (!body.empty()) {
+    request += "Content-Type: application/json\r\nContent-Length: " + std::to_string(body.size()) + "\r\n";
+  }
+  request += "\r\n" + body;
+  if (send(fd, request.data(), request.size(), MSG_NOSIGNAL) != (ssize_t)request.size()) {
+    close(fd);
+    return response;
+  }
+  
+  std::string raw;
+  char buffer[4096];
+  ssize_t received;
+  while ((received = recv(fd, buffer, sizeof(buffer), 0)) > 0) {
+    raw.append(buffer, received);
+  }
+  close(fd);
+  if (received < 0 || raw.compare(0, 5, "HTTP/") != 0) return response;
+  
+  response.status = atoi(raw.c_str() + raw.find(' ') + 1);
+  size_t headEnd = raw.find("\r\n\r\n");
+  if (headEnd == std::string::npos) return response;
+  
+  // Chunked bodies are joined; the framing is only needed for /api/profile
+  std::string head = raw.substr(0, headEnd);
+  std::string content = raw.substr(headEnd + 4);
+  if (head.find("Transfer-Encoding: chunked") == std::string::npos) {
+    response.body = content;
+    return response;
+  }
+  size_t position = 0;
+  while (position < content.size()) {
+    size_t lineEnd = content.find("\r\n", position);
+    if (lineEnd == std::string::npos) break;
+    size_t length = strtoul(content.c_str() + position, nullptr, 16);
+    if (length == 0) break;
+    response.body.append(content, lineEnd + 2, length);
+    position = lineEnd + 2 + length + 2;
+  }
+  return response;
+}
+
+// ---------------------------------------------------------------------------------------
+// Server-side figures from /api/profile
+// ---------------------------------------------------------------------------------------
+
+struct SectionStats {
+  bool found = false;
+  double count = 0;
+  double avgUs = 0;
+  double p99Us = 0;
+  double maxUs = 0;
+};
+
+static double jsonNumber(const std::string& object, const char* key) {
+  std::string pattern = std::string("\"") + key + "\":";
+  size_t at = object.find(pattern);
+  return at == std::string::npos ? 0 : strtod(object.c_str() + at + pattern.size(), nullptr);
+}
+
+// Profile sections hold only numbers and one array, so the first '}' closes them
+static SectionStats profileSection(const std::string& profile, const std::string& name) {
+  SectionStats stats;
+  size_t start = profile.find("\"" + name + "\":{");
+  if (start == std::string::npos) return stats;
+  std::string object = profile.substr(start, profile.find('}', start) - start);
+  
+  stats.found = true;
+  stats.count = jsonNumber(object, "count");
+  stats.avgUs = jsonNumber(object, "avgUs");
+  stats.p99Us = jsonNumber(object, "p99Us");
+  stats.maxUs = jsonNumber(object, "maxUs");
+  return stats;
+}
+
+// ---------------------------------------------------------------------------------------
+// Load
+// ---------------------------------------------------------------------------------------
+
+static void runClient(const Options& options, const addrinfo* address, int client, Clock::time_point start,
+                      Clock::time_point end, std::vector<Sample>& samples) {
+  std::mt19937 random(client * 7919 + 1);
+  int totalWeight = 0;
+  for (int weight : options.weights) totalWeight += weight;
+  
+  // Each client drags its own servo back and forth, as a slider would
+  int board = client % options.boards;
+  int servo = client % options.servos;
+  double interval = options.rate > 0 ? options.clients / options.rate : 0;
+  // Clients are staggered so a fixed rate does not arrive in bursts
+  Clock::time_point due = start + std::chrono::duration_cast<Clock::duration>(
+    std::chrono::duration<double>(interval * client / options.clients));
+  
+  for (uint32_t step = 0;; step++) {
+    if (interval > 0) {
+      std::this_thread::sleep_until(due);
+    } else {
+      due = Clock::now();
+    }
+    if (due >= end) break;
+    
+    int pick = random() % totalWeight;
+    int kind = 0;
+    while (pick >= options.weights[kind]) pick -= options.weights[kind++];
+    
+    double position = 50 + 45 * sin(step * 0.1);
+    char body[128];
+    Response response;
+    switch (kind) {
+      case REQUEST_TEST:
+        snprintf(body, sizeof(body), "{\"board\":%d,\"servo\":%d,\"position\":%.1f}", board, servo, position);
+        response = httpRequest(address, "POST", "/api/test", body);
+        break;
+      case REQUEST_COMMAND:
+        snprintf(body, sizeof(body), "{\"command\":\"servo %d %d %.1f\"}", board, (servo + 1) % options.servos, position);
+        response = httpRequest(address, "POST", "/api/command", body);
+        break;
+      case REQUEST_CONFIG:
+        response = httpRequest(address, "GET", "/api/config");
+        break;
+      default:
+        response = httpRequest(address, "GET", "/api/debug");
+        break;
+    }
+    
+    auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - due).count();
+    bool ok = response.status >= 200 && response.status < 400;
+    samples.push_back({(uint8_t)kind, ok, (uint32_t)elapsed});
+    
+    if (interval > 0) {
+      due += std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(interval));
+    }
+  }
+}
+
+static double percentileMillis(std::vector<uint32_t>& sorted, double fraction) {
+  if (sorted.empty()) return 0;
+  size_t rank = (size_t)ceil(sorted.size() * fraction);
+  return sorted[std::min(std::max(rank, (size_t)1), sorted.size()) - 1] / 1000.0;
+}
+
+static bool parseMix(const char* text, int* weights) {
+  for (int i = 0; i < REQUEST_KIND_COUNT; i++) weights[i] = 0;
+  
+  std::string mix = text;
+  size_t start = 0;
+  while (start < mix.size()) {
+    size_t end = mix.find(',', start);
+    if (end == std::string::npos) end = mix.size();
+    std::string item = mix.substr(start, end - start);
+    size_t equals = item.find('=');
+    
+    int kind = 0;
+    while (kind < REQUEST_KIND_COUNT && item.substr(0, equals) != ENDPOINTS[kind].name) kind++;
+    if (kind == REQUEST_KIND_COUNT || equals == std::string::npos) return false;
+    weights[kind] = atoi(item.c_str() + equals + 1);
+    start = end + 1;
+  }
+  
+  int total = 0;
+  for (int i = 0; i < REQUEST_KIND_COUNT; i++) total += std::max(weights[i], 0);
+  return total > 0;
+}
+
+static void printTick(FILE* out, const char* label, const SectionStats& stats) {
+  fprintf(out, "%-14s %9.0f %9.1f %9.1f %9.1f %9.1f\n", label, stats.count, stats.avgUs, stats.p99Us, stats.maxUs,
+          stats.p99Us - stats.avgUs);
+}
+
+int main(int argc, char** argv) {
+  Options options;
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    bool hasValue = i + 1 < argc;
+    if (arg == "--host" && hasValue) {
+      options.host = argv[++i];
+    } else if (arg == "--port" && hasValue) {
+      options.port = argv[++i];
+    } else if (arg == "--clients" && hasValue) {
+      options.clients = std::max(atoi(argv[++i]), 1);
+    } else if (arg == "--duration" && hasValue) {
+      options.duration = atof(argv[++i]);
+    } else if (arg == "--rate" && hasValue) {
+      options.rate = atof(argv[++i]);
+    } else if (arg == "--settle" && hasValue) {
+      options.settle = atof(argv[++i]);
+    } else if (arg == "--boards" && hasValue) {
+      options.boards = std::max(atoi(argv[++i]), 1);
+    } else if (arg == "--servos" && hasValue) {
+      options.servos = std::max(atoi(argv[++i]), 1);
+    } else if (arg == "--out" && hasValue) {
+      options.out = argv[++i];
+    } else if (arg == "--mix" && hasValue && parseMix(argv[++i], options.weights)) {
+      continue;
+    } else {
+      fprintf(stderr, "Usage: %s [--host H] [--port N] [--clients N] [--duration S] [--rate R]\n"
+                      "          [--mix test=60,debug=25,command=10,config=5] [--boards N] [--servos N]\n"
+                      "          [--settle S] [--out FILE]\n", argv[0]);
+      return 1;
+    }
+  }
+  
+  addrinfo hints = {};
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  addrinfo* address = nullptr;
+  if (getaddrinfo(options.host.c_str(), options.port.c_str(), &hints, &address) != 0) {
+    fprintf(stderr, "Cannot resolve %s\n", options.host.c_str());
+    return 1;
+  }
+  
+  // Idle baseline: the tick with nothing but the profiler polls
+  if (httpRequest(address, "DELETE", "/api/profile").status != 200) {
+    fprintf(stderr, "No controller at %s:%s (DELETE /api/profile failed)\n", options.host.c_str(), options.port.c_str());
+    return 1;
+  }
+  std::this_thread::sleep_for(std::chrono::duration<double>(options.settle));
+  std::string idleProfile = httpRequest(address, "GET", "/api/profile").body;
+  httpRequest(address, "DELETE", "/api/profile");
+  
+  Clock::time_point start = Clock::now();
+  Clock::time_point end = start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(options.duration));
+  std::vector<std::vector<Sample>> clientSamples(options.clients);
+  std::vector<std::thread> threads;
+  for (int c = 0; c < options.clients; c++) {
+    threads.emplace_back(runClient, std::cref(options), address, c, start, end, std::ref(clientSamples[c]));
+  }
+  for (std::thread& thread : threads) thread.join();
+  double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+  
+  std::string loadProfile = httpRequest(address, "GET", "/api/profile").body;
+  freeaddrinfo(address);
+  
+  // Latency per endpoint, then all together
+  std::vector<uint32_t> latencies[REQUEST_KIND_COUNT + 1];
+  int errors[REQUEST_KIND_COUNT + 1] = {};
+  for (const auto& samples : clientSamples) {
+    for (const Sample& sample : samples) {
+      latencies[sample.kind].push_back(sample.micros);
+      latencies[REQUEST_KIND_COUNT].push_back(sample.micros);
+      if (!sample.ok) {
+        errors[sample.kind]++;
+        errors[REQUEST_KIND_COUNT]++;
+      }
+    }
+  }
+  
+  FILE* json = options.out.empty() ? nullptr : fopen(options.out.c_str(), "w");
+  if (!options.out.empty() && !json) {
+    fprintf(stderr, "Cannot write %s\n", options.out.c_str());
+    return 1;
+  }
+  
+  printf("%d clients, %s, %.1f s\n", options.clients,
+         options.rate > 0 ? (std::to_string((int)options.rate) + " req/s scheduled").c_str() : "closed loop", elapsed);
+  printf("%-14s %9s %7s %9s %9s %9s %9s %9s %11s\n", "Endpoint", "Requests", "Errors", "Req/s", "p50 ms", "p90 ms",
+         "p99 ms", "Max ms", "Server p99");
+  if (json) fprintf(json, "{\n  \"clients\": %d,\n  \"rate\": %.1f,\n  \"seconds\": %.3f,\n  \"endpoints\": {\n",
+                    options.clients, options.rate, elapsed);
+  
+  for (int kind = 0; kind <= REQUEST_KIND_COUNT; kind++) {
+    std::vector<uint32_t>& sorted = latencies[kind];
+    if (kind < REQUEST_KIND_COUNT && sorted.empty()) continue;
+    std::sort(sorted.begin(), sorted.end());
+    
+    const char* name = kind < REQUEST_KIND_COUNT ? ENDPOINTS[kind].name : "total";
+    SectionStats server;
+    if (kind < REQUEST_KIND_COUNT) server = profileSection(loadProfile, ENDPOINTS[kind].route);
+    double rate = sorted.size() / elapsed;
+    double p50 = percentileMillis(sorted, 0.5), p90 = percentileMillis(sorted, 0.9), p99 = percentileMillis(sorted, 0.99);
+    double max = sorted.empty() ? 0 : sorted.back() / 1000.0;
+    
+    char serverText[16] = "-";
+    if (server.found) snprintf(serverText, sizeof(serverText), "%.2f", server.p99Us / 1000);
+    printf("%-14s %9zu %7d %9.1f %9.2f %9.2f %9.2f %9.2f %11s\n", name, sorted.size(), errors[kind], rate, p50, p90, p99,
+           max, serverText);
+    if (json) {
+      fprintf(json, "    \"%s\": {\"requests\": %zu, \"errors\": %d, \"rps\": %.2f, \"p50Ms\": %.3f, \"p90Ms\": %.3f, "
+                    "\"p99Ms\": %.3f, \"maxMs\": %.3f, \"serverP99Ms\": %.3f}%s\n",
+              name, sorted.size(), errors[kind], rate, p50, p90, p99, max, server.p99Us / 1000,
+              kind < REQUEST_KIND_COUNT ? "," : "");
+    }
+  }
+  printf("Server p99: handler time from /api/profile (ms)\n\n");
+  
+  SectionStats idleTick = profileSection(idleProfile, "tickInterval");
+  SectionStats loadTick = profileSection(loadProfile, "tickInterval");
+  SectionStats loadLoop = profileSection(loadProfile, "loop");
+  printf("Motion tick    %9s %9s %9s %9s %9s\n", "Ticks", "Avg us", "P99 us", "Max us", "Jitter us");
+  printTick(stdout, "idle", idleTick);
+  printTick(stdout, "under load", loadTick);
+  printf("Jitter: p99 - avg of the interval between loop() passes. Loop pass under load: avg %.1f us, p99 %.1f us, max %.1f us\n",
+         loadLoop.avgUs, loadLoop.p99Us, loadLoop.maxUs);
+  if (!loadTick.found) printf("No tickInterval in /api/profile; the server predates it\n");
+  
+  if (json) {
+    const SectionStats* ticks[] = {&idleTick, &loadTick};
+    const char* labels[] = {"idle", "load"};
+    fprintf(json, "  },\n  \"tickInterval\": {\n");
+    for (int i = 0; i < 2; i++) {
+      fprintf(json, "    \"%s\": {\"count\": %.0f, \"avgUs\": %.1f, \"p99Us\": %.1f, \"maxUs\": %.1f}%s\n", labels[i],
+              ticks[i]->count, ticks[i]->avgUs, ticks[i]->p99Us, ticks[i]->maxUs, i == 0 ? "," : "");
+    }
+    fprintf(json, "  }\n}\n");
+    fclose(json);
+  }
+  
+  return errors[REQUEST_KIND_COUNT] > 0 ? 2 : 0;
+}
@@ -0,0 +1,427 @@
+// Faster-than-real-time show simulation. Runs a show file, or a command recording
+// downloaded from /api/recorder, against simulated boards on a virtual clock and traces
+// every output change per motion frame. A choreography is checked in milliseconds and a
+// field problem replays exactly, and either can be compared frame by frame with a golden
+// trace.
+//
+//   pio run -e native_sim
+//   .pio/build/native_sim/program (SHOW | --replay RECORDING [--dump])
+//       [--boards N] [--tick-ms MS] [--frame-ms MS] [--duration MS] [--fs DIR]
+//       [--out TRACE] [--expect GOLDEN] [--timeline JSON]
+//
+// A show file holds one controller command per line. '@<ms> <command>' issues the command
+// at that show time; lines without it follow the previous line. '#' starts a comment.
+// Without --duration the run ends once every command is issued and all motion is done.
+//
+// The controller ticks every --tick-ms (1, as loop() does) and outputs are sampled every
+// --frame-ms (20, one PWM period). The trace is CSV, 'time_ms,board,channel,pulse_us',
+// one line per channel whose output changed since the previous frame. --timeline also
+// writes the EventTrace ring (the newest TRACE_EVENT_CAPACITY events) as Chrome trace
+// JSON, stamped in virtual time.
+
+#include <Arduino.h>
+#include <Wire.h>
+#include <LittleFS.h>
+#include <VirtualPCA9685.h>
+#include <VirtualClock.h>
+#include <climits>
+#include <cmath>
+#include <memory>
+#include <vector>
+#include "ServoController.h"
+#include "CommandRecorder.h"
+#include "TraceJsonStream.h"
+
+static const unsigned long MAX_SHOW_MILLIS = 3600000;  // Stop runaway shows after an hour of show time
+
+struct ShowCommand {
+  unsigned long at;
+  uint8_t kind;      // CommandRecordKind
+  uint8_t source;    // CommandSource
+  uint32_t delayMs;  // RECORD_QUEUE only
+  String command;    // RECORD_SEQUENCE: commands separated by '\n'
+};
+
+struct TraceChange {
+  unsigned long time;
+  int board;
+  int channel;
+  float pulse;
+};
+
+static const char* const SOURCE_NAMES[] = {"internal", "serial", "http"};
+static const char* const KIND_NAMES[] = {"execute", "queue", "sequence"};
+
+static bool readShow(const char* path, std::vector<ShowCommand>& show) {
+  FILE* file = fopen(path, "r");
+  if (!file) return false;
+  
+  char buffer[1024];
+  unsigned long at = 0;
+  while (fgets(buffer, sizeof(buffer), file)) {
+    String line = buffer;
+    int comment = line.indexOf('#');
+    if (comment >= 0) line = line.substring(0, comment);
+    line.trim();
+    
+    if (line.startsWith("@")) {
+      int space = line.indexOf(' ');
+      at = (space > 0 ? line.substring(1, space) : line.substring(1)).toInt();
+      line = space > 0 ? line.substring(space + 1) : "";
+      line.trim();
+    }
+    if (line.length() > 0) show.push_back({at, RECORD_EXECUTE, COMMAND_SOURCE_INTERNAL, 0, line});
+  }
+  
+  fclose(file);
+  return true;
+}
+
+// Top-level entries become the show, timed from the first one; nested entries are only
+// counted, since replaying their outer call reproduces them
+static bool readRecording(const char* path, std::vector<ShowCommand>& show, bool dump) {
+  FILE* file = fopen(path, "rb");
+  if (!file) return false;
+  
+  CommandRecordFileHeader fileHeader;
+  if (fread(&fileHeader, sizeof(fileHeader), 1, file) != 1 || fileHeader.magic != COMMAND_RECORD_MAGIC ||
+      fileHeader.version != COMMAND_RECORD_VERSION) {
+    fprintf(stderr, "%s is not a command recording\n", path);
+    fclose(file);
+    return false;
+  }
+  
+  uint32_t sourceCounts[COMMAND_SOURCE_COUNT] = {};
+  uint32_t nestedCount = 0;
+  uint32_t truncatedCount = 0;
+  bool haveFirst = false;
+  uint32_t firstTime = 0, lastTime = 0;
+  uint32_t minGap = UINT32_MAX, maxGap = 0, burst = 0, maxBurst = 0;
+  
+  CommandRecordHeader header;
+  while (fread(&header, sizeof(header), 1, file) == 1) {
+    String payload;
+    char buffer[256];
+    size_t remaining = header.length;
+    while (remaining > 0) {
+      size_t count = fread(buffer, 1, min(remaining, sizeof(buffer)), file);
+      if (count == 0) break;
+      payload.concat(buffer, count);
+      remaining -= count;
+    }
+    
+    uint8_t kind = header.kind & ~(RECORD_NESTED | RECORD_TRUNCATED);
+    bool nested = header.kind & RECORD_NESTED;
+    bool truncated = header.kind & RECORD_TRUNCATED;
+    if (kind > RECORD_SEQUENCE || header.source >= COMMAND_SOURCE_COUNT) continue;
+    if (!haveFirst) {
+      firstTime = lastTime = header.time;
+      haveFirst = true;
+    }
+    
+    if (dump) {
+      String shown = payload;
+      if (kind == RECORD_QUEUE) shown = "+" + String(payload.length() >= 4 ? *(const uint32_t*)payload.c_str() : 0u) + "ms " + payload.substring(4);
+      shown.replace("\n", " | ");
+      fprintf(stderr, "%8lu ms %-8s %-8s%s%s %s\n", (unsigned long)(header.time - firstTime), SOURCE_NAMES[header.source],
+              KIND_NAMES[kind], nested ? " (nested)" : "", truncated ? " (truncated)" : "", shown.c_str());
+    }
+    
+    if (nested) {
+      nestedCount++;
+      continue;
+    }
+    
+    // Only part of the command was kept; issuing it would run something else entirely
+    if (truncated) {
+      fprintf(stderr, "Skipping truncated %s entry at %lu ms\n", KIND_NAMES[kind], (unsigned long)(header.time - firstTime));
+      truncatedCount++;
+      continue;
+    }
+    
+    // Arrival statistics over the top-level traffic
+    sourceCounts[header.source]++;
+    if (!show.empty()) {
+      uint32_t gap = header.time - lastTime;
+      minGap = min(minGap, gap);
+      maxGap = max(maxGap, gap);
+      burst = gap == 0 ? burst + 1 : 1;
+    } else {
+      burst = 1;
+    }
+    maxBurst = max(maxBurst, burst);
+    lastTime = header.time;
+    
+    ShowCommand entry = {header.time - firstTime, kind, header.source, 0, payload};
+    if (kind == RECORD_QUEUE) {
+      entry.delayMs = payload.length() >= 4 ? *(const uint32_t*)payload.c_str() : 0;
+      entry.command = payload.substring(4);
+    }
+    show.push_back(entry);
+  }
+  fclose(file);
+  
+  unsigned long span = lastTime - firstTime;
+  fprintf(stderr, "Recording: %lu entries (%lu top-level, %lu nested, %lu truncated), %lu dropped before capture, span %lu ms\n",
+          (unsigned long)fileHeader.entries, (unsigned long)show.size(), (unsigned long)nestedCount,
+          (unsigned long)truncatedCount, (unsigned long)fileHeader.dropped, span);
+  for (int s = 0; s < COMMAND_SOURCE_COUNT; s++) {
+    if (sourceCounts[s]) fprintf(stderr, "  %-8s %lu\n", SOURCE_NAMES[s], (unsigned long)sourceCounts[s]);
+  }
+  if (show.size() > 1) {
+    fprintf(stderr, "  rate %.2f/s, gap min %lu / avg %.1f / max %lu ms, largest same-millisecond burst %lu\n",
+            span > 0 ? (show.size() - 1) * 1000.0 / span : 0.0, (unsigned long)minGap, (double)span / (show.size() - 1),
+            (unsigned long)maxGap, (unsigned long)maxBurst);
+  }
+  return true;
+}
+
+static void issue(ServoController& controller, const ShowCommand& entry, unsigned long now) {
+  CommandRecorder::SourceScope source((CommandSource)entry.source);
+  String result;
+  
+  switch (entry.kind) {
+    case RECORD_EXECUTE:
+      result = controller.executeCommand(entry.command);
+      break;
+    case RECORD_QUEUE:
+      controller.queueCommand(entry.command, entry.delayMs);
+      break;
+    case RECORD_SEQUENCE: {
+      std::vector<String> commands;
+      int from = 0;
+      while (from <= (int)entry.command.length()) {
+        int end = entry.command.indexOf('\n', from);
+        if (end < 0) end = entry.command.length();
+        commands.push_back(entry.command.substring(from, end));
+        from = end + 1;
+      }
+      if (!controller.startCommandSequence(commands.data(), commands.size())) result = "Error: sequence rejected";
+      break;
+    }
+  }
+  
+  if (result.startsWith("Error")) {
+    fprintf(stderr, "%lu ms: %s -> %s\n", now, entry.command.c_str(), result.c_str());
+  }
+}
+
+static String readFile(const char* path) {
+  String content;
+  FILE* file = fopen(path, "r");
+  if (!file) return content;
+  char buffer[4096];
+  size_t count;
+  while ((count = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+    content.concat(buffer, count);
+  }
+  fclose(file);
+  return content;
+}
+
+static std::vector<TraceChange> parseTrace(const String& trace) {
+  std::vector<TraceChange> changes;
+  int from = trace.indexOf('\n') + 1;  // Skip the header
+  while (from > 0 && from < (int)trace.length()) {
+    int end = trace.indexOf('\n', from);
+    if (end < 0) end = trace.length();
+    TraceChange change;
+    if (sscanf(trace.substring(from, end).c_str(), "%lu,%d,%d,%f", &change.time, &change.board, &change.channel, &change.pulse) == 4 &&
+        change.board >= 0 && change.board < MAX_BOARDS && change.channel >= 0 && change.channel < SERVOS_PER_BOARD) {
+      changes.push_back(change);
+    }
+    from = end + 1;
+  }
+  return changes;
+}
+
+// Rebuilds both output states frame by frame and reports where they diverge
+static bool compareTraces(const String& actualTrace, const String& expectedTrace) {
+  std::vector<TraceChange> actual = parseTrace(actualTrace);
+  std::vector<TraceChange> expected = parseTrace(expectedTrace);
+  std::vector<float> actualState(MAX_BOARDS * SERVOS_PER_BOARD), expectedState(MAX_BOARDS * SERVOS_PER_BOARD);
+  
+  size_t a = 0, e = 0;
+  unsigned long frames = 0, divergent = 0;
+  float maxDifference = 0;
+  while (a < actual.size() || e < expected.size()) {
+    unsigned long time = a < actual.size() ? actual[a].time : ULONG_MAX;
+    if (e < expected.size()) time = min(time, expected[e].time);
+    for (; a < actual.size() && actual[a].time == time; a++) {
+      actualState[actual[a].board * SERVOS_PER_BOARD + actual[a].channel] = actual[a].pulse;
+    }
+    for (; e < expected.size() && expected[e].time == time; e++) {
+      expectedState[expected[e].board * SERVOS_PER_BOARD + expected[e].channel] = expected[e].pulse;
+    }
+    frames++;
+    
+    bool frameDiverges = false;
+    for (int i = 0; i < MAX_BOARDS * SERVOS_PER_BOARD; i++) {
+      float difference = fabsf(actualState[i] - expectedState[i]);
+      if (difference == 0) continue;
+      if (!divergent && !frameDiverges) {
+        fprintf(stderr, "First divergence at %lu ms: board %d channel %d expected %.1f us, got %.1f us\n",
+                time, i / SERVOS_PER_BOARD, i % SERVOS_PER_BOARD, expectedState[i], actualState[i]);
+      }
+      frameDiverges = true;
+      maxDifference = max(maxDifference, difference);
+    }
+    if (frameDiverges) divergent++;
+  }
+  
+  if (divergent) {
+    fprintf(stderr, "%lu of %lu changed frames diverge, largest difference %.1f us\n", divergent, frames, maxDifference);
+  } else {
+    fprintf(stderr, "All %lu changed frames match\n", frames);
+  }
+  return divergent == 0;
+}
+
+int main(int argc, char** argv) {
+  const char* showPath = nullptr;
+  const char* outputPath = nullptr;
+  const char* expectPath = nullptr;
+  const char* replayPath = nullptr;
+  const char* timelinePath = nullptr;
+  bool dump = false;
+  int boardCount = 2;
+  unsigned long tickMillis = 1;
+  unsigned long frameMillis = 20;  // One PWM period at SERVO_FREQ; servos see nothing finer
+  unsigned long duration = 0;
+  
+  for (int i = 1; i < argc; i++) {
+    String arg = argv[i];
+    if (arg == "--boards" && i + 1 < argc) {
+      boardCount = constrain(atoi(argv[++i]), 0, BOARD_ADDRESSES);
+    } else if (arg == "--tick-ms" && i + 1 < argc) {
+      tickMillis = constrain(atol(argv[++i]), 1L, 1000L);
+    } else if (arg == "--frame-ms" && i + 1 < argc) {
+      frameMillis = constrain(atol(argv[++i]), 1L, 1000L);
+    } else if (arg == "--duration" && i + 1 < argc) {
+      duration = atol(argv[++i]);
+    } else if (arg == "--fs" && i + 1 < argc) {
+      LittleFS.setRoot(argv[++i]);
+    } else if (arg == "--out" && i + 1 < argc) {
+      outputPath = argv[++i];
+    } else if (arg == "--expect" && i + 1 < argc) {
+      expectPath = argv[++i];
+    } else if (arg == "--replay" && i + 1 < argc) {
+      replayPath = argv[++i];
+    } else if (arg == "--timeline" && i + 1 < argc) {
+      timelinePath = argv[++i];
+    } else if (arg == "--dump") {
+      dump = true;
+    } else if (!showPath && !arg.startsWith("--")) {
+      showPath = argv[i];
+    } else {
+      showPath = nullptr;
+      break;
+    }
+  }
+  if (!showPath == !replayPath) {
+    fprintf(stderr, "Usage: %s (SHOW | --replay RECORDING [--dump]) [--boards N] [--tick-ms MS] [--frame-ms MS] "
+                    "[--duration MS] [--fs DIR] [--out TRACE] [--expect GOLDEN] [--timeline JSON]\n", argv[0]);
+    return 1;
+  }
+  
+  std::vector<ShowCommand> show;
+  if (showPath ? !readShow(showPath, show) : !readRecording(replayPath, show, dump)) {
+    fprintf(stderr, "Could not read %s\n", showPath ? showPath : replayPath);
+    return 1;
+  }
+  
+  VirtualClock clock;
+  Clock::install(&clock);
+  
+  std::vector<std::unique_ptr<VirtualPCA9685>> chips;
+  for (int b = 0; b < boardCount; b++) {
+    chips.emplace_back(new VirtualPCA9685(0x40 + b));
+  }
+  
+  Wire.begin();
+  LittleFS.begin(true);
+  
+  ServoController controller;
+  controller.scanForBoards();
+  controller.initializeBoards();
+  controller.loadConfiguration();
+  controller.applyInitialPositions();
+  controller.update();
+  
+  // Only changes made by the show are traced
+  std::vector<float> lastPulse(boardCount * VirtualPCA9685::CHANNELS);
+  for (int b = 0; b < boardCount; b++) {
+    for (int c = 0; c < VirtualPCA9685::CHANNELS; c++) {
+      lastPulse[b * VirtualPCA9685::CHANNELS + c] = chips[b]->pulseMicroseconds(c, PCA9685_OSC_FREQ);
+    }
+  }
+  
+  if (timelinePath) EventTrace::getInstance().setEnabled(true);
+  
+  String trace = "time_ms,board,channel,pulse_us\n";
+  size_t next = 0;
+  unsigned long frames = 0;
+  
+  for (unsigned long now = 0;; now += tickMillis) {
+    clock.setMillis(now);
+    
+    while (next < show.size() && show[next].at <= now) {
+      issue(controller, show[next++], now);
+    }
+    
+    controller.update();
+    if (now % frameMillis != 0) continue;
+    frames++;
+    
+    for (int b = 0; b < boardCount; b++) {
+      for (int c = 0; c < VirtualPCA9685::CHANNELS; c++) {
+        float pulse = chips[b]->pulseMicroseconds(c, PCA9685_OSC_FREQ);
+        float& last = lastPulse[b * VirtualPCA9685::CHANNELS + c];
+        if (pulse == last) continue;
+        last = pulse;
+        
+        char line[64];
+        snprintf(line, sizeof(line), "%lu,%d,%d,%.1f\n", now, b, c, pulse);
+        trace += line;
+      }
+    }
+    
+    if (duration > 0 ? now >= duration : (next >= show.size() && controller.isIdle())) break;
+    if (now >= MAX_SHOW_MILLIS) {
+      fprintf(stderr, "Show still running after %lu ms; stopping (use --duration)\n", MAX_SHOW_MILLIS);
+      break;
+    }
+  }
+  
+  fprintf(stderr, "Simulated %lu ms in %lu frames of %lu ms\n", clock.millis(), frames, frameMillis);
+  
+  if (outputPath) {
+    FILE* output = fopen(outputPath, "w");
+    if (!output) {
+      fprintf(stderr, "Could not open %s\n", outputPath);
+      return 1;
+    }
+    fwrite(trace.c_str(), 1, trace.length(), output);
+    fclose(output);
+  } else if (!expectPath) {
+    fwrite(trace.c_str(), 1, trace.length(), stdout);
+  }
+  
+  if (timelinePath) {
+    FILE* timeline = fopen(timelinePath, "w");
+    if (!timeline) {
+      fprintf(stderr, "Could not open %s\n", timelinePath);
+      return 1;
+    }
+    TraceJsonStream stream;
+    uint8_t buffer[512];
+    size_t count;
+    while ((count = stream.read(buffer, sizeof(buffer))) > 0) {
+      fwrite(buffer, 1, count, timeline);
+    }
+    fclose(timeline);
+  }
+  
+  if (expectPath && !compareTraces(trace, readFile(expectPath))) return 1;
+  return 0;
+}
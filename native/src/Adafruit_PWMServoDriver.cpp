@@ -0,0 +1,118 @@
+#include "Adafruit_PWMServoDriver.h"
+
+bool Adafruit_PWMServoDriver::begin(uint8_t prescale) {
+  reset();
+  if (prescale) {
+    setExtClk(prescale);
+  } else {
+    setPWMFreq(1000);
+  }
+  setOscillatorFrequency(FREQUENCY_OSCILLATOR);
+  return true;
+}
+
+void Adafruit_PWMServoDriver::reset() {
+  write8(PCA9685_MODE1, MODE1_RESTART);
+  delay(10);
+}
+
+void Adafruit_PWMServoDriver::sleep() {
+  write8(PCA9685_MODE1, read8(PCA9685_MODE1) | MODE1_SLEEP);
+  delay(5);
+}
+
+void Adafruit_PWMServoDriver::wakeup() {
+  write8(PCA9685_MODE1, read8(PCA9685_MODE1) & ~MODE1_SLEEP);
+}
+
+void Adafruit_PWMServoDriver::setExtClk(uint8_t prescale) {
+  uint8_t oldMode = read8(PCA9685_MODE1);
+  uint8_t newMode = (oldMode & ~MODE1_RESTART) | MODE1_SLEEP;
+  write8(PCA9685_MODE1, newMode);
+  write8(PCA9685_MODE1, (newMode |= MODE1_EXTCLK));
+  write8(PCA9685_PRESCALE, prescale);
+  delay(5);
+  write8(PCA9685_MODE1, (newMode & ~MODE1_SLEEP) | MODE1_RESTART | MODE1_AI);
+}
+
+void Adafruit_PWMServoDriver::setPWMFreq(float frequency) {
+  if (frequency < 1) frequency = 1;
+  if (frequency > 3500) frequency = 3500;
+  
+  float prescaleValue = ((oscillatorFrequency / (frequency * 4096.0)) + 0.5) - 1;
+  if (prescaleValue < PCA9685_PRESCALE_MIN) prescaleValue = PCA9685_PRESCALE_MIN;
+  if (prescaleValue > PCA9685_PRESCALE_MAX) prescaleValue = PCA9685_PRESCALE_MAX;
+  uint8_t prescale = (uint8_t)prescaleValue;
+  
+  // PRESCALE only accepts writes while the oscillator sleeps
+  uint8_t oldMode = read8(PCA9685_MODE1);
+  write8(PCA9685_MODE1, (oldMode & ~MODE1_RESTART) | MODE1_SLEEP);
+  write8(PCA9685_PRESCALE, prescale);
+  write8(PCA9685_MODE1, oldMode);
+  delay(5);
+  write8(PCA9685_MODE1, oldMode | MODE1_RESTART | MODE1_AI);
+}
+
+void Adafruit_PWMServoDriver::setOutputMode(bool totempole) {
+  uint8_t mode = read8(PCA9685_MODE2);
+  write8(PCA9685_MODE2, totempole ? (mode | MODE2_OUTDRV) : (mode & ~MODE2_OUTDRV));
+}
+
+uint8_t Adafruit_PWMServoDriver::getPWM(uint8_t num, bool off) {
+  return read8(PCA9685_LED0_ON_L + 4 * num + (off ? 2 : 0));
+}
+
+uint8_t Adafruit_PWMServoDriver::setPWM(uint8_t num, uint16_t on, uint16_t off) {
+  i2c->beginTransmission(address);
+  i2c->write(PCA9685_LED0_ON_L + 4 * num);
+  i2c->write(on & 0xFF);
+  i2c->write(on >> 8);
+  i2c->write(off & 0xFF);
+  i2c->write(off >> 8);
+  return i2c->endTransmission();
+}
+
+void Adafruit_PWMServoDriver::setPin(uint8_t num, uint16_t value, bool invert) {
+  value = std::min(value, (uint16_t)4095);
+  if (invert) {
+    if (value == 0) {
+      setPWM(num, 4096, 0);
+    } else if (value == 4095) {
+      setPWM(num, 0, 4096);
+    } else {
+      setPWM(num, 0, 4095 - value);
+    }
+  } else {
+    if (value == 4095) {
+      setPWM(num, 4096, 0);
+    } else if (value == 0) {
+      setPWM(num, 0, 4096);
+    } else {
+      setPWM(num, 0, value);
+    }
+  }
+}
+
+uint8_t Adafruit_PWMServoDriver::readPrescale() {
+  return read8(PCA9685_PRESCALE);
+}
+
+void Adafruit_PWMServoDriver::writeMicroseconds(uint8_t num, uint16_t microseconds) {
+  double pulseLength = 1000000.0 * (readPrescale() + 1) / oscillatorFrequency;
+  setPWM(num, 0, (uint16_t)(microseconds / pulseLength));
+}
+
+uint8_t Adafruit_PWMServoDriver::read8(uint8_t reg) {
+  i2c->beginTransmission(address);
+  i2c->write(reg);
+  i2c->endTransmission();
+  i2c->requestFrom(address, (uint8_t)1);
+  return (uint8_t)i2c->read();
+}
+
+void Adafruit_PWMServoDriver::write8(uint8_t reg, uint8_t value) {
+  i2c->beginTransmission(address);
+  i2c->write(reg);
+  i2c->write(value);
+  i2c->endTransmission();
+}
@@ -0,0 +1,296 @@
+#include "Arduino.h"
+#include <chrono>
+#include <thread>
+#include <random>
+#include <malloc.h>
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/ioctl.h>
+#include <termios.h>
+#include <unistd.h>
+
+HardwareSerial Serial;
+EspClass ESP;
+
+// ---------------------------------------------------------------------------------------
+// String
+// ---------------------------------------------------------------------------------------
+
+static std::string formatInteger(unsigned long long number, bool negative, unsigned char base) {
+  if (base < 2 || base > 36) base = 10;
+  std::string digits;
+  do {
+    int digit = number % base;
+    digits += (char)(digit < 10 ? '0' + digit : 'a' + digit - 10);
+    number /= base;
+  } while (number > 0);
+  if (negative) digits += '-';
+  return std::string(digits.rbegin(), digits.rend());
+}
+
+static std::string formatSigned(long long number, unsigned char base) {
+  // Like the Arduino core, only base 10 prints a sign
+  if (base == 10 && number < 0) return formatInteger(0ULL - (unsigned long long)number, true, base);
+  return formatInteger((unsigned long long)number, false, base);
+}
+
+String::String(unsigned char number, unsigned char base) : value(formatInteger(number, false, base)) {}
+String::String(int number, unsigned char base) : value(formatSigned(number, base)) {}
+String::String(unsigned int number, unsigned char base) : value(formatInteger(number, false, base)) {}
+String::String(long number, unsigned char base) : value(formatSigned(number, base)) {}
+String::String(unsigned long number, unsigned char base) : value(formatInteger(number, false, base)) {}
+String::String(long long number, unsigned char base) : value(formatSigned(number, base)) {}
+String::String(unsigned long long number, unsigned char base) : value(formatInteger(number, false, base)) {}
+
+String::String(float number, unsigned int decimals) : String((double)number, decimals) {}
+
+String::String(double number, unsigned int decimals) {
+  char buffer[64];
+  snprintf(buffer, sizeof(buffer), "%.*f", (int)decimals, number);
+  value = buffer;
+}
+
+bool String::equalsIgnoreCase(const String& other) const {
+  if (value.length() != other.value.length()) return false;
+  for (size_t i = 0; i < value.length(); i++) {
+    if (tolower((unsigned char)value[i]) != tolower((unsigned char)other.value[i])) return false;
+  }
+  return true;
+}
+
+bool String::endsWith(const String& suffix) const {
+  return value.length() >= suffix.value.length() &&
+         value.compare(value.length() - suffix.value.length(), suffix.value.length(), suffix.value) == 0;
+}
+
+String String::substring(unsigned int from, unsigned int to) const {
+  if (from > to) std::swap(from, to);
+  if (from >= value.length()) return String();
+  if (to > value.length()) to = value.length();
+  return String(value.substr(from, to - from).c_str());
+}
+
+void String::trim() {
+  size_t first = value.find_first_not_of(" \t\r\n\f\v");
+  if (first == std::string::npos) {
+    value.clear();
+    return;
+  }
+  size_t last = value.find_last_not_of(" \t\r\n\f\v");
+  value = value.substr(first, last - first + 1);
+}
+
+void String::toLowerCase() {
+  for (char& c : value) c = tolower((unsigned char)c);
+}
+
+void String::toUpperCase() {
+  for (char& c : value) c = toupper((unsigned char)c);
+}
+
+void String::replace(char find, char with) {
+  std::replace(value.begin(), value.end(), find, with);
+}
+
+void String::replace(const String& find, const String& with) {
+  if (find.value.empty()) return;
+  size_t pos = 0;
+  while ((pos = value.find(find.value, pos)) != std::string::npos) {
+    value.replace(pos, find.value.length(), with.value);
+    pos += with.value.length();
+  }
+}
+
+void String::toCharArray(char* buffer, unsigned int size) const {
+  if (size == 0) return;
+  size_t count = std::min((size_t)size - 1, value.length());
+  memcpy(buffer, value.c_str(), count);
+  buffer[count] = '\0';
+}
+
+// ---------------------------------------------------------------------------------------
+// Print / Stream
+// ---------------------------------------------------------------------------------------
+
+size_t Print::write(const uint8_t* buffer, size_t size) {
+  size_t written = 0;
+  while (size--) {
+    if (!write(*buffer++)) break;
+    written++;
+  }
+  return written;
+}
+
+size_t Print::printf(const char* format, ...) {
+  char buffer[512];
+  va_list args;
+  va_start(args, format);
+  int length = vsnprintf(buffer, sizeof(buffer), format, args);
+  va_end(args);
+  if (length < 0) return 0;
+  return write((const uint8_t*)buffer, std::min((size_t)length, sizeof(buffer) - 1));
+}
+
+size_t Stream::readBytes(char* buffer, size_t length) {
+  size_t count = 0;
+  while (count < length) {
+    int c = read();
+    if (c < 0) break;
+    buffer[count++] = (char)c;
+  }
+  return count;
+}
+
+HardwareSerial::~HardwareSerial() {
+  if (fd >= 0) close(fd);
+}
+
+bool HardwareSerial::open(const char* path) {
+  fd = ::open(path, O_RDWR | O_NOCTTY | O_NONBLOCK);
+  if (fd < 0) return false;
+  
+  // Bytes pass through untouched, as on a UART
+  termios mode;
+  if (tcgetattr(fd, &mode) == 0) {
+    cfmakeraw(&mode);
+    tcsetattr(fd, TCSANOW, &mode);
+  }
+  return true;
+}
+
+int HardwareSerial::available() {
+  int count = 0;
+  if (fd < 0 || ioctl(fd, FIONREAD, &count) < 0) return 0;
+  return count;
+}
+
+int HardwareSerial::read() {
+  uint8_t c;
+  return read(&c, 1) == 1 ? c : -1;
+}
+
+size_t HardwareSerial::read(uint8_t* buffer, size_t size) {
+  if (fd < 0) return 0;
+  ssize_t count = ::read(fd, buffer, size);
+  return count > 0 ? count : 0;
+}
+
+size_t HardwareSerial::write(const uint8_t* buffer, size_t size) {
+  if (fd < 0) return fwrite(buffer, 1, size, stdout);
+  
+  // Like the UART driver, block until the bytes are queued
+  size_t written = 0;
+  while (written < size) {
+    ssize_t count = ::write(fd, buffer + written, size - written);
+    if (count > 0) {
+      written += count;
+    } else if (count < 0 && errno != EAGAIN) {
+      break;
+    } else {
+      std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+  }
+  return written;
+}
+
+void HardwareSerial::flush() {
+  if (fd < 0) {
+    fflush(stdout);
+  } else {
+    tcdrain(fd);
+  }
+}
+
+// ---------------------------------------------------------------------------------------
+// Time, randomness and heap
+// ---------------------------------------------------------------------------------------
+
+static const auto startTime = std::chrono::steady_clock::now();
+
+unsigned long millis() {
+  return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - startTime).count();
+}
+
+unsigned long micros() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - startTime).count();
+}
+
+void delay(unsigned long ms) {
+  std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+void delayMicroseconds(unsigned int us) {
+  std::this_thread::sleep_for(std::chrono::microseconds(us));
+}
+
+void yield() {
+  std::this_thread::yield();
+}
+
+static std::mt19937& randomEngine() {
+  static std::mt19937 engine(std::random_device{}());
+  return engine;
+}
+
+uint32_t esp_random() {
+  return randomEngine()();
+}
+
+long random(long max) {
+  return max > 0 ? (long)(randomEngine()() % (unsigned long)max) : 0;
+}
+
+long random(long min, long max) {
+  return max > min ? min + random(max - min) : min;
+}
+
+// The host heap has no fixed size; report what glibc holds so trends are still visible
+uint32_t EspClass::getFreeHeap() {
+  return (uint32_t)mallinfo2().fordblks;
+}
+
+uint32_t EspClass::getMinFreeHeap() {
+  return getFreeHeap();
+}
+
+uint32_t EspClass::getMaxAllocHeap() {
+  return getFreeHeap();
+}
+
+uint32_t EspClass::getHeapSize() {
+  struct mallinfo2 info = mallinfo2();
+  return (uint32_t)(info.arena + info.hblkhd);
+}
+
+uint32_t EspClass::getCycleCount() {
+  auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - startTime);
+  return (uint32_t)((uint64_t)elapsed.count() * getCpuFreqMHz() / 1000);
+}
+
+void EspClass::restart() {
+  fflush(stdout);
+  exit(0);
+}
+
+// ---------------------------------------------------------------------------------------
+// FreeRTOS
+// ---------------------------------------------------------------------------------------
+
+BaseType_t xTaskCreatePinnedToCore(void (*task)(void*), const char* name, uint32_t stackDepth, void* parameter,
+                                   unsigned priority, TaskHandle_t* handle, int core) {
+  if (handle) *handle = nullptr;
+  return pdFAIL;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clearOnExit, TickType_t ticksToWait) {
+  delay(ticksToWait);
+  return 0;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task) {
+  return pdPASS;
+}
+
+void vTaskDelay(TickType_t ticks) {
+  delay(ticks);
+}
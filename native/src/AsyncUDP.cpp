@@ -0,0 +1,102 @@
+#include "AsyncUDP.h"
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <vector>
+
+String IPAddress::toString() const {
+  char text[16];
+  snprintf(text, sizeof(text), "%u.%u.%u.%u", octets[0], octets[1], octets[2], octets[3]);
+  return String(text);
+}
+
+bool AsyncUDP::open(uint16_t port) {
+  close();
+  
+  int fd = socket(AF_INET, SOCK_DGRAM, 0);
+  if (fd < 0) return false;
+  
+  // Several receivers may share a port, as the sACN unicast and multicast sockets do
+  int reuse = 1;
+  setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+  setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &reuse, sizeof(reuse));
+  
+  sockaddr_in address = {};
+  address.sin_family = AF_INET;
+  address.sin_addr.s_addr = htonl(INADDR_ANY);
+  address.sin_port = htons(port);
+  if (bind(fd, (sockaddr*)&address, sizeof(address)) < 0) {
+    ::close(fd);
+    return false;
+  }
+  
+  socketFd = fd;
+  multicast = false;
+  return true;
+}
+
+bool AsyncUDP::listen(uint16_t port) {
+  if (!open(port)) return false;
+  startReceiver();
+  return true;
+}
+
+bool AsyncUDP::listenMulticast(const IPAddress& group, uint16_t port, uint8_t ttl) {
+  if (!group.isMulticast() || !open(port)) return false;
+  
+  ip_mreq membership = {};
+  membership.imr_multiaddr.s_addr = htonl(((uint32_t)group[0] << 24) | (group[1] << 16) | (group[2] << 8) | group[3]);
+  membership.imr_interface.s_addr = htonl(INADDR_ANY);
+  if (setsockopt(socketFd, IPPROTO_IP, IP_ADD_MEMBERSHIP, &membership, sizeof(membership)) < 0) {
+    close();
+    return false;
+  }
+  
+  multicast = true;
+  startReceiver();
+  return true;
+}
+
+void AsyncUDP::onPacket(AuPacketHandlerFunction callback) {
+  // Set before the thread exists, so it never reads the callback while it changes
+  if (running) return;
+  handler = callback;
+  startReceiver();
+}
+
+void AsyncUDP::startReceiver() {
+  if (running || socketFd < 0 || !handler) return;
+  running = true;
+  receiver = std::thread(&AsyncUDP::receiveLoop, this);
+}
+
+void AsyncUDP::close() {
+  running = false;
+  if (receiver.joinable()) receiver.join();
+  if (socketFd >= 0) {
+    ::close(socketFd);
+    socketFd = -1;
+  }
+}
+
+void AsyncUDP::receiveLoop() {
+  std::vector<uint8_t> buffer(65536);
+  pollfd readable = {socketFd, POLLIN, 0};
+  
+  while (running) {
+    // Wakes periodically so close() is noticed
+    if (poll(&readable, 1, 100) <= 0) continue;
+    
+    sockaddr_in source = {};
+    socklen_t sourceLength = sizeof(source);
+    ssize_t length = recvfrom(socketFd, buffer.data(), buffer.size(), 0, (sockaddr*)&source, &sourceLength);
+    if (length < 0) continue;
+    
+    uint32_t remote = ntohl(source.sin_addr.s_addr);
+    IPAddress remoteIP(remote >> 24, remote >> 16, remote >> 8, remote);
+    AsyncUDPPacket packet(buffer.data(), length, remoteIP, ntohs(source.sin_port), multicast);
+    handler(packet);
+  }
+}
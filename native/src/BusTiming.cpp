@@ -0,0 +1,40 @@
+#include "BusTiming.h"
+
+void BusTiming::beginFrame() {
+  frameStartBusy = bus.getStats().busyMicros;
+  frameStartTransactions = bus.getStats().transactions;
+}
+
+void BusTiming::endFrame(double intervalMicros) {
+  if (bus.getStats().transactions == frameStartTransactions) return;
+  
+  double busy = bus.getStats().busyMicros - frameStartBusy;
+  double utilization = intervalMicros > 0 ? busy / intervalMicros : 1;
+  
+  frames++;
+  if (busy > intervalMicros) overruns++;
+  lastBusyMicros = busy;
+  totalBusyMicros += busy;
+  totalUtilization += utilization;
+  if (busy > maxBusyMicros) maxBusyMicros = busy;
+  if (utilization > maxUtilization) maxUtilization = utilization;
+}
+
+void BusTiming::reset() {
+  frames = 0;
+  overruns = 0;
+  lastBusyMicros = 0;
+  totalBusyMicros = 0;
+  maxBusyMicros = 0;
+  totalUtilization = 0;
+  maxUtilization = 0;
+}
+
+double BusTiming::fullFrameMicros(int boards, uint32_t clock, double overheadMicros) {
+  // Register pointer byte followed by four bytes per channel
+  return boards * TwoWire::transactionMicros(1 + CHANNELS_PER_BOARD * CHANNEL_BYTES, clock, overheadMicros);
+}
+
+double BusTiming::unbatchedFrameMicros(int boards, uint32_t clock, double overheadMicros) {
+  return boards * CHANNELS_PER_BOARD * TwoWire::transactionMicros(1 + CHANNEL_BYTES, clock, overheadMicros);
+}
@@ -0,0 +1,614 @@
+#include "ESPAsyncWebServer.h"
+#include <errno.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+uint16_t AsyncWebServer::portOverride = 0;
+
+// ---------------------------------------------------------------------------------------
+// Responses
+// ---------------------------------------------------------------------------------------
+
+static const char* statusText(int code) {
+  switch (code) {
+    case 200: return "OK";
+    case 204: return "No Content";
+    case 304: return "Not Modified";
+    case 400: return "Bad Request";
+    case 404: return "Not Found";
+    case 409: return "Conflict";
+    case 413: return "Payload Too Large";
+    case 431: return "Request Header Fields Too Large";
+    case 500: return "Internal Server Error";
+    case 501: return "Not Implemented";
+    case 503: return "Service Unavailable";
+    default: return "";
+  }
+}
+
+static String contentTypeFor(const String& path) {
+  String name = path.endsWith(".gz") ? path.substring(0, path.length() - 3) : path;
+  if (name.endsWith(".html") || name.endsWith(".htm")) return "text/html";
+  if (name.endsWith(".css")) return "text/css";
+  if (name.endsWith(".js")) return "application/javascript";
+  if (name.endsWith(".json")) return "application/json";
+  if (name.endsWith(".png")) return "image/png";
+  if (name.endsWith(".svg")) return "image/svg+xml";
+  if (name.endsWith(".ico")) return "image/x-icon";
+  if (name.endsWith(".txt")) return "text/plain";
+  return "application/octet-stream";
+}
+
+std::string AsyncWebServerResponse::head() const {
+  std::string text = "HTTP/1.1 " + std::to_string(code) + " " + statusText(code) + "\r\n";
+  if (contentType.length() > 0) {
+    text += std::string("Content-Type: ") + contentType.c_str() + "\r\n";
+  }
+  if (isChunked()) {
+    text += "Transfer-Encoding: chunked\r\n";
+  } else {
+    text += "Content-Length: " + std::to_string(contentLength) + "\r\n";
+  }
+  for (const AsyncWebHeader& header : headers) {
+    text += std::string(header.name().c_str()) + ": " + header.value().c_str() + "\r\n";
+  }
+  text += "Connection: close\r\n\r\n";
+  return text;
+}
+
+class BasicResponse : public AsyncWebServerResponse {
+public:
+  BasicResponse(int code, const String& contentType, const String& content)
+    : AsyncWebServerResponse(code, contentType), content(content.c_str()) {
+    contentLength = this->content.size();
+  }
+  
+  size_t fill(uint8_t* buffer, size_t maxLen, size_t index) override {
+    if (index >= content.size()) return 0;
+    size_t length = std::min(maxLen, content.size() - index);
+    memcpy(buffer, content.data() + index, length);
+    return length;
+  }
+
+private:
+  std::string content;
+};
+
+// beginResponse with a length, or beginChunkedResponse when length is -1
+class CallbackResponse : public AsyncWebServerResponse {
+public:
+  CallbackResponse(const String& contentType, long length, AwsResponseFiller callback)
+    : AsyncWebServerResponse(200, contentType), callback(callback) {
+    contentLength = length;
+  }
+  
+  size_t fill(uint8_t* buffer, size_t maxLen, size_t index) override {
+    if (!isChunked()) {
+      if (index >= (size_t)contentLength) return 0;
+      maxLen = std::min(maxLen, (size_t)contentLength - index);
+    }
+    return callback(buffer, maxLen, index);
+  }
+
+private:
+  AwsResponseFiller callback;
+};
+
+class FileResponse : public AsyncWebServerResponse {
+public:
+  FileResponse(fs::FS& fs, const String& path, const String& contentType, bool download)
+    : AsyncWebServerResponse(200, contentType.length() > 0 ? contentType : contentTypeFor(path)) {
+    // Like the device, a missing file is served from its gzipped copy
+    String name = path;
+    if (!fs.exists(path) && fs.exists(path + ".gz")) {
+      name = path + ".gz";
+      addHeader("Content-Encoding", "gzip");
+    }
+    file = fs.open(name, "r");
+    if (file && !file.isDirectory()) {
+      contentLength = file.size();
+    } else {
+      file = File();
+    }
+    
+    if (download) {
+      int slash = path.lastIndexOf('/');
+      addHeader("Content-Disposition", "attachment; filename=\"" + path.substring(slash + 1) + "\"");
+    }
+  }
+  
+  bool sourceValid() const override { return (bool)file; }
+  
+  size_t fill(uint8_t* buffer, size_t maxLen, size_t index) override {
+    return file.read(buffer, maxLen);
+  }
+
+private:
+  File file;
+};
+
+AsyncResponseStream::AsyncResponseStream(const String& contentType, size_t bufferSize)
+  : AsyncWebServerResponse(200, contentType) {
+  content.reserve(bufferSize);
+}
+
+size_t AsyncResponseStream::write(uint8_t data) {
+  content += (char)data;
+  contentLength = content.size();
+  return 1;
+}
+
+size_t AsyncResponseStream::write(const uint8_t* data, size_t length) {
+  content.append((const char*)data, length);
+  contentLength = content.size();
+  return length;
+}
+
+size_t AsyncResponseStream::fill(uint8_t* buffer, size_t maxLen, size_t index) {
+  if (index >= content.size()) return 0;
+  size_t length = std::min(maxLen, content.size() - index);
+  memcpy(buffer, content.data() + index, length);
+  return length;
+}
+
+// ---------------------------------------------------------------------------------------
+// Requests
+// ---------------------------------------------------------------------------------------
+
+static String urlDecode(const std::string& text) {
+  std::string decoded;
+  for (size_t i = 0; i < text.size(); i++) {
+    if (text[i] == '+') {
+      decoded += ' ';
+    } else if (text[i] == '%' && i + 2 < text.size() && isxdigit((unsigned char)text[i + 1]) && isxdigit((unsigned char)text[i + 2])) {
+      decoded += (char)strtol(text.substr(i + 1, 2).c_str(), nullptr, 16);
+      i += 2;
+    } else {
+      decoded += text[i];
+    }
+  }
+  return String(decoded.c_str());
+}
+
+static WebRequestMethodComposite parseMethod(const std::string& name) {
+  if (name == "GET") return HTTP_GET;
+  if (name == "POST") return HTTP_POST;
+  if (name == "DELETE") return HTTP_DELETE;
+  if (name == "PUT") return HTTP_PUT;
+  if (name == "PATCH") return HTTP_PATCH;
+  if (name == "HEAD") return HTTP_HEAD;
+  if (name == "OPTIONS") return HTTP_OPTIONS;
+  return 0;
+}
+
+AsyncWebServerRequest::AsyncWebServerRequest(AsyncWebServer* server, int clientFd) : server(server), clientFd(clientFd) {}
+
+AsyncWebServerRequest::~AsyncWebServerRequest() {
+  // As in the library: whatever a handler left here is released with the request
+  free(_tempObject);
+}
+
+const char* AsyncWebServerRequest::methodToString() const {
+  switch (requestMethod) {
+    case HTTP_GET: return "GET";
+    case HTTP_POST: return "POST";
+    case HTTP_DELETE: return "DELETE";
+    case HTTP_PUT: return "PUT";
+    case HTTP_PATCH: return "PATCH";
+    case HTTP_HEAD: return "HEAD";
+    case HTTP_OPTIONS: return "OPTIONS";
+    default: return "UNKNOWN";
+  }
+}
+
+bool AsyncWebServerRequest::parseHead(size_t headLength) {
+  std::string head = input.substr(0, headLength);
+  size_t lineEnd = head.find("\r\n");
+  std::string requestLine = head.substr(0, lineEnd);
+  
+  // METHOD SP target SP version
+  size_t firstSpace = requestLine.find(' ');
+  size_t secondSpace = requestLine.find(' ', firstSpace + 1);
+  if (firstSpace == std::string::npos || secondSpace == std::string::npos) return false;
+  requestMethod = parseMethod(requestLine.substr(0, firstSpace));
+  
+  std::string target = requestLine.substr(firstSpace + 1, secondSpace - firstSpace - 1);
+  size_t query = target.find('?');
+  requestUrl = urlDecode(target.substr(0, query));
+  if (query != std::string::npos) addParameters(String(target.substr(query + 1).c_str()));
+  
+  while (lineEnd != std::string::npos && lineEnd < head.size()) {
+    size_t start = lineEnd + 2;
+    lineEnd = head.find("\r\n", start);
+    std::string line = head.substr(start, lineEnd == std::string::npos ? std::string::npos : lineEnd - start);
+    size_t colon = line.find(':');
+    if (colon == std::string::npos) continue;
+    
+    String name = line.substr(0, colon).c_str();
+    String value = line.substr(colon + 1).c_str();
+    value.trim();
+    if (name.equalsIgnoreCase("Content-Length")) {
+      bodyLength = strtoul(value.c_str(), nullptr, 10);
+    }
+    requestHeaders.emplace_back(new AsyncWebHeader(name, value));
+  }
+  return true;
+}
+
+void AsyncWebServerRequest::addParameters(const String& query) {
+  std::string text = query.c_str();
+  size_t start = 0;
+  while (start <= text.size()) {
+    size_t end = text.find('&', start);
+    if (end == std::string::npos) end = text.size();
+    std::string pair = text.substr(start, end - start);
+    if (!pair.empty()) {
+      size_t equals = pair.find('=');
+      String name = urlDecode(pair.substr(0, equals));
+      String value = equals == std::string::npos ? String() : urlDecode(pair.substr(equals + 1));
+      parameters.emplace_back(new AsyncWebParameter(name, value));
+    }
+    start = end + 1;
+  }
+}
+
+bool AsyncWebServerRequest::hasParam(const String& name, bool post, bool file) const {
+  return getParam(name, post, file) != nullptr;
+}
+
+AsyncWebParameter* AsyncWebServerRequest::getParam(const String& name, bool post, bool file) const {
+  if (post || file) return nullptr;
+  for (const auto& parameter : parameters) {
+    if (parameter->name() == name) return parameter.get();
+  }
+  return nullptr;
+}
+
+bool AsyncWebServerRequest::hasHeader(const String& name) const {
+  return getHeader(name) != nullptr;
+}
+
+AsyncWebHeader* AsyncWebServerRequest::getHeader(const String& name) const {
+  for (const auto& header : requestHeaders) {
+    if (header->name().equalsIgnoreCase(name)) return header.get();
+  }
+  return nullptr;
+}
+
+String AsyncWebServerRequest::header(const char* name) const {
+  AsyncWebHeader* found = getHeader(name);
+  return found ? found->value() : String();
+}
+
+void AsyncWebServerRequest::send(int code, const String& contentType, const String& content) {
+  send(beginResponse(code, contentType, content));
+}
+
+void AsyncWebServerRequest::send(AsyncWebServerResponse* sent) {
+  // Only the first response counts, as on the device
+  if (response) {
+    delete sent;
+    return;
+  }
+  if (!sent->sourceValid()) {
+    delete sent;
+    sent = beginResponse(500);
+  }
+  
+  response.reset(sent);
+  output = response->head();
+  outputSent = 0;
+  bodyIndex = 0;
+  bodyDone = false;
+}
+
+AsyncWebServerResponse* AsyncWebServerRequest::beginResponse(int code, const String& contentType, const String& content) {
+  return new BasicResponse(code, contentType, content);
+}
+
+AsyncWebServerResponse* AsyncWebServerRequest::beginResponse(fs::FS& fs, const String& path, const String& contentType, bool download) {
+  return new FileResponse(fs, path, contentType, download);
+}
+
+AsyncWebServerResponse* AsyncWebServerRequest::beginResponse(const String& contentType, size_t length, AwsResponseFiller callback) {
+  return new CallbackResponse(contentType, (long)length, callback);
+}
+
+AsyncWebServerResponse* AsyncWebServerRequest::beginChunkedResponse(const String& contentType, AwsResponseFiller callback) {
+  return new CallbackResponse(contentType, -1, callback);
+}
+
+AsyncResponseStream* AsyncWebServerRequest::beginResponseStream(const String& contentType, size_t bufferSize) {
+  return new AsyncResponseStream(contentType, bufferSize);
+}
+
+// ---------------------------------------------------------------------------------------
+// Handlers
+// ---------------------------------------------------------------------------------------
+
+bool AsyncCallbackWebHandler::canHandle(AsyncWebServerRequest* request) {
+  if (!(request->method() & method)) return false;
+  return request->url() == uri || request->url().startsWith(uri + "/");
+}
+
+void AsyncCallbackWebHandler::handleRequest(AsyncWebServerRequest* request) {
+  if (requestCallback) {
+    requestCallback(request);
+  } else {
+    request->send(500);
+  }
+}
+
+void AsyncCallbackWebHandler::handleBody(AsyncWebServerRequest* request, uint8_t* data, size_t len, size_t index, size_t total) {
+  if (bodyCallback) bodyCallback(request, data, len, index, total);
+}
+
+AsyncStaticWebHandler::AsyncStaticWebHandler(const char* uri, fs::FS& fs, const char* path, const char* cacheControl)
+  : uri(uri), fs(fs), path(path), cacheControl(cacheControl ? cacheControl : "") {}
+
+String AsyncStaticWebHandler::filePath(const String& url) const {
+  String file = path + url.substring(uri.length());
+  if (file.endsWith("/")) {
+    file += defaultFile;
+  } else if (fs.exists(file) && fs.open(file).isDirectory()) {
+    file += "/" + defaultFile;
+  }
+  return file;
+}
+
+bool AsyncStaticWebHandler::canHandle(AsyncWebServerRequest* request) {
+  if (!(request->method() & HTTP_GET) || !request->url().startsWith(uri)) return false;
+  // The filesystem is a host directory; nothing may climb out of it
+  if (request->url().indexOf("..") >= 0) return false;
+  
+  String file = filePath(request->url());
+  return (fs.exists(file) && !fs.open(file).isDirectory()) || fs.exists(file + ".gz");
+}
+
+void AsyncStaticWebHandler::handleRequest(AsyncWebServerRequest* request) {
+  AsyncWebServerResponse* response = request->beginResponse(fs, filePath(request->url()));
+  if (cacheControl.length() > 0) {
+    response->addHeader("Cache-Control", cacheControl);
+  }
+  request->send(response);
+}
+
+bool AsyncWebSocket::canHandle(AsyncWebServerRequest* request) {
+  return request->method() == HTTP_GET && request->url() == url && request->hasHeader("Upgrade");
+}
+
+void AsyncWebSocket::handleRequest(AsyncWebServerRequest* request) {
+  request->send(501, "text/plain", "WebSocket is not supported by the host server");
+}
+
+// ---------------------------------------------------------------------------------------
+// Server
+// ---------------------------------------------------------------------------------------
+
+AsyncWebServer::AsyncWebServer(uint16_t port) : port(portOverride ? portOverride : port) {}
+
+AsyncWebServer::~AsyncWebServer() {
+  end();
+}
+
+AsyncCallbackWebHandler& AsyncWebServer::on(const char* uri, WebRequestMethodComposite method, ArRequestHandlerFunction onRequest) {
+  AsyncCallbackWebHandler* handler = new AsyncCallbackWebHandler(uri, method);
+  handler->onRequest(onRequest);
+  ownedHandlers.emplace_back(handler);
+  addHandler(handler);
+  return *handler;
+}
+
+AsyncCallbackWebHandler& AsyncWebServer::on(const char* uri, WebRequestMethodComposite method, ArRequestHandlerFunction onRequest,
+                                            ArUploadHandlerFunction onUpload, ArBodyHandlerFunction onBody) {
+  AsyncCallbackWebHandler& handler = on(uri, method, onRequest);
+  handler.onUpload(onUpload);
+  handler.onBody(onBody);
+  return handler;
+}
+
+AsyncStaticWebHandler& AsyncWebServer::serveStatic(const char* uri, fs::FS& fs, const char* path, const char* cacheControl) {
+  AsyncStaticWebHandler* handler = new AsyncStaticWebHandler(uri, fs, path, cacheControl);
+  ownedHandlers.emplace_back(handler);
+  addHandler(handler);
+  return *handler;
+}
+
+AsyncWebHandler& AsyncWebServer::addHandler(AsyncWebHandler* handler) {
+  handlers.push_back(handler);
+  return *handler;
+}
+
+void AsyncWebServer::begin() {
+  if (running) return;
+  
+  listenFd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+  int reuse = 1;
+  setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+  
+  sockaddr_in address = {};
+  address.sin_family = AF_INET;
+  address.sin_addr.s_addr = htonl(INADDR_ANY);
+  address.sin_port = htons(port);
+  if (listenFd < 0 || bind(listenFd, (sockaddr*)&address, sizeof(address)) < 0 || listen(listenFd, 64) < 0) {
+    fprintf(stderr, "Web server cannot listen on port %u: %s\n", port, strerror(errno));
+    if (listenFd >= 0) ::close(listenFd);
+    listenFd = -1;
+    return;
+  }
+  
+  running = true;
+  serverThread = std::thread(&AsyncWebServer::serve, this);
+}
+
+void AsyncWebServer::end() {
+  running = false;
+  if (serverThread.joinable()) serverThread.join();
+  while (!clients.empty()) {
+    close(clients.back().get());
+  }
+  if (listenFd >= 0) {
+    ::close(listenFd);
+    listenFd = -1;
+  }
+}
+
+void AsyncWebServer::serve() {
+  std::vector<pollfd> descriptors;
+  
+  while (running) {
+    // A connection is read until its response exists, then written until it is sent
+    descriptors.clear();
+    descriptors.push_back({listenFd, (short)(clients.size() < MAX_CLIENTS ? POLLIN : 0), 0});
+    for (const auto& client : clients) {
+      descriptors.push_back({client->clientFd, (short)(client->response ? POLLOUT : POLLIN), 0});
+    }
+    
+    // Wakes periodically so end() is noticed
+    if (poll(descriptors.data(), descriptors.size(), 100) <= 0) continue;
+    
+    // Walked backwards so closing a connection leaves the earlier indices valid
+    for (size_t i = descriptors.size() - 1; i > 0; i--) {
+      short events = descriptors[i].revents;
+      if (!events) continue;
+      
+      AsyncWebServerRequest* request = clients[i - 1].get();
+      bool open;
+      if (events & POLLOUT) {
+        open = transmit(request);
+      } else if (events & POLLIN) {
+        open = receive(request);
+      } else {
+        open = false;  // Error or hangup before the response
+      }
+      if (!open) close(request);
+    }
+    
+    if (descriptors[0].revents & POLLIN) accept();
+  }
+}
+
+void AsyncWebServer::accept() {
+  while (clients.size() < MAX_CLIENTS) {
+    int fd = accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK);
+    if (fd < 0) return;
+    
+    int noDelay = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+    clients.emplace_back(new AsyncWebServerRequest(this, fd));
+  }
+}
+
+bool AsyncWebServer::receive(AsyncWebServerRequest* request) {
+  uint8_t buffer[RESPONSE_CHUNK_SIZE];
+  ssize_t received = recv(request->clientFd, buffer, sizeof(buffer), 0);
+  if (received < 0) return errno == EAGAIN || errno == EINTR;
+  if (received == 0) return false;
+  
+  if (request->headerParsed) {
+    dispatchBody(request, buffer, received);
+  } else {
+    request->input.append((const char*)buffer, received);
+    size_t headEnd = request->input.find("\r\n\r\n");
+    if (headEnd == std::string::npos) {
+      if (request->input.size() > MAX_HEAD_SIZE) request->send(431);
+      return true;
+    }
+    if (!request->parseHead(headEnd)) {
+      request->send(400);
+      return true;
+    }
+    request->headerParsed = true;
+    
+    for (AsyncWebHandler* handler : handlers) {
+      if (handler->canHandle(request)) {
+        request->handler = handler;
+        break;
+      }
+    }
+    
+    // Whatever followed the headers in this read is the start of the body
+    std::string body = request->input.substr(headEnd + 4);
+    request->input.clear();
+    request->input.shrink_to_fit();
+    if (!body.empty()) dispatchBody(request, (const uint8_t*)body.data(), body.size());
+  }
+  
+  if (!request->handled && request->bodyReceived >= request->bodyLength) complete(request);
+  return true;
+}
+
+void AsyncWebServer::dispatchBody(AsyncWebServerRequest* request, const uint8_t* data, size_t length) {
+  // Bytes past the declared length are ignored; a connection carries one request
+  length = std::min(length, request->bodyLength - request->bodyReceived);
+  if (length == 0) return;
+  
+  size_t index = request->bodyReceived;
+  request->bodyReceived += length;
+  if (request->handler) {
+    request->handler->handleBody(request, (uint8_t*)data, length, index, request->bodyLength);
+  }
+}
+
+void AsyncWebServer::complete(AsyncWebServerRequest* request) {
+  request->handled = true;
+  if (request->handler) {
+    request->handler->handleRequest(request);
+  } else if (notFoundCallback) {
+    notFoundCallback(request);
+  } else {
+    request->send(404);
+  }
+  
+  if (!request->response) {
+    request->send(501, "text/plain", "Handler did not handle the request");
+  }
+}
+
+bool AsyncWebServer::transmit(AsyncWebServerRequest* request) {
+  if (request->outputSent == request->output.size()) {
+    if (request->bodyDone) return false;
+    
+    // Next piece of the body, framed when the length is not known up front
+    uint8_t chunk[RESPONSE_CHUNK_SIZE];
+    AsyncWebServerResponse& response = *request->response;
+    size_t length = response.fill(chunk, sizeof(chunk), request->bodyIndex);
+    request->bodyIndex += length;
+    request->output.clear();
+    request->outputSent = 0;
+    
+    if (response.isChunked()) {
+      char size[16];
+      snprintf(size, sizeof(size), "%zx\r\n", length);
+      request->output = size;
+      request->output.append((const char*)chunk, length);
+      request->output += "\r\n";
+      request->bodyDone = (length == 0);
+    } else {
+      request->output.append((const char*)chunk, length);
+      request->bodyDone = (length == 0);
+    }
+  }
+  
+  ssize_t sent = ::send(request->clientFd, request->output.data() + request->outputSent,
+                        request->output.size() - request->outputSent, MSG_NOSIGNAL);
+  if (sent < 0) return errno == EAGAIN || errno == EINTR;
+  request->outputSent += sent;
+  return true;
+}
+
+void AsyncWebServer::close(AsyncWebServerRequest* request) {
+  // Runs for every request, as the connection always closes; handlers release buffers here
+  if (request->disconnectCallback) request->disconnectCallback();
+  ::close(request->clientFd);
+  
+  for (size_t i = 0; i < clients.size(); i++) {
+    if (clients[i].get() == request) {
+      clients.erase(clients.begin() + i);
+      return;
+    }
+  }
+}
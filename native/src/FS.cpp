@@ -0,0 +1,199 @@
+#include "FS.h"
+#include "LittleFS.h"
+#include <filesystem>
+#include <algorithm>
+
+namespace stdfs = std::filesystem;
+
+LittleFSFS LittleFS;
+
+namespace fs {
+
+// ---------------------------------------------------------------------------------------
+// File
+// ---------------------------------------------------------------------------------------
+
+File::File(FILE* file, const std::string& path) : handle(file, fclose), fullPath(path) {}
+
+File::File(const std::string& directory, std::vector<std::string> names)
+    : fullPath(directory), isDir(true), entries(std::move(names)) {}
+
+size_t File::write(uint8_t c) {
+  return handle ? fwrite(&c, 1, 1, handle.get()) : 0;
+}
+
+size_t File::write(const uint8_t* buffer, size_t size) {
+  return handle ? fwrite(buffer, 1, size, handle.get()) : 0;
+}
+
+int File::available() {
+  if (!handle) return 0;
+  return (int)(size() - position());
+}
+
+int File::read() {
+  if (!handle) return -1;
+  int c = fgetc(handle.get());
+  return c == EOF ? -1 : c;
+}
+
+int File::peek() {
+  if (!handle) return -1;
+  int c = fgetc(handle.get());
+  if (c == EOF) return -1;
+  ungetc(c, handle.get());
+  return c;
+}
+
+size_t File::read(uint8_t* buffer, size_t size) {
+  return handle ? fread(buffer, 1, size, handle.get()) : 0;
+}
+
+void File::flush() {
+  if (handle) fflush(handle.get());
+}
+
+bool File::seek(uint32_t offset, SeekMode mode) {
+  if (!handle) return false;
+  int whence = mode == SeekSet ? SEEK_SET : mode == SeekCur ? SEEK_CUR : SEEK_END;
+  return fseek(handle.get(), offset, whence) == 0;
+}
+
+size_t File::position() const {
+  return handle ? (size_t)ftell(handle.get()) : 0;
+}
+
+size_t File::size() const {
+  if (!handle) return 0;
+  fflush(handle.get());
+  long current = ftell(handle.get());
+  fseek(handle.get(), 0, SEEK_END);
+  long end = ftell(handle.get());
+  fseek(handle.get(), current, SEEK_SET);
+  return end < 0 ? 0 : (size_t)end;
+}
+
+void File::close() {
+  handle.reset();
+  isDir = false;
+  entries.clear();
+}
+
+const char* File::name() const {
+  size_t slash = fullPath.rfind('/');
+  return fullPath.c_str() + (slash == std::string::npos ? 0 : slash + 1);
+}
+
+File File::openNextFile(const char* mode) {
+  if (!isDir || nextEntry >= entries.size()) return File();
+  std::string child = (fullPath == "/" ? "" : fullPath) + "/" + entries[nextEntry++];
+  return LittleFS.open(child.c_str(), mode);
+}
+
+// ---------------------------------------------------------------------------------------
+// FS
+// ---------------------------------------------------------------------------------------
+
+std::string FS::hostPath(const char* path) const {
+  std::string relative = path ? path : "";
+  while (!relative.empty() && relative[0] == '/') relative.erase(0, 1);
+  return root + "/" + relative;
+}
+
+File FS::open(const char* path, const char* mode, bool create) {
+  if (root.empty() || !path) return File();
+  std::string host = hostPath(path);
+  
+  std::error_code error;
+  if (stdfs::is_directory(host, error)) {
+    std::vector<std::string> names;
+    for (const auto& entry : stdfs::directory_iterator(host, error)) {
+      names.push_back(entry.path().filename().string());
+    }
+    std::sort(names.begin(), names.end());
+    return File(path, std::move(names));
+  }
+  
+  if (create && mode[0] != 'r') {
+    stdfs::create_directories(stdfs::path(host).parent_path(), error);
+  }
+  
+  // Binary mode throughout; "r+" etc. map directly onto stdio
+  std::string stdioMode = mode;
+  if (stdioMode.find('b') == std::string::npos) stdioMode += 'b';
+  FILE* file = fopen(host.c_str(), stdioMode.c_str());
+  if (!file) return File();
+  return File(file, path);
+}
+
+bool FS::exists(const char* path) {
+  std::error_code error;
+  return !root.empty() && stdfs::exists(hostPath(path), error);
+}
+
+bool FS::remove(const char* path) {
+  std::error_code error;
+  return !root.empty() && stdfs::remove(hostPath(path), error);
+}
+
+bool FS::rename(const char* from, const char* to) {
+  std::error_code error;
+  if (root.empty()) return false;
+  stdfs::rename(hostPath(from), hostPath(to), error);
+  return !error;
+}
+
+bool FS::mkdir(const char* path) {
+  std::error_code error;
+  return !root.empty() && (stdfs::create_directories(hostPath(path), error) || stdfs::is_directory(hostPath(path), error));
+}
+
+bool FS::rmdir(const char* path) {
+  std::error_code error;
+  return !root.empty() && stdfs::remove(hostPath(path), error);
+}
+
+}  // namespace fs
+
+// ---------------------------------------------------------------------------------------
+// LittleFS
+// ---------------------------------------------------------------------------------------
+
+bool LittleFSFS::setRoot(const std::string& directory) {
+  std::error_code error;
+  stdfs::create_directories(directory, error);
+  if (!stdfs::is_directory(directory, error)) return false;
+  root = directory;
+  return true;
+}
+
+bool LittleFSFS::begin(bool formatOnFail, const char* basePath, uint8_t maxOpenFiles, const char* partitionLabel) {
+  if (!root.empty()) return true;
+  
+  const char* configured = getenv("NATIVE_FS_ROOT");
+  if (configured && *configured) return setRoot(configured);
+  
+  char pattern[] = "/tmp/nixon-littlefs-XXXXXX";
+  if (!mkdtemp(pattern)) return false;
+  root = pattern;
+  return true;
+}
+
+bool LittleFSFS::format() {
+  if (root.empty()) return false;
+  std::error_code error;
+  for (const auto& entry : stdfs::directory_iterator(root, error)) {
+    stdfs::remove_all(entry.path(), error);
+  }
+  return true;
+}
+
+size_t LittleFSFS::usedBytes() {
+  size_t used = 0;
+  std::error_code error;
+  if (root.empty()) return 0;
+  for (const auto& entry : stdfs::recursive_directory_iterator(root, error)) {
+    if (entry.is_regular_file(error)) used += entry.file_size(error);
+  }
+  return used;
+}
@@ -0,0 +1,101 @@
+#include "VirtualPCA9685.h"
+
+static const uint8_t LAST_LED_REGISTER = PCA9685_LED0_ON_L + 4 * VirtualPCA9685::CHANNELS - 1;  // 0x45
+
+VirtualPCA9685::VirtualPCA9685(uint8_t address, TwoWire& bus) : address(address), bus(bus) {
+  powerOn();
+  bus.attach(address, this);
+}
+
+VirtualPCA9685::~VirtualPCA9685() {
+  bus.detach(address);
+}
+
+void VirtualPCA9685::powerOn() {
+  memset(registers, 0, sizeof(registers));
+  registers[PCA9685_MODE1] = MODE1_SLEEP | MODE1_ALLCALL;
+  registers[PCA9685_MODE2] = MODE2_OUTDRV;
+  registers[PCA9685_PRESCALE] = 0x1E;
+  for (int channel = 0; channel < CHANNELS; channel++) {
+    registers[PCA9685_LED0_ON_L + 4 * channel + 3] = 0x10;  // Full off
+  }
+  registers[PCA9685_ALLLED_ON_L + 3] = 0x10;
+  pointer = 0;
+}
+
+uint8_t VirtualPCA9685::nextPointer(uint8_t reg) const {
+  if (!(registers[PCA9685_MODE1] & MODE1_AI)) return reg;
+  // Auto-increment walks MODE1..LED15 and wraps; the ALL_LED block cycles on its own
+  if (reg == LAST_LED_REGISTER) return 0;
+  if (reg == PCA9685_ALLLED_ON_L + 3) return PCA9685_ALLLED_ON_L;
+  return reg + 1;
+}
+
+void VirtualPCA9685::writeRegister(uint8_t reg, uint8_t value) {
+  writeCount++;
+  
+  if (reg == PCA9685_MODE1) {
+    // Writing 1 to RESTART clears it
+    registers[reg] = value & ~MODE1_RESTART;
+    return;
+  }
+  if (reg == PCA9685_PRESCALE) {
+    if (isSleeping()) registers[reg] = value;
+    return;
+  }
+  if (reg >= PCA9685_ALLLED_ON_L && reg <= PCA9685_ALLLED_ON_L + 3) {
+    registers[reg] = value;
+    for (int channel = 0; channel < CHANNELS; channel++) {
+      registers[PCA9685_LED0_ON_L + 4 * channel + (reg - PCA9685_ALLLED_ON_L)] = value;
+    }
+    return;
+  }
+  
+  registers[reg] = value;
+  if (reg >= PCA9685_LED0_ON_L && reg <= LAST_LED_REGISTER) {
+    channelWrites[(reg - PCA9685_LED0_ON_L) / 4]++;
+  }
+}
+
+void VirtualPCA9685::receive(const uint8_t* data, size_t length) {
+  // First byte selects the register, the rest are written from there
+  pointer = data[0];
+  for (size_t i = 1; i < length; i++) {
+    writeRegister(pointer, data[i]);
+    pointer = nextPointer(pointer);
+  }
+}
+
+size_t VirtualPCA9685::transmit(uint8_t* data, size_t length) {
+  for (size_t i = 0; i < length; i++) {
+    data[i] = registers[pointer];
+    pointer = nextPointer(pointer);
+  }
+  return length;
+}
+
+uint16_t VirtualPCA9685::getOn(int channel) const {
+  int base = PCA9685_LED0_ON_L + 4 * channel;
+  return registers[base] | (registers[base + 1] << 8);
+}
+
+uint16_t VirtualPCA9685::getOff(int channel) const {
+  int base = PCA9685_LED0_ON_L + 4 * channel;
+  return registers[base + 2] | (registers[base + 3] << 8);
+}
+
+float VirtualPCA9685::outputFrequency(uint32_t oscillatorFrequency) const {
+  return (float)oscillatorFrequency / (4096.0f * (getPrescale() + 1));
+}
+
+float VirtualPCA9685::pulseMicroseconds(int channel, uint32_t oscillatorFrequency) const {
+  if (isSleeping()) return 0;
+  
+  uint16_t on = getOn(channel);
+  uint16_t off = getOff(channel);
+  float tick = 1000000.0f * (getPrescale() + 1) / oscillatorFrequency;
+  if (off & 0x1000) return 0;                 // Full off wins over full on
+  if (on & 0x1000) return tick * 4096;        // Full on
+  int width = ((off & 0x0FFF) - (on & 0x0FFF) + 4096) % 4096;
+  return tick * width;
+}
@@ -0,0 +1,29 @@
+#include "VirtualTCA9548A.h"
+
+VirtualTCA9548A::VirtualTCA9548A(uint8_t address, TwoWire& bus) : address(address), bus(bus) {
+  bus.attach(address, this);
+}
+
+VirtualTCA9548A::~VirtualTCA9548A() {
+  bus.detach(address);
+}
+
+void VirtualTCA9548A::receive(const uint8_t* data, size_t length) {
+  // A single register with no pointer: every byte written replaces it
+  control = data[length - 1];
+  controlWrites++;
+}
+
+size_t VirtualTCA9548A::transmit(uint8_t* data, size_t length) {
+  memset(data, control, length);
+  return length;
+}
+
+I2CDevice* VirtualTCA9548A::route(uint8_t target) {
+  for (int c = 0; c < CHANNELS; c++) {
+    if (!(control & (1 << c))) continue;
+    I2CDevice* device = channels[c].device(target);
+    if (device) return device;
+  }
+  return nullptr;
+}
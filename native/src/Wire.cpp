@@ -0,0 +1,96 @@
+#include "Wire.h"
+#include <algorithm>
+
+TwoWire Wire;
+
+bool TwoWire::begin(int sda, int scl, uint32_t frequency) {
+  if (frequency) clock = frequency;
+  return true;
+}
+
+void TwoWire::attach(uint8_t address, I2CDevice* device) {
+  if (address >= MAX_DEVICES) return;
+  devices[address] = device;
+  if (device->isSwitch()) switches.push_back(device);
+}
+
+void TwoWire::detach(uint8_t address) {
+  if (address >= MAX_DEVICES) return;
+  switches.erase(std::remove(switches.begin(), switches.end(), devices[address]), switches.end());
+  devices[address] = nullptr;
+}
+
+I2CDevice* TwoWire::resolve(uint8_t address) const {
+  I2CDevice* target = device(address);
+  for (size_t i = 0; i < switches.size() && !target; i++) {
+    target = switches[i]->route(address);
+  }
+  return target;
+}
+
+void TwoWire::beginTransmission(uint8_t address) {
+  busLock.lock();
+  txAddress = address;
+  txLength = 0;
+  txOverflow = false;
+}
+
+size_t TwoWire::write(uint8_t data) {
+  if (txLength >= BUFFER_LENGTH) {
+    txOverflow = true;
+    return 0;
+  }
+  txBuffer[txLength++] = data;
+  return 1;
+}
+
+size_t TwoWire::write(const uint8_t* data, size_t length) {
+  size_t written = 0;
+  while (written < length && write(data[written])) {
+    written++;
+  }
+  return written;
+}
+
+double TwoWire::transactionMicros(size_t dataBytes, uint32_t frequency, double overheadMicros) {
+  if (frequency == 0) return overheadMicros;
+  double bits = 1 + 9.0 * (1 + dataBytes) + 1;
+  return bits * 1000000.0 / frequency + overheadMicros;
+}
+
+void TwoWire::recordTransaction(size_t dataBytes, bool acknowledged) {
+  // A NACKed address ends the transaction before any data is clocked
+  if (!acknowledged) {
+    dataBytes = 0;
+    stats.nacks++;
+  }
+  stats.transactions++;
+  stats.bytes += 1 + dataBytes;
+  stats.busyMicros += transactionMicros(dataBytes, clock, overheadMicros);
+}
+
+uint8_t TwoWire::endTransmission(bool sendStop) {
+  std::lock_guard<std::recursive_mutex> unlock(busLock, std::adopt_lock);
+  
+  // Return codes follow the Arduino API: 1 data too long, 2 address NACK
+  if (txOverflow) return 1;
+  I2CDevice* target = resolve(txAddress);
+  recordTransaction(txLength, target != nullptr);
+  if (!target) return 2;
+  if (txLength > 0) target->receive(txBuffer, txLength);
+  return 0;
+}
+
+uint8_t TwoWire::requestFrom(uint8_t address, uint8_t quantity, bool sendStop) {
+  std::lock_guard<std::recursive_mutex> lock(busLock);
+  rxIndex = 0;
+  rxLength = 0;
+  I2CDevice* target = resolve(address);
+  if (!target) {
+    recordTransaction(0, false);
+    return 0;
+  }
+  rxLength = target->transmit(rxBuffer, std::min((size_t)quantity, BUFFER_LENGTH));
+  recordTransaction(rxLength, true);
+  return (uint8_t)rxLength;
+}
@@ -0,0 +1,154 @@
+// The firmware's web server on the host. WebServerManager and its route table run
+// unchanged on the host ESPAsyncWebServer (POSIX sockets), against simulated PCA9685
+// boards, while the main thread runs loop() as the device does. Point native_loadgen, a
+// browser or curl at it.
+//
+//   pio run -e native_web
+//   .pio/build/native_web/program [--port N] [--udp-port N] [--boards N] [--mux N] [--fs DIR] [--clock HZ] [--i2c-overhead US]
+//
+// Handlers run on the server thread, like async_tcp on the ESP32, so contention with the
+// motion tick shows up in /api/profile ('tickInterval'). Lines on stdin are executed as
+// serial commands. The web UI is served if data/ is copied into the --fs directory.
+// Realtime UDP frames are received on --udp-port (default 5800), so stream_udp.py can
+// drive the controller over loopback.
+
+#include <Arduino.h>
+#include <Wire.h>
+#include <LittleFS.h>
+#include <VirtualPCA9685.h>
+#include <VirtualTCA9548A.h>
+#include <sys/select.h>
+#include <unistd.h>
+#include <memory>
+#include <vector>
+#include "ServoController.h"
+#include "WebServer.h"
+#include "DmxInput.h"
+#include "UdpFrameReceiver.h"
+
+static std::unique_ptr<VirtualTCA9548A> mux;  // Declared first so it outlives the chips behind it
+static std::vector<std::unique_ptr<VirtualPCA9685>> chips;
+
+// Main-bus boards at 0x40 up, then muxBoards behind a TCA9548A at 0x70, channel by channel
+// on the addresses the main bus leaves free (as scanForBoards() requires)
+static void attachChips(int boardCount, int muxBoards) {
+  for (int b = 0; b < boardCount; b++) {
+    chips.emplace_back(new VirtualPCA9685(0x40 + b));
+  }
+  if (muxBoards == 0) return;
+  
+  mux.reset(new VirtualTCA9548A(MUX_BASE_ADDRESS));
+  int perChannel = BOARD_ADDRESSES - boardCount;
+  for (int k = 0; k < muxBoards && perChannel > 0 && k / perChannel < VirtualTCA9548A::CHANNELS; k++) {
+    chips.emplace_back(new VirtualPCA9685(0x40 + boardCount + k % perChannel, mux->channel(k / perChannel)));
+  }
+}
+
+static bool stdinReady() {
+  fd_set readable;
+  FD_ZERO(&readable);
+  FD_SET(STDIN_FILENO, &readable);
+  timeval timeout = {0, 0};
+  return select(STDIN_FILENO + 1, &readable, nullptr, nullptr, &timeout) > 0;
+}
+
+// Reads what stdin has without blocking; returns false at end of input
+static bool readConsole(String& line, ServoController& controller) {
+  char buffer[512];
+  ssize_t count = read(STDIN_FILENO, buffer, sizeof(buffer));
+  if (count <= 0) return false;
+  
+  for (ssize_t i = 0; i < count; i++) {
+    if (buffer[i] != '\n' && buffer[i] != '\r') {
+      line += buffer[i];
+      continue;
+    }
+    line.trim();
+    if (line.length() > 0) {
+      LoopProfiler::PhaseScope phase(PROFILE_SERIAL_COMMAND);
+      CommandRecorder::SourceScope source(COMMAND_SOURCE_SERIAL);
+      Serial.println("Result: " + controller.executeCommand(line));
+    }
+    line = "";
+  }
+  return true;
+}
+
+int main(int argc, char** argv) {
+  int boardCount = 2;
+  int muxBoards = 0;
+  uint16_t port = 8080;
+  uint16_t udpPort = UdpFrameReceiver::DEFAULT_PORT;
+  for (int i = 1; i < argc; i++) {
+    String arg = argv[i];
+    if (arg == "--port" && i + 1 < argc) {
+      port = atoi(argv[++i]);
+    } else if (arg == "--udp-port" && i + 1 < argc) {
+      udpPort = atoi(argv[++i]);
+    } else if (arg == "--boards" && i + 1 < argc) {
+      boardCount = constrain(atoi(argv[++i]), 0, BOARD_ADDRESSES);
+    } else if (arg == "--mux" && i + 1 < argc) {
+      muxBoards = constrain(atoi(argv[++i]), 0, MAX_BOARDS);
+    } else if (arg == "--fs" && i + 1 < argc) {
+      LittleFS.setRoot(argv[++i]);
+    } else if (arg == "--clock" && i + 1 < argc) {
+      Wire.setClock(atol(argv[++i]));
+    } else if (arg == "--i2c-overhead" && i + 1 < argc) {
+      Wire.setTransactionOverhead(atof(argv[++i]));
+    } else {
+      fprintf(stderr, "Usage: %s [--port N] [--udp-port N] [--boards N] [--mux N] [--fs DIR] [--clock HZ] [--i2c-overhead US]\n", argv[0]);
+      return 1;
+    }
+  }
+  
+  attachChips(boardCount, muxBoards);
+  
+  // The same start-up order as setup()
+  JsonArenaPool::getInstance().begin();
+  Wire.begin();
+  LittleFS.begin(true);
+  Serial.printf("LittleFS at %s\n", LittleFS.getRoot().c_str());
+  
+  ServoController controller;
+  controller.scanForBoards();
+  controller.initializeBoards();
+  controller.loadConfiguration();
+  controller.startPersistence();
+  
+  DmxInput dmxInput(controller);
+  dmxInput.begin();
+  
+  UdpFrameReceiver udpReceiver(controller);
+  udpReceiver.begin(udpPort);
+  
+  AsyncWebServer::setPortOverride(port);
+  WebServerManager webServer(&controller, &dmxInput);
+  webServer.begin();
+  
+  controller.applyInitialPositions();
+  Serial.printf("Serving http://localhost:%u\n", port);
+  
+  String line;
+  bool consoleOpen = true;
+  for (;;) {
+    // loop(), with stdin standing in for the serial port
+    LoopProfiler::getInstance().beginFrame();
+    
+    controller.update();
+    {
+      LoopProfiler::PhaseScope phase(PROFILE_WEB_UPDATE);
+      webServer.update();
+    }
+    {
+      LoopProfiler::PhaseScope phase(PROFILE_SERIAL_INPUT);
+      if (consoleOpen && stdinReady()) consoleOpen = readConsole(line, controller);
+    }
+    
+    LoopProfiler::getInstance().endFrame();
+    HeapTracker::getInstance().sample();
+    
+    delay(1);
+  }
+  
+  return 0;
+}
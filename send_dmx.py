@@ -0,0 +1,101 @@
+#!/usr/bin/env python3
+"""
+Host-side Art-Net / sACN (E1.31) packet generator for testing the DMX input.
+
+Sends an animated universe to the controller:
+    python3 send_dmx.py --host 192.168.4.1 --protocol artnet --universe 1 --slots 32
+    python3 send_dmx.py --host 192.168.4.1 --protocol sacn --universe 1 --slots 32 --sixteen-bit
+
+Map the universe onto servos first with POST /api/dmx, for example:
+    {"mappings": [{"universe": 1, "address": 1, "board": 0, "servo": 0, "count": 16, "sixteenBit": false}]}
+"""
+
+import argparse
+import math
+import socket
+import struct
+import sys
+import time
+import uuid
+
+ARTNET_PORT = 6454
+SACN_PORT = 5568
+
+
+def artdmx_packet(universe, sequence, slots):
+    data = bytes(slots)
+    if len(data) % 2:
+        data += b"\x00"  # ArtDmx length must be even
+    return (b"Art-Net\x00" + struct.pack("<H", 0x5000) + struct.pack(">H", 14) +
+            struct.pack("BB", sequence & 0xFF, 0) + struct.pack("<H", universe) +
+            struct.pack(">H", len(data)) + data)
+
+
+def e131_packet(universe, sequence, slots, cid, source="send_dmx.py", priority=100):
+    data = b"\x00" + bytes(slots)  # start code + slots
+    dmp = struct.pack(">HBBHHH", 0x7000 | (10 + len(data)), 0x02, 0xA1, 0, 1, len(data)) + data
+    framing = (struct.pack(">HI", 0x7000 | (77 + len(dmp)), 0x00000002) +
+               source.encode().ljust(64, b"\x00") +
+               struct.pack(">BHBBH", priority, 0, sequence & 0xFF, 0, universe) + dmp)
+    root = (struct.pack(">HH", 0x0010, 0) + b"ASC-E1.17\x00\x00\x00" +
+            struct.pack(">HI", 0x7000 | (22 + len(framing)), 0x00000004) + cid + framing)
+    return root
+
+
+def animated_slots(count, t, sixteen_bit):
+    slots = []
+    servos = count // 2 if sixteen_bit else count
+    for i in range(servos):
+        value = 0.5 + 0.4 * math.sin(2 * math.pi * 0.5 * t + i * 0.3)
+        if sixteen_bit:
+            v = int(value * 65535)
+            slots += [v >> 8, v & 0xFF]
+        else:
+            slots.append(int(value * 255))
+    return slots
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Send Art-Net or sACN DMX universes")
+    parser.add_argument("--host", default="192.168.4.1", help="controller IP address")
+    parser.add_argument("--protocol", choices=["artnet", "sacn"], default="artnet")
+    parser.add_argument("--universe", type=int, default=1)
+    parser.add_argument("--slots", type=int, default=32, help="DMX slots per packet")
+    parser.add_argument("--sixteen-bit", action="store_true", help="send coarse/fine slot pairs")
+    parser.add_argument("--rate", type=float, default=44, help="packets per second")
+    parser.add_argument("--seconds", type=float, default=10, help="duration (0 = until Ctrl-C)")
+    args = parser.parse_args()
+
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    port = ARTNET_PORT if args.protocol == "artnet" else SACN_PORT
+    cid = uuid.uuid4().bytes
+    period = 1.0 / args.rate
+    start = time.monotonic()
+    next_packet = start
+    sequence = 0
+
+    try:
+        while args.seconds <= 0 or time.monotonic() - start < args.seconds:
+            slots = animated_slots(args.slots, time.monotonic() - start, args.sixteen_bit)
+            if args.protocol == "artnet":
+                packet = artdmx_packet(args.universe, sequence + 1, slots)
+            else:
+                packet = e131_packet(args.universe, sequence, slots, cid)
+            sock.sendto(packet, (args.host, port))
+            sequence += 1
+
+            next_packet += period
+            delay = next_packet - time.monotonic()
+            if delay > 0:
+                time.sleep(delay)
+    except KeyboardInterrupt:
+        pass
+
+    elapsed = time.monotonic() - start
+    print(f"[DMX] Sent {sequence} {args.protocol} packets for universe {args.universe} "
+          f"in {elapsed:.2f}s ({sequence / elapsed:.1f} packets/s)")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
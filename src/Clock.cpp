@@ -0,0 +1,9 @@
+#include "Clock.h"
+
+static SystemClock systemClock;
+
+Clock* Clock::instance = &systemClock;
+
+void Clock::install(Clock* clock) {
+  instance = clock ? clock : &systemClock;
+}
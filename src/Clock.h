@@ -0,0 +1,26 @@
+#pragma once
+
+#include <Arduino.h>
+
+// Time source for the controller's queue, sweeps, sequences, realtime timeout, save
+// debounce and log timestamps. The firmware reads the system clock; host simulations
+// install a clock they step themselves, so a show runs faster than real time and the
+// same inputs always give the same motion.
+class Clock {
+public:
+  virtual ~Clock() {}
+  virtual unsigned long millis() = 0;
+  virtual unsigned long micros() = 0;
+  
+  static Clock& getInstance() { return *instance; }
+  static void install(Clock* clock);  // nullptr restores the system clock
+
+private:
+  static Clock* instance;
+};
+
+class SystemClock : public Clock {
+public:
+  unsigned long millis() override { return ::millis(); }
+  unsigned long micros() override { return ::micros(); }
+};
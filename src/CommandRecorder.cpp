@@ -0,0 +1,127 @@
+#include "CommandRecorder.h"
+#include "Clock.h"
+
+thread_local uint8_t CommandRecorder::currentSource = COMMAND_SOURCE_INTERNAL;
+thread_local int CommandRecorder::nesting = 0;
+
+CommandRecorder::SourceScope::SourceScope(CommandSource source) : previous(currentSource) {
+  currentSource = source;
+}
+
+CommandRecorder::SourceScope::~SourceScope() {
+  currentSource = previous;
+}
+
+CommandRecorder::NestedScope::NestedScope() {
+  nesting++;
+}
+
+CommandRecorder::NestedScope::~NestedScope() {
+  nesting--;
+}
+
+void CommandRecorder::recordExecute(const String& command) {
+  record(RECORD_EXECUTE, nullptr, 0, command.c_str(), command.length());
+}
+
+void CommandRecorder::recordQueue(const String& command, unsigned long delayMs) {
+  uint32_t delay = delayMs;
+  record(RECORD_QUEUE, (const uint8_t*)&delay, sizeof(delay), command.c_str(), command.length());
+}
+
+void CommandRecorder::recordSequence(const String* commands, int count) {
+  if (!enabled) return;
+  
+  String joined;
+  for (int i = 0; i < count; i++) {
+    if (i > 0) joined += '\n';
+    joined += commands[i];
+  }
+  record(RECORD_SEQUENCE, nullptr, 0, joined.c_str(), joined.length());
+}
+
+void CommandRecorder::record(CommandRecordKind kind, const uint8_t* prefix, size_t prefixLength, const char* text, size_t textLength) {
+  if (!enabled) return;
+  
+  // A replay only needs the outer call in full; nested entries are kept for context
+  bool nested = nesting > 0;
+  size_t limit = nested ? COMMAND_RECORD_NESTED_LIMIT : COMMAND_RECORD_SIZE / 4;
+  bool truncated = prefixLength + textLength > limit;
+  if (truncated) {
+    textLength = limit > prefixLength ? limit - prefixLength : 0;
+  }
+  
+  CommandRecordHeader header;
+  header.time = Clock::getInstance().millis();
+  header.source = currentSource;
+  header.kind = kind | (nested ? RECORD_NESTED : 0) | (truncated ? RECORD_TRUNCATED : 0);
+  header.length = prefixLength + textLength;
+  size_t total = sizeof(header) + header.length;
+  
+  std::lock_guard<std::mutex> lock(mutex);
+  
+  // Drop whole entries from the old end until the new one fits
+  while (COMMAND_RECORD_SIZE - used < total) {
+    CommandRecordHeader oldest;
+    copyOut(start, &oldest, sizeof(oldest));
+    size_t size = sizeof(oldest) + oldest.length;
+    start = (start + size) % COMMAND_RECORD_SIZE;
+    used -= size;
+    entries--;
+    dropped++;
+  }
+  
+  size_t end = (start + used) % COMMAND_RECORD_SIZE;
+  copyIn(end, &header, sizeof(header));
+  copyIn((end + sizeof(header)) % COMMAND_RECORD_SIZE, prefix, prefixLength);
+  copyIn((end + sizeof(header) + prefixLength) % COMMAND_RECORD_SIZE, text, textLength);
+  used += total;
+  entries++;
+}
+
+void CommandRecorder::copyIn(size_t offset, const void* data, size_t length) {
+  if (length == 0) return;  // data may be null
+  size_t first = min(length, COMMAND_RECORD_SIZE - offset);
+  memcpy(ring + offset, data, first);
+  memcpy(ring, (const uint8_t*)data + first, length - first);
+}
+
+void CommandRecorder::copyOut(size_t offset, void* data, size_t length) const {
+  size_t first = min(length, COMMAND_RECORD_SIZE - offset);
+  memcpy(data, ring + offset, first);
+  memcpy((uint8_t*)data + first, ring, length - first);
+}
+
+void CommandRecorder::clear() {
+  std::lock_guard<std::mutex> lock(mutex);
+  start = 0;
+  used = 0;
+  entries = 0;
+  dropped = 0;
+}
+
+size_t CommandRecorder::writeTo(Print& output) {
+  std::lock_guard<std::mutex> lock(mutex);
+  
+  CommandRecordFileHeader header;
+  header.magic = COMMAND_RECORD_MAGIC;
+  header.version = COMMAND_RECORD_VERSION;
+  header.reserved = 0;
+  header.entries = entries;
+  header.dropped = dropped;
+  header.captureTime = Clock::getInstance().millis();
+  
+  size_t written = output.write((const uint8_t*)&header, sizeof(header));
+  size_t first = min(used, COMMAND_RECORD_SIZE - start);
+  written += output.write(ring + start, first);
+  written += output.write(ring, used - first);
+  return written;
+}
+
+String CommandRecorder::getStatusText() {
+  std::lock_guard<std::mutex> lock(mutex);
+  return "Recorder - " + String(enabled ? "On" : "Off") +
+         ", Entries: " + String(entries) +
+         ", Bytes: " + String((unsigned long)used) + "/" + String((unsigned long)COMMAND_RECORD_SIZE) +
+         ", Dropped: " + String(dropped);
+}
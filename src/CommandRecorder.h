@@ -0,0 +1,109 @@
+#pragma once
+
+#include <Arduino.h>
+#include <mutex>
+
+const size_t COMMAND_RECORD_SIZE = 8192;           // Ring bytes; a few hundred typical commands
+const size_t COMMAND_RECORD_NESTED_LIMIT = 64;     // Payload kept for nested entries
+const uint32_t COMMAND_RECORD_MAGIC = 0x4352584E;  // "NXRC"
+const uint16_t COMMAND_RECORD_VERSION = 1;
+
+// Where a command came from
+enum CommandSource : uint8_t {
+  COMMAND_SOURCE_INTERNAL,
+  COMMAND_SOURCE_SERIAL,
+  COMMAND_SOURCE_HTTP,
+  COMMAND_SOURCE_COUNT
+};
+
+// Which entry point recorded it. Payloads: EXECUTE is the command text, QUEUE is a
+// uint32_t delay followed by the command, SEQUENCE is the commands separated by '\n'.
+enum CommandRecordKind : uint8_t {
+  RECORD_EXECUTE,
+  RECORD_QUEUE,
+  RECORD_SEQUENCE
+};
+
+// Set on kind for entries made while another recorded call (or the queue and sequence
+// processing in update()) was running. Replaying the outer entry reproduces them, so a
+// replayer skips them; their payload is truncated to COMMAND_RECORD_NESTED_LIMIT.
+const uint8_t RECORD_NESTED = 0x80;
+
+// Set on kind when the payload was cut to fit (COMMAND_RECORD_SIZE / 4 for top-level
+// entries). The stored command is not the one that ran, so a replayer must not issue it.
+const uint8_t RECORD_TRUNCATED = 0x40;
+
+struct CommandRecordHeader {
+  uint32_t time;    // Clock millis
+  uint8_t source;   // CommandSource
+  uint8_t kind;     // CommandRecordKind, possibly | RECORD_NESTED | RECORD_TRUNCATED
+  uint16_t length;  // Payload bytes that follow
+};
+
+// Start of a downloaded recording; the entries follow, oldest first
+struct CommandRecordFileHeader {
+  uint32_t magic;        // COMMAND_RECORD_MAGIC
+  uint16_t version;      // COMMAND_RECORD_VERSION
+  uint16_t reserved;
+  uint32_t entries;
+  uint32_t dropped;      // Oldest entries overwritten since the last clear
+  uint32_t captureTime;  // Clock millis when the snapshot was taken
+};
+
+// Ring of the command traffic entering executeCommand(), queueCommand() and
+// startCommandSequence(), kept so a field problem can be replayed on a host build
+// (see native/sim). When the ring is full the oldest entries are dropped.
+class CommandRecorder {
+public:
+  static CommandRecorder& getInstance() {
+    static CommandRecorder instance;
+    return instance;
+  }
+  
+  // Commands issued on this task while the scope is alive are attributed to source
+  class SourceScope {
+  public:
+    explicit SourceScope(CommandSource source);
+    ~SourceScope();
+  private:
+    uint8_t previous;
+  };
+  
+  // Everything recorded while the scope is alive is marked RECORD_NESTED
+  class NestedScope {
+  public:
+    NestedScope();
+    ~NestedScope();
+  };
+  
+  void recordExecute(const String& command);
+  void recordQueue(const String& command, unsigned long delayMs);
+  void recordSequence(const String* commands, int count);
+  
+  void setEnabled(bool value) { enabled = value; }
+  bool isEnabled() const { return enabled; }
+  void clear();
+  
+  // Writes a CommandRecordFileHeader followed by the entries
+  size_t writeTo(Print& output);
+  size_t getRecordedBytes() const { return sizeof(CommandRecordFileHeader) + used; }
+  String getStatusText();
+
+private:
+  CommandRecorder() {}
+  
+  uint8_t ring[COMMAND_RECORD_SIZE];
+  size_t start = 0;  // Oldest entry
+  size_t used = 0;
+  uint32_t entries = 0;
+  uint32_t dropped = 0;
+  volatile bool enabled = true;
+  std::mutex mutex;
+  
+  static thread_local uint8_t currentSource;
+  static thread_local int nesting;
+  
+  void record(CommandRecordKind kind, const uint8_t* prefix, size_t prefixLength, const char* text, size_t textLength);
+  void copyIn(size_t offset, const void* data, size_t length);
+  void copyOut(size_t offset, void* data, size_t length) const;
+};
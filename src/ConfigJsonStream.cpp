@@ -0,0 +1,254 @@
+#include "ConfigJsonStream.h"
+#include "JsonArena.h"
+
+size_t ConfigJsonStream::PieceWriter::write(uint8_t c) {
+  if (skip > 0) {
+    skip--;
+  } else if (length < capacity) {
+    buffer[length++] = c;
+  } else {
+    overflow++;
+  }
+  return 1;
+}
+
+ConfigJsonStream::ConfigJsonStream(ServoController& controller, Content content, uint32_t since, const Filter& filter)
+  : controller(controller), content(content), since(since), filter(filter) {
+  stage = OPEN;
+  boardIndex = 0;
+  servoIndex = 0;
+  scriptIndex = 0;
+  boardsWritten = 0;
+  servosWritten = 0;
+  pieceLength = 0;
+  pieceOffset = 0;
+  scriptSent = 0;
+}
+
+size_t ConfigJsonStream::read(uint8_t* buffer, size_t maxLen) {
+  size_t written = 0;
+  
+  while (written < maxLen) {
+    if (pieceOffset == pieceLength && !nextPiece()) break;
+    
+    size_t count = min(pieceLength - pieceOffset, maxLen - written);
+    memcpy(buffer + written, piece + pieceOffset, count);
+    pieceOffset += count;
+    written += count;
+  }
+  
+  return written;
+}
+
+String ConfigJsonStream::readAll() {
+  String result;
+  uint8_t buffer[256];
+  size_t count;
+  while ((count = read(buffer, sizeof(buffer))) > 0) {
+    result.concat((const char*)buffer, count);
+  }
+  return result;
+}
+
+bool ConfigJsonStream::parseFields(const String& list, uint16_t& fields, String& error) {
+  fields = 0;
+  int start = 0;
+  while (start <= (int)list.length()) {
+    int end = list.indexOf(',', start);
+    if (end < 0) end = list.length();
+    
+    String name = list.substring(start, end);
+    name.trim();
+    if (name.length() > 0 && name != "index") {
+      int bit = findServoField(name);
+      if (bit < 0) {
+        name.replace("\"", "");  // The message is embedded in a JSON string
+        name.replace("\\", "");
+        error = "Unknown field '" + name + "'";
+        return false;
+      }
+      fields |= (1 << bit);
+    }
+    start = end + 1;
+  }
+  return true;
+}
+
+bool ConfigJsonStream::includeServo(int board, int servo) {
+  if (servo < filter.firstServo || servo > filter.lastServo) return false;
+  if (filter.enabledOnly && !controller.getServoConfig(board, servo)->enabled) return false;
+  return content != CHANGES || controller.getServoVersion(board, servo) > since;
+}
+
+bool ConfigJsonStream::includeBoard(int board) {
+  if (filter.board >= 0 && board != filter.board) return false;
+  
+  // A full document keeps selected boards even when every servo is filtered out
+  if (content != CHANGES) return true;
+  
+  for (int s = filter.firstServo; s <= filter.lastServo; s++) {
+    if (includeServo(board, s)) return true;
+  }
+  return false;
+}
+
+bool ConfigJsonStream::nextPiece() {
+  pieceLength = 0;
+  pieceOffset = 0;
+  PieceWriter out(piece, sizeof(piece), pieceLength);
+  
+  int boardCount = controller.getDetectedBoardCount();
+  int scriptCount = controller.getScriptCount();
+  
+  switch (stage) {
+    case OPEN:
+      if (content == SCRIPTS) {
+        out.print("{\"success\":true,\"count\":");
+        out.print(scriptCount);
+        out.print(",\"scripts\":[");
+        stage = (scriptCount > 0) ? SCRIPT : CLOSE;
+      } else {
+        writeRootFields(out);
+        out.print(",\"boards\":[");
+        stage = BOARD_OPEN;
+      }
+      break;
+      
+    case BOARD_OPEN:
+      // Skip boards outside the filter, or with nothing to report for CHANGES
+      while (boardIndex < boardCount && !includeBoard(boardIndex)) {
+        boardIndex++;
+      }
+      if (boardIndex >= boardCount) {
+        stage = SCRIPTS_OPEN;
+        break;
+      }
+      if (boardsWritten++ > 0) out.print(',');
+      writeBoardHeader(out);
+      servoIndex = filter.firstServo;
+      servosWritten = 0;
+      stage = SERVO;
+      break;
+      
+    case SERVO:
+      while (servoIndex < SERVOS_PER_BOARD && !includeServo(boardIndex, servoIndex)) {
+        servoIndex++;
+      }
+      if (servoIndex >= SERVOS_PER_BOARD) {
+        stage = BOARD_CLOSE;
+        break;
+      }
+      if (servosWritten++ > 0) out.print(',');
+      writeServo(out);
+      servoIndex++;
+      break;
+      
+    case BOARD_CLOSE:
+      out.print("]}");
+      boardIndex++;
+      stage = BOARD_OPEN;
+      break;
+      
+    case SCRIPTS_OPEN:
+      // A change to any script resends the whole list, since deletes shift indices
+      if (!filter.scripts || (content == CHANGES && controller.getScriptsVersion() <= since)) {
+        out.print("]}");
+        stage = DONE;
+        break;
+      }
+      out.print("],\"scripts\":[");
+      stage = (scriptCount > 0) ? SCRIPT : CLOSE;
+      break;
+      
+    case SCRIPT: {
+      // Scripts can be deleted between chunks; end the list early rather than overrun
+      if (scriptSent == 0) {
+        if (scriptIndex >= scriptCount) {
+          stage = CLOSE;
+          break;
+        }
+        scriptCopy = *controller.getScript(scriptIndex);
+      }
+      
+      // Written whole each time, keeping only the bytes not yet sent
+      PieceWriter rest(piece, sizeof(piece), pieceLength, scriptSent);
+      if (scriptIndex > 0) rest.print(',');
+      writeScript(rest);
+      if (rest.getOverflow() > 0) {
+        scriptSent += pieceLength;
+        break;
+      }
+      scriptSent = 0;
+      if (++scriptIndex >= scriptCount) stage = CLOSE;
+      break;
+    }
+      
+    case CLOSE:
+      out.print("]}");
+      stage = DONE;
+      break;
+      
+    case DONE:
+      return false;
+  }
+  
+  // Headers and servos always fit; say so loudly if that ever stops being true
+  if (out.getOverflow() > 0) {
+    DebugConsole::getInstance().logf("error", "Config JSON element cut short by %u bytes", (unsigned)out.getOverflow());
+  }
+  return true;
+}
+
+void ConfigJsonStream::writeRootFields(PieceWriter& out) {
+  char bootId[12];
+  snprintf(bootId, sizeof(bootId), "%08lx", (unsigned long)controller.getConfigBootId());
+  
+  out.print("{\"success\":true,\"version\":");
+  out.print((unsigned long)controller.getConfigVersion());
+  out.print(",\"boot\":\"");
+  out.print(bootId);
+  out.print("\"");
+  if (content == CHANGES) {
+    out.print(",\"since\":");
+    out.print((unsigned long)since);
+  }
+}
+
+void ConfigJsonStream::writeBoardHeader(PieceWriter& out) {
+  const PCA9685Board& board = controller.getBoards()[boardIndex];
+  
+  PooledJsonDocument doc;
+  doc["index"] = boardIndex;
+  doc["address"] = board.address;
+  doc["mux"] = board.mux;
+  doc["channel"] = board.muxChannel;
+  doc["name"] = board.name;
+  doc["enabled"] = board.enabled;
+  
+  // Serialize the header fields, then reopen the object to stream the servo array into it
+  size_t start = pieceLength;
+  serializeJson(doc, out);
+  if (pieceLength > start) pieceLength--;  // Drop the closing brace
+  out.print(",\"servos\":[");
+}
+
+void ConfigJsonStream::writeServo(PieceWriter& out) {
+  const ServoConfig* config = controller.getServoConfig(boardIndex, servoIndex);
+  
+  // Only the selected fields are added, so a projection costs less than the full object
+  PooledJsonDocument doc;
+  JsonObject servo = doc.to<JsonObject>();
+  servo["index"] = servoIndex;
+  writeServoJson(*config, servo, filter.fields);
+  serializeJson(doc, out);
+}
+
+void ConfigJsonStream::writeScript(PieceWriter& out) {
+  PooledJsonDocument doc;
+  doc["index"] = scriptIndex;
+  doc["name"] = scriptCopy.name;
+  doc["description"] = scriptCopy.description;
+  doc["commands"] = scriptCopy.commands;
+  doc["enabled"] = scriptCopy.enabled;
+  serializeJson(doc, out);
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include "ServoController.h"
+#include "ServoConfigSchema.h"
+
+// Incremental JSON serializer for the configuration and script list.
+//
+// The document is produced one element (board header, servo, script) at a time into a
+// small fixed buffer, so memory use does not grow with the number of boards or scripts.
+// read() has the shape of an AsyncWebServer chunked-response filler.
+
+class ConfigJsonStream {
+public:
+  enum Content {
+    CONFIGURATION,   // {"success":true,"version":V,"boot":B,"boards":[...],"scripts":[...]}
+    CHANGES,         // Same shape, limited to servos and scripts changed after 'since'
+    SCRIPTS          // {"success":true,"count":N,"scripts":[...]}
+  };
+  
+  // Selects which boards, servos and servo fields are written. Defaults select everything.
+  struct Filter {
+    int board;              // Only this board (-1 for all)
+    int firstServo;         // Inclusive servo range on each board
+    int lastServo;
+    bool enabledOnly;       // Skip disabled servos
+    uint16_t fields;        // Bitmask of SERVO_FIELDS indices
+    bool scripts;           // Include the script list
+    
+    Filter() : board(-1), firstServo(0), lastServo(SERVOS_PER_BOARD - 1),
+               enabledOnly(false), fields(SERVO_FIELDS_ALL), scripts(true) {}
+  };
+  
+  // Fits any board header or servo. A script can escape to about 3.7 KB (control characters
+  // become \u00XX), so one that does not fit is continued over as many pieces as it needs.
+  static const size_t PIECE_SIZE = 1536;
+  
+  ConfigJsonStream(ServoController& controller, Content content, uint32_t since = 0,
+                   const Filter& filter = Filter());
+  
+  // Parses a comma-separated field list such as "center,range" into a bitmask.
+  // Returns false and names the offending entry in error if a field is unknown.
+  static bool parseFields(const String& list, uint16_t& fields, String& error);
+  
+  // Copies up to maxLen bytes of the document into buffer; returns 0 once complete
+  size_t read(uint8_t* buffer, size_t maxLen);
+  
+  // Convenience for callers that need the whole document as a String
+  String readAll();
+  
+private:
+  enum Stage { OPEN, BOARD_OPEN, SERVO, BOARD_CLOSE, SCRIPTS_OPEN, SCRIPT, CLOSE, DONE };
+  
+  // Print target that appends to the piece buffer. The first 'skip' bytes are discarded and
+  // bytes past the capacity are counted as overflow, so an element can be written again to
+  // produce its continuation.
+  class PieceWriter : public Print {
+  public:
+    PieceWriter(char* buffer, size_t capacity, size_t& length, size_t skip = 0)
+      : buffer(buffer), capacity(capacity), length(length), skip(skip), overflow(0) {}
+    size_t write(uint8_t c) override;
+    size_t getOverflow() const { return overflow; }
+  private:
+    char* buffer;
+    size_t capacity;
+    size_t& length;
+    size_t skip;
+    size_t overflow;
+  };
+  
+  ServoController& controller;
+  Content content;
+  uint32_t since;
+  Filter filter;
+  Stage stage;
+  int boardIndex;
+  int servoIndex;
+  int scriptIndex;
+  int boardsWritten;
+  int servosWritten;
+  
+  char piece[PIECE_SIZE];
+  size_t pieceLength;
+  size_t pieceOffset;
+  
+  // The script being written, copied so its continuation pieces match even if it is
+  // edited between chunks, and how much of it has been sent
+  ScriptAction scriptCopy;
+  size_t scriptSent;
+  
+  bool nextPiece();
+  bool includeServo(int board, int servo);
+  bool includeBoard(int board);
+  void writeRootFields(PieceWriter& out);
+  void writeBoardHeader(PieceWriter& out);
+  void writeServo(PieceWriter& out);
+  void writeScript(PieceWriter& out);
+};
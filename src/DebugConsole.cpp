@@ -1,9 +1,11 @@
 #include "DebugConsole.h"
-#include <WiFi.h>
+#include "JsonArena.h"
+#include "Clock.h"
+#include "HeapTracker.h"
 
 String DebugConsole::getCurrentTimestamp() {
     // Get time since boot in milliseconds
-    unsigned long ms = millis();
+    unsigned long ms = Clock::getInstance().millis();
     unsigned long seconds = ms / 1000;
     unsigned long minutes = seconds / 60;
     unsigned long hours = minutes / 60;
@@ -20,6 +22,7 @@ String DebugConsole::getCurrentTimestamp() {
 }
 
 void DebugConsole::log(const String& message, const String& type) {
+    HeapTracker::Scope heap(HEAP_TAG_LOG);
     DebugMessage msg;
     msg.timestamp = getCurrentTimestamp();
     msg.message = message;
@@ -34,6 +37,7 @@ void DebugConsole::log(const String& message, const String& type) {
 }
 
 void DebugConsole::logf(const String& type, const char* format, ...) {
+    HeapTracker::Scope heap(HEAP_TAG_LOG);
     va_list args;
     va_start(args, format);
     
@@ -46,7 +50,8 @@ void DebugConsole::logf(const String& type, const char* format, ...) {
 }
 
 String DebugConsole::getMessagesJson() {
-    JsonDocument doc;
+    // Polled by every open page, so built in a pooled slab and serialized into one allocation
+    PooledJsonDocument doc;
     JsonArray msgArray = doc["messages"].to<JsonArray>();
     
     for (const auto& msg : messages) {
@@ -57,6 +62,7 @@ String DebugConsole::getMessagesJson() {
     }
     
     String result;
+    result.reserve(measureJson(doc));
     serializeJson(doc, result);
     return result;
 }
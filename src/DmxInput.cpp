@@ -0,0 +1,309 @@
+#include "DmxInput.h"
+#include "JsonArena.h"
+
+static const uint8_t ARTNET_ID[8] = {'A', 'r', 't', '-', 'N', 'e', 't', 0};
+static const uint8_t ACN_ID[12] = {'A', 'S', 'C', '-', 'E', '1', '.', '1', '7', 0, 0, 0};
+
+DmxInput::DmxInput(ServoController& controller) : controller(controller) {
+  mappingCount = 0;
+  artnetPackets = 0;
+  sacnPackets = 0;
+  malformedPackets = 0;
+  appliedPackets = 0;
+  for (int i = 0; i < MAX_DMX_MULTICAST; i++) {
+    multicastUniverses[i] = 0;
+    sacnMulticast[i].onPacket([this](AsyncUDPPacket& packet) {
+      this->handleSacn(packet.data(), packet.length());
+    });
+  }
+}
+
+DmxInput::~DmxInput() {
+  // Stop every callback before the mappings and mutex they use go away
+  artnetUdp.close();
+  sacnUdp.close();
+  for (int i = 0; i < MAX_DMX_MULTICAST; i++) {
+    sacnMulticast[i].close();
+  }
+}
+
+void DmxInput::begin() {
+  loadConfiguration();
+  
+  if (artnetUdp.listen(ARTNET_PORT)) {
+    artnetUdp.onPacket([this](AsyncUDPPacket& packet) {
+      this->handleArtnet(packet.data(), packet.length());
+    });
+  } else {
+    DebugConsole::getInstance().log("Art-Net receiver failed to listen", "error");
+  }
+  
+  if (sacnUdp.listen(SACN_PORT)) {
+    sacnUdp.onPacket([this](AsyncUDPPacket& packet) {
+      this->handleSacn(packet.data(), packet.length());
+    });
+  } else {
+    DebugConsole::getInstance().log("sACN receiver failed to listen", "error");
+  }
+  
+  DebugConsole::getInstance().logf("success", "DMX input listening (Art-Net %u, sACN %u) with %d mappings",
+                                   ARTNET_PORT, SACN_PORT, mappingCount);
+}
+
+bool DmxInput::parseArtDmx(const uint8_t* data, size_t len, DmxPacket& packet) {
+  if (len < 18 || memcmp(data, ARTNET_ID, sizeof(ARTNET_ID)) != 0) return false;
+  
+  uint16_t opcode = data[8] | (data[9] << 8);
+  if (opcode != 0x5000) return false;  // OpDmx
+  
+  uint16_t length = (data[16] << 8) | data[17];
+  if (length < 2 || length > DMX_UNIVERSE_SIZE || len < 18 + (size_t)length) return false;
+  
+  packet.universe = data[14] | ((data[15] & 0x7F) << 8);  // Net:SubUni port address
+  packet.slots = data + 18;
+  packet.slotCount = length;
+  return true;
+}
+
+bool DmxInput::parseE131(const uint8_t* data, size_t len, DmxPacket& packet) {
+  if (len < 126 || memcmp(data + 4, ACN_ID, sizeof(ACN_ID)) != 0) return false;
+  
+  // Root layer vector: VECTOR_ROOT_E131_DATA
+  if (data[18] != 0 || data[19] != 0 || data[20] != 0 || data[21] != 0x04) return false;
+  // Framing layer vector: VECTOR_E131_DATA_PACKET
+  if (data[40] != 0 || data[41] != 0 || data[42] != 0 || data[43] != 0x02) return false;
+  // Ignore preview data and terminated streams
+  if (data[112] & 0xC0) return false;
+  // DMP layer: set property, start code 0 (dimmer data)
+  if (data[117] != 0x02 || data[125] != 0) return false;
+  
+  uint16_t valueCount = (data[123] << 8) | data[124];  // Includes the start code
+  if (valueCount < 2 || valueCount > DMX_UNIVERSE_SIZE + 1 || len < 125 + (size_t)valueCount) return false;
+  
+  packet.universe = (data[113] << 8) | data[114];
+  packet.slots = data + 126;
+  packet.slotCount = valueCount - 1;
+  return true;
+}
+
+void DmxInput::handleArtnet(const uint8_t* data, size_t len) {
+  artnetPackets++;
+  DmxPacket packet;
+  if (parseArtDmx(data, len, packet)) {
+    applyPacket(packet);
+  } else {
+    malformedPackets++;
+  }
+}
+
+void DmxInput::handleSacn(const uint8_t* data, size_t len) {
+  sacnPackets++;
+  DmxPacket packet;
+  if (parseE131(data, len, packet)) {
+    applyPacket(packet);
+  } else {
+    malformedPackets++;
+  }
+}
+
+void DmxInput::applyPacket(const DmxPacket& packet) {
+  std::lock_guard<std::mutex> lock(mappingMutex);
+  bool applied = false;
+  
+  // Stage the whole universe inside one frame so it lands on a single motion tick
+  controller.beginFrame();
+  for (int m = 0; m < mappingCount; m++) {
+    const DmxMapping& mapping = mappings[m];
+    if (mapping.universe != packet.universe) continue;
+    
+    int slotsPerServo = mapping.sixteenBit ? 2 : 1;
+    int firstChannel = mapping.boardIndex * SERVOS_PER_BOARD + mapping.servoIndex;
+    
+    for (int i = 0; i < mapping.count; i++) {
+      int slot = mapping.address - 1 + i * slotsPerServo;
+      if (slot + slotsPerServo > packet.slotCount) break;
+      
+      float position;
+      if (mapping.sixteenBit) {
+        position = ((packet.slots[slot] << 8) | packet.slots[slot + 1]) * (100.0f / 65535.0f);
+      } else {
+        position = packet.slots[slot] * (100.0f / 255.0f);
+      }
+      
+      int channel = firstChannel + i;
+      controller.stageServoTarget(channel / SERVOS_PER_BOARD, channel % SERVOS_PER_BOARD, position);
+      applied = true;
+    }
+  }
+  controller.endFrame();
+  
+  if (applied) appliedPackets++;
+}
+
+bool DmxInput::setMappings(const DmxMapping* newMappings, int count) {
+  if (count < 0 || count > MAX_DMX_MAPPINGS) return false;
+  
+  for (int i = 0; i < count; i++) {
+    const DmxMapping& mapping = newMappings[i];
+    int slotsPerServo = mapping.sixteenBit ? 2 : 1;
+    if (mapping.address < 1 || mapping.address - 1 + mapping.count * slotsPerServo > DMX_UNIVERSE_SIZE) return false;
+    if (mapping.boardIndex >= MAX_BOARDS || mapping.servoIndex >= SERVOS_PER_BOARD || mapping.count == 0) return false;
+    if (mapping.boardIndex * SERVOS_PER_BOARD + mapping.servoIndex + mapping.count > MAX_BOARDS * SERVOS_PER_BOARD) return false;
+  }
+  
+  {
+    std::lock_guard<std::mutex> lock(mappingMutex);
+    for (int i = 0; i < count; i++) {
+      mappings[i] = newMappings[i];
+    }
+    mappingCount = count;
+  }
+  
+  joinMulticastGroups();
+  DebugConsole::getInstance().logf("info", "DMX mappings updated: %d mappings", count);
+  return true;
+}
+
+void DmxInput::joinMulticastGroups() {
+  // Copied under the lock; joining can take a while and packets keep arriving
+  uint16_t wanted[MAX_DMX_MULTICAST];
+  int wantedCount = 0;
+  {
+    std::lock_guard<std::mutex> lock(mappingMutex);
+    for (int m = 0; m < mappingCount && wantedCount < MAX_DMX_MULTICAST; m++) {
+      uint16_t universe = mappings[m].universe;
+      if (universe == 0) continue;
+      
+      bool duplicate = false;
+      for (int w = 0; w < wantedCount; w++) {
+        if (wanted[w] == universe) duplicate = true;
+      }
+      if (!duplicate) wanted[wantedCount++] = universe;
+    }
+  }
+  
+  // Groups still wanted stay joined; the rest are closed, which stops their callbacks
+  for (int i = 0; i < MAX_DMX_MULTICAST; i++) {
+    if (multicastUniverses[i] == 0) continue;
+    
+    bool kept = false;
+    for (int w = 0; w < wantedCount; w++) {
+      if (wanted[w] == multicastUniverses[i]) {
+        wanted[w] = wanted[--wantedCount];
+        kept = true;
+        break;
+      }
+    }
+    if (!kept) {
+      sacnMulticast[i].close();
+      multicastUniverses[i] = 0;
+    }
+  }
+  
+  // sACN senders multicast each universe to 239.255.<universe hi>.<universe lo>
+  int slot = 0;
+  for (int w = 0; w < wantedCount; w++) {
+    while (multicastUniverses[slot] != 0) slot++;
+    
+    uint16_t universe = wanted[w];
+    if (sacnMulticast[slot].listenMulticast(IPAddress(239, 255, universe >> 8, universe & 0xFF), SACN_PORT)) {
+      multicastUniverses[slot] = universe;
+    } else {
+      DebugConsole::getInstance().logf("error", "Failed to join sACN multicast for universe %u", universe);
+    }
+  }
+}
+
+String DmxInput::getConfigJson() {
+  PooledJsonDocument doc;
+  doc["success"] = true;
+  doc["artnetPort"] = ARTNET_PORT;
+  doc["sacnPort"] = SACN_PORT;
+  
+  JsonObject stats = doc["stats"].to<JsonObject>();
+  stats["artnetPackets"] = artnetPackets;
+  stats["sacnPackets"] = sacnPackets;
+  stats["malformedPackets"] = malformedPackets;
+  stats["appliedPackets"] = appliedPackets;
+  
+  JsonArray mappingsArray = doc["mappings"].to<JsonArray>();
+  std::lock_guard<std::mutex> lock(mappingMutex);
+  for (int i = 0; i < mappingCount; i++) {
+    JsonObject mappingObj = mappingsArray.add<JsonObject>();
+    mappingObj["universe"] = mappings[i].universe;
+    mappingObj["address"] = mappings[i].address;
+    mappingObj["board"] = mappings[i].boardIndex;
+    mappingObj["servo"] = mappings[i].servoIndex;
+    mappingObj["count"] = mappings[i].count;
+    mappingObj["sixteenBit"] = mappings[i].sixteenBit;
+  }
+  
+  String response;
+  serializeJson(doc, response);
+  return response;
+}
+
+void DmxInput::saveConfiguration() {
+  JsonDocument doc;
+  JsonArray mappingsArray = doc["mappings"].to<JsonArray>();
+  {
+    std::lock_guard<std::mutex> lock(mappingMutex);
+    for (int i = 0; i < mappingCount; i++) {
+      JsonObject mappingObj = mappingsArray.add<JsonObject>();
+      mappingObj["universe"] = mappings[i].universe;
+      mappingObj["address"] = mappings[i].address;
+      mappingObj["board"] = mappings[i].boardIndex;
+      mappingObj["servo"] = mappings[i].servoIndex;
+      mappingObj["count"] = mappings[i].count;
+      mappingObj["sixteenBit"] = mappings[i].sixteenBit;
+    }
+  }
+  
+  File file = LittleFS.open(CONFIG_FILE, "w");
+  if (file) {
+    serializeJson(doc, file);
+    file.close();
+    DebugConsole::getInstance().log("DMX configuration saved to " + String(CONFIG_FILE), "success");
+  } else {
+    DebugConsole::getInstance().log("Failed to save DMX configuration", "error");
+  }
+}
+
+void DmxInput::loadConfiguration() {
+  if (!LittleFS.exists(CONFIG_FILE)) {
+    DebugConsole::getInstance().log("No DMX configuration file found", "info");
+    return;
+  }
+  
+  File file = LittleFS.open(CONFIG_FILE, "r");
+  if (!file) {
+    DebugConsole::getInstance().log("Failed to open DMX configuration file", "error");
+    return;
+  }
+  
+  JsonDocument doc;
+  DeserializationError error = deserializeJson(doc, file);
+  file.close();
+  
+  if (error) {
+    DebugConsole::getInstance().log("Failed to parse DMX configuration file", "error");
+    return;
+  }
+  
+  DmxMapping loaded[MAX_DMX_MAPPINGS];
+  int count = 0;
+  for (JsonObject mappingObj : doc["mappings"].as<JsonArray>()) {
+    if (count >= MAX_DMX_MAPPINGS) break;
+    loaded[count].universe = mappingObj["universe"] | 0;
+    loaded[count].address = mappingObj["address"] | 1;
+    loaded[count].boardIndex = mappingObj["board"] | 0;
+    loaded[count].servoIndex = mappingObj["servo"] | 0;
+    loaded[count].count = mappingObj["count"] | 0;
+    loaded[count].sixteenBit = mappingObj["sixteenBit"] | false;
+    count++;
+  }
+  
+  if (!setMappings(loaded, count)) {
+    DebugConsole::getInstance().log("DMX configuration contains an invalid mapping", "error");
+  }
+}
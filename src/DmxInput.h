@@ -0,0 +1,81 @@
+#pragma once
+
+#include <Arduino.h>
+#include <AsyncUDP.h>
+#include <LittleFS.h>
+#include <ArduinoJson.h>
+#include "ServoController.h"
+
+// Art-Net (ArtDmx, UDP 6454) and sACN / E1.31 (UDP 5568, unicast or multicast) receiver.
+//
+// Each mapping routes a run of DMX slots in one universe onto consecutive servos. With
+// sixteenBit set every servo consumes a coarse/fine slot pair. Values are scaled to
+// 0-100% and go through the servo's configured center/range clamping; all servos
+// touched by one universe packet are staged together and land on the same motion tick.
+
+const int MAX_DMX_MAPPINGS = 16;
+const int MAX_DMX_MULTICAST = 4;   // sACN universes joined by multicast
+const int DMX_UNIVERSE_SIZE = 512;
+
+struct DmxMapping {
+  uint16_t universe;      // Art-Net 15-bit port address or sACN universe (1-63999)
+  uint16_t address;       // First DMX slot (1-512)
+  uint8_t boardIndex;     // First target board
+  uint8_t servoIndex;     // First target servo; continues onto the next board
+  uint8_t count;          // Number of servos
+  bool sixteenBit;        // Coarse/fine slot pairs
+};
+
+struct DmxPacket {
+  uint16_t universe;
+  const uint8_t* slots;   // Slot 1 is slots[0]
+  uint16_t slotCount;
+};
+
+class DmxInput {
+public:
+  static const uint16_t ARTNET_PORT = 6454;
+  static const uint16_t SACN_PORT = 5568;
+  
+  DmxInput(ServoController& controller);
+  ~DmxInput();
+  
+  void begin();
+  
+  // Packet decoding; no allocation, safe to call from the network task
+  static bool parseArtDmx(const uint8_t* data, size_t len, DmxPacket& packet);
+  static bool parseE131(const uint8_t* data, size_t len, DmxPacket& packet);
+  
+  void applyPacket(const DmxPacket& packet);
+  
+  // Mapping management
+  bool setMappings(const DmxMapping* newMappings, int count);
+  int getMappingCount() const { return mappingCount; }
+  String getConfigJson();
+  void saveConfiguration();
+  void loadConfiguration();
+  
+private:
+  ServoController& controller;
+  AsyncUDP artnetUdp;
+  AsyncUDP sacnUdp;
+  // Live as long as the receiver, so a callback still in flight after close() never
+  // sees a freed listener; slots are closed and reopened as the universes change
+  AsyncUDP sacnMulticast[MAX_DMX_MULTICAST];
+  uint16_t multicastUniverses[MAX_DMX_MULTICAST];   // 0 for an unused slot
+  
+  DmxMapping mappings[MAX_DMX_MAPPINGS];
+  int mappingCount;
+  std::mutex mappingMutex;
+  
+  uint32_t artnetPackets;
+  uint32_t sacnPackets;
+  uint32_t malformedPackets;
+  uint32_t appliedPackets;
+  
+  const char* CONFIG_FILE = "/dmx_config.json";
+  
+  void handleArtnet(const uint8_t* data, size_t len);
+  void handleSacn(const uint8_t* data, size_t len);
+  void joinMulticastGroups();
+};
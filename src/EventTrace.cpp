@@ -0,0 +1,69 @@
+#include "EventTrace.h"
+#include "Clock.h"
+
+thread_local uint8_t EventTrace::currentTrack = TRACE_TRACK_LOOP;
+
+EventTrace::TrackScope::TrackScope(TraceTrack track) : previous(currentTrack) {
+  currentTrack = track;
+}
+
+EventTrace::TrackScope::~TrackScope() {
+  currentTrack = previous;
+}
+
+EventTrace::EventTrace() {
+  names[TRACE_NAME_OTHER] = "other";
+  nameCount = 1;
+}
+
+uint16_t EventTrace::intern(const String& name) {
+  std::lock_guard<std::mutex> lock(nameMutex);
+  for (uint16_t i = 0; i < nameCount; i++) {
+    if (names[i] == name) return i;
+  }
+  if (nameCount >= TRACE_NAME_LIMIT) return TRACE_NAME_OTHER;
+  
+  names[nameCount] = name;
+  return nameCount++;
+}
+
+void EventTrace::add(uint16_t name, char phase, int32_t arg) {
+  uint32_t index = head.fetch_add(1);
+  TraceEvent& event = ring[index % TRACE_EVENT_CAPACITY];
+  event.time = Clock::getInstance().micros();
+  event.name = name;
+  event.phase = phase;
+  event.track = currentTrack;
+  event.arg = arg;
+}
+
+bool EventTrace::setEnabled(bool value) {
+  if (value && !ring) {
+    ring = (TraceEvent*)malloc(TRACE_EVENT_CAPACITY * sizeof(TraceEvent));
+    if (!ring) return false;
+  }
+  enabled = value;
+  return true;
+}
+
+void EventTrace::clear() {
+  head.store(0);
+}
+
+bool EventTrace::readEvent(uint32_t index, TraceEvent& event) const {
+  uint32_t current = head.load();
+  if (!ring || index >= current || current - index > TRACE_EVENT_CAPACITY) return false;
+  
+  event = ring[index % TRACE_EVENT_CAPACITY];
+  return true;
+}
+
+String EventTrace::getStatusText() const {
+  uint32_t written = head.load();
+  uint32_t held = min(written, TRACE_EVENT_CAPACITY);
+  
+  return "Event trace " + String(enabled ? "enabled" : "disabled") +
+         " - Events: " + String((unsigned long)held) + "/" + String((unsigned long)TRACE_EVENT_CAPACITY) +
+         ", Overwritten: " + String((unsigned long)(written - held)) +
+         ", Names: " + String((unsigned)nameCount) + "/" + String(TRACE_NAME_LIMIT);
+}
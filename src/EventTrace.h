@@ -0,0 +1,90 @@
+#pragma once
+
+#include <Arduino.h>
+#include <atomic>
+#include <mutex>
+
+const uint32_t TRACE_EVENT_CAPACITY = 4096;  // Ring events (12 bytes each); about a second of a busy show
+const int TRACE_NAME_LIMIT = 96;             // Distinct event names
+const uint16_t TRACE_NAME_OTHER = 0;         // Name given once the table is full
+
+// Chrome trace thread an event is shown on
+enum TraceTrack : uint8_t {
+  TRACE_TRACK_LOOP,   // loop(): controller, sequences, sweeps, I2C
+  TRACE_TRACK_HTTP,   // async_tcp: web handlers and the commands they run
+  TRACE_TRACK_COUNT
+};
+
+struct TraceEvent {
+  uint32_t time;   // Clock micros
+  uint16_t name;   // Index into the name table
+  char phase;      // 'B' begin, 'E' end, 'i' instant (Chrome trace phases)
+  uint8_t track;   // TraceTrack
+  int32_t arg;
+};
+
+// Timeline of controller, sweep, sequence, I2C and web handler events in a fixed ring,
+// exported as Chrome Trace Event JSON (TraceJsonStream) for chrome://tracing or Perfetto.
+//
+// Tracing is off until enabled; the ring is allocated then and kept. Writers on any task
+// claim a slot with one atomic increment, so an event costs a clock read and 12 bytes. The
+// newest events overwrite the oldest; switch tracing off to freeze a window before
+// downloading it.
+class EventTrace {
+public:
+  static EventTrace& getInstance() {
+    static EventTrace instance;
+    return instance;
+  }
+  
+  // Begin on construction, end on destruction
+  class Span {
+  public:
+    Span(uint16_t name, int32_t arg = 0) : name(name) { getInstance().begin(name, arg); }
+    ~Span() { getInstance().end(name); }
+  private:
+    uint16_t name;
+  };
+  
+  // Events from this task go to track while the scope is alive
+  class TrackScope {
+  public:
+    explicit TrackScope(TraceTrack track);
+    ~TrackScope();
+  private:
+    uint8_t previous;
+  };
+  
+  // Id for an event name; trace points intern their names once and keep the id
+  uint16_t intern(const String& name);
+  const String& getName(uint16_t id) const { return names[id < nameCount ? id : TRACE_NAME_OTHER]; }
+  
+  void begin(uint16_t name, int32_t arg = 0) { if (enabled) add(name, 'B', arg); }
+  void end(uint16_t name) { if (enabled) add(name, 'E', 0); }
+  void instant(uint16_t name, int32_t arg = 0) { if (enabled) add(name, 'i', arg); }
+  
+  // Returns false when the ring cannot be allocated
+  bool setEnabled(bool value);
+  bool isEnabled() const { return enabled; }
+  void clear();
+  
+  // Events ever written; event n lives in slot n % TRACE_EVENT_CAPACITY until overwritten
+  uint32_t getHead() const { return head.load(); }
+  bool readEvent(uint32_t index, TraceEvent& event) const;
+  String getStatusText() const;
+
+private:
+  EventTrace();
+  
+  TraceEvent* ring = nullptr;
+  std::atomic<uint32_t> head{0};
+  volatile bool enabled = false;
+  
+  String names[TRACE_NAME_LIMIT];
+  uint16_t nameCount = 0;
+  std::mutex nameMutex;
+  
+  static thread_local uint8_t currentTrack;
+  
+  void add(uint16_t name, char phase, int32_t arg);
+};
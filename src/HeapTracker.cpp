@@ -0,0 +1,368 @@
+#include "HeapTracker.h"
+#include "Clock.h"
+#include <atomic>
+
+static const char* const TAG_NAMES[HEAP_TAG_COUNT] = {"other", "parse", "log", "http", "json", "script", "motion"};
+
+volatile bool HeapTracker::enabled = false;
+thread_local uint8_t HeapTracker::currentTag = HEAP_TAG_OTHER;
+thread_local uint32_t HeapTracker::taskAllocations = 0;
+thread_local uint64_t HeapTracker::taskBytes = 0;
+thread_local int32_t HeapTracker::taskLiveBytes = 0;
+thread_local uint8_t HeapTracker::commandDepth = 0;
+
+// Live blocks: open addressing with linear probing, keyed by pointer
+struct HeapBlock {
+  void* pointer;
+  uint32_t size;
+  uint8_t tag;
+};
+static HeapBlock* blocks = nullptr;
+static int blockCount = 0;
+
+static int homeSlot(const void* pointer) {
+  return (int)((((uintptr_t)pointer >> 3) * 2654435761u) & (HEAP_TRACK_SLOTS - 1));
+}
+
+static int findSlot(const void* pointer) {
+  for (int i = homeSlot(pointer), probes = 0; probes < HEAP_TRACK_SLOTS; i = (i + 1) & (HEAP_TRACK_SLOTS - 1), probes++) {
+    if (blocks[i].pointer == pointer) return i;
+    if (!blocks[i].pointer) return -1;
+  }
+  return -1;
+}
+
+static void removeSlot(int slot) {
+  // Backward-shift deletion keeps every probe chain unbroken without tombstones
+  blocks[slot].pointer = nullptr;
+  blockCount--;
+  for (int j = (slot + 1) & (HEAP_TRACK_SLOTS - 1); blocks[j].pointer; j = (j + 1) & (HEAP_TRACK_SLOTS - 1)) {
+    int home = homeSlot(blocks[j].pointer);
+    bool movable = slot <= j ? (home <= slot || home > j) : (home <= slot && home > j);
+    if (!movable) continue;
+    blocks[slot] = blocks[j];
+    blocks[j].pointer = nullptr;
+    slot = j;
+  }
+}
+
+#if defined(ESP32)
+static portMUX_TYPE heapLock = portMUX_INITIALIZER_UNLOCKED;
+
+void HeapTracker::lock() {
+  portENTER_CRITICAL(&heapLock);
+}
+
+void HeapTracker::unlock() {
+  portEXIT_CRITICAL(&heapLock);
+}
+#else
+static std::atomic_flag heapLock = ATOMIC_FLAG_INIT;
+
+void HeapTracker::lock() {
+  while (heapLock.test_and_set(std::memory_order_acquire)) {}
+}
+
+void HeapTracker::unlock() {
+  heapLock.clear(std::memory_order_release);
+}
+#endif
+
+bool HeapTracker::hooksBuilt() {
+#ifdef HEAP_TRACKING
+  return true;
+#else
+  return false;
+#endif
+}
+
+bool HeapTracker::setEnabled(bool value) {
+  if (value && !hooksBuilt()) return false;
+  
+  if (value && !blocks) {
+    // Taken before tracking starts, so the table never charges itself
+    blocks = (HeapBlock*)calloc(HEAP_TRACK_SLOTS, sizeof(HeapBlock));
+    if (!blocks) return false;
+  }
+  // Blocks freed while off were never credited, so their table entries are stale
+  if (value && !enabled) reset();
+  enabled = value;
+  return true;
+}
+
+void HeapTracker::reset() {
+  lock();
+  for (int i = 0; i < HEAP_TAG_COUNT; i++) tags[i] = HeapTagStats();
+  if (blocks) memset(blocks, 0, HEAP_TRACK_SLOTS * sizeof(HeapBlock));
+  blockCount = 0;
+  totalAllocations = 0;
+  totalBytes = 0;
+  liveBytes = 0;
+  peakBytes = 0;
+  untracked = 0;
+  commands = 0;
+  commandAllocations = 0;
+  commandBytes = 0;
+  maxCommandAllocations = 0;
+  maxCommandVerb[0] = '\0';
+  lastCommandAllocations = 0;
+  lastCommandBytes = 0;
+  lastCommandRetained = 0;
+  minLargestBlock = UINT32_MAX;
+  historyCount = 0;
+  historyNext = 0;
+  unlock();
+}
+
+void HeapTracker::onAllocate(void* pointer, size_t size) {
+  if (!pointer) return;
+  
+  lock();
+  HeapTagStats& tag = tags[currentTag];
+  tag.allocations++;
+  tag.bytes += size;
+  totalAllocations++;
+  totalBytes += size;
+  taskAllocations++;
+  taskBytes += size;
+  
+  // Three quarters full keeps probe chains short; beyond that blocks go uncredited
+  if (blockCount < HEAP_TRACK_SLOTS * 3 / 4) {
+    int slot = homeSlot(pointer);
+    while (blocks[slot].pointer) slot = (slot + 1) & (HEAP_TRACK_SLOTS - 1);
+    blocks[slot] = {pointer, (uint32_t)size, currentTag};
+    blockCount++;
+    
+    tag.liveBytes += size;
+    if (tag.liveBytes > tag.peakBytes) tag.peakBytes = tag.liveBytes;
+    liveBytes += size;
+    if (liveBytes > peakBytes) peakBytes = liveBytes;
+    taskLiveBytes += size;
+  } else {
+    untracked++;
+  }
+  unlock();
+}
+
+void HeapTracker::onFree(void* pointer) {
+  if (!pointer) return;
+  
+  lock();
+  int slot = blocks ? findSlot(pointer) : -1;
+  if (slot >= 0) {
+    HeapTagStats& tag = tags[blocks[slot].tag];
+    tag.frees++;
+    tag.liveBytes -= blocks[slot].size;
+    liveBytes -= blocks[slot].size;
+    taskLiveBytes -= blocks[slot].size;
+    removeSlot(slot);
+  }
+  unlock();
+}
+
+HeapTracker::CommandScope::CommandScope(const String& command) {
+  outermost = commandDepth++ == 0;
+  if (!outermost) return;
+  
+  // Copied by hand: the verb must not itself be charged to the command
+  size_t start = 0;
+  while (start < command.length() && command[start] == ' ') start++;
+  size_t length = 0;
+  while (start + length < command.length() && command[start + length] != ' ' && length < sizeof(verb) - 1) {
+    verb[length] = command[start + length];
+    length++;
+  }
+  verb[length] = '\0';
+  
+  allocations = taskAllocations;
+  bytes = taskBytes;
+  liveBytes = taskLiveBytes;
+}
+
+HeapTracker::CommandScope::~CommandScope() {
+  commandDepth--;
+  if (!outermost || !enabled) return;
+  
+  HeapTracker& tracker = getInstance();
+  tracker.lock();
+  uint32_t count = taskAllocations - allocations;
+  tracker.commands++;
+  tracker.commandAllocations += count;
+  tracker.commandBytes += taskBytes - bytes;
+  tracker.lastCommandAllocations = count;
+  tracker.lastCommandBytes = taskBytes - bytes;
+  tracker.lastCommandRetained = taskLiveBytes - liveBytes;
+  if (count > tracker.maxCommandAllocations) {
+    tracker.maxCommandAllocations = count;
+    memcpy(tracker.maxCommandVerb, verb, sizeof(verb));
+  }
+  tracker.unlock();
+}
+
+void HeapTracker::sample() {
+  unsigned long now = Clock::getInstance().millis();
+  if (historyCount > 0 && now - lastSampleTime < HEAP_SAMPLE_MS) return;
+  lastSampleTime = now;
+  
+  uint32_t largestBlock = ESP.getMaxAllocHeap();
+  history[historyNext] = {(uint32_t)now, ESP.getFreeHeap(), largestBlock};
+  historyNext = (historyNext + 1) % HEAP_HISTORY_LENGTH;
+  if (historyCount < HEAP_HISTORY_LENGTH) historyCount++;
+  if (largestBlock < minLargestBlock) minLargestBlock = largestBlock;
+}
+
+void HeapTracker::snapshot(HeapTagStats* tagCopy, uint32_t* totals) {
+  // Copied first, so building the report does not show up in it
+  lock();
+  memcpy(tagCopy, tags, sizeof(tags));
+  totals[0] = liveBytes;
+  totals[1] = peakBytes;
+  totals[2] = totalAllocations;
+  totals[3] = untracked;
+  unlock();
+}
+
+void HeapTracker::writeStats(JsonObject stats) {
+  HeapTagStats tags[HEAP_TAG_COUNT];
+  uint32_t totals[4];
+  snapshot(tags, totals);
+  
+  stats["hooks"] = hooksBuilt();
+  stats["enabled"] = (bool)enabled;
+  stats["liveBytes"] = totals[0];
+  stats["peakBytes"] = totals[1];
+  stats["allocations"] = totals[2];
+  stats["untracked"] = totals[3];
+  
+  JsonObject tagStats = stats["tags"].to<JsonObject>();
+  for (int i = 0; i < HEAP_TAG_COUNT; i++) {
+    JsonObject tag = tagStats[TAG_NAMES[i]].to<JsonObject>();
+    tag["allocations"] = tags[i].allocations;
+    tag["frees"] = tags[i].frees;
+    tag["bytes"] = tags[i].bytes;
+    tag["liveBytes"] = tags[i].liveBytes;
+    tag["peakBytes"] = tags[i].peakBytes;
+  }
+  
+  JsonObject commandStats = stats["commands"].to<JsonObject>();
+  commandStats["count"] = commands;
+  commandStats["allocationsPerCommand"] = commands ? (float)commandAllocations / commands : 0;
+  commandStats["bytesPerCommand"] = commands ? (float)commandBytes / commands : 0;
+  commandStats["maxAllocations"] = maxCommandAllocations;
+  commandStats["maxCommand"] = maxCommandVerb;
+  commandStats["lastAllocations"] = lastCommandAllocations;
+  commandStats["lastBytes"] = lastCommandBytes;
+  commandStats["lastRetained"] = lastCommandRetained;
+  
+  // [time, freeHeap, largestBlock], oldest first
+  JsonObject largest = stats["largestFreeBlock"].to<JsonObject>();
+  largest["min"] = historyCount ? minLargestBlock : 0;
+  JsonArray samples = largest["history"].to<JsonArray>();
+  for (int i = 0; i < historyCount; i++) {
+    const HeapSample& sample = history[(historyNext - historyCount + i + HEAP_HISTORY_LENGTH) % HEAP_HISTORY_LENGTH];
+    JsonArray entry = samples.add<JsonArray>();
+    entry.add(sample.time);
+    entry.add(sample.freeHeap);
+    entry.add(sample.largestBlock);
+  }
+}
+
+String HeapTracker::getStatsText() {
+  HeapTagStats tags[HEAP_TAG_COUNT];
+  uint32_t totals[4];
+  snapshot(tags, totals);
+  
+  String text;
+  if (!hooksBuilt()) {
+    text = "Allocation hooks not built (use env:esp32dev_heap or -DHEAP_TRACKING)\n";
+  } else {
+    text = "Heap tracking " + String(enabled ? "enabled" : "disabled") +
+           " - Live: " + String(totals[0]) + " bytes, Peak: " + String(totals[1]) +
+           ", Allocations: " + String(totals[2]) + ", Untracked: " + String(totals[3]) + "\n";
+    
+    char line[112];
+    snprintf(line, sizeof(line), "%-8s %10s %10s %12s %10s %10s\n", "Tag", "Allocs", "Frees", "Bytes", "Live", "Peak");
+    text += line;
+    for (int i = 0; i < HEAP_TAG_COUNT; i++) {
+      snprintf(line, sizeof(line), "%-8s %10lu %10lu %12llu %10lu %10lu\n", TAG_NAMES[i], (unsigned long)tags[i].allocations,
+               (unsigned long)tags[i].frees, (unsigned long long)tags[i].bytes, (unsigned long)tags[i].liveBytes,
+               (unsigned long)tags[i].peakBytes);
+      text += line;
+    }
+    
+    text += "Commands: " + String(commands) +
+            ", Allocations/command: " + String(commands ? (float)commandAllocations / commands : 0.0f, 1) +
+            ", Most: " + String(maxCommandAllocations) + " (" + String(maxCommandVerb) + ")" +
+            ", Last: " + String(lastCommandAllocations) + " allocations, " + String(lastCommandBytes) +
+            " bytes, " + String(lastCommandRetained) + " retained\n";
+  }
+  
+  uint32_t current = historyCount ? history[(historyNext + HEAP_HISTORY_LENGTH - 1) % HEAP_HISTORY_LENGTH].largestBlock : 0;
+  text += "Largest free block: " + String(current) + " now, " + String(historyCount ? minLargestBlock : 0) +
+          " lowest over " + String(historyCount) + " samples";
+  return text;
+}
+
+// ---------------------------------------------------------------------------------------
+// Allocation hooks
+// ---------------------------------------------------------------------------------------
+
+#ifdef HEAP_TRACKING
+static thread_local bool inHook = false;
+
+static void trackAllocate(void* pointer, size_t size) {
+  if (!HeapTracker::isTracking() || inHook) return;
+  inHook = true;
+  HeapTracker::getInstance().onAllocate(pointer, size);
+  inHook = false;
+}
+
+static void trackFree(void* pointer) {
+  if (!HeapTracker::isTracking() || inHook) return;
+  inHook = true;
+  HeapTracker::getInstance().onFree(pointer);
+  inHook = false;
+}
+
+#if defined(ESP32)
+// Linked with -Wl,--wrap=malloc,--wrap=calloc,--wrap=realloc,--wrap=free; operator new and
+// String allocate through these. Direct heap_caps_* calls are not seen.
+#define REAL(name) __real_##name
+#define HOOK(name) __wrap_##name
+#else
+// glibc: replacing the malloc family also covers operator new
+#define REAL(name) __libc_##name
+#define HOOK(name) name
+#endif
+
+extern "C" {
+void* REAL(malloc)(size_t size);
+void* REAL(calloc)(size_t count, size_t size);
+void* REAL(realloc)(void* pointer, size_t size);
+void REAL(free)(void* pointer);
+
+void* HOOK(malloc)(size_t size) {
+  void* pointer = REAL(malloc)(size);
+  trackAllocate(pointer, size);
+  return pointer;
+}
+
+void* HOOK(calloc)(size_t count, size_t size) {
+  void* pointer = REAL(calloc)(count, size);
+  trackAllocate(pointer, count * size);
+  return pointer;
+}
+
+void* HOOK(realloc)(void* pointer, size_t size) {
+  void* moved = REAL(realloc)(pointer, size);
+  if (moved || size == 0) trackFree(pointer);
+  trackAllocate(moved, size);
+  return moved;
+}
+
+void HOOK(free)(void* pointer) {
+  trackFree(pointer);
+  REAL(free)(pointer);
+}
+}
+#endif
@@ -0,0 +1,133 @@
+#pragma once
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+
+const int HEAP_TRACK_SLOTS = 2048;        // Live blocks attributed at once (12 bytes each)
+const int HEAP_HISTORY_LENGTH = 60;       // Largest-free-block samples kept
+const unsigned long HEAP_SAMPLE_MS = 1000;
+
+// Subsystem a heap allocation is charged to: the innermost HeapTracker::Scope on the task
+enum HeapTag : uint8_t {
+  HEAP_TAG_OTHER,    // Outside any scope: libraries, WiFi, startup
+  HEAP_TAG_PARSE,    // Command parsing and execution
+  HEAP_TAG_LOG,      // DebugConsole entries
+  HEAP_TAG_HTTP,     // Web handlers
+  HEAP_TAG_JSON,     // JSON documents that outgrew their slab
+  HEAP_TAG_SCRIPT,   // Script parsing and storage
+  HEAP_TAG_MOTION,   // The motion tick: sweeps, sequences, queue, flush
+  HEAP_TAG_COUNT
+};
+
+struct HeapTagStats {
+  uint32_t allocations = 0;
+  uint32_t frees = 0;
+  uint64_t bytes = 0;       // Total requested
+  uint32_t liveBytes = 0;   // Still allocated
+  uint32_t peakBytes = 0;
+};
+
+// Opt-in heap accounting. Built with -DHEAP_TRACKING (env:esp32dev_heap, env:native_heap),
+// malloc/calloc/realloc/free are wrapped. Each block is charged to the subsystem scope
+// active when it was allocated, and credited back to it when freed. Blocks allocated
+// before tracking was switched on are not counted. Live blocks beyond HEAP_TRACK_SLOTS are
+// counted as allocations but cannot be credited on free ('untracked').
+//
+// Without the flag the scopes cost one thread-local store each, and only the
+// largest-free-block history (sampled whether or not tracking is on) is available.
+class HeapTracker {
+public:
+  static HeapTracker& getInstance() {
+    static HeapTracker instance;
+    return instance;
+  }
+  
+  // Charges allocations on this task to tag while alive
+  class Scope {
+  public:
+    explicit Scope(HeapTag tag) : previous(currentTag) { currentTag = tag; }
+    ~Scope() { currentTag = previous; }
+  private:
+    uint8_t previous;
+  };
+  
+  // Measures one command: allocations, bytes and what it left allocated. Counted per task,
+  // so allocations by other tasks meanwhile are not charged to it; a command executed
+  // while another is measured on the same task is part of the outermost one.
+  class CommandScope {
+  public:
+    explicit CommandScope(const String& command);
+    ~CommandScope();
+  private:
+    char verb[16];
+    bool outermost;
+    uint32_t allocations;
+    uint64_t bytes;
+    int32_t liveBytes;
+  };
+  
+  static bool hooksBuilt();
+  
+  bool setEnabled(bool value);  // Starts from zero; false when the hooks are not built
+  bool isEnabled() const { return enabled; }
+  void reset();
+  
+  // Samples free heap and the largest free block once per HEAP_SAMPLE_MS; call from loop()
+  void sample();
+  
+  // Called by the allocation hooks, which check isTracking() first
+  static bool isTracking() { return enabled; }
+  void onAllocate(void* pointer, size_t size);
+  void onFree(void* pointer);
+  
+  // For /api/heap and 'system heap'
+  void writeStats(JsonObject stats);
+  String getStatsText();
+
+private:
+  HeapTracker() {}
+  
+  // Static so the hooks can test it before anything else is initialised
+  static volatile bool enabled;
+  static thread_local uint8_t currentTag;
+  
+  // This task's share of the totals, for CommandScope
+  static thread_local uint32_t taskAllocations;
+  static thread_local uint64_t taskBytes;
+  static thread_local int32_t taskLiveBytes;
+  static thread_local uint8_t commandDepth;
+  
+  HeapTagStats tags[HEAP_TAG_COUNT];
+  uint32_t totalAllocations = 0;
+  uint64_t totalBytes = 0;
+  uint32_t liveBytes = 0;
+  uint32_t peakBytes = 0;
+  uint32_t untracked = 0;
+  
+  // Per-command figures
+  uint32_t commands = 0;
+  uint32_t commandAllocations = 0;
+  uint64_t commandBytes = 0;
+  uint32_t maxCommandAllocations = 0;
+  char maxCommandVerb[16] = "";
+  uint32_t lastCommandAllocations = 0;
+  uint32_t lastCommandBytes = 0;
+  int32_t lastCommandRetained = 0;
+  
+  // Largest free block history, oldest first once full
+  struct HeapSample {
+    uint32_t time;  // Clock millis
+    uint32_t freeHeap;
+    uint32_t largestBlock;
+  };
+  HeapSample history[HEAP_HISTORY_LENGTH];
+  int historyCount = 0;
+  int historyNext = 0;
+  unsigned long lastSampleTime = 0;
+  uint32_t minLargestBlock = UINT32_MAX;
+  
+  void lock();
+  void unlock();
+  // totals: live, peak, allocations, untracked
+  void snapshot(HeapTagStats* tagCopy, uint32_t* totals);
+};
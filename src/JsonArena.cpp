@@ -0,0 +1,168 @@
+#include "JsonArena.h"
+#include "DebugConsole.h"
+#include "HeapTracker.h"
+
+// Each block is preceded by its size, so reallocate() knows how much to copy
+static const size_t BLOCK_HEADER = 8;
+
+static size_t alignBlock(size_t size) {
+  return (size + 7) & ~(size_t)7;
+}
+
+// ---------------------------------------------------------------------------------------
+// JsonArena
+// ---------------------------------------------------------------------------------------
+
+void JsonArena::attach(uint8_t* memory) {
+  slab = memory;
+  reset();
+}
+
+void JsonArena::reset() {
+  top = 0;
+  lastBlock = SIZE_MAX;
+}
+
+bool JsonArena::contains(const void* pointer) const {
+  const uint8_t* p = (const uint8_t*)pointer;
+  return slab && p >= slab && p < slab + JSON_ARENA_SIZE;
+}
+
+size_t JsonArena::blockSize(const void* pointer) const {
+  return *(const uint32_t*)((const uint8_t*)pointer - BLOCK_HEADER);
+}
+
+void* JsonArena::allocate(size_t size) {
+  size_t needed = BLOCK_HEADER + alignBlock(size);
+  if (!slab || top + needed > JSON_ARENA_SIZE) {
+    if (slab) overflows++;
+    HeapTracker::Scope heap(HEAP_TAG_JSON);
+    return malloc(size);
+  }
+  
+  uint8_t* block = slab + top;
+  *(uint32_t*)block = size;
+  lastBlock = top;
+  top += needed;
+  if (top > highWater) highWater = top;
+  return block + BLOCK_HEADER;
+}
+
+void JsonArena::deallocate(void* pointer) {
+  if (!pointer) return;
+  if (!contains(pointer)) {
+    free(pointer);
+    return;
+  }
+  
+  // Only the newest block can be given back; the rest is reclaimed by reset()
+  if (lastBlock != SIZE_MAX && pointer == slab + lastBlock + BLOCK_HEADER) {
+    top = lastBlock;
+    lastBlock = SIZE_MAX;
+  }
+}
+
+void* JsonArena::reallocate(void* pointer, size_t size) {
+  if (!pointer) return allocate(size);
+  if (!contains(pointer)) {
+    HeapTracker::Scope heap(HEAP_TAG_JSON);
+    return realloc(pointer, size);
+  }
+  
+  // Strings being built and pools being shrunk are almost always the newest block
+  if (lastBlock != SIZE_MAX && pointer == slab + lastBlock + BLOCK_HEADER &&
+      lastBlock + BLOCK_HEADER + alignBlock(size) <= JSON_ARENA_SIZE) {
+    *(uint32_t*)(slab + lastBlock) = size;
+    top = lastBlock + BLOCK_HEADER + alignBlock(size);
+    if (top > highWater) highWater = top;
+    return pointer;
+  }
+  
+  void* moved = allocate(size);
+  if (!moved) return nullptr;
+  size_t oldSize = blockSize(pointer);
+  memcpy(moved, pointer, oldSize < size ? oldSize : size);
+  deallocate(pointer);
+  return moved;
+}
+
+// ---------------------------------------------------------------------------------------
+// JsonArenaPool
+// ---------------------------------------------------------------------------------------
+
+void JsonArenaPool::begin() {
+  std::lock_guard<std::mutex> lock(mutex);
+  for (int i = 0; i < JSON_ARENA_COUNT; i++) {
+    if (arenas[i].slab) continue;
+    
+    uint8_t* memory = (uint8_t*)malloc(JSON_ARENA_SIZE);
+    if (!memory) {
+      DebugConsole::getInstance().logf("error", "Could not allocate JSON slab %d", i);
+      continue;
+    }
+    arenas[i].attach(memory);
+  }
+}
+
+JsonArena* JsonArenaPool::acquire() {
+  std::lock_guard<std::mutex> lock(mutex);
+  leases++;
+  for (int i = 0; i < JSON_ARENA_COUNT; i++) {
+    if (arenas[i].slab && !arenas[i].inUse) {
+      arenas[i].inUse = true;
+      return &arenas[i];
+    }
+  }
+  fallbacks++;
+  return &heapArena;
+}
+
+void JsonArenaPool::release(JsonArena* arena) {
+  if (arena == &heapArena) return;
+  
+  std::lock_guard<std::mutex> lock(mutex);
+  arena->reset();
+  arena->inUse = false;
+}
+
+void JsonArenaPool::writeStats(JsonObject stats) {
+  uint32_t freeHeap = ESP.getFreeHeap();
+  uint32_t largestBlock = ESP.getMaxAllocHeap();
+  
+  stats["freeHeap"] = freeHeap;
+  stats["minFreeHeap"] = ESP.getMinFreeHeap();
+  stats["largestFreeBlock"] = largestBlock;
+  // 0% when all free memory is one block; rises as it splinters
+  stats["fragmentation"] = freeHeap > 0 ? 100 - (int)((uint64_t)largestBlock * 100 / freeHeap) : 0;
+  
+  std::lock_guard<std::mutex> lock(mutex);
+  JsonObject slabs = stats["jsonSlabs"].to<JsonObject>();
+  slabs["count"] = JSON_ARENA_COUNT;
+  slabs["size"] = JSON_ARENA_SIZE;
+  slabs["leases"] = leases;
+  slabs["fallbacks"] = fallbacks;
+  
+  uint32_t overflows = 0;
+  size_t highWater = 0;
+  for (int i = 0; i < JSON_ARENA_COUNT; i++) {
+    overflows += arenas[i].overflows;
+    if (arenas[i].highWater > highWater) highWater = arenas[i].highWater;
+  }
+  slabs["overflows"] = overflows;
+  slabs["highWater"] = highWater;
+}
+
+String JsonArenaPool::getStatsText() {
+  JsonDocument doc;
+  writeStats(doc.to<JsonObject>());
+  
+  return "Heap - Free: " + String(doc["freeHeap"].as<unsigned long>()) +
+         ", Min free: " + String(doc["minFreeHeap"].as<unsigned long>()) +
+         ", Largest block: " + String(doc["largestFreeBlock"].as<unsigned long>()) +
+         ", Fragmentation: " + String(doc["fragmentation"].as<int>()) + "%\n" +
+         "JSON slabs - " + String(JSON_ARENA_COUNT) + " x " + String((unsigned long)JSON_ARENA_SIZE) + " bytes" +
+         ", High water: " + String(doc["jsonSlabs"]["highWater"].as<unsigned long>()) +
+         ", Leases: " + String(doc["jsonSlabs"]["leases"].as<unsigned long>()) +
+         ", No free slab: " + String(doc["jsonSlabs"]["fallbacks"].as<unsigned long>()) +
+         ", Heap overflows: " + String(doc["jsonSlabs"]["overflows"].as<unsigned long>());
+}
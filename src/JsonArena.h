@@ -0,0 +1,81 @@
+#pragma once
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <mutex>
+
+const size_t JSON_ARENA_SIZE = 8192;  // One slab; enough for every API response but a full debug log
+const int JSON_ARENA_COUNT = 3;       // Documents that can be served from slabs at once
+
+// Bump allocator over one preallocated slab. ArduinoJson frees everything when a document
+// is destroyed, so the slab is simply rewound afterwards instead of returning blocks one
+// by one. Allocations that don't fit spill to the heap and are freed normally.
+class JsonArena : public ArduinoJson::Allocator {
+public:
+  void* allocate(size_t size) override;
+  void deallocate(void* pointer) override;
+  void* reallocate(void* pointer, size_t size) override;
+  
+  void attach(uint8_t* memory);
+  void reset();
+  bool contains(const void* pointer) const;
+
+private:
+  friend class JsonArenaPool;
+  
+  uint8_t* slab = nullptr;
+  size_t top = 0;              // Bytes in use
+  size_t lastBlock = SIZE_MAX; // Offset of the newest block, which can grow or shrink in place
+  size_t highWater = 0;
+  uint32_t overflows = 0;      // Allocations that went to the heap
+  bool inUse = false;
+  
+  size_t blockSize(const void* pointer) const;
+};
+
+class JsonArenaPool {
+public:
+  static JsonArenaPool& getInstance() {
+    static JsonArenaPool instance;
+    return instance;
+  }
+  
+  // Allocates the slabs; call early in setup(), before the heap has fragmented
+  void begin();
+  
+  // Always returns an allocator; when every slab is taken it is a heap-only arena
+  JsonArena* acquire();
+  void release(JsonArena* arena);
+  
+  // Heap fragmentation and slab usage, for /api/info and 'system memory'
+  void writeStats(JsonObject stats);
+  String getStatsText();
+
+private:
+  JsonArenaPool() {}
+  
+  JsonArena arenas[JSON_ARENA_COUNT];
+  JsonArena heapArena;  // No slab: every allocation goes straight to the heap
+  std::mutex mutex;
+  uint32_t leases = 0;
+  uint32_t fallbacks = 0;  // Documents that found no free slab
+};
+
+// Holds a slab for the lifetime of a PooledJsonDocument. A base class so the slab is
+// acquired before the document is built and released after it is destroyed.
+class JsonArenaLease {
+protected:
+  JsonArenaLease() : arena(JsonArenaPool::getInstance().acquire()) {}
+  ~JsonArenaLease() { JsonArenaPool::getInstance().release(arena); }
+  
+  JsonArena* arena;
+};
+
+// Drop-in JsonDocument for request and response handling. Its memory comes from a pooled
+// slab that is reset in one step when the document goes out of scope.
+class PooledJsonDocument : private JsonArenaLease, public JsonDocument {
+public:
+  PooledJsonDocument() : JsonDocument(arena) {}
+  PooledJsonDocument(const PooledJsonDocument&) = delete;
+  PooledJsonDocument& operator=(const PooledJsonDocument&) = delete;
+};
@@ -0,0 +1,180 @@
+#include "LoopProfiler.h"
+#include "Clock.h"
+#include <math.h>
+
+static const char* const PHASE_NAMES[PROFILE_PHASE_COUNT] = {
+  "loop", "update", "sweeps", "sequence", "queue", "realtime", "flush", "i2cWrite", "webUpdate", "serialInput", "serialCommand"
+};
+
+// Bucket i < 4 holds [i, i+1) us; above that each octave [2^k, 2^(k+1)) is split in two
+static int bucketFor(uint32_t micros) {
+  if (micros < 4) return micros;
+  int octave = 31 - __builtin_clz(micros);
+  int index = 4 + (octave - 2) * 2 + ((micros >> (octave - 1)) & 1);
+  return index < PROFILE_HISTOGRAM_BUCKETS ? index : PROFILE_HISTOGRAM_BUCKETS - 1;
+}
+
+static uint32_t bucketUpperMicros(int index) {
+  if (index < 4) return index + 1;
+  int octave = 2 + (index - 4) / 2;
+  return (1UL << octave) + ((index - 4) % 2 + 1) * (1UL << (octave - 1));
+}
+
+void ProfileStats::add(uint32_t cycles, uint32_t cyclesPerMicro) {
+  if (count == 0 || cycles < minCycles) minCycles = cycles;
+  if (cycles > maxCycles) maxCycles = cycles;
+  count++;
+  totalCycles += cycles;
+  buckets[bucketFor(cycles / cyclesPerMicro)]++;
+}
+
+const char* LoopProfiler::getPhaseName(ProfilePhase phase) {
+  return phase < PROFILE_PHASE_COUNT ? PHASE_NAMES[phase] : "unknown";
+}
+
+void LoopProfiler::beginFrame() {
+  if (loopResetPending) applyLoopReset();
+  memset(frame, 0, sizeof(frame));
+  
+  uint32_t now = cycles();
+  if (enabled && intervalStarted) interval.add(now - frameStart, cyclesPerMicro);
+  intervalStarted = enabled;
+  frameStart = now;
+}
+
+void LoopProfiler::endFrame() {
+  addPhase(PROFILE_LOOP, cycles() - frameStart);
+  if (!enabled) return;
+  
+  if (frame[PROFILE_LOOP] > worst[PROFILE_LOOP]) {
+    memcpy(worst, frame, sizeof(worst));
+    worstTime = Clock::getInstance().millis();
+  }
+}
+
+int LoopProfiler::registerHandler(const String& name) {
+  for (int i = 0; i < handlerCount; i++) {
+    if (handlerNames[i] == name) return i;
+  }
+  if (handlerCount >= PROFILE_HANDLER_SLOTS) return -1;
+  
+  handlerNames[handlerCount] = name;
+  return handlerCount++;
+}
+
+void LoopProfiler::addPhase(ProfilePhase phase, uint32_t cycles) {
+  if (!enabled) return;
+  if (loopResetPending) applyLoopReset();
+  
+  phases[phase].add(cycles, cyclesPerMicro);
+  frame[phase] += cycles;
+}
+
+void LoopProfiler::addHandler(int slot, uint32_t cycles) {
+  if (!enabled || slot < 0) return;
+  if (handlerResetPending) {
+    for (int i = 0; i < PROFILE_HANDLER_SLOTS; i++) handlers[i] = ProfileStats();
+    handlerResetPending = false;
+  }
+  
+  handlers[slot].add(cycles, cyclesPerMicro);
+}
+
+void LoopProfiler::reset() {
+  loopResetPending = true;
+  handlerResetPending = true;
+}
+
+void LoopProfiler::applyLoopReset() {
+  for (int i = 0; i < PROFILE_PHASE_COUNT; i++) phases[i] = ProfileStats();
+  memset(worst, 0, sizeof(worst));
+  worstTime = 0;
+  interval = ProfileStats();
+  intervalStarted = false;
+  loopResetPending = false;
+}
+
+float LoopProfiler::percentileMicros(const ProfileStats& stats, float fraction) const {
+  if (stats.count == 0) return 0;
+  
+  // Upper edge of the bucket holding the sample, never above the true maximum
+  uint32_t rank = (uint32_t)ceilf(stats.count * fraction);
+  uint32_t seen = 0;
+  for (int i = 0; i < PROFILE_HISTOGRAM_BUCKETS; i++) {
+    seen += stats.buckets[i];
+    if (seen >= rank) return min((float)bucketUpperMicros(i), toMicros(stats.maxCycles));
+  }
+  return toMicros(stats.maxCycles);
+}
+
+void LoopProfiler::writeSection(JsonObject section, const ProfileStats& stats) const {
+  section["count"] = stats.count;
+  section["minUs"] = toMicros(stats.minCycles);
+  section["avgUs"] = stats.count ? toMicros(stats.totalCycles) / stats.count : 0;
+  section["p99Us"] = percentileMicros(stats, 0.99f);
+  section["maxUs"] = toMicros(stats.maxCycles);
+  
+  JsonArray histogram = section["histogram"].to<JsonArray>();
+  for (int i = 0; i < PROFILE_HISTOGRAM_BUCKETS; i++) {
+    histogram.add(stats.buckets[i]);
+  }
+}
+
+void LoopProfiler::writeStats(JsonObject stats) {
+  stats["enabled"] = (bool)enabled;
+  stats["cpuMhz"] = cyclesPerMicro;
+  
+  // Histogram bucket i counts samples below bucketUpperUs[i] and at or above the one before
+  JsonArray edges = stats["bucketUpperUs"].to<JsonArray>();
+  for (int i = 0; i < PROFILE_HISTOGRAM_BUCKETS; i++) {
+    edges.add(bucketUpperMicros(i));
+  }
+  
+  JsonObject phaseStats = stats["phases"].to<JsonObject>();
+  for (int i = 0; i < PROFILE_PHASE_COUNT; i++) {
+    writeSection(phaseStats[PHASE_NAMES[i]].to<JsonObject>(), phases[i]);
+  }
+  
+  writeSection(stats["tickInterval"].to<JsonObject>(), interval);
+  
+  JsonObject worstFrame = stats["worstFrame"].to<JsonObject>();
+  worstFrame["time"] = worstTime;
+  JsonObject breakdown = worstFrame["phasesUs"].to<JsonObject>();
+  for (int i = 0; i < PROFILE_PHASE_COUNT; i++) {
+    breakdown[PHASE_NAMES[i]] = toMicros(worst[i]);
+  }
+  
+  JsonObject handlerStats = stats["handlers"].to<JsonObject>();
+  for (int i = 0; i < handlerCount; i++) {
+    if (handlers[i].count > 0) writeSection(handlerStats[handlerNames[i]].to<JsonObject>(), handlers[i]);
+  }
+}
+
+String LoopProfiler::formatSection(const char* name, const ProfileStats& stats) const {
+  char line[128];
+  snprintf(line, sizeof(line), "%-24s %8lu %9.1f %9.1f %9.1f %9.1f\n", name, (unsigned long)stats.count,
+           toMicros(stats.minCycles), stats.count ? toMicros(stats.totalCycles) / stats.count : 0.0f,
+           percentileMicros(stats, 0.99f), toMicros(stats.maxCycles));
+  return String(line);
+}
+
+String LoopProfiler::getStatsText() {
+  String text = "Profiler " + String(enabled ? "enabled" : "disabled") + " (us)\n";
+  char line[128];
+  snprintf(line, sizeof(line), "%-24s %8s %9s %9s %9s %9s\n", "Section", "Count", "Min", "Avg", "P99", "Max");
+  text += line;
+  
+  for (int i = 0; i < PROFILE_PHASE_COUNT; i++) {
+    text += formatSection(PHASE_NAMES[i], phases[i]);
+  }
+  text += formatSection("tickInterval", interval);
+  for (int i = 0; i < handlerCount; i++) {
+    if (handlers[i].count > 0) text += formatSection(handlerNames[i].c_str(), handlers[i]);
+  }
+  
+  text += "Slowest pass at " + String(worstTime) + " ms:";
+  for (int i = 0; i < PROFILE_PHASE_COUNT; i++) {
+    if (worst[i] > 0) text += " " + String(PHASE_NAMES[i]) + " " + String(toMicros(worst[i]), 1);
+  }
+  return text;
+}
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+
+const int PROFILE_HISTOGRAM_BUCKETS = 40;  // 0-3 us one each, then two per octave up to ~1 s
+const int PROFILE_HANDLER_SLOTS = 32;      // HTTP routes timed separately
+
+// Timed sections of a loop() pass. Each phase also counts inside the phases around it.
+enum ProfilePhase : uint8_t {
+  PROFILE_LOOP,            // Whole pass, delay(1) excluded
+  PROFILE_UPDATE,          // ServoController::update()
+  PROFILE_SWEEPS,
+  PROFILE_SEQUENCE,
+  PROFILE_QUEUE,
+  PROFILE_REALTIME,        // Stream/UDP/DMX sources and staged targets
+  PROFILE_FLUSH,           // flushOutputs()
+  PROFILE_I2C_WRITE,       // One auto-increment burst; a flush makes one per changed run
+  PROFILE_WEB_UPDATE,      // WebServerManager::update()
+  PROFILE_SERIAL_INPUT,    // processSerialInput()
+  PROFILE_SERIAL_COMMAND,  // executeSerialCommand()
+  PROFILE_PHASE_COUNT
+};
+
+// Durations of one section, in CPU cycles
+struct ProfileStats {
+  uint32_t count = 0;
+  uint32_t minCycles = 0;
+  uint32_t maxCycles = 0;
+  uint64_t totalCycles = 0;
+  uint32_t buckets[PROFILE_HISTOGRAM_BUCKETS] = {};
+  
+  void add(uint32_t cycles, uint32_t cyclesPerMicro);
+};
+
+// Cycle-counter timing of the loop phases, the I2C writes and every HTTP handler. Each
+// section keeps min/avg/max and a microsecond histogram for percentiles, and the phases
+// of the slowest loop pass are kept as a breakdown. The time from the start of one pass
+// to the next is kept as the tick interval; its spread is the motion-tick jitter. A sample
+// costs two cycle-counter reads and a few additions, so the profiler stays compiled in.
+//
+// Loop phases are written only by the loop task and HTTP handlers only by the async_tcp
+// task, so neither needs a lock. A reader on the other task may see a sample half-added.
+class LoopProfiler {
+public:
+  static LoopProfiler& getInstance() {
+    static LoopProfiler instance;
+    return instance;
+  }
+  
+  static uint32_t cycles() { return ESP.getCycleCount(); }
+  
+  // Times the enclosing block as one sample of a loop phase
+  class PhaseScope {
+  public:
+    explicit PhaseScope(ProfilePhase phase) : phase(phase), start(cycles()) {}
+    ~PhaseScope() { getInstance().addPhase(phase, cycles() - start); }
+  private:
+    ProfilePhase phase;
+    uint32_t start;
+  };
+  
+  // Times the enclosing block as one call of a registered HTTP handler
+  class HandlerScope {
+  public:
+    explicit HandlerScope(int slot) : slot(slot), start(cycles()) {}
+    ~HandlerScope() { getInstance().addHandler(slot, cycles() - start); }
+  private:
+    int slot;
+    uint32_t start;
+  };
+  
+  // Bracket each loop() pass; the pass becomes the worst-case capture if it is the slowest,
+  // and beginFrame() also samples the interval since the previous pass began
+  void beginFrame();
+  void endFrame();
+  
+  // Returns the slot for a handler name, or -1 once every slot is taken
+  int registerHandler(const String& name);
+  
+  void addPhase(ProfilePhase phase, uint32_t cycles);
+  void addHandler(int slot, uint32_t cycles);
+  
+  void setEnabled(bool value) { enabled = value; }
+  bool isEnabled() const { return enabled; }
+  // Each task clears its own statistics at its next sample
+  void reset();
+  
+  // For /api/profile and 'system profile'
+  void writeStats(JsonObject stats);
+  String getStatsText();
+  
+  static const char* getPhaseName(ProfilePhase phase);
+
+private:
+  LoopProfiler() : cyclesPerMicro(ESP.getCpuFreqMHz()) {}
+  
+  uint32_t cyclesPerMicro;
+  volatile bool enabled = true;
+  volatile bool loopResetPending = false;
+  volatile bool handlerResetPending = false;
+  
+  ProfileStats phases[PROFILE_PHASE_COUNT];
+  uint32_t frameStart = 0;
+  uint32_t frame[PROFILE_PHASE_COUNT] = {};  // Cycles per phase in the current pass
+  uint32_t worst[PROFILE_PHASE_COUNT] = {};  // Breakdown of the slowest pass
+  unsigned long worstTime = 0;               // Clock millis when it ended
+  ProfileStats interval;                     // Start of one pass to the start of the next
+  bool intervalStarted = false;
+  
+  ProfileStats handlers[PROFILE_HANDLER_SLOTS];
+  String handlerNames[PROFILE_HANDLER_SLOTS];
+  int handlerCount = 0;
+  
+  void applyLoopReset();
+  float toMicros(uint64_t cycles) const { return (float)cycles / cyclesPerMicro; }
+  float percentileMicros(const ProfileStats& stats, float fraction) const;
+  void writeSection(JsonObject section, const ProfileStats& stats) const;
+  String formatSection(const char* name, const ProfileStats& stats) const;
+};
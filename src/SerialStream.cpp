@@ -0,0 +1,183 @@
+#include "SerialStream.h"
+#include "Clock.h"
+
+const uint8_t SerialStream::ENTRY_MAGIC[4] = {0xFE, 0xED, 0xBE, 0xEF};
+
+SerialStream::SerialStream(HardwareSerial& serial, ServoController& controller)
+  : serial(serial), controller(controller) {
+  active = false;
+  magicMatched = 0;
+  state = WAIT_SYNC;
+  frameLength = 0;
+  frameType = 0;
+  payloadIndex = 0;
+  frameCrc = 0;
+  frameCount = 0;
+  crcErrorCount = 0;
+  overflowCount = 0;
+  timeoutCount = 0;
+  lastFrameTime = 0;
+}
+
+bool SerialStream::matchEntryMagic(uint8_t byte) {
+  if (byte == ENTRY_MAGIC[magicMatched]) {
+    magicMatched++;
+  } else {
+    magicMatched = (byte == ENTRY_MAGIC[0]) ? 1 : 0;
+  }
+  
+  if (magicMatched == sizeof(ENTRY_MAGIC)) {
+    magicMatched = 0;
+    return true;
+  }
+  return false;
+}
+
+void SerialStream::begin() {
+  DebugConsole::getInstance().log("Serial stream: entering binary mode", "info");
+  
+  // Acknowledge at the console rate, then switch; the host changes baud after the ACK
+  serial.write(FRAME_ACK);
+  serial.flush();
+  serial.updateBaudRate(STREAM_BAUD);
+  
+  state = WAIT_SYNC;
+  lastFrameTime = Clock::getInstance().millis();
+  active = true;
+}
+
+void SerialStream::end() {
+  serial.flush();
+  serial.updateBaudRate(CONSOLE_BAUD);
+  active = false;
+  
+  DebugConsole::getInstance().logf("info", "Serial stream: leaving binary mode (%lu frames, %lu CRC errors, %lu overflows)",
+                                   (unsigned long)frameCount, (unsigned long)crcErrorCount, (unsigned long)overflowCount);
+}
+
+void SerialStream::poll() {
+  uint8_t buffer[256];
+  
+  // Drain in bulk rather than a byte per call; the UART driver buffers RX_BUFFER_SIZE bytes
+  int available = serial.available();
+  while (active && available > 0) {
+    size_t count = serial.read(buffer, min((size_t)available, sizeof(buffer)));
+    feed(buffer, count);
+    available = serial.available();
+  }
+  
+  // Noise or a stalled host does not count as activity, only frames that pass the CRC
+  if (active && Clock::getInstance().millis() - lastFrameTime >= INACTIVITY_TIMEOUT_MS) {
+    timeoutCount++;
+    DebugConsole::getInstance().logf("error", "Serial stream: no valid frame for %lums", INACTIVITY_TIMEOUT_MS);
+    end();
+  }
+}
+
+void SerialStream::feed(const uint8_t* data, size_t len) {
+  for (size_t i = 0; i < len && active; i++) {
+    uint8_t byte = data[i];
+    
+    switch (state) {
+      case WAIT_SYNC:
+        if (byte == FRAME_SYNC) state = LENGTH_LO;
+        break;
+      case LENGTH_LO:
+        frameLength = byte;
+        state = LENGTH_HI;
+        break;
+      case LENGTH_HI:
+        frameLength |= (uint16_t)byte << 8;
+        if (frameLength > MAX_PAYLOAD) {
+          overflowCount++;
+          state = WAIT_SYNC;
+        } else {
+          state = TYPE;
+        }
+        break;
+      case TYPE:
+        frameType = byte;
+        payloadIndex = 0;
+        state = (frameLength > 0) ? PAYLOAD : CRC_LO;
+        break;
+      case PAYLOAD:
+        payload[payloadIndex++] = byte;
+        if (payloadIndex == frameLength) state = CRC_LO;
+        break;
+      case CRC_LO:
+        frameCrc = byte;
+        state = CRC_HI;
+        break;
+      case CRC_HI: {
+        frameCrc |= (uint16_t)byte << 8;
+        state = WAIT_SYNC;
+        
+        uint8_t header[3] = {(uint8_t)(frameLength & 0xFF), (uint8_t)(frameLength >> 8), frameType};
+        uint16_t crc = crc16(0xFFFF, header, sizeof(header));
+        crc = crc16(crc, payload, frameLength);
+        if (crc == frameCrc) {
+          frameCount++;
+          lastFrameTime = Clock::getInstance().millis();
+          handleFrame();
+        } else {
+          crcErrorCount++;
+        }
+        break;
+      }
+    }
+  }
+}
+
+void SerialStream::handleFrame() {
+  switch (frameType) {
+    case FRAME_POSITIONS: {
+      if (frameLength < 2 || (frameLength & 1)) return;
+      uint16_t firstChannel = payload[0] | ((uint16_t)payload[1] << 8);
+      int count = (frameLength - 2) / 2;
+      for (int i = 0; i < count; i++) {
+        positions[i] = payload[2 + 2 * i] | ((uint16_t)payload[3 + 2 * i] << 8);
+      }
+      controller.applyChannelPositions(firstChannel, count, positions);
+      break;
+    }
+    case FRAME_STATS:
+      sendStats();
+      break;
+    case FRAME_EXIT:
+      end();
+      break;
+    default:
+      break;
+  }
+}
+
+void SerialStream::sendStats() {
+  uint8_t frame[1 + 3 + 12 + 2];
+  uint32_t counters[3] = {frameCount, crcErrorCount, overflowCount};
+  
+  frame[0] = FRAME_SYNC;
+  frame[1] = 12;
+  frame[2] = 0;
+  frame[3] = FRAME_STATS_REPLY;
+  for (int c = 0; c < 3; c++) {
+    for (int b = 0; b < 4; b++) {
+      frame[4 + c * 4 + b] = (counters[c] >> (8 * b)) & 0xFF;
+    }
+  }
+  uint16_t crc = crc16(0xFFFF, &frame[1], 3 + 12);
+  frame[16] = crc & 0xFF;
+  frame[17] = crc >> 8;
+  
+  serial.write(frame, sizeof(frame));
+}
+
+uint16_t SerialStream::crc16(uint16_t crc, const uint8_t* data, size_t len) {
+  // CRC-16/CCITT-FALSE (poly 0x1021, init 0xFFFF)
+  for (size_t i = 0; i < len; i++) {
+    crc ^= (uint16_t)data[i] << 8;
+    for (int bit = 0; bit < 8; bit++) {
+      crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : (crc << 1);
+    }
+  }
+  return crc;
+}
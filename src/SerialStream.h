@@ -0,0 +1,93 @@
+#pragma once
+
+#include <Arduino.h>
+#include "ServoController.h"
+
+// Binary streaming protocol for host-driven animation over the serial port.
+//
+// The text console switches to binary mode when it receives ENTRY_MAGIC. The device
+// answers with a single ACK byte and moves the UART to STREAM_BAUD. From then on the
+// host sends frames:
+//
+//   0xA5 | length (u16 LE) | type (u8) | payload[length] | CRC16-CCITT (u16 LE)
+//
+// The CRC covers the length, type and payload bytes. Frames with a bad CRC are dropped
+// and the decoder resynchronises on the next sync byte. No per-frame reply is sent.
+// Nothing else may write to the UART once the console is up (web handlers and other tasks
+// log through DebugConsole), or the host would read stray text as a stats reply.
+//
+//   FRAME_POSITIONS  payload = first channel (u16 LE), then one u16 LE position per
+//                    channel (0-65535 = 0-100%), channel = board * 16 + servo
+//   FRAME_STATS      device replies with a FRAME_STATS_REPLY frame carrying the
+//                    frame, CRC error and overflow counters (3 x u32 LE)
+//   FRAME_EXIT       return to text mode at the console baud rate
+//
+// A host that goes away without sending FRAME_EXIT would otherwise leave the console
+// deaf: after INACTIVITY_TIMEOUT_MS without a valid frame the device also returns to
+// text mode at the console baud rate.
+
+class SerialStream {
+public:
+  static const uint32_t CONSOLE_BAUD = 115200;
+  static const uint32_t STREAM_BAUD = 921600;
+  static const size_t RX_BUFFER_SIZE = 4096;
+  static const unsigned long INACTIVITY_TIMEOUT_MS = 2000;
+  
+  static const uint8_t FRAME_SYNC = 0xA5;
+  static const uint8_t FRAME_ACK = 0x06;
+  static const uint8_t FRAME_POSITIONS = 0x01;
+  static const uint8_t FRAME_STATS = 0x02;
+  static const uint8_t FRAME_EXIT = 0x03;
+  static const uint8_t FRAME_STATS_REPLY = 0x82;
+  static const size_t MAX_PAYLOAD = 2 + 2 * MAX_BOARDS * SERVOS_PER_BOARD;
+  
+  SerialStream(HardwareSerial& serial, ServoController& controller);
+  
+  // Text mode: feed every received byte; returns true once the entry sequence completes
+  bool matchEntryMagic(uint8_t byte);
+  
+  void begin();   // Enter binary mode
+  void end();     // Leave binary mode
+  bool isActive() const { return active; }
+  
+  // Binary mode: drain the UART, apply every complete frame, and leave binary mode once
+  // no valid frame has arrived for INACTIVITY_TIMEOUT_MS
+  void poll();
+  
+  // Decoder entry point, usable without a UART
+  void feed(const uint8_t* data, size_t len);
+  
+  uint32_t getFrameCount() const { return frameCount; }
+  uint32_t getCrcErrorCount() const { return crcErrorCount; }
+  uint32_t getOverflowCount() const { return overflowCount; }
+  uint32_t getTimeoutCount() const { return timeoutCount; }
+  
+  static uint16_t crc16(uint16_t crc, const uint8_t* data, size_t len);
+  
+private:
+  enum DecoderState { WAIT_SYNC, LENGTH_LO, LENGTH_HI, TYPE, PAYLOAD, CRC_LO, CRC_HI };
+  
+  static const uint8_t ENTRY_MAGIC[4];
+  
+  HardwareSerial& serial;
+  ServoController& controller;
+  bool active;
+  int magicMatched;
+  
+  DecoderState state;
+  uint16_t frameLength;
+  uint8_t frameType;
+  uint16_t payloadIndex;
+  uint16_t frameCrc;
+  uint8_t payload[MAX_PAYLOAD];
+  uint16_t positions[MAX_BOARDS * SERVOS_PER_BOARD];
+  
+  uint32_t frameCount;
+  uint32_t crcErrorCount;
+  uint32_t overflowCount;
+  uint32_t timeoutCount;
+  unsigned long lastFrameTime;  // Entry into binary mode, then each valid frame
+  
+  void handleFrame();
+  void sendStats();
+};
@@ -0,0 +1,163 @@
+#include "ServoConfigSchema.h"
+
+static_assert(SERVO_FIELD_COUNT <= 16, "Field projections use a 16-bit mask");
+static_assert(SERVO_PACKED_SIZE == 47, "SERVO_FIELDS packing no longer matches CONFIG_FORMAT_BINARY");
+
+static uint8_t* fieldPointer(ServoConfig& config, const SchemaField& field) {
+  return reinterpret_cast<uint8_t*>(&config) + field.offset;
+}
+
+static const uint8_t* fieldPointer(const ServoConfig& config, const SchemaField& field) {
+  return reinterpret_cast<const uint8_t*>(&config) + field.offset;
+}
+
+static bool inBounds(const SchemaField& field, float value) {
+  return value >= field.minValue && value <= field.maxValue;
+}
+
+int findServoField(const char* name, size_t length) {
+  int index = SERVO_FIELD_HASH.slots[schemaHash(name, length, SERVO_FIELD_SEED) & (SERVO_FIELD_HASH_SIZE - 1)];
+  if (index < 0) return -1;
+  
+  // The hash is only perfect for known names; anything else may land on a used slot
+  const char* candidate = SERVO_FIELDS[index].name;
+  return (strncmp(candidate, name, length) == 0 && candidate[length] == '\0') ? index : -1;
+}
+
+bool setServoField(ServoConfig& config, int index, const String& value) {
+  const SchemaField& field = SERVO_FIELDS[index];
+  uint8_t* target = fieldPointer(config, field);
+  
+  switch (field.type) {
+    case SCHEMA_BOOL:
+      *reinterpret_cast<bool*>(target) = (value == "true" || value == "1");
+      return true;
+    
+    case SCHEMA_FLOAT: {
+      float number = value.toFloat();
+      if (!inBounds(field, number)) return false;
+      *reinterpret_cast<float*>(target) = number;
+      return true;
+    }
+    
+    case SCHEMA_INT: {
+      int number = value.toInt();
+      if (!inBounds(field, number)) return false;
+      *reinterpret_cast<int*>(target) = number;
+      return true;
+    }
+    
+    case SCHEMA_STRING:
+      strncpy(reinterpret_cast<char*>(target), value.c_str(), field.size - 1);
+      target[field.size - 1] = '\0';
+      return true;
+  }
+  return false;
+}
+
+void writeServoJson(const ServoConfig& config, JsonObject object, uint16_t fields) {
+  for (int i = 0; i < SERVO_FIELD_COUNT; i++) {
+    if (!(fields & (1 << i))) continue;
+    
+    const SchemaField& field = SERVO_FIELDS[i];
+    const uint8_t* source = fieldPointer(config, field);
+    switch (field.type) {
+      case SCHEMA_BOOL:
+        object[field.name] = *reinterpret_cast<const bool*>(source);
+        break;
+      case SCHEMA_FLOAT:
+        object[field.name] = *reinterpret_cast<const float*>(source);
+        break;
+      case SCHEMA_INT:
+        object[field.name] = *reinterpret_cast<const int*>(source);
+        break;
+      case SCHEMA_STRING:
+        object[field.name] = reinterpret_cast<const char*>(source);
+        break;
+    }
+  }
+}
+
+void readServoJson(ServoConfig& config, JsonObjectConst object) {
+  // Walk the object rather than the table so each key costs one hash lookup
+  for (JsonPairConst pair : object) {
+    int index = findServoField(pair.key().c_str(), pair.key().size());
+    if (index < 0) continue;
+    
+    const SchemaField& field = SERVO_FIELDS[index];
+    uint8_t* target = fieldPointer(config, field);
+    JsonVariantConst value = pair.value();
+    switch (field.type) {
+      case SCHEMA_BOOL:
+        *reinterpret_cast<bool*>(target) = value.as<bool>();
+        break;
+      case SCHEMA_FLOAT:
+        if (inBounds(field, value.as<float>())) *reinterpret_cast<float*>(target) = value.as<float>();
+        break;
+      case SCHEMA_INT:
+        if (inBounds(field, value.as<int>())) *reinterpret_cast<int*>(target) = value.as<int>();
+        break;
+      case SCHEMA_STRING:
+        if (value.is<const char*>()) {
+          strncpy(reinterpret_cast<char*>(target), value.as<const char*>(), field.size - 1);
+          target[field.size - 1] = '\0';
+        }
+        break;
+    }
+  }
+}
+
+void packServoRecord(const ServoConfig& config, uint8_t* record) {
+  memset(record, 0, SERVO_PACKED_SIZE);
+  
+  for (const SchemaField& field : SERVO_FIELDS) {
+    const uint8_t* source = fieldPointer(config, field);
+    uint8_t* out = record + field.packedOffset;
+    switch (field.type) {
+      case SCHEMA_BOOL:
+        if (*reinterpret_cast<const bool*>(source)) *out |= (1 << field.packedBit);
+        break;
+      case SCHEMA_FLOAT:
+        memcpy(out, source, sizeof(float));
+        break;
+      case SCHEMA_INT:
+        *reinterpret_cast<int8_t*>(out) = (int8_t)*reinterpret_cast<const int*>(source);
+        break;
+      case SCHEMA_STRING:
+        memcpy(out, source, field.size);
+        out[field.size - 1] = '\0';
+        break;
+    }
+  }
+}
+
+void unpackServoRecord(ServoConfig& config, const uint8_t* record) {
+  for (const SchemaField& field : SERVO_FIELDS) {
+    uint8_t* target = fieldPointer(config, field);
+    const uint8_t* in = record + field.packedOffset;
+    switch (field.type) {
+      case SCHEMA_BOOL:
+        *reinterpret_cast<bool*>(target) = (*in >> field.packedBit) & 1;
+        break;
+      case SCHEMA_FLOAT:
+        memcpy(target, in, sizeof(float));
+        break;
+      case SCHEMA_INT:
+        *reinterpret_cast<int*>(target) = *reinterpret_cast<const int8_t*>(in);
+        break;
+      case SCHEMA_STRING:
+        memcpy(target, in, field.size);
+        target[field.size - 1] = '\0';
+        break;
+    }
+  }
+}
+
+String servoFieldNames() {
+  String names;
+  for (int i = 0; i < SERVO_FIELD_COUNT; i++) {
+    if (i > 0) names += ", ";
+    names += SERVO_FIELDS[i].name;
+  }
+  return names;
+}
@@ -0,0 +1,144 @@
+#pragma once
+
+#include "ServoController.h"
+#include <stddef.h>
+
+// Field table for ServoConfig.
+//
+// Every format goes through this one table: JSON encode/decode, the packed binary slot
+// record, updateServoConfig (the web API, PATCH and the 'config' command) and the field
+// projections on /api/config. Adding a field here adds it everywhere.
+// Names are found through a perfect hash computed at compile time.
+
+enum SchemaFieldType : uint8_t {
+  SCHEMA_BOOL,
+  SCHEMA_FLOAT,
+  SCHEMA_INT,     // Stored as int, packed as int8
+  SCHEMA_STRING   // Fixed char array, size includes the terminator
+};
+
+struct SchemaField {
+  const char* name;
+  uint16_t offset;        // Byte offset in ServoConfig
+  SchemaFieldType type;
+  uint8_t size;           // String capacity
+  float minValue;         // Accepted range for numeric fields
+  float maxValue;
+  uint8_t packedOffset;   // Byte position in the binary servo record
+  uint8_t packedBit;      // Bit within that byte, for SCHEMA_BOOL
+};
+
+// The packed positions reproduce CONFIG_FORMAT_BINARY's servo record: one flags byte,
+// pairBoard, pairServo, three floats, then the name
+constexpr SchemaField SERVO_FIELDS[] = {
+  {"enabled",      offsetof(ServoConfig, enabled),      SCHEMA_BOOL,   0, 0, 1,                         0, 0},
+  {"center",       offsetof(ServoConfig, center),       SCHEMA_FLOAT,  0, 0, 100,                       3, 0},
+  {"range",        offsetof(ServoConfig, range),        SCHEMA_FLOAT,  0, 0, 50,                        7, 0},
+  {"initPosition", offsetof(ServoConfig, initPosition), SCHEMA_FLOAT,  0, 0, 100,                       11, 0},
+  {"isPair",       offsetof(ServoConfig, isPair),       SCHEMA_BOOL,   0, 0, 1,                         0, 1},
+  {"pairBoard",    offsetof(ServoConfig, pairBoard),    SCHEMA_INT,    0, -1, MAX_BOARDS - 1,           1, 0},
+  {"pairServo",    offsetof(ServoConfig, pairServo),    SCHEMA_INT,    0, -1, SERVOS_PER_BOARD - 1,     2, 0},
+  {"isPairMaster", offsetof(ServoConfig, isPairMaster), SCHEMA_BOOL,   0, 0, 1,                         0, 2},
+  {"name",         offsetof(ServoConfig, name),         SCHEMA_STRING, sizeof(ServoConfig::name), 0, 0, 15, 0},
+};
+
+constexpr int SERVO_FIELD_COUNT = sizeof(SERVO_FIELDS) / sizeof(SERVO_FIELDS[0]);
+constexpr uint16_t SERVO_FIELDS_ALL = (1 << SERVO_FIELD_COUNT) - 1;
+
+constexpr size_t schemaPackedSize(const SchemaField& field) {
+  return field.type == SCHEMA_BOOL ? 1 : field.type == SCHEMA_FLOAT ? sizeof(float) :
+         field.type == SCHEMA_INT ? 1 : field.size;
+}
+
+constexpr size_t servoPackedRecordSize() {
+  size_t size = 0;
+  for (const SchemaField& field : SERVO_FIELDS) {
+    size_t end = field.packedOffset + schemaPackedSize(field);
+    if (end > size) size = end;
+  }
+  return size;
+}
+
+constexpr size_t SERVO_PACKED_SIZE = servoPackedRecordSize();
+
+// ---------------------------------------------------------------------------------------
+// Compile-time perfect hash over the field names
+// ---------------------------------------------------------------------------------------
+
+constexpr int SERVO_FIELD_HASH_SIZE = 16;  // Power of two, at least the field count
+
+constexpr uint32_t schemaHash(const char* name, size_t length, uint32_t seed) {
+  uint32_t hash = 2166136261u ^ seed;  // FNV-1a
+  for (size_t i = 0; i < length; i++) {
+    hash ^= (uint8_t)name[i];
+    hash *= 16777619u;
+  }
+  return hash ^ (hash >> 16);  // Fold the high half down; slots use the low bits
+}
+
+constexpr size_t schemaLength(const char* name) {
+  size_t length = 0;
+  while (name[length]) length++;
+  return length;
+}
+
+constexpr uint32_t SCHEMA_NO_SEED = 0xFFFFFFFF;
+
+// Tries seeds until every name lands in its own slot
+constexpr uint32_t findSchemaSeed() {
+  for (uint32_t seed = 0; seed < 10000; seed++) {
+    bool used[SERVO_FIELD_HASH_SIZE] = {};
+    bool collision = false;
+    for (const SchemaField& field : SERVO_FIELDS) {
+      uint32_t slot = schemaHash(field.name, schemaLength(field.name), seed) & (SERVO_FIELD_HASH_SIZE - 1);
+      if (used[slot]) {
+        collision = true;
+        break;
+      }
+      used[slot] = true;
+    }
+    if (!collision) return seed;
+  }
+  return SCHEMA_NO_SEED;
+}
+
+constexpr uint32_t SERVO_FIELD_SEED = findSchemaSeed();
+static_assert(SERVO_FIELD_SEED != SCHEMA_NO_SEED, "No perfect hash seed for SERVO_FIELDS; grow SERVO_FIELD_HASH_SIZE");
+
+struct SchemaHashTable {
+  int8_t slots[SERVO_FIELD_HASH_SIZE];  // Field index, or -1
+};
+
+constexpr SchemaHashTable buildSchemaHashTable() {
+  SchemaHashTable table = {};
+  for (int i = 0; i < SERVO_FIELD_HASH_SIZE; i++) table.slots[i] = -1;
+  for (int i = 0; i < SERVO_FIELD_COUNT; i++) {
+    const char* name = SERVO_FIELDS[i].name;
+    table.slots[schemaHash(name, schemaLength(name), SERVO_FIELD_SEED) & (SERVO_FIELD_HASH_SIZE - 1)] = i;
+  }
+  return table;
+}
+
+constexpr SchemaHashTable SERVO_FIELD_HASH = buildSchemaHashTable();
+
+// ---------------------------------------------------------------------------------------
+// Field access
+// ---------------------------------------------------------------------------------------
+
+// Index into SERVO_FIELDS for a field name, or -1; one hash and one compare
+int findServoField(const char* name, size_t length);
+inline int findServoField(const String& name) { return findServoField(name.c_str(), name.length()); }
+
+// Parses and bounds-checks a text value (web API, 'config' command) into the field
+bool setServoField(ServoConfig& config, int field, const String& value);
+
+// JSON encode/decode; fields is a bitmask of SERVO_FIELDS indices
+void writeServoJson(const ServoConfig& config, JsonObject object, uint16_t fields = SERVO_FIELDS_ALL);
+void readServoJson(ServoConfig& config, JsonObjectConst object);
+
+// Binary servo record of SERVO_PACKED_SIZE bytes
+void packServoRecord(const ServoConfig& config, uint8_t* record);
+void unpackServoRecord(ServoConfig& config, const uint8_t* record);
+
+// Comma-separated list of field names, for help and error messages
+String servoFieldNames();
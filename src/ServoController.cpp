@@ -6,14 +6,21 @@ ServoController::ServoController() {
   activeSweepCount = 0;
   scriptRecursionDepth = 0;
   
-  // Initialize all board pointers to nullptr
-  for (int i = 0; i < MAX_BOARDS; i++) {
-    boards[i].detected = false;
-    boards[i].enabled = false;
-    boards[i].driver = nullptr;
-    boards[i].address = 0;
-    strcpy(boards[i].name, "");
-  }
+  // Board storage is allocated by scanForBoards() once the boards are known
+  boards = nullptr;
+  servoConfigs = nullptr;
+  sweepActions = nullptr;
+  pendingPulse = nullptr;
+  dirtyChannels = nullptr;
+  stagedTarget = nullptr;
+  stagedChannels = nullptr;
+  realtimeDriven = nullptr;
+  servoVersions = nullptr;
+  segments = nullptr;
+  segmentCount = 0;
+  selectedSegment = -1;
+  detectedMuxes = 0;
+  muxSwitchCount = 0;
   
   // Initialize script actions
   for (int i = 0; i < MAX_SCRIPTS; i++) {
@@ -23,26 +30,35 @@ ServoController::ServoController() {
     scriptActions[i].enabled = false;
   }
   
-  // Initialize sweep actions
-  for (int i = 0; i < MAX_BOARDS * SERVOS_PER_BOARD; i++) {
-    sweepActions[i].active = false;
-  }
-  
   // Initialize command sequence
   commandSequence.active = false;
   commandSequence.currentIndex = 0;
   commandSequence.totalCount = 0;
   commandSequence.waitUntil = 0;
   
-  initializeServoConfigs();
+  // Initialize realtime frame source
+  realtimeLastSequence = 0;
+  realtimeLastFrameTime = 0;
+  realtimeActive = false;
+  realtimeTimeoutMs = DEFAULT_REALTIME_TIMEOUT;
+  realtimeTimeoutMode = REALTIME_HOLD;
+  realtimeFramesAccepted = 0;
+  realtimeFramesDropped = 0;
+  
+  // Initialize configuration versioning
+  configVersion = 1;
+  configBootId = esp_random();
+  scriptsVersion = 0;
+  
+  // Initialize write-behind persistence
+  persistenceTask = nullptr;
+  saveDirty = false;
+  saveFlushRequested = false;
+  lastSaveRequest = 0;
+  saveRequestsPending = 0;
+  configSaveCount = 0;
 }
 
 ServoController::~ServoController() {
-  // Clean up dynamically allocated drivers
-  for (int i = 0; i < MAX_BOARDS; i++) {
-    if (boards[i].driver) {
-      delete boards[i].driver;
-      boards[i].driver = nullptr;
-    }
-  }
+  freeBoardStorage();
 }
\ No newline at end of file
@@ -6,7 +6,13 @@
 #include <LittleFS.h>
 #include <ArduinoJson.h>
 #include <queue>
+#include <mutex>
 #include "DebugConsole.h"
+#include "Clock.h"
+#include "CommandRecorder.h"
+#include "LoopProfiler.h"
+#include "EventTrace.h"
+#include "HeapTracker.h"
 
 #define SERVOMIN  150 // This is the 'minimum' pulse length count (out of 4096)
 #define SERVOMAX  600 // This is the 'maximum' pulse length count (out of 4096)
@@ -17,16 +23,30 @@
 #define USMIDPOINT ((USMAX+USMIN)/2)
 #define USDEVIATION ((USMAX-USMIN)/2)
 
-const int MAX_BOARDS = 8;        // Maximum number of PCA9685 boards
+#define PCA9685_OSC_FREQ 27000000 // Oscillator frequency configured on every board
+
+const int MAX_BOARDS = 64;       // Board index limit; per-board storage is sized to the boards found
 const int SERVOS_PER_BOARD = 16; // 16 servos per PCA9685 board
+const int BOARD_ADDRESSES = 8;   // PCA9685 addresses probed on each I2C segment, 0x40-0x47
+const int MAX_MUXES = 8;         // TCA9548A I2C multiplexers, at 0x70-0x77
+const int MUX_CHANNELS = 8;      // Downstream buses per multiplexer
+const uint8_t MUX_BASE_ADDRESS = 0x70;
 const int MAX_SCRIPTS = 20;      // Maximum number of script actions
+const int MAX_BATCH_ITEMS = MAX_BOARDS * SERVOS_PER_BOARD; // Maximum items in one batch request
+const unsigned long DEFAULT_REALTIME_TIMEOUT = 500; // Realtime source silence before fallback (ms)
+const unsigned long SAVE_QUIET_PERIOD = 2000; // Config changes are written once edits pause this long (ms)
+const unsigned long SAVE_POLL_INTERVAL = 250; // How often the persistence task checks for pending saves (ms)
 
-// PCA9685 board structure
+// PCA9685 board structure. A board is identified by (mux, muxChannel, address): boards
+// behind different multiplexer channels may share an I2C address.
 struct PCA9685Board {
+  int8_t mux;             // TCA9548A index (address - MUX_BASE_ADDRESS), -1 on the main bus
+  uint8_t muxChannel;     // Downstream channel of that multiplexer
   uint8_t address;
   bool detected;
   bool enabled;
   Adafruit_PWMServoDriver* driver;
+  uint8_t prescale;       // Cached PWM prescale so pulse conversion needs no I2C read
   char name[32];
 };
 
@@ -54,7 +74,7 @@ struct ScriptAction {
 // Command queue item structure
 struct QueuedCommand {
   String command;         // Command to execute
-  unsigned long executeTime; // When to execute (millis())
+  unsigned long executeTime; // When to execute (Clock millis)
 };
 
 struct CommandSequence {
@@ -65,6 +85,34 @@ struct CommandSequence {
   bool active;            // Whether this sequence is active
 };
 
+// One servo position inside a batch frame
+struct PositionTarget {
+  int boardIndex;
+  int servoIndex;
+  float position;
+};
+
+// Header at the start of each A/B configuration slot file; the payload follows it
+struct ConfigSlotHeader {
+  uint32_t magic;         // CONFIG_SLOT_MAGIC
+  uint16_t format;        // Payload encoding (CONFIG_FORMAT_JSON)
+  uint16_t reserved;
+  uint32_t generation;    // Incremented on every save; the newest valid slot wins at boot
+  uint32_t length;        // Payload bytes after the header
+  uint32_t crc;           // CRC-32 of the payload
+};
+
+const uint32_t CONFIG_SLOT_MAGIC = 0x4643584E; // "NXCF"
+const uint16_t CONFIG_FORMAT_JSON = 1;   // Written by earlier firmware; still loadable
+const uint16_t CONFIG_FORMAT_BINARY = 2; // Packed board, servo and script records; main bus only
+const uint16_t CONFIG_FORMAT_BINARY_MUX = 3; // As CONFIG_FORMAT_BINARY, board records lead with their mux channel
+
+// What happens to realtime-driven servos when their frame source goes quiet
+enum RealtimeTimeoutMode {
+  REALTIME_HOLD,          // Keep the last received positions
+  REALTIME_RETURN_INIT    // Move back to each servo's initPosition
+};
+
 struct SweepAction {
   int boardIndex;
   int servoIndex;
@@ -75,24 +123,75 @@ struct SweepAction {
   bool active;
 };
 
+// Boards sharing one I2C segment: the main bus, or one channel of one multiplexer
+struct BusSegment {
+  int8_t mux;
+  uint8_t muxChannel;
+  int firstBoard;         // Boards are numbered in scan order, so a segment's boards are contiguous
+  int boardCount;
+};
+
 class ServoController {
 private:
-  PCA9685Board boards[MAX_BOARDS];
-  ServoConfig servoConfigs[MAX_BOARDS][SERVOS_PER_BOARD];
+  // Per-board storage, allocated by scanForBoards() for the boards it finds
+  PCA9685Board* boards;
+  ServoConfig (*servoConfigs)[SERVOS_PER_BOARD];
   ScriptAction scriptActions[MAX_SCRIPTS];
   std::queue<QueuedCommand> commandQueue;
-  SweepAction sweepActions[MAX_BOARDS * SERVOS_PER_BOARD];
+  SweepAction* sweepActions;  // One slot per servo
   CommandSequence commandSequence;
   int detectedBoardCount;
   int scriptCount;
   int activeSweepCount;
   int scriptRecursionDepth;
   
+  // Output frame: servo writes are staged here and flushed to the boards once per motion tick
+  uint16_t (*pendingPulse)[SERVOS_PER_BOARD];
+  uint16_t* dirtyChannels;  // Bitmask of channels changed since the last flush
+  std::recursive_mutex frameMutex;
+  
+  // I2C segments in scan order, and the multiplexer channel currently switched in
+  BusSegment* segments;
+  int segmentCount;
+  int selectedSegment;      // -1 when no multiplexer channel is selected
+  uint8_t detectedMuxes;    // Bitmask of multiplexers found by the scan
+  uint32_t muxSwitchCount;
+  
+  // Staged targets: newest requested position per servo, applied at the next motion tick
+  float (*stagedTarget)[SERVOS_PER_BOARD];
+  uint16_t* stagedChannels;
+  
+  // Realtime frame source state
+  uint32_t realtimeLastSequence;
+  unsigned long realtimeLastFrameTime;
+  bool realtimeActive;
+  uint16_t* realtimeDriven;  // Channels the current realtime session has moved
+  unsigned long realtimeTimeoutMs;
+  RealtimeTimeoutMode realtimeTimeoutMode;
+  uint32_t realtimeFramesAccepted;
+  uint32_t realtimeFramesDropped;
+  
+  // Configuration versioning: every change bumps configVersion and stamps what changed
+  uint32_t configVersion;
+  uint32_t configBootId;  // Distinguishes versions across reboots
+  uint32_t (*servoVersions)[SERVOS_PER_BOARD];
+  uint32_t scriptsVersion;
+  
+  // Write-behind persistence: changes mark the config dirty and a background task saves it
+  TaskHandle_t persistenceTask;
+  std::mutex saveMutex;              // Serializes flash writes between the task and direct saves
+  volatile bool saveDirty;
+  volatile bool saveFlushRequested;
+  volatile unsigned long lastSaveRequest;
+  uint32_t saveRequestsPending;      // Changes coalesced into the next write
+  uint32_t configSaveCount;
+  
   // Common I2C addresses for PCA9685 boards
-  uint8_t commonAddresses[8] = {0x40, 0x41, 0x42, 0x43, 0x44, 0x45, 0x46, 0x47};
+  uint8_t commonAddresses[BOARD_ADDRESSES] = {0x40, 0x41, 0x42, 0x43, 0x44, 0x45, 0x46, 0x47};
   
   // Configuration file paths
-  const char* CONFIG_FILE = "/servo_config.json";
+  const char* CONFIG_FILE = "/servo_config.json";  // Pre-slot format, read once for migration
+  const char* CONFIG_SLOT_FILES[2] = {"/servo_config_a.cfg", "/servo_config_b.cfg"};
   const char* OFFLINE_CONFIG_FILE = "/offline_config.json";
   
 public:
@@ -100,7 +199,7 @@ public:
   ~ServoController();
   
   // Hardware management
-  void scanForBoards();
+  void scanForBoards();   // Main bus, then every channel of every TCA9548A found
   void initializeBoards();
   void initializeServoConfigs();
   
@@ -109,6 +208,25 @@ public:
   void setServoToConfiguredPosition(int boardIndex, int servonum, float position);
   void applyInitialPositions();
   
+  // Output frame control
+  void beginFrame();    // Hold output flushing so every move until endFrame() lands in one frame
+  void endFrame();
+  void flushOutputs();  // Write all changed channels to the boards, one I2C burst per channel run
+  uint32_t getMuxSwitchCount() const { return muxSwitchCount; }
+  
+  // Batch control
+  bool validatePositionTarget(const PositionTarget& target, String& error);
+  void applyPositionFrame(const PositionTarget* targets, int count);
+  void executeCommandBatch(const String* commands, int count, String* results);
+  
+  // Streaming control (channel = board * SERVOS_PER_BOARD + servo, position 0-65535 = 0-100%)
+  int applyChannelPositions(int firstChannel, int count, const uint16_t* positions);
+  void stageServoTarget(int boardIndex, int servoIndex, float position);
+  
+  // Realtime frames: newest sequence wins, applied at the next motion tick
+  bool submitRealtimeFrame(uint32_t sequence, int firstChannel, int count, const uint16_t* positions);
+  void setRealtimeTimeout(unsigned long timeoutMs, RealtimeTimeoutMode mode);
+  
   // Sweep control
   bool startSweep(int boardIndex, int servoIndex, float startPos, float endPos, unsigned long durationMs);
   void stopSweep(int boardIndex, int servoIndex);
@@ -116,7 +234,13 @@ public:
   void updateSweeps();
   
   // Configuration management
-  void saveConfiguration();
+  void saveConfiguration();       // Write to flash now, on the calling task
+  void startPersistence();        // Start the background task that performs deferred saves
+  void requestSave();             // Mark dirty; saved once changes pause for SAVE_QUIET_PERIOD
+  void flushConfiguration();      // Save as soon as possible on the background task
+  bool isSavePending() const { return saveDirty; }
+  uint32_t getConfigSaveCount() const { return configSaveCount; }
+  int applyConfigPatch(JsonArrayConst servos, JsonArray errors);
   void loadConfiguration();
   void saveOfflineConfiguration();
   void loadOfflineConfiguration();
@@ -127,6 +251,13 @@ public:
   const ServoConfig* getServoConfigs() const { return (const ServoConfig*)servoConfigs; }
   ServoConfig* getServoConfig(int boardIndex, int servoIndex);
   
+  // Configuration versioning
+  uint32_t getConfigVersion() const { return configVersion; }
+  uint32_t getConfigBootId() const { return configBootId; }
+  String getConfigEtag() const;
+  uint32_t getServoVersion(int boardIndex, int servoIndex) const { return servoVersions[boardIndex][servoIndex]; }
+  uint32_t getScriptsVersion() const { return scriptsVersion; }
+  
   // JSON serialization
   String getSystemInfoJson();
   String getConfigurationJson();
@@ -149,6 +280,7 @@ public:
   void update();  // Call this regularly to process queued commands
   bool queueCommand(const String& command, unsigned long delayMs = 0);
   void clearQueue();
+  bool isIdle() const;  // No sweep, command sequence or queued command left to run
   
   // Command sequence management
   bool startCommandSequence(String* commands, int count);
@@ -163,8 +295,47 @@ private:
   String executePairCommand(const String& args);
   String executeSweepCommand(const String& args);
   String executeRepeatCommand(const String& args);
+  String executeStreamCommand(const String& args);
   String executeHelpCommand();
+  static uint16_t commandTraceName(const String& mainCommand);
   
   // Queue management helpers
   String executeCommandImmediate(const String& command);
+  
+  // Output helpers
+  void moveServo(int boardIndex, int servonum, float position, bool verbose);
+  void applyStagedTargets();
+  
+  // Versioning helpers
+  void markServoChanged(int boardIndex, int servoIndex);
+  void markScriptsChanged();
+  void markAllChanged();
+  
+  // Persistence helpers
+  bool readConfigSlotHeader(int slot, ConfigSlotHeader& header);
+  bool verifyConfigSlot(int slot, const ConfigSlotHeader& header);
+  int findNewestConfigSlot(ConfigSlotHeader& header);
+  bool writeConfigSlot(const uint8_t* payload, size_t length, uint16_t format, int& slot, uint32_t& generation);
+  bool loadConfigSlot(int slot, const ConfigSlotHeader& header);
+  bool applyConfigurationJson(JsonDocument& doc);
+  void remapPairBoards(const int* boardMap, int recordCount);  // Saved board index -> scanned index
+  
+  // Binary configuration format
+  static size_t binaryConfigSize(int boardCount, int scripts, uint16_t format = CONFIG_FORMAT_BINARY_MUX);
+  size_t encodeBinaryConfig(uint8_t* buffer);
+  bool decodeBinaryConfig(const uint8_t* data, size_t length, uint16_t format);
+  static void persistenceTaskEntry(void* arg);
+  void persistenceLoop();
+  void updateRealtime();
+  uint16_t microsecondsToTicks(int boardIndex, uint16_t microseconds) const;
+  
+  // Board discovery and bus switching
+  void allocateBoardStorage(int count);
+  void freeBoardStorage();
+  bool probeAddress(uint8_t address);
+  bool selectMuxChannel(int mux, int channel);  // channel -1 deselects every channel
+  void selectSegment(int segment);
+  int findBoard(int mux, int muxChannel, uint8_t address) const;
+  void flushBoard(int boardIndex, int segment, bool& traced);
+  void writeChannelRun(int boardIndex, int firstServo, int count, const uint16_t* pulses);
 };
\ No newline at end of file
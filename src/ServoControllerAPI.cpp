@@ -1,77 +1,79 @@
 #include "ServoController.h"
+#include "ConfigJsonStream.h"
+#include "ServoConfigSchema.h"
+#include "JsonArena.h"
+#include <vector>
 
 ServoConfig* ServoController::getServoConfig(int boardIndex, int servoIndex) {
-  if (boardIndex >= 0 && boardIndex < MAX_BOARDS && 
+  if (boardIndex >= 0 && boardIndex < detectedBoardCount && 
       servoIndex >= 0 && servoIndex < SERVOS_PER_BOARD) {
     return &servoConfigs[boardIndex][servoIndex];
   }
   return nullptr;
 }
 
+String ServoController::getConfigEtag() const {
+  char etag[24];
+  snprintf(etag, sizeof(etag), "\"%08lx-%lu\"", (unsigned long)configBootId, (unsigned long)configVersion);
+  return String(etag);
+}
+
+void ServoController::markServoChanged(int boardIndex, int servoIndex) {
+  std::lock_guard<std::recursive_mutex> lock(frameMutex);
+  servoVersions[boardIndex][servoIndex] = ++configVersion;
+}
+
+void ServoController::markScriptsChanged() {
+  std::lock_guard<std::recursive_mutex> lock(frameMutex);
+  scriptsVersion = ++configVersion;
+}
+
+void ServoController::markAllChanged() {
+  std::lock_guard<std::recursive_mutex> lock(frameMutex);
+  ++configVersion;
+  for (int b = 0; b < detectedBoardCount; b++) {
+    for (int s = 0; s < SERVOS_PER_BOARD; s++) {
+      servoVersions[b][s] = configVersion;
+    }
+  }
+  scriptsVersion = configVersion;
+}
+
 String ServoController::getSystemInfoJson() {
-  JsonDocument doc;
+  PooledJsonDocument doc;
   doc["success"] = true;
   doc["boardCount"] = detectedBoardCount;
   doc["servosPerBoard"] = SERVOS_PER_BOARD;
+  doc["muxSwitches"] = muxSwitchCount;
   
-  JsonArray boardsArray = doc["boards"].to<JsonArray>();
-  for (int b = 0; b < detectedBoardCount; b++) {
-    JsonObject boardObj = boardsArray.add<JsonObject>();
-    boardObj["index"] = b;
-    boardObj["address"] = boards[b].address;
-    boardObj["name"] = boards[b].name;
-    boardObj["enabled"] = boards[b].enabled;
+  JsonArray muxArray = doc["muxes"].to<JsonArray>();
+  for (int m = 0; m < MAX_MUXES; m++) {
+    if (detectedMuxes & (1 << m)) muxArray.add(MUX_BASE_ADDRESS + m);
   }
   
-  String response;
-  serializeJson(doc, response);
-  return response;
-}
-
-String ServoController::getConfigurationJson() {
-  JsonDocument doc;
-  doc["success"] = true;
-  
   JsonArray boardsArray = doc["boards"].to<JsonArray>();
   for (int b = 0; b < detectedBoardCount; b++) {
     JsonObject boardObj = boardsArray.add<JsonObject>();
     boardObj["index"] = b;
     boardObj["address"] = boards[b].address;
+    boardObj["mux"] = boards[b].mux;
+    boardObj["channel"] = boards[b].muxChannel;
     boardObj["name"] = boards[b].name;
     boardObj["enabled"] = boards[b].enabled;
-    
-    JsonArray servosArray = boardObj["servos"].to<JsonArray>();
-    for (int s = 0; s < SERVOS_PER_BOARD; s++) {
-      JsonObject servoObj = servosArray.add<JsonObject>();
-      servoObj["index"] = s;
-      servoObj["enabled"] = servoConfigs[b][s].enabled;
-      servoObj["center"] = servoConfigs[b][s].center;
-      servoObj["range"] = servoConfigs[b][s].range;
-      servoObj["initPosition"] = servoConfigs[b][s].initPosition;
-      servoObj["isPair"] = servoConfigs[b][s].isPair;
-      servoObj["pairBoard"] = servoConfigs[b][s].pairBoard;
-      servoObj["pairServo"] = servoConfigs[b][s].pairServo;
-      servoObj["isPairMaster"] = servoConfigs[b][s].isPairMaster;
-      servoObj["name"] = servoConfigs[b][s].name;
-    }
   }
   
-  // Add scripts to configuration
-  JsonArray scriptsArray = doc["scripts"].to<JsonArray>();
-  for (int i = 0; i < scriptCount; i++) {
-    JsonObject scriptObj = scriptsArray.add<JsonObject>();
-    scriptObj["index"] = i;
-    scriptObj["name"] = scriptActions[i].name;
-    scriptObj["description"] = scriptActions[i].description;
-    scriptObj["commands"] = scriptActions[i].commands;
-    scriptObj["enabled"] = scriptActions[i].enabled;
-  }
+  JsonArenaPool::getInstance().writeStats(doc["memory"].to<JsonObject>());
   
   String response;
   serializeJson(doc, response);
   return response;
 }
 
+String ServoController::getConfigurationJson() {
+  ConfigJsonStream stream(*this, ConfigJsonStream::CONFIGURATION);
+  return stream.readAll();
+}
+
 bool ServoController::updateServoConfig(int boardIndex, int servoIndex, const String& field, const String& value) {
   DebugConsole::getInstance().logf("info", "updateServoConfig: board=%d, servo=%d, field=%s, value=%s", boardIndex, servoIndex, field.c_str(), value.c_str());
   
@@ -81,32 +83,86 @@ bool ServoController::updateServoConfig(int boardIndex, int servoIndex, const St
     return false;
   }
   
-  ServoConfig* config = &servoConfigs[boardIndex][servoIndex];
+  // One hash lookup instead of a compare per known field
+  int fieldIndex = findServoField(field);
+  if (fieldIndex < 0) {
+    DebugConsole::getInstance().logf("error", "Unknown servo field '%s'", field.c_str());
+    return false;
+  }
   
-  if (field == "enabled") {
-    bool newEnabled = (value == "true");
-    DebugConsole::getInstance().logf("info", "Setting servo %d:%d enabled from %s to %s", boardIndex, servoIndex, config->enabled ? "true" : "false", newEnabled ? "true" : "false");
-    config->enabled = newEnabled;
-  } else if (field == "center") {
-    config->center = value.toFloat();
-  } else if (field == "range") {
-    config->range = value.toFloat();
-  } else if (field == "initPosition") {
-    config->initPosition = value.toFloat();
-  } else if (field == "isPair") {
-    config->isPair = (value == "true");
-  } else if (field == "pairBoard") {
-    config->pairBoard = value.toInt();
-  } else if (field == "pairServo") {
-    config->pairServo = value.toInt();
-  } else if (field == "isPairMaster") {
-    config->isPairMaster = (value == "true");
-  } else if (field == "name") {
-    strncpy(config->name, value.c_str(), sizeof(config->name) - 1);
-    config->name[sizeof(config->name) - 1] = '\0';
-  } else {
+  if (!setServoField(servoConfigs[boardIndex][servoIndex], fieldIndex, value)) {
+    DebugConsole::getInstance().logf("error", "Value %s out of range for %s", value.c_str(), field.c_str());
     return false;
   }
   
+  markServoChanged(boardIndex, servoIndex);
   return true;
-}
\ No newline at end of file
+}
+
+int ServoController::applyConfigPatch(JsonArrayConst servos, JsonArray errors) {
+  // Hold the frame lock so a save or delta response sees either none or all of the patch
+  std::lock_guard<std::recursive_mutex> lock(frameMutex);
+  
+  // Every field is set on a copy first; the patch lands only if all of them were accepted
+  struct StagedServo {
+    int boardIndex;
+    int servoIndex;
+    ServoConfig config;
+  };
+  std::vector<StagedServo> staged;
+  int accepted = 0;
+  
+  for (JsonObjectConst item : servos) {
+    if (!item["board"].is<int>() || !item["servo"].is<int>()) {
+      errors.add("Each entry needs integer 'board' and 'servo'");
+      continue;
+    }
+    int boardIndex = item["board"];
+    int servoIndex = item["servo"];
+    if (boardIndex < 0 || boardIndex >= detectedBoardCount || servoIndex < 0 || servoIndex >= SERVOS_PER_BOARD) {
+      errors.add("Servo " + String(boardIndex) + ":" + String(servoIndex) + " does not exist");
+      continue;
+    }
+    
+    // Entries for the same servo build on each other
+    StagedServo* target = nullptr;
+    for (StagedServo& entry : staged) {
+      if (entry.boardIndex == boardIndex && entry.servoIndex == servoIndex) target = &entry;
+    }
+    if (!target) {
+      staged.push_back({boardIndex, servoIndex, servoConfigs[boardIndex][servoIndex]});
+      target = &staged.back();
+    }
+    
+    for (JsonPairConst field : item) {
+      String key = field.key().c_str();
+      if (key == "board" || key == "servo") continue;
+      
+      // The same string form the single-field POST sends
+      String value;
+      if (field.value().is<bool>()) {
+        value = field.value().as<bool>() ? "true" : "false";
+      } else {
+        value = field.value().as<String>();
+      }
+      
+      int fieldIndex = findServoField(key);
+      if (fieldIndex >= 0 && setServoField(target->config, fieldIndex, value)) {
+        accepted++;
+      } else {
+        errors.add("Servo " + String(boardIndex) + ":" + String(servoIndex) + " rejected field '" + key + "'");
+      }
+    }
+  }
+  
+  if (errors.size() > 0) {
+    DebugConsole::getInstance().logf("error", "Config patch rejected: %u errors, nothing applied", (unsigned)errors.size());
+    return 0;
+  }
+  
+  for (const StagedServo& entry : staged) {
+    servoConfigs[entry.boardIndex][entry.servoIndex] = entry.config;
+    markServoChanged(entry.boardIndex, entry.servoIndex);
+  }
+  return accepted;
+}
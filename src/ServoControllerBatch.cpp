@@ -0,0 +1,66 @@
+#include "ServoController.h"
+
+bool ServoController::validatePositionTarget(const PositionTarget& target, String& error) {
+  if (target.boardIndex < 0 || target.boardIndex >= detectedBoardCount) {
+    error = "Invalid board index " + String(target.boardIndex);
+    return false;
+  }
+
+  if (target.servoIndex < 0 || target.servoIndex >= SERVOS_PER_BOARD) {
+    error = "Invalid servo index " + String(target.servoIndex);
+    return false;
+  }
+
+  if (target.position < 0.0 || target.position > 100.0) {
+    error = "Position must be between 0.0 and 100.0";
+    return false;
+  }
+
+  if (!servoConfigs[target.boardIndex][target.servoIndex].enabled) {
+    error = "Servo " + String(target.boardIndex) + ":" + String(target.servoIndex) + " not enabled";
+    return false;
+  }
+
+  return true;
+}
+
+void ServoController::applyPositionFrame(const PositionTarget* targets, int count) {
+  // Hold the frame so the next flush writes either none or all of these positions
+  beginFrame();
+  for (int i = 0; i < count; i++) {
+    setServoToConfiguredPosition(targets[i].boardIndex, targets[i].servoIndex, targets[i].position);
+  }
+  endFrame();
+
+  DebugConsole::getInstance().logf("info", "Applied batch frame with %d positions", count);
+}
+
+// Only motion verbs run inside the frame. Anything else (system load, config, scripts)
+// can read or write flash and take saveMutex, which must never nest inside frameMutex.
+static bool isFrameCommand(const String& command) {
+  String verb = command;
+  verb.trim();
+  verb.toLowerCase();
+  int spaceIndex = verb.indexOf(' ');
+  if (spaceIndex > 0) verb = verb.substring(0, spaceIndex);
+  return verb == "servo" || verb == "sweep";
+}
+
+void ServoController::executeCommandBatch(const String* commands, int count, String* results) {
+  // Consecutive motion commands share one frame; other commands close it first
+  bool framed = false;
+  for (int i = 0; i < count; i++) {
+    bool motion = isFrameCommand(commands[i]);
+    if (motion && !framed) {
+      beginFrame();
+      framed = true;
+    } else if (!motion && framed) {
+      endFrame();
+      framed = false;
+    }
+    results[i] = executeCommand(commands[i]);
+  }
+  if (framed) endFrame();
+
+  DebugConsole::getInstance().logf("info", "Executed command batch with %d commands", count);
+}
@@ -1,6 +1,13 @@
 #include "ServoController.h"
+#include "ServoConfigSchema.h"
+#include "JsonArena.h"
 
 String ServoController::executeCommand(const String& command) {
+  CommandRecorder::getInstance().recordExecute(command);
+  CommandRecorder::NestedScope nested;
+  HeapTracker::Scope heap(HEAP_TAG_PARSE);
+  HeapTracker::CommandScope heapCommand(command);
+  
   String cmd = command;
   cmd.trim();
   cmd.toLowerCase();
@@ -13,6 +20,7 @@ String ServoController::executeCommand(const String& command) {
   int spaceIndex = cmd.indexOf(' ');
   String mainCommand = (spaceIndex > 0) ? cmd.substring(0, spaceIndex) : cmd;
   String args = (spaceIndex > 0) ? cmd.substring(spaceIndex + 1) : "";
+  EventTrace::Span span(commandTraceName(mainCommand));
   
   // Route to appropriate command handler
   if (mainCommand == "servo") {
@@ -27,6 +35,8 @@ String ServoController::executeCommand(const String& command) {
     return executeSweepCommand(args);
   } else if (mainCommand == "repeat") {
     return executeRepeatCommand(args);
+  } else if (mainCommand == "stream") {
+    return executeStreamCommand(args);
   } else if (mainCommand == "script") {
     if (args.length() == 0) {
       return "Error: script command requires a script name. Usage: script <name>";
@@ -57,6 +67,29 @@ String ServoController::executeCommand(const String& command) {
   }
 }
 
+uint16_t ServoController::commandTraceName(const String& mainCommand) {
+  // One name per known verb, interned once; anything typed is traced as "cmd other" so
+  // tracing a command allocates nothing and unknown verbs never fill the name table
+  static const uint16_t TRACE_OTHER = EventTrace::getInstance().intern("cmd other");
+  static const struct { const char* verb; uint16_t name; } TRACE_VERBS[] = {
+    {"servo", EventTrace::getInstance().intern("cmd servo")},
+    {"system", EventTrace::getInstance().intern("cmd system")},
+    {"config", EventTrace::getInstance().intern("cmd config")},
+    {"pair", EventTrace::getInstance().intern("cmd pair")},
+    {"sweep", EventTrace::getInstance().intern("cmd sweep")},
+    {"repeat", EventTrace::getInstance().intern("cmd repeat")},
+    {"stream", EventTrace::getInstance().intern("cmd stream")},
+    {"script", EventTrace::getInstance().intern("cmd script")},
+    {"sleep", EventTrace::getInstance().intern("cmd sleep")},
+    {"help", EventTrace::getInstance().intern("cmd help")},
+  };
+  
+  for (const auto& entry : TRACE_VERBS) {
+    if (mainCommand == entry.verb) return entry.name;
+  }
+  return TRACE_OTHER;
+}
+
 String ServoController::executeServoCommand(const String& args) {
   if (args.length() == 0) {
     return "Error: servo command requires arguments. Usage: servo <board> <servo> <position>";
@@ -95,22 +128,61 @@ String ServoController::executeServoCommand(const String& args) {
 
 String ServoController::executeSystemCommand(const String& args) {
   if (args.length() == 0) {
-    return "Error: system command requires arguments. Usage: system <info|init|save|load>";
+    return "Error: system command requires arguments. Usage: system <info|init|save|load|memory|heap|recorder|profile|trace>";
   }
   
   if (args == "info") {
-    return "System Info - Boards: " + String(detectedBoardCount) + ", Total Servos: " + String(detectedBoardCount * SERVOS_PER_BOARD);
+    return "System Info - Boards: " + String(detectedBoardCount) + ", Total Servos: " + String(detectedBoardCount * SERVOS_PER_BOARD) +
+           ", I2C Segments: " + String(segmentCount) + ", Mux Switches: " + String(muxSwitchCount);
   } else if (args == "init") {
     applyInitialPositions();
     return "Success: Applied initial positions to all enabled servos";
   } else if (args == "save") {
-    saveConfiguration();
-    return "Success: Configuration saved";
+    flushConfiguration();
+    return "Success: Configuration save started";
   } else if (args == "load") {
     loadConfiguration();
     return "Success: Configuration loaded";
+  } else if (args == "memory") {
+    return JsonArenaPool::getInstance().getStatsText();
+  } else if (args == "heap") {
+    return HeapTracker::getInstance().getStatsText();
+  } else if (args == "heap on" || args == "heap off") {
+    if (!HeapTracker::getInstance().setEnabled(args == "heap on")) {
+      return "Error: Heap tracking needs a build with -DHEAP_TRACKING (env:esp32dev_heap)";
+    }
+    return "Success: Heap tracking " + String(args == "heap on" ? "enabled" : "disabled");
+  } else if (args == "heap reset") {
+    HeapTracker::getInstance().reset();
+    return "Success: Heap accounting cleared";
+  } else if (args == "recorder") {
+    return CommandRecorder::getInstance().getStatusText();
+  } else if (args == "recorder on" || args == "recorder off") {
+    CommandRecorder::getInstance().setEnabled(args == "recorder on");
+    return "Success: Command recorder " + String(args == "recorder on" ? "enabled" : "disabled");
+  } else if (args == "recorder clear") {
+    CommandRecorder::getInstance().clear();
+    return "Success: Command recording cleared";
+  } else if (args == "profile") {
+    return LoopProfiler::getInstance().getStatsText();
+  } else if (args == "profile on" || args == "profile off") {
+    LoopProfiler::getInstance().setEnabled(args == "profile on");
+    return "Success: Profiler " + String(args == "profile on" ? "enabled" : "disabled");
+  } else if (args == "profile reset") {
+    LoopProfiler::getInstance().reset();
+    return "Success: Profiler statistics cleared";
+  } else if (args == "trace") {
+    return EventTrace::getInstance().getStatusText();
+  } else if (args == "trace on" || args == "trace off") {
+    if (!EventTrace::getInstance().setEnabled(args == "trace on")) {
+      return "Error: Not enough memory for the trace buffer";
+    }
+    return "Success: Event trace " + String(args == "trace on" ? "enabled" : "disabled");
+  } else if (args == "trace clear") {
+    EventTrace::getInstance().clear();
+    return "Success: Event trace cleared";
   } else {
-    return "Error: Unknown system command '" + args + "'. Available: info, init, save, load";
+    return "Error: Unknown system command '" + args + "'. Available: info, init, save, load, memory, heap, recorder, profile, trace";
   }
 }
 
@@ -152,7 +224,12 @@ String ServoController::executeConfigCommand(const String& args) {
   if (updateServoConfig(boardIndex, servoIndex, field, value)) {
     return "Success: Updated " + field + " to " + value + " for servo " + String(boardIndex) + ":" + String(servoIndex);
   } else {
-    return "Error: Failed to update " + field + ". Valid fields: enabled, center, range, initPosition, isPair, pairBoard, pairServo, isPairMaster, name";
+    int fieldIndex = findServoField(field);
+    if (fieldIndex < 0) {
+      return "Error: Unknown field " + field + ". Valid fields: " + servoFieldNames();
+    }
+    const SchemaField& schema = SERVO_FIELDS[fieldIndex];
+    return "Error: Invalid value " + value + " for " + field + " (range " + String(schema.minValue, 0) + " to " + String(schema.maxValue, 0) + ")";
   }
 }
 
@@ -205,6 +282,9 @@ String ServoController::executePairCommand(const String& args) {
   slave->pairBoard = -1;
   slave->pairServo = -1;
   
+  markServoChanged(board1, servo1);
+  markServoChanged(board2, servo2);
+  
   return "Success: Paired servo " + String(board1) + ":" + String(servo1) + " (master) with " + String(board2) + ":" + String(servo2) + " (slave)";
 }
 
@@ -324,15 +404,63 @@ String ServoController::executeRepeatCommand(const String& args) {
   }
 }
 
+String ServoController::executeStreamCommand(const String& args) {
+  if (args.length() == 0) {
+    return "Error: stream command requires arguments. Usage: stream <status|timeout <ms> [hold|init]>";
+  }
+  
+  if (args == "status") {
+    return "Stream status - Active: " + String(realtimeActive ? "yes" : "no") +
+           ", Last sequence: " + String(realtimeLastSequence) +
+           ", Accepted: " + String(realtimeFramesAccepted) +
+           ", Dropped: " + String(realtimeFramesDropped) +
+           ", Timeout: " + String(realtimeTimeoutMs) + "ms " + (realtimeTimeoutMode == REALTIME_RETURN_INIT ? "init" : "hold");
+  }
+  
+  if (args.startsWith("timeout ")) {
+    String rest = args.substring(8);
+    rest.trim();
+    int spaceIndex = rest.indexOf(' ');
+    long timeoutMs = (spaceIndex == -1 ? rest : rest.substring(0, spaceIndex)).toInt();
+    String modeName = (spaceIndex == -1) ? "hold" : rest.substring(spaceIndex + 1);
+    modeName.trim();
+    
+    if (timeoutMs < 50 || timeoutMs > 60000) {
+      return "Error: Stream timeout must be between 50ms and 60000ms";
+    }
+    
+    RealtimeTimeoutMode mode;
+    if (modeName == "hold") {
+      mode = REALTIME_HOLD;
+    } else if (modeName == "init") {
+      mode = REALTIME_RETURN_INIT;
+    } else {
+      return "Error: Unknown timeout mode '" + modeName + "'. Available: hold, init";
+    }
+    
+    setRealtimeTimeout(timeoutMs, mode);
+    return "Success: Stream timeout set to " + String(timeoutMs) + "ms (" + modeName + ")";
+  }
+  
+  return "Error: Unknown stream command '" + args + "'. Available: status, timeout";
+}
+
 String ServoController::executeHelpCommand() {
   return "Available commands:\n"
          "servo <board> <servo> <position> - Move servo to position (0-100%)\n"
          "sweep <board> <servo> <start> <end> <duration_ms> - Sweep servo from start to end position\n"
          "repeat <count> <command> - Repeat a command multiple times (max 100)\n"
+         "stream status - Show realtime frame stream statistics\n"
+         "stream timeout <ms> [hold|init] - Set realtime stream timeout behaviour\n"
          "system info - Show system information\n"
          "system init - Apply initial positions to all servos\n"
          "system save - Save current configuration\n"
          "system load - Load saved configuration\n"
+         "system memory - Show heap fragmentation and JSON slab usage\n"
+         "system heap [on|off|reset] - Allocations per subsystem and per command\n"
+         "system recorder [on|off|clear] - Command recording status and control\n"
+         "system profile [on|off|reset] - Loop, I2C and HTTP handler timings\n"
+         "system trace [on|off|clear] - Event timeline for /api/trace (Chrome trace JSON)\n"
          "config <board> <servo> <field> <value> - Update servo configuration\n"
          "pair <board1> <servo1> <board2> <servo2> - Pair two servos (first is master)\n"
          "script <name> - Execute a saved script\n"
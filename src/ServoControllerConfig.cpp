@@ -1,52 +1,111 @@
 #include "ServoController.h"
+#include "ServoConfigSchema.h"
 
 void ServoController::saveConfiguration() {
-  JsonDocument doc;
-  JsonArray boardsArray = doc["boards"].to<JsonArray>();
+  std::lock_guard<std::mutex> saveLock(saveMutex);
   
-  for (int b = 0; b < detectedBoardCount; b++) {
-    JsonObject boardObj = boardsArray.add<JsonObject>();
-    boardObj["address"] = boards[b].address;
-    boardObj["name"] = boards[b].name;
-    boardObj["enabled"] = boards[b].enabled;
-    
-    JsonArray servosArray = boardObj["servos"].to<JsonArray>();
-    for (int s = 0; s < SERVOS_PER_BOARD; s++) {
-      JsonObject servoObj = servosArray.add<JsonObject>();
-      servoObj["enabled"] = servoConfigs[b][s].enabled;
-      servoObj["center"] = servoConfigs[b][s].center;
-      servoObj["range"] = servoConfigs[b][s].range;
-      servoObj["initPosition"] = servoConfigs[b][s].initPosition;
-      servoObj["isPair"] = servoConfigs[b][s].isPair;
-      servoObj["pairBoard"] = servoConfigs[b][s].pairBoard;
-      servoObj["pairServo"] = servoConfigs[b][s].pairServo;
-      servoObj["isPairMaster"] = servoConfigs[b][s].isPairMaster;
-      servoObj["name"] = servoConfigs[b][s].name;
-    }
+  uint8_t* payload = (uint8_t*)malloc(binaryConfigSize(detectedBoardCount, MAX_SCRIPTS));
+  if (!payload) {
+    saveDirty = true;
+    DebugConsole::getInstance().log("Out of memory saving configuration", "error");
+    return;
   }
   
-  // Add scripts to configuration
-  JsonArray scriptsArray = doc["scripts"].to<JsonArray>();
-  for (int i = 0; i < scriptCount; i++) {
-    JsonObject scriptObj = scriptsArray.add<JsonObject>();
-    scriptObj["index"] = i;
-    scriptObj["name"] = scriptActions[i].name;
-    scriptObj["description"] = scriptActions[i].description;
-    scriptObj["commands"] = scriptActions[i].commands;
-    scriptObj["enabled"] = scriptActions[i].enabled;
+  // Snapshot under the frame lock; changes made after it mark the config dirty again
+  size_t length;
+  uint32_t coalesced;
+  {
+    std::lock_guard<std::recursive_mutex> frameLock(frameMutex);
+    coalesced = saveRequestsPending;
+    saveDirty = false;
+    saveRequestsPending = 0;
+    length = encodeBinaryConfig(payload);
   }
   
-  File file = LittleFS.open(CONFIG_FILE, "w");
-  if (file) {
-    serializeJson(doc, file);
-    file.close();
-    DebugConsole::getInstance().log("Configuration saved to " + String(CONFIG_FILE), "success");
+  int slot;
+  uint32_t generation;
+  bool saved = writeConfigSlot(payload, length, CONFIG_FORMAT_BINARY_MUX, slot, generation);
+  free(payload);
+  
+  if (saved) {
+    configSaveCount++;
+    DebugConsole::getInstance().logf("success", "Configuration saved to %s, generation %lu, %u bytes (%lu changes)",
+      CONFIG_SLOT_FILES[slot], (unsigned long)generation, (unsigned)length, (unsigned long)coalesced);
   } else {
+    saveDirty = true;
     DebugConsole::getInstance().log("Failed to save configuration", "error");
   }
 }
 
+void ServoController::startPersistence() {
+  if (persistenceTask) return;
+  
+  // Below the loop task's priority so a flash write never delays a motion tick
+  xTaskCreatePinnedToCore(persistenceTaskEntry, "config_save", 8192, this, 0, &persistenceTask, 0);
+}
+
+void ServoController::persistenceTaskEntry(void* arg) {
+  static_cast<ServoController*>(arg)->persistenceLoop();
+}
+
+void ServoController::persistenceLoop() {
+  for (;;) {
+    // Woken early by flushConfiguration(), otherwise poll for the end of the quiet period
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(SAVE_POLL_INTERVAL));
+    
+    if (!saveDirty) continue;
+    if (!saveFlushRequested && Clock::getInstance().millis() - lastSaveRequest < SAVE_QUIET_PERIOD) continue;
+    
+    saveFlushRequested = false;
+    saveConfiguration();
+  }
+}
+
+void ServoController::requestSave() {
+  lastSaveRequest = Clock::getInstance().millis();
+  saveRequestsPending++;
+  saveDirty = true;
+  
+  // Without the task (e.g. before startPersistence) fall back to saving immediately
+  if (!persistenceTask) {
+    saveConfiguration();
+  }
+}
+
+void ServoController::flushConfiguration() {
+  if (!persistenceTask) {
+    saveConfiguration();
+    return;
+  }
+  
+  saveDirty = true;
+  saveFlushRequested = true;
+  xTaskNotifyGive(persistenceTask);
+}
+
 void ServoController::loadConfiguration() {
+  // Try the slots newest first; each payload is read once and checked against its CRC
+  ConfigSlotHeader headers[2];
+  bool present[2];
+  for (int slot = 0; slot < 2; slot++) {
+    present[slot] = LittleFS.exists(CONFIG_SLOT_FILES[slot]) && readConfigSlotHeader(slot, headers[slot]);
+  }
+  int newest = (present[1] && (!present[0] || headers[1].generation > headers[0].generation)) ? 1 : 0;
+  
+  for (int attempt = 0; attempt < 2; attempt++) {
+    int slot = (attempt == 0) ? newest : 1 - newest;
+    if (!present[slot]) continue;
+    
+    if (loadConfigSlot(slot, headers[slot])) {
+      markAllChanged();
+      DebugConsole::getInstance().logf("success", "Configuration loaded from %s, generation %lu",
+        CONFIG_SLOT_FILES[slot], (unsigned long)headers[slot].generation);
+      return;
+    }
+    DebugConsole::getInstance().logf("error", "Configuration slot %s is invalid, ignoring it", CONFIG_SLOT_FILES[slot]);
+  }
+  
+  // No usable slot: migrate the JSON file written by older firmware
   if (!LittleFS.exists(CONFIG_FILE)) {
     DebugConsole::getInstance().log("No configuration file found, using defaults", "info");
     return;
@@ -62,33 +121,40 @@ void ServoController::loadConfiguration() {
   DeserializationError error = deserializeJson(doc, file);
   file.close();
   
-  if (error) {
+  if (error || !applyConfigurationJson(doc)) {
     DebugConsole::getInstance().log("Failed to parse configuration file", "error");
     return;
   }
   
+  markAllChanged();
+  DebugConsole::getInstance().log("Configuration loaded from " + String(CONFIG_FILE) + ", migrating to slots", "success");
+  saveConfiguration();
+}
+
+bool ServoController::applyConfigurationJson(JsonDocument& doc) {
+  if (!doc["boards"].is<JsonArray>()) {
+    return false;
+  }
+  
+  // Boards are matched by (mux, channel, address); files without a mux are main-bus boards
   JsonArray boardsArray = doc["boards"].as<JsonArray>();
-  for (int b = 0; b < boardsArray.size() && b < detectedBoardCount; b++) {
-    JsonObject boardObj = boardsArray[b];
-    if (boardObj["address"] == boards[b].address) {
+  int boardMap[MAX_BOARDS];
+  int recordCount = 0;
+  for (JsonObject boardObj : boardsArray) {
+    if (recordCount >= MAX_BOARDS) break;
+    int b = findBoard(boardObj["mux"] | -1, boardObj["channel"] | 0, boardObj["address"] | 0);
+    boardMap[recordCount++] = b;
+    if (b >= 0) {
       strncpy(boards[b].name, boardObj["name"] | boards[b].name, sizeof(boards[b].name));
       boards[b].enabled = boardObj["enabled"] | boards[b].enabled;
       
       JsonArray servosArray = boardObj["servos"].as<JsonArray>();
       for (int s = 0; s < servosArray.size() && s < SERVOS_PER_BOARD; s++) {
-        JsonObject servoObj = servosArray[s];
-        servoConfigs[b][s].enabled = servoObj["enabled"];
-        servoConfigs[b][s].center = servoObj["center"];
-        servoConfigs[b][s].range = servoObj["range"];
-        servoConfigs[b][s].initPosition = servoObj["initPosition"];
-        servoConfigs[b][s].isPair = servoObj["isPair"];
-        servoConfigs[b][s].pairBoard = servoObj["pairBoard"];
-        servoConfigs[b][s].pairServo = servoObj["pairServo"];
-        servoConfigs[b][s].isPairMaster = servoObj["isPairMaster"];
-        strncpy(servoConfigs[b][s].name, servoObj["name"] | servoConfigs[b][s].name, sizeof(servoConfigs[b][s].name));
+        readServoJson(servoConfigs[b][s], servosArray[s].as<JsonObjectConst>());
       }
     }
   }
+  remapPairBoards(boardMap, recordCount);
   
   // Load scripts if they exist
   if (doc["scripts"].is<JsonArray>()) {
@@ -110,7 +176,7 @@ void ServoController::loadConfiguration() {
     }
   }
   
-  DebugConsole::getInstance().log("Configuration loaded from " + String(CONFIG_FILE), "success");
+  return true;
 }
 
 void ServoController::saveOfflineConfiguration() {
@@ -120,21 +186,14 @@ void ServoController::saveOfflineConfiguration() {
   for (int b = 0; b < detectedBoardCount; b++) {
     JsonObject boardObj = boardsArray.add<JsonObject>();
     boardObj["address"] = boards[b].address;
+    boardObj["mux"] = boards[b].mux;
+    boardObj["channel"] = boards[b].muxChannel;
     boardObj["name"] = boards[b].name;
     boardObj["enabled"] = boards[b].enabled;
     
     JsonArray servosArray = boardObj["servos"].to<JsonArray>();
     for (int s = 0; s < SERVOS_PER_BOARD; s++) {
-      JsonObject servoObj = servosArray.add<JsonObject>();
-      servoObj["enabled"] = servoConfigs[b][s].enabled;
-      servoObj["center"] = servoConfigs[b][s].center;
-      servoObj["range"] = servoConfigs[b][s].range;
-      servoObj["initPosition"] = servoConfigs[b][s].initPosition;
-      servoObj["isPair"] = servoConfigs[b][s].isPair;
-      servoObj["pairBoard"] = servoConfigs[b][s].pairBoard;
-      servoObj["pairServo"] = servoConfigs[b][s].pairServo;
-      servoObj["isPairMaster"] = servoConfigs[b][s].isPairMaster;
-      servoObj["name"] = servoConfigs[b][s].name;
+      writeServoJson(servoConfigs[b][s], servosArray.add<JsonObject>());
     }
   }
   
@@ -175,53 +234,11 @@ void ServoController::loadOfflineConfiguration() {
   DeserializationError error = deserializeJson(doc, file);
   file.close();
   
-  if (error) {
+  if (error || !applyConfigurationJson(doc)) {
     DebugConsole::getInstance().log("Failed to parse offline configuration file", "error");
     return;
   }
   
-  JsonArray boardsArray = doc["boards"].as<JsonArray>();
-  for (int b = 0; b < boardsArray.size() && b < detectedBoardCount; b++) {
-    JsonObject boardObj = boardsArray[b];
-    if (boardObj["address"] == boards[b].address) {
-      strncpy(boards[b].name, boardObj["name"] | boards[b].name, sizeof(boards[b].name));
-      boards[b].enabled = boardObj["enabled"] | boards[b].enabled;
-      
-      JsonArray servosArray = boardObj["servos"].as<JsonArray>();
-      for (int s = 0; s < servosArray.size() && s < SERVOS_PER_BOARD; s++) {
-        JsonObject servoObj = servosArray[s];
-        servoConfigs[b][s].enabled = servoObj["enabled"];
-        servoConfigs[b][s].center = servoObj["center"];
-        servoConfigs[b][s].range = servoObj["range"];
-        servoConfigs[b][s].initPosition = servoObj["initPosition"];
-        servoConfigs[b][s].isPair = servoObj["isPair"];
-        servoConfigs[b][s].pairBoard = servoObj["pairBoard"];
-        servoConfigs[b][s].pairServo = servoObj["pairServo"];
-        servoConfigs[b][s].isPairMaster = servoObj["isPairMaster"];
-        strncpy(servoConfigs[b][s].name, servoObj["name"] | servoConfigs[b][s].name, sizeof(servoConfigs[b][s].name));
-      }
-    }
-  }
-  
-  // Load scripts from offline configuration if they exist
-  if (doc["scripts"].is<JsonArray>()) {
-    JsonArray scriptsArray = doc["scripts"].as<JsonArray>();
-    scriptCount = 0;
-    for (int i = 0; i < scriptsArray.size() && i < MAX_SCRIPTS; i++) {
-      JsonObject scriptObj = scriptsArray[i];
-      strncpy(scriptActions[scriptCount].name, scriptObj["name"] | "", sizeof(scriptActions[scriptCount].name) - 1);
-      scriptActions[scriptCount].name[sizeof(scriptActions[scriptCount].name) - 1] = '\0';
-      
-      strncpy(scriptActions[scriptCount].description, scriptObj["description"] | "", sizeof(scriptActions[scriptCount].description) - 1);
-      scriptActions[scriptCount].description[sizeof(scriptActions[scriptCount].description) - 1] = '\0';
-      
-      strncpy(scriptActions[scriptCount].commands, scriptObj["commands"] | "", sizeof(scriptActions[scriptCount].commands) - 1);
-      scriptActions[scriptCount].commands[sizeof(scriptActions[scriptCount].commands) - 1] = '\0';
-      
-      scriptActions[scriptCount].enabled = scriptObj["enabled"] | true;
-      scriptCount++;
-    }
-  }
-  
+  markAllChanged();
   DebugConsole::getInstance().log("Offline configuration loaded from " + String(OFFLINE_CONFIG_FILE), "success");
 }
\ No newline at end of file
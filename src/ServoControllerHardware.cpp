@@ -1,28 +1,140 @@
 #include "ServoController.h"
 
 void ServoController::setServoByPercent(int boardIndex, int servonum, float pct) {
-  if (boardIndex < 0 || boardIndex >= MAX_BOARDS) return;
+  if (boardIndex < 0 || boardIndex >= detectedBoardCount) return;
   if (servonum < 0 || servonum >= SERVOS_PER_BOARD) return;
   if (!boards[boardIndex].detected || !boards[boardIndex].enabled) return;
   
-  boards[boardIndex].driver->writeMicroseconds(servonum,
-      uint16_t((((100.0 - pct) * USMIN) / 100.0) + ((pct * USMAX) / 100.0))
-  );
+  uint16_t microseconds = uint16_t((((100.0 - pct) * USMIN) / 100.0) + ((pct * USMAX) / 100.0));
+  
+  // Stage the pulse; flushOutputs() writes it on the next motion tick
+  std::lock_guard<std::recursive_mutex> lock(frameMutex);
+  pendingPulse[boardIndex][servonum] = microsecondsToTicks(boardIndex, microseconds);
+  dirtyChannels[boardIndex] |= (1 << servonum);
+}
+
+uint16_t ServoController::microsecondsToTicks(int boardIndex, uint16_t microseconds) const {
+  // Same conversion as Adafruit_PWMServoDriver::writeMicroseconds, using the cached prescale
+  double pulseLength = (1000000.0 * (boards[boardIndex].prescale + 1)) / PCA9685_OSC_FREQ;
+  return uint16_t(microseconds / pulseLength);
+}
+
+void ServoController::beginFrame() {
+  frameMutex.lock();
+}
+
+void ServoController::endFrame() {
+  frameMutex.unlock();
+}
+
+void ServoController::flushOutputs() {
+  static const uint16_t TRACE_FLUSH = EventTrace::getInstance().intern("flush");
+  bool traced = false;  // Only frames that write something appear on the timeline
+  
+  // Segment by segment, starting with the multiplexer channel left selected by the last
+  // frame, so each segment with changes is switched in at most once per frame
+  int start = selectedSegment >= 0 ? selectedSegment : 0;
+  for (int i = 0; i < segmentCount; i++) {
+    int segment = (start + i) % segmentCount;
+    for (int b = segments[segment].firstBoard; b < segments[segment].firstBoard + segments[segment].boardCount; b++) {
+      flushBoard(b, segment, traced);
+    }
+  }
+  
+  if (traced) EventTrace::getInstance().end(TRACE_FLUSH);
+}
+
+void ServoController::flushBoard(int boardIndex, int segment, bool& traced) {
+  static const uint16_t TRACE_FLUSH = EventTrace::getInstance().intern("flush");
+  uint16_t pulses[SERVOS_PER_BOARD];
+  uint16_t dirty;
+  {
+    // Snapshot under the lock so a frame being built is never written half-way
+    std::lock_guard<std::recursive_mutex> lock(frameMutex);
+    dirty = dirtyChannels[boardIndex];
+    if (dirty == 0) return;
+    dirtyChannels[boardIndex] = 0;
+    memcpy(pulses, pendingPulse[boardIndex], sizeof(pulses));
+  }
+  
+  if (!boards[boardIndex].detected || !boards[boardIndex].enabled) return;
+  
+  if (!traced) {
+    EventTrace::getInstance().begin(TRACE_FLUSH);
+    traced = true;
+  }
+  selectSegment(segment);
+  
+  // Write each run of consecutive changed channels as one auto-increment burst
+  int s = 0;
+  while (s < SERVOS_PER_BOARD) {
+    if (!(dirty & (1 << s))) {
+      s++;
+      continue;
+    }
+    int first = s;
+    while (s < SERVOS_PER_BOARD && (dirty & (1 << s))) {
+      s++;
+    }
+    writeChannelRun(boardIndex, first, s - first, &pulses[first]);
+  }
+}
+
+bool ServoController::selectMuxChannel(int mux, int channel) {
+  // The TCA9548A has a single control register: one bit per downstream channel
+  Wire.beginTransmission(MUX_BASE_ADDRESS + mux);
+  Wire.write(channel < 0 ? 0 : (1 << channel));
+  return Wire.endTransmission() == 0;
+}
+
+void ServoController::selectSegment(int segment) {
+  const BusSegment& target = segments[segment];
+  if (target.mux < 0 || segment == selectedSegment) return;
+  
+  static const uint16_t TRACE_MUX = EventTrace::getInstance().intern("mux switch");
+  EventTrace::Span span(TRACE_MUX, target.mux * MUX_CHANNELS + target.muxChannel);
+  
+  // Boards on different multiplexers may share addresses, so only one channel is ever joined
+  if (selectedSegment >= 0 && segments[selectedSegment].mux != target.mux) {
+    selectMuxChannel(segments[selectedSegment].mux, -1);
+  }
+  selectMuxChannel(target.mux, target.muxChannel);
+  selectedSegment = segment;
+  muxSwitchCount++;
+}
+
+void ServoController::writeChannelRun(int boardIndex, int firstServo, int count, const uint16_t* pulses) {
+  // LEDn_ON_L/ON_H/OFF_L/OFF_H are consecutive and MODE1 auto-increment is enabled by setPWMFreq()
+  static const uint16_t TRACE_I2C = EventTrace::getInstance().intern("i2c write");
+  LoopProfiler::PhaseScope profile(PROFILE_I2C_WRITE);
+  EventTrace::Span span(TRACE_I2C, boardIndex);
+  Wire.beginTransmission(boards[boardIndex].address);
+  Wire.write(PCA9685_LED0_ON_L + 4 * firstServo);
+  for (int i = 0; i < count; i++) {
+    Wire.write(0);
+    Wire.write(0);
+    Wire.write(pulses[i] & 0xFF);
+    Wire.write(pulses[i] >> 8);
+  }
+  Wire.endTransmission();
 }
 
 void ServoController::setServoToConfiguredPosition(int boardIndex, int servonum, float position) {
   DebugConsole::getInstance().logf("info", "setServoToConfiguredPosition: board=%d, servo=%d, position=%.1f", boardIndex, servonum, position);
-  
-  if (boardIndex < 0 || boardIndex >= MAX_BOARDS) {
-    DebugConsole::getInstance().logf("error", "Invalid board index: %d", boardIndex);
+  moveServo(boardIndex, servonum, position, true);
+}
+
+void ServoController::moveServo(int boardIndex, int servonum, float position, bool verbose) {
+  if (boardIndex < 0 || boardIndex >= detectedBoardCount) {
+    if (verbose) DebugConsole::getInstance().logf("error", "Invalid board index: %d", boardIndex);
     return;
   }
   if (servonum < 0 || servonum >= SERVOS_PER_BOARD) {
-    DebugConsole::getInstance().logf("error", "Invalid servo index: %d", servonum);
+    if (verbose) DebugConsole::getInstance().logf("error", "Invalid servo index: %d", servonum);
     return;
   }
   if (!servoConfigs[boardIndex][servonum].enabled) {
-    DebugConsole::getInstance().logf("error", "Servo %d:%d not enabled", boardIndex, servonum);
+    if (verbose) DebugConsole::getInstance().logf("error", "Servo %d:%d not enabled", boardIndex, servonum);
     return;
   }
   
@@ -57,63 +169,186 @@ void ServoController::setServoToConfiguredPosition(int boardIndex, int servonum,
       
       setServoByPercent(pairBoard, pairServo, pairPosition);
       
-      DebugConsole::getInstance().logf("success", "Pairing: Board %d Servo %d (%.1f%%) -> Board %d Servo %d (%.1f%%)", 
-                    boardIndex, servonum, position, pairBoard, pairServo, pairPosition);
-    } else {
+      if (verbose) {
+        DebugConsole::getInstance().logf("success", "Pairing: Board %d Servo %d (%.1f%%) -> Board %d Servo %d (%.1f%%)", 
+                      boardIndex, servonum, position, pairBoard, pairServo, pairPosition);
+      }
+    } else if (verbose) {
       DebugConsole::getInstance().logf("error", "Pairing failed: Board %d Servo %d - Invalid pair target (Board %d, Servo %d)", 
                     boardIndex, servonum, pairBoard, pairServo);
     }
   }
 }
 
+bool ServoController::probeAddress(uint8_t address) {
+  Wire.beginTransmission(address);
+  return Wire.endTransmission() == 0;
+}
+
 void ServoController::scanForBoards() {
   DebugConsole::getInstance().log("Scanning for PCA9685 boards...", "info");
   
-  // Clean up existing drivers first
-  for (int i = 0; i < MAX_BOARDS; i++) {
-    if (boards[i].driver) {
-      delete boards[i].driver;
-      boards[i].driver = nullptr;
+  // Clean up existing drivers and storage first
+  freeBoardStorage();
+  detectedMuxes = 0;
+  
+  // Multiplexers first, each left with every channel off. A PCA9685 also answers at 0x70
+  // (its all-call address), so a device only counts as a TCA9548A if its control register
+  // reads back what was written.
+  for (int m = 0; m < MAX_MUXES; m++) {
+    if (!selectMuxChannel(m, 0)) continue;
+    bool isMux = Wire.requestFrom((uint8_t)(MUX_BASE_ADDRESS + m), (uint8_t)1) == 1 && Wire.read() == 0x01;
+    selectMuxChannel(m, -1);
+    if (isMux) {
+      detectedMuxes |= (1 << m);
+      DebugConsole::getInstance().logf("success", "Found TCA9548A multiplexer at address 0x%02X", MUX_BASE_ADDRESS + m);
     }
-    boards[i].detected = false;
-    boards[i].enabled = false;
   }
   
-  detectedBoardCount = 0;
+  struct FoundBoard {
+    int8_t mux;
+    uint8_t muxChannel;
+    uint8_t address;
+  };
+  FoundBoard found[MAX_BOARDS];
+  int count = 0;
+  uint8_t mainBus = 0;  // Bit per common address that answered with no channel selected
   
-  // Scan common I2C addresses
-  for (int i = 0; i < 8 && detectedBoardCount < MAX_BOARDS; i++) {
-    Wire.beginTransmission(commonAddresses[i]);
-    if (Wire.endTransmission() == 0) {
-      // Device found
-      boards[detectedBoardCount].address = commonAddresses[i];
-      boards[detectedBoardCount].detected = true;
-      boards[detectedBoardCount].enabled = true;
-      boards[detectedBoardCount].driver = new Adafruit_PWMServoDriver(commonAddresses[i]);
-      snprintf(boards[detectedBoardCount].name, sizeof(boards[detectedBoardCount].name), 
-               "PCA9685 @0x%02X", commonAddresses[i]);
-      
-      DebugConsole::getInstance().logf("success", "Found PCA9685 at address 0x%02X", commonAddresses[i]);
-      detectedBoardCount++;
+  // Main bus
+  for (int i = 0; i < BOARD_ADDRESSES && count < MAX_BOARDS; i++) {
+    if (probeAddress(commonAddresses[i])) {
+      found[count++] = {-1, 0, commonAddresses[i]};
+      mainBus |= (1 << i);
+    }
+  }
+  
+  // Each multiplexer channel on its own. An address already taken on the main bus would
+  // answer on every channel, so it is not probed behind the multiplexers.
+  for (int m = 0; m < MAX_MUXES; m++) {
+    if (!(detectedMuxes & (1 << m))) continue;
+    for (int c = 0; c < MUX_CHANNELS; c++) {
+      selectMuxChannel(m, c);
+      for (int i = 0; i < BOARD_ADDRESSES; i++) {
+        if ((mainBus & (1 << i)) || !probeAddress(commonAddresses[i])) continue;
+        if (count >= MAX_BOARDS) {
+          DebugConsole::getInstance().logf("error", "Ignoring PCA9685 at 0x%02X on 0x%02X channel %d: limit of %d boards",
+                                           commonAddresses[i], MUX_BASE_ADDRESS + m, c, MAX_BOARDS);
+          continue;
+        }
+        found[count++] = {(int8_t)m, (uint8_t)c, commonAddresses[i]};
+      }
+    }
+    selectMuxChannel(m, -1);
+  }
+  
+  allocateBoardStorage(count);
+  
+  for (int b = 0; b < count; b++) {
+    PCA9685Board& board = boards[b];
+    board.mux = found[b].mux;
+    board.muxChannel = found[b].muxChannel;
+    board.address = found[b].address;
+    board.detected = true;
+    board.enabled = true;
+    board.driver = new Adafruit_PWMServoDriver(board.address);
+    
+    if (board.mux < 0) {
+      snprintf(board.name, sizeof(board.name), "PCA9685 @0x%02X", board.address);
+      DebugConsole::getInstance().logf("success", "Found PCA9685 at address 0x%02X", board.address);
+    } else {
+      snprintf(board.name, sizeof(board.name), "PCA9685 @0x%02X mux %d.%d", board.address, board.mux, board.muxChannel);
+      DebugConsole::getInstance().logf("success", "Found PCA9685 at address 0x%02X on 0x%02X channel %d",
+                                       board.address, MUX_BASE_ADDRESS + board.mux, board.muxChannel);
+    }
+    
+    // Scan order keeps each segment's boards together
+    if (segmentCount == 0 || segments[segmentCount - 1].mux != board.mux ||
+        segments[segmentCount - 1].muxChannel != board.muxChannel) {
+      segments[segmentCount++] = {board.mux, board.muxChannel, b, 0};
     }
+    segments[segmentCount - 1].boardCount++;
   }
   
-  DebugConsole::getInstance().logf("success", "Found %d PCA9685 boards", detectedBoardCount);
+  DebugConsole::getInstance().logf("success", "Found %d PCA9685 boards on %d I2C segments", detectedBoardCount, segmentCount);
+}
+
+void ServoController::allocateBoardStorage(int count) {
+  freeBoardStorage();
+  
+  // Zero-initialised; at most one segment per board
+  boards = new PCA9685Board[count]();
+  servoConfigs = new ServoConfig[count][SERVOS_PER_BOARD]();
+  sweepActions = new SweepAction[count * SERVOS_PER_BOARD]();
+  pendingPulse = new uint16_t[count][SERVOS_PER_BOARD]();
+  dirtyChannels = new uint16_t[count]();
+  stagedTarget = new float[count][SERVOS_PER_BOARD]();
+  stagedChannels = new uint16_t[count]();
+  realtimeDriven = new uint16_t[count]();
+  servoVersions = new uint32_t[count][SERVOS_PER_BOARD]();
+  segments = new BusSegment[count]();
+  detectedBoardCount = count;
+  
+  initializeServoConfigs();
+}
+
+void ServoController::freeBoardStorage() {
+  for (int b = 0; b < detectedBoardCount; b++) {
+    delete boards[b].driver;
+  }
+  
+  delete[] boards;
+  delete[] servoConfigs;
+  delete[] sweepActions;
+  delete[] pendingPulse;
+  delete[] dirtyChannels;
+  delete[] stagedTarget;
+  delete[] stagedChannels;
+  delete[] realtimeDriven;
+  delete[] servoVersions;
+  delete[] segments;
+  
+  boards = nullptr;
+  servoConfigs = nullptr;
+  sweepActions = nullptr;
+  pendingPulse = nullptr;
+  dirtyChannels = nullptr;
+  stagedTarget = nullptr;
+  stagedChannels = nullptr;
+  realtimeDriven = nullptr;
+  servoVersions = nullptr;
+  segments = nullptr;
+  detectedBoardCount = 0;
+  segmentCount = 0;
+  selectedSegment = -1;
+  activeSweepCount = 0;
+}
+
+int ServoController::findBoard(int mux, int muxChannel, uint8_t address) const {
+  for (int b = 0; b < detectedBoardCount; b++) {
+    if (boards[b].mux == mux && (mux < 0 || boards[b].muxChannel == muxChannel) && boards[b].address == address) {
+      return b;
+    }
+  }
+  return -1;
 }
 
 void ServoController::initializeBoards() {
-  for (int i = 0; i < detectedBoardCount; i++) {
-    if (boards[i].driver) {
-      boards[i].driver->begin();
-      boards[i].driver->setOscillatorFrequency(27000000);
-      boards[i].driver->setPWMFreq(SERVO_FREQ);
-      delay(10);
+  for (int segment = 0; segment < segmentCount; segment++) {
+    selectSegment(segment);
+    for (int i = segments[segment].firstBoard; i < segments[segment].firstBoard + segments[segment].boardCount; i++) {
+      if (boards[i].driver) {
+        boards[i].driver->begin();
+        boards[i].driver->setOscillatorFrequency(PCA9685_OSC_FREQ);
+        boards[i].driver->setPWMFreq(SERVO_FREQ);
+        boards[i].prescale = boards[i].driver->readPrescale();
+        delay(10);
+      }
     }
   }
 }
 
 void ServoController::initializeServoConfigs() {
-  for (int b = 0; b < MAX_BOARDS; b++) {
+  for (int b = 0; b < detectedBoardCount; b++) {
     for (int s = 0; s < SERVOS_PER_BOARD; s++) {
       servoConfigs[b][s].enabled = false;
       servoConfigs[b][s].center = 50.0;
@@ -1,33 +1,63 @@
 #include "ServoController.h"
 
 void ServoController::update() {
-  unsigned long currentTime = millis();
+  // Commands run from the queue and sequences are replayed by the calls that scheduled them
+  CommandRecorder::NestedScope nested;
+  LoopProfiler::PhaseScope profile(PROFILE_UPDATE);
+  HeapTracker::Scope heap(HEAP_TAG_MOTION);
+  unsigned long currentTime = Clock::getInstance().millis();
   
   // Update sweep actions
-  updateSweeps();
+  {
+    LoopProfiler::PhaseScope phase(PROFILE_SWEEPS);
+    updateSweeps();
+  }
   
   // Update command sequences
-  updateCommandSequence();
+  {
+    LoopProfiler::PhaseScope phase(PROFILE_SEQUENCE);
+    updateCommandSequence();
+  }
   
   // Process command queue
-  while (!commandQueue.empty()) {
-    QueuedCommand& nextCommand = commandQueue.front();
-    
-    if (currentTime >= nextCommand.executeTime) {
-      // Execute the command
-      executeCommandImmediate(nextCommand.command);
-      commandQueue.pop();
-    } else {
-      // Commands are queued in order, so if this one isn't ready, none after it are
-      break;
+  {
+    LoopProfiler::PhaseScope phase(PROFILE_QUEUE);
+    while (!commandQueue.empty()) {
+      QueuedCommand& nextCommand = commandQueue.front();
+      
+      if (currentTime >= nextCommand.executeTime) {
+        // Execute the command
+        static const uint16_t TRACE_QUEUED = EventTrace::getInstance().intern("queued command");
+        EventTrace::Span span(TRACE_QUEUED, commandQueue.size());
+        executeCommandImmediate(nextCommand.command);
+        commandQueue.pop();
+      } else {
+        // Commands are queued in order, so if this one isn't ready, none after it are
+        break;
+      }
     }
   }
+  
+  // Realtime sources and staged targets win over anything scheduled this tick
+  {
+    LoopProfiler::PhaseScope phase(PROFILE_REALTIME);
+    updateRealtime();
+    applyStagedTargets();
+  }
+  
+  // Write everything moved during this tick as one output frame
+  {
+    LoopProfiler::PhaseScope phase(PROFILE_FLUSH);
+    flushOutputs();
+  }
 }
 
 bool ServoController::queueCommand(const String& command, unsigned long delayMs) {
+  CommandRecorder::getInstance().recordQueue(command, delayMs);
+  
   QueuedCommand queuedCmd;
   queuedCmd.command = command;
-  queuedCmd.executeTime = millis() + delayMs;
+  queuedCmd.executeTime = Clock::getInstance().millis() + delayMs;
   
   commandQueue.push(queuedCmd);
   return true;
@@ -39,7 +69,12 @@ void ServoController::clearQueue() {
   }
 }
 
+bool ServoController::isIdle() const {
+  return activeSweepCount == 0 && !commandSequence.active && commandQueue.empty();
+}
+
 String ServoController::executeCommandImmediate(const String& command) {
+  HeapTracker::Scope heap(HEAP_TAG_PARSE);
   String cmd = command;
   cmd.trim();
   cmd.toLowerCase();
@@ -54,6 +89,7 @@ String ServoController::executeCommandImmediate(const String& command) {
   int spaceIndex = cmd.indexOf(' ');
   String mainCommand = (spaceIndex > 0) ? cmd.substring(0, spaceIndex) : cmd;
   String args = (spaceIndex > 0) ? cmd.substring(spaceIndex + 1) : "";
+  EventTrace::Span span(commandTraceName(mainCommand));
   
   // Route to appropriate command handler (excluding sleep and script commands)
   if (mainCommand == "servo") {
@@ -62,6 +98,8 @@ String ServoController::executeCommandImmediate(const String& command) {
     return executeSweepCommand(args);
   } else if (mainCommand == "repeat") {
     return executeRepeatCommand(args);
+  } else if (mainCommand == "stream") {
+    return executeStreamCommand(args);
   } else if (mainCommand == "system") {
     return executeSystemCommand(args);
   } else if (mainCommand == "config") {
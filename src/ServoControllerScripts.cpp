@@ -1,4 +1,5 @@
 #include "ServoController.h"
+#include "ConfigJsonStream.h"
 
 bool ServoController::addScript(const String& name, const String& description, const String& commands) {
   if (scriptCount >= MAX_SCRIPTS) {
@@ -25,6 +26,7 @@ bool ServoController::addScript(const String& name, const String& description, c
   scriptActions[scriptCount].enabled = true;
   scriptCount++;
   
+  markScriptsChanged();
   return true;
 }
 
@@ -50,6 +52,7 @@ bool ServoController::updateScript(int index, const String& name, const String&
   strncpy(scriptActions[index].commands, commands.c_str(), sizeof(scriptActions[index].commands) - 1);
   scriptActions[index].commands[sizeof(scriptActions[index].commands) - 1] = '\0';
   
+  markScriptsChanged();
   return true;
 }
 
@@ -64,6 +67,7 @@ bool ServoController::deleteScript(int index) {
   }
   
   scriptCount--;
+  markScriptsChanged();
   return true;
 }
 
@@ -76,6 +80,8 @@ bool ServoController::executeScript(int index) {
 }
 
 bool ServoController::executeScript(const String& name) {
+  HeapTracker::Scope heap(HEAP_TAG_SCRIPT);
+  
   // Prevent infinite recursion
   if (scriptRecursionDepth >= 5) {
     DebugConsole::getInstance().log("Script recursion limit exceeded (max 5): " + name, "error");
@@ -189,24 +195,8 @@ bool ServoController::executeScript(const String& name) {
 }
 
 String ServoController::getScriptsJson() {
-  JsonDocument doc;
-  doc["success"] = true;
-  doc["count"] = scriptCount;
-  
-  JsonArray scripts = doc["scripts"].to<JsonArray>();
-  
-  for (int i = 0; i < scriptCount; i++) {
-    JsonObject script = scripts.add<JsonObject>();
-    script["index"] = i;
-    script["name"] = scriptActions[i].name;
-    script["description"] = scriptActions[i].description;
-    script["commands"] = scriptActions[i].commands;
-    script["enabled"] = scriptActions[i].enabled;
-  }
-  
-  String output;
-  serializeJson(doc, output);
-  return output;
+  ConfigJsonStream stream(*this, ConfigJsonStream::SCRIPTS);
+  return stream.readAll();
 }
 
 ScriptAction* ServoController::getScript(int index) {
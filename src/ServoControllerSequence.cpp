@@ -6,6 +6,8 @@ bool ServoController::startCommandSequence(String* commands, int count) {
     return false;
   }
   
+  CommandRecorder::getInstance().recordSequence(commands, count);
+  
   // Stop any existing sequence
   commandSequence.active = false;
   
@@ -16,9 +18,11 @@ bool ServoController::startCommandSequence(String* commands, int count) {
   
   commandSequence.currentIndex = 0;
   commandSequence.totalCount = count;
-  commandSequence.waitUntil = millis();
+  commandSequence.waitUntil = Clock::getInstance().millis();
   commandSequence.active = true;
   
+  static const uint16_t TRACE_SEQUENCE_START = EventTrace::getInstance().intern("sequence start");
+  EventTrace::getInstance().instant(TRACE_SEQUENCE_START, count);
   DebugConsole::getInstance().logf("info", "Started command sequence with %d commands", count);
   
   return true;
@@ -27,7 +31,7 @@ bool ServoController::startCommandSequence(String* commands, int count) {
 void ServoController::updateCommandSequence() {
   if (!commandSequence.active) return;
   
-  unsigned long currentTime = millis();
+  unsigned long currentTime = Clock::getInstance().millis();
   
   // Check if we're still waiting
   if (currentTime < commandSequence.waitUntil) {
@@ -37,6 +41,8 @@ void ServoController::updateCommandSequence() {
   // Check if sequence is complete
   if (commandSequence.currentIndex >= commandSequence.totalCount) {
     commandSequence.active = false;
+    static const uint16_t TRACE_SEQUENCE_END = EventTrace::getInstance().intern("sequence end");
+    EventTrace::getInstance().instant(TRACE_SEQUENCE_END, commandSequence.totalCount);
     DebugConsole::getInstance().log("Command sequence completed", "success");
     return;
   }
@@ -55,7 +61,12 @@ void ServoController::updateCommandSequence() {
                                    commandSequence.currentIndex + 1, currentCommand.c_str());
   
   // Execute the command
-  String result = executeCommandImmediate(currentCommand);
+  static const uint16_t TRACE_STEP = EventTrace::getInstance().intern("sequence step");
+  String result;
+  {
+    EventTrace::Span span(TRACE_STEP, commandSequence.currentIndex);
+    result = executeCommandImmediate(currentCommand);
+  }
   DebugConsole::getInstance().logf("info", "Sequence command result: %s", result.c_str());
   
   // Determine wait time for next command
@@ -0,0 +1,268 @@
+#include "ServoController.h"
+#include "ServoConfigSchema.h"
+
+// Packed on-flash records for CONFIG_FORMAT_BINARY and CONFIG_FORMAT_BINARY_MUX. Field
+// order and sizes are part of the format, so any change to them needs a new format number.
+// Servo records are laid out by SERVO_FIELDS (see ServoConfigSchema.h).
+struct __attribute__((packed)) BinaryConfigHeader {
+  uint8_t boardCount;
+  uint8_t servosPerBoard;
+  uint8_t scriptCount;
+  uint8_t reserved;
+};
+
+// Precedes each board record in CONFIG_FORMAT_BINARY_MUX
+struct __attribute__((packed)) BinaryBoardLocation {
+  int8_t mux;
+  uint8_t muxChannel;
+};
+
+struct __attribute__((packed)) BinaryBoardRecord {
+  uint8_t address;
+  uint8_t enabled;
+  char name[sizeof(PCA9685Board::name)];
+};
+
+struct __attribute__((packed)) BinaryScriptRecord {
+  uint8_t enabled;
+  char name[sizeof(ScriptAction::name)];
+  char description[sizeof(ScriptAction::description)];
+  char commands[sizeof(ScriptAction::commands)];
+};
+
+// CRC-32 (IEEE 802.3), bitwise; saves are infrequent so no lookup table is kept
+static uint32_t crc32Update(uint32_t crc, const uint8_t* data, size_t length) {
+  crc = ~crc;
+  while (length--) {
+    crc ^= *data++;
+    for (int bit = 0; bit < 8; bit++) {
+      crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+    }
+  }
+  return ~crc;
+}
+
+// Copies a fixed-size string field, always leaving it terminated
+static void copyName(char* dest, const char* src, size_t size) {
+  memcpy(dest, src, size);
+  dest[size - 1] = '\0';
+}
+
+size_t ServoController::binaryConfigSize(int boardCount, int scripts, uint16_t format) {
+  size_t location = (format == CONFIG_FORMAT_BINARY_MUX) ? sizeof(BinaryBoardLocation) : 0;
+  return sizeof(BinaryConfigHeader) +
+         boardCount * (location + sizeof(BinaryBoardRecord) + SERVOS_PER_BOARD * SERVO_PACKED_SIZE) +
+         scripts * sizeof(BinaryScriptRecord);
+}
+
+size_t ServoController::encodeBinaryConfig(uint8_t* buffer) {
+  uint8_t* out = buffer;
+  
+  BinaryConfigHeader header = {(uint8_t)detectedBoardCount, (uint8_t)SERVOS_PER_BOARD, (uint8_t)scriptCount, 0};
+  memcpy(out, &header, sizeof(header));
+  out += sizeof(header);
+  
+  for (int b = 0; b < detectedBoardCount; b++) {
+    BinaryBoardLocation location = {boards[b].mux, boards[b].muxChannel};
+    memcpy(out, &location, sizeof(location));
+    out += sizeof(location);
+    
+    BinaryBoardRecord board;
+    board.address = boards[b].address;
+    board.enabled = boards[b].enabled;
+    copyName(board.name, boards[b].name, sizeof(board.name));
+    memcpy(out, &board, sizeof(board));
+    out += sizeof(board);
+    
+    for (int s = 0; s < SERVOS_PER_BOARD; s++) {
+      packServoRecord(servoConfigs[b][s], out);
+      out += SERVO_PACKED_SIZE;
+    }
+  }
+  
+  for (int i = 0; i < scriptCount; i++) {
+    BinaryScriptRecord script;
+    script.enabled = scriptActions[i].enabled;
+    copyName(script.name, scriptActions[i].name, sizeof(script.name));
+    copyName(script.description, scriptActions[i].description, sizeof(script.description));
+    copyName(script.commands, scriptActions[i].commands, sizeof(script.commands));
+    memcpy(out, &script, sizeof(script));
+    out += sizeof(script);
+  }
+  
+  return out - buffer;
+}
+
+bool ServoController::decodeBinaryConfig(const uint8_t* data, size_t length, uint16_t format) {
+  BinaryConfigHeader header;
+  if (length < sizeof(header)) return false;
+  memcpy(&header, data, sizeof(header));
+  
+  if (header.servosPerBoard != SERVOS_PER_BOARD || header.boardCount > MAX_BOARDS ||
+      length != binaryConfigSize(header.boardCount, header.scriptCount, format)) {
+    DebugConsole::getInstance().log("Binary configuration does not match this firmware's layout", "error");
+    return false;
+  }
+  
+  const uint8_t* in = data + sizeof(header);
+  int boardMap[MAX_BOARDS];
+  for (int r = 0; r < header.boardCount; r++) {
+    // Earlier slots only held main-bus boards
+    BinaryBoardLocation location = {-1, 0};
+    if (format == CONFIG_FORMAT_BINARY_MUX) {
+      memcpy(&location, in, sizeof(location));
+      in += sizeof(location);
+    }
+    
+    BinaryBoardRecord board;
+    memcpy(&board, in, sizeof(board));
+    in += sizeof(board);
+    
+    // Boards are matched by (mux, channel, address), as in the JSON format
+    int b = findBoard(location.mux, location.muxChannel, board.address);
+    boardMap[r] = b;
+    if (b >= 0) {
+      boards[b].enabled = board.enabled;
+      copyName(boards[b].name, board.name, sizeof(boards[b].name));
+    }
+    
+    for (int s = 0; s < SERVOS_PER_BOARD; s++) {
+      if (b >= 0) unpackServoRecord(servoConfigs[b][s], in);
+      in += SERVO_PACKED_SIZE;
+    }
+  }
+  remapPairBoards(boardMap, header.boardCount);
+  
+  scriptCount = 0;
+  for (int i = 0; i < header.scriptCount; i++) {
+    BinaryScriptRecord script;
+    memcpy(&script, in, sizeof(script));
+    in += sizeof(script);
+    if (scriptCount >= MAX_SCRIPTS) continue;
+    
+    ScriptAction& action = scriptActions[scriptCount++];
+    action.enabled = script.enabled;
+    copyName(action.name, script.name, sizeof(action.name));
+    copyName(action.description, script.description, sizeof(action.description));
+    copyName(action.commands, script.commands, sizeof(action.commands));
+  }
+  
+  return true;
+}
+
+void ServoController::remapPairBoards(const int* boardMap, int recordCount) {
+  // Saved pairs name the partner by its board index when saved; once every record is
+  // matched, point them at that board's index in this scan, or at nothing if it is gone
+  for (int r = 0; r < recordCount; r++) {
+    if (boardMap[r] < 0) continue;
+    for (int s = 0; s < SERVOS_PER_BOARD; s++) {
+      ServoConfig& config = servoConfigs[boardMap[r]][s];
+      if (config.pairBoard < 0) continue;
+      config.pairBoard = config.pairBoard < recordCount ? boardMap[config.pairBoard] : -1;
+    }
+  }
+}
+
+bool ServoController::readConfigSlotHeader(int slot, ConfigSlotHeader& header) {
+  File file = LittleFS.open(CONFIG_SLOT_FILES[slot], "r");
+  if (!file) return false;
+  
+  // A slot cut short by a reset fails the size check here; a torn payload fails the CRC later
+  bool valid = file.read((uint8_t*)&header, sizeof(header)) == sizeof(header) &&
+               header.magic == CONFIG_SLOT_MAGIC &&
+               (header.format == CONFIG_FORMAT_JSON || header.format == CONFIG_FORMAT_BINARY ||
+                header.format == CONFIG_FORMAT_BINARY_MUX) &&
+               file.size() == sizeof(header) + header.length;
+  file.close();
+  return valid;
+}
+
+bool ServoController::verifyConfigSlot(int slot, const ConfigSlotHeader& header) {
+  File file = LittleFS.open(CONFIG_SLOT_FILES[slot], "r");
+  if (!file) return false;
+  file.seek(sizeof(ConfigSlotHeader));
+  
+  uint8_t buffer[256];
+  uint32_t crc = 0;
+  size_t count;
+  while ((count = file.read(buffer, sizeof(buffer))) > 0) {
+    crc = crc32Update(crc, buffer, count);
+  }
+  file.close();
+  return crc == header.crc;
+}
+
+int ServoController::findNewestConfigSlot(ConfigSlotHeader& header) {
+  int newest = -1;
+  ConfigSlotHeader candidate;
+  
+  for (int slot = 0; slot < 2; slot++) {
+    if (!LittleFS.exists(CONFIG_SLOT_FILES[slot])) continue;
+    if (!readConfigSlotHeader(slot, candidate) || !verifyConfigSlot(slot, candidate)) {
+      DebugConsole::getInstance().logf("error", "Configuration slot %s is invalid, ignoring it", CONFIG_SLOT_FILES[slot]);
+      continue;
+    }
+    if (newest < 0 || candidate.generation > header.generation) {
+      newest = slot;
+      header = candidate;
+    }
+  }
+  
+  return newest;
+}
+
+bool ServoController::writeConfigSlot(const uint8_t* payload, size_t length, uint16_t format,
+                                      int& slot, uint32_t& generation) {
+  // Write into the slot not holding the newest valid copy, so a reset mid-write
+  // leaves the previous configuration intact
+  ConfigSlotHeader newest;
+  int activeSlot = findNewestConfigSlot(newest);
+  slot = (activeSlot == 0) ? 1 : 0;
+  generation = (activeSlot >= 0) ? newest.generation + 1 : 1;
+  
+  ConfigSlotHeader header;
+  header.magic = CONFIG_SLOT_MAGIC;
+  header.format = format;
+  header.reserved = 0;
+  header.generation = generation;
+  header.length = length;
+  header.crc = crc32Update(0, payload, length);
+  
+  File file = LittleFS.open(CONFIG_SLOT_FILES[slot], "w");
+  if (!file) return false;
+  
+  bool written = file.write((const uint8_t*)&header, sizeof(header)) == sizeof(header) &&
+                 file.write(payload, length) == length;
+  file.close();
+  
+  // The slot only becomes the newest once every byte is down, so this is the commit point
+  return written;
+}
+
+bool ServoController::loadConfigSlot(int slot, const ConfigSlotHeader& header) {
+  uint8_t* payload = (uint8_t*)malloc(header.length);
+  if (!payload) {
+    DebugConsole::getInstance().log("Out of memory loading configuration", "error");
+    return false;
+  }
+  
+  // One read of the whole payload, checked before anything is applied
+  File file = LittleFS.open(CONFIG_SLOT_FILES[slot], "r");
+  bool loaded = file && file.seek(sizeof(ConfigSlotHeader)) &&
+                file.read(payload, header.length) == header.length &&
+                crc32Update(0, payload, header.length) == header.crc;
+  if (file) file.close();
+  
+  if (loaded) {
+    if (header.format == CONFIG_FORMAT_BINARY || header.format == CONFIG_FORMAT_BINARY_MUX) {
+      loaded = decodeBinaryConfig(payload, header.length, header.format);
+    } else {
+      // Slots written before the binary format are still JSON
+      JsonDocument doc;
+      loaded = !deserializeJson(doc, (const char*)payload, header.length) && applyConfigurationJson(doc);
+    }
+  }
+  
+  free(payload);
+  return loaded;
+}
@@ -0,0 +1,111 @@
+#include "ServoController.h"
+
+int ServoController::applyChannelPositions(int firstChannel, int count, const uint16_t* positions) {
+  int applied = 0;
+  
+  // Streamed frames arrive at animation rate, so they skip the per-move debug logging
+  beginFrame();
+  for (int i = 0; i < count; i++) {
+    int channel = firstChannel + i;
+    int boardIndex = channel / SERVOS_PER_BOARD;
+    int servoIndex = channel % SERVOS_PER_BOARD;
+    if (channel < 0) continue;
+    if (boardIndex >= detectedBoardCount) break;
+    if (!servoConfigs[boardIndex][servoIndex].enabled) continue;
+    
+    moveServo(boardIndex, servoIndex, positions[i] * (100.0f / 65535.0f), false);
+    applied++;
+  }
+  endFrame();
+  
+  return applied;
+}
+
+void ServoController::stageServoTarget(int boardIndex, int servoIndex, float position) {
+  if (boardIndex < 0 || boardIndex >= detectedBoardCount) return;
+  if (servoIndex < 0 || servoIndex >= SERVOS_PER_BOARD) return;
+  
+  // Latest wins: a newer target for the same servo replaces one not yet applied
+  std::lock_guard<std::recursive_mutex> lock(frameMutex);
+  stagedTarget[boardIndex][servoIndex] = position;
+  stagedChannels[boardIndex] |= (1 << servoIndex);
+}
+
+void ServoController::applyStagedTargets() {
+  std::lock_guard<std::recursive_mutex> lock(frameMutex);
+  for (int b = 0; b < detectedBoardCount; b++) {
+    uint16_t staged = stagedChannels[b];
+    if (staged == 0) continue;
+    stagedChannels[b] = 0;
+    
+    for (int s = 0; s < SERVOS_PER_BOARD; s++) {
+      if (staged & (1 << s)) {
+        moveServo(b, s, stagedTarget[b][s], false);
+      }
+    }
+  }
+}
+
+bool ServoController::submitRealtimeFrame(uint32_t sequence, int firstChannel, int count, const uint16_t* positions) {
+  std::lock_guard<std::recursive_mutex> lock(frameMutex);
+  
+  // Drop frames that are not newer than the last accepted one (wrap-safe compare).
+  // After a timeout any sequence starts a new session, so a restarted sender is accepted.
+  if (realtimeActive && (int32_t)(sequence - realtimeLastSequence) <= 0) {
+    realtimeFramesDropped++;
+    return false;
+  }
+  
+  if (!realtimeActive) {
+    DebugConsole::getInstance().logf("info", "Realtime stream started at sequence %lu", (unsigned long)sequence);
+  }
+  
+  realtimeLastSequence = sequence;
+  realtimeLastFrameTime = Clock::getInstance().millis();
+  realtimeActive = true;
+  realtimeFramesAccepted++;
+  
+  for (int i = 0; i < count; i++) {
+    int channel = firstChannel + i;
+    if (channel < 0) continue;
+    int boardIndex = channel / SERVOS_PER_BOARD;
+    int servoIndex = channel % SERVOS_PER_BOARD;
+    if (boardIndex >= detectedBoardCount) break;
+    
+    stageServoTarget(boardIndex, servoIndex, positions[i] * (100.0f / 65535.0f));
+    realtimeDriven[boardIndex] |= (1 << servoIndex);
+  }
+  
+  return true;
+}
+
+void ServoController::setRealtimeTimeout(unsigned long timeoutMs, RealtimeTimeoutMode mode) {
+  std::lock_guard<std::recursive_mutex> lock(frameMutex);
+  realtimeTimeoutMs = timeoutMs;
+  realtimeTimeoutMode = mode;
+}
+
+void ServoController::updateRealtime() {
+  std::lock_guard<std::recursive_mutex> lock(frameMutex);
+  if (!realtimeActive) return;
+  if (Clock::getInstance().millis() - realtimeLastFrameTime < realtimeTimeoutMs) return;
+  
+  realtimeActive = false;
+  
+  if (realtimeTimeoutMode == REALTIME_RETURN_INIT) {
+    for (int b = 0; b < detectedBoardCount; b++) {
+      for (int s = 0; s < SERVOS_PER_BOARD; s++) {
+        if (realtimeDriven[b] & (1 << s)) {
+          stageServoTarget(b, s, servoConfigs[b][s].initPosition);
+        }
+      }
+    }
+  }
+  
+  for (int b = 0; b < detectedBoardCount; b++) {
+    realtimeDriven[b] = 0;
+  }
+  
+  DebugConsole::getInstance().logf("info", "Realtime stream timed out after %lums, %s", realtimeTimeoutMs,
+                                   realtimeTimeoutMode == REALTIME_RETURN_INIT ? "returning to initial positions" : "holding positions");
+}
@@ -29,7 +29,7 @@ bool ServoController::startSweep(int boardIndex, int servoIndex, float startPos,
   
   // Find existing sweep slot or create new one
   int sweepIndex = -1;
-  for (int i = 0; i < MAX_BOARDS * SERVOS_PER_BOARD; i++) {
+  for (int i = 0; i < detectedBoardCount * SERVOS_PER_BOARD; i++) {
     if (sweepActions[i].active && 
         sweepActions[i].boardIndex == boardIndex && 
         sweepActions[i].servoIndex == servoIndex) {
@@ -41,7 +41,7 @@ bool ServoController::startSweep(int boardIndex, int servoIndex, float startPos,
   
   if (sweepIndex == -1) {
     // Find empty slot
-    for (int i = 0; i < MAX_BOARDS * SERVOS_PER_BOARD; i++) {
+    for (int i = 0; i < detectedBoardCount * SERVOS_PER_BOARD; i++) {
       if (!sweepActions[i].active) {
         sweepIndex = i;
         activeSweepCount++;
@@ -60,13 +60,15 @@ bool ServoController::startSweep(int boardIndex, int servoIndex, float startPos,
   sweepActions[sweepIndex].servoIndex = servoIndex;
   sweepActions[sweepIndex].startPosition = startPos;
   sweepActions[sweepIndex].endPosition = endPos;
-  sweepActions[sweepIndex].startTime = millis();
+  sweepActions[sweepIndex].startTime = Clock::getInstance().millis();
   sweepActions[sweepIndex].duration = durationMs;
   sweepActions[sweepIndex].active = true;
   
   // Set initial position
   setServoToConfiguredPosition(boardIndex, servoIndex, startPos);
   
+  static const uint16_t TRACE_SWEEP_START = EventTrace::getInstance().intern("sweep start");
+  EventTrace::getInstance().instant(TRACE_SWEEP_START, boardIndex * SERVOS_PER_BOARD + servoIndex);
   DebugConsole::getInstance().logf("success", "Started sweep: servo %d:%d from %.1f to %.1f over %lums", 
                                    boardIndex, servoIndex, startPos, endPos, durationMs);
   
@@ -74,12 +76,14 @@ bool ServoController::startSweep(int boardIndex, int servoIndex, float startPos,
 }
 
 void ServoController::stopSweep(int boardIndex, int servoIndex) {
-  for (int i = 0; i < MAX_BOARDS * SERVOS_PER_BOARD; i++) {
+  for (int i = 0; i < detectedBoardCount * SERVOS_PER_BOARD; i++) {
     if (sweepActions[i].active && 
         sweepActions[i].boardIndex == boardIndex && 
         sweepActions[i].servoIndex == servoIndex) {
       sweepActions[i].active = false;
       activeSweepCount--;
+      static const uint16_t TRACE_SWEEP_STOP = EventTrace::getInstance().intern("sweep stop");
+      EventTrace::getInstance().instant(TRACE_SWEEP_STOP, boardIndex * SERVOS_PER_BOARD + servoIndex);
       DebugConsole::getInstance().logf("info", "Stopped sweep for servo %d:%d", boardIndex, servoIndex);
       return;
     }
@@ -88,7 +92,7 @@ void ServoController::stopSweep(int boardIndex, int servoIndex) {
 
 void ServoController::stopAllSweeps() {
   int stopped = 0;
-  for (int i = 0; i < MAX_BOARDS * SERVOS_PER_BOARD; i++) {
+  for (int i = 0; i < detectedBoardCount * SERVOS_PER_BOARD; i++) {
     if (sweepActions[i].active) {
       sweepActions[i].active = false;
       stopped++;
@@ -101,9 +105,11 @@ void ServoController::stopAllSweeps() {
 void ServoController::updateSweeps() {
   if (activeSweepCount == 0) return;
   
-  unsigned long currentTime = millis();
+  static const uint16_t TRACE_SWEEPS = EventTrace::getInstance().intern("sweeps");
+  EventTrace::Span span(TRACE_SWEEPS, activeSweepCount);
+  unsigned long currentTime = Clock::getInstance().millis();
   
-  for (int i = 0; i < MAX_BOARDS * SERVOS_PER_BOARD; i++) {
+  for (int i = 0; i < detectedBoardCount * SERVOS_PER_BOARD; i++) {
     if (!sweepActions[i].active) continue;
     
     SweepAction& sweep = sweepActions[i];
@@ -114,6 +120,8 @@ void ServoController::updateSweeps() {
       setServoToConfiguredPosition(sweep.boardIndex, sweep.servoIndex, sweep.endPosition);
       sweep.active = false;
       activeSweepCount--;
+      static const uint16_t TRACE_SWEEP_END = EventTrace::getInstance().intern("sweep end");
+      EventTrace::getInstance().instant(TRACE_SWEEP_END, sweep.boardIndex * SERVOS_PER_BOARD + sweep.servoIndex);
       DebugConsole::getInstance().logf("info", "Sweep completed: servo %d:%d", sweep.boardIndex, sweep.servoIndex);
     } else {
       // Calculate current position using linear interpolation
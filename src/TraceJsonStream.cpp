@@ -0,0 +1,109 @@
+#include "TraceJsonStream.h"
+
+static const char* const TRACK_NAMES[TRACE_TRACK_COUNT] = {"loop", "async_tcp"};
+
+// Copies text into out as the body of a JSON string. Stops before an escape that would
+// not fit, so a long name is shortened rather than cut mid-escape.
+static void escapeJson(const char* text, char* out, size_t size) {
+  size_t length = 0;
+  for (; *text; text++) {
+    unsigned char c = *text;
+    char escaped[8];
+    int count;
+    if (c == '"' || c == '\\') {
+      count = snprintf(escaped, sizeof(escaped), "\\%c", c);
+    } else if (c < 0x20) {
+      count = snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+    } else {
+      escaped[0] = c;
+      count = 1;
+    }
+    if (length + count >= size) break;
+    memcpy(out + length, escaped, count);
+    length += count;
+  }
+  out[length] = '\0';
+}
+
+TraceJsonStream::TraceJsonStream() {
+  end = EventTrace::getInstance().getHead();
+  next = end > TRACE_EVENT_CAPACITY ? end - TRACE_EVENT_CAPACITY : 0;
+}
+
+size_t TraceJsonStream::read(uint8_t* buffer, size_t maxLen) {
+  size_t written = 0;
+  
+  while (written < maxLen) {
+    if (pieceOffset == pieceLength && !nextPiece()) break;
+    
+    size_t count = min(pieceLength - pieceOffset, maxLen - written);
+    memcpy(buffer + written, piece + pieceOffset, count);
+    pieceOffset += count;
+    written += count;
+  }
+  
+  return written;
+}
+
+bool TraceJsonStream::nextPiece() {
+  pieceLength = 0;
+  pieceOffset = 0;
+  EventTrace& trace = EventTrace::getInstance();
+  
+  switch (stage) {
+    case OPEN: {
+      // Thread names first, so each track is labelled in the viewer
+      int length = snprintf(piece, sizeof(piece), "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+      for (int t = 0; t < TRACE_TRACK_COUNT; t++) {
+        length += snprintf(piece + length, sizeof(piece) - length,
+                           "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+                           t > 0 ? "," : "", t, TRACK_NAMES[t]);
+      }
+      pieceLength = length;
+      stage = EVENT;
+      return true;
+    }
+    
+    case EVENT: {
+      TraceEvent event;
+      while (next < end && !trace.readEvent(next, event)) {
+        next++;  // Overwritten since the snapshot
+      }
+      if (next >= end) {
+        stage = CLOSE;
+        return nextPiece();
+      }
+      next++;
+      
+      // Events from two tasks can land in the ring slightly out of time order
+      if (haveBase) elapsed += (int32_t)(event.time - previousTime);
+      previousTime = event.time;
+      haveBase = true;
+      
+      // Names come from routes and callers, so they are escaped and kept short enough to
+      // leave room for the rest of the event
+      char name[PIECE_SIZE / 2];
+      escapeJson(trace.getName(event.name).c_str(), name, sizeof(name));
+      int length = snprintf(piece, sizeof(piece), ",{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%lld,\"pid\":1,\"tid\":%d",
+                            name, event.phase, (long long)elapsed, event.track);
+      if (event.phase == 'i') {
+        length += snprintf(piece + length, sizeof(piece) - length, ",\"s\":\"t\"");
+      }
+      if (event.phase != 'E') {
+        length += snprintf(piece + length, sizeof(piece) - length, ",\"args\":{\"value\":%ld}", (long)event.arg);
+      }
+      length += snprintf(piece + length, sizeof(piece) - length, "}");
+      pieceLength = min((size_t)length, sizeof(piece) - 1);
+      return true;
+    }
+    
+    case CLOSE:
+      pieceLength = snprintf(piece, sizeof(piece), "]}");
+      stage = DONE;
+      return true;
+    
+    case DONE:
+      return false;
+  }
+  return false;
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <Arduino.h>
+#include "EventTrace.h"
+
+// Chrome Trace Event JSON for the events in the EventTrace ring, produced one event at a
+// time into a small buffer. read() has the shape of an AsyncWebServer chunked-response
+// filler, like ConfigJsonStream.
+//
+// The window is the ring as it stood at construction. Events overwritten while the
+// document is being read are skipped.
+class TraceJsonStream {
+public:
+  static const size_t PIECE_SIZE = 256;  // Fits one event or the thread-name metadata
+  
+  TraceJsonStream();
+  
+  // Copies up to maxLen bytes of the document into buffer; returns 0 once complete
+  size_t read(uint8_t* buffer, size_t maxLen);
+
+private:
+  enum Stage { OPEN, EVENT, CLOSE, DONE };
+  
+  Stage stage = OPEN;
+  uint32_t next;         // Ring index of the next event
+  uint32_t end;          // Head at construction
+  bool haveBase = false;
+  uint32_t previousTime = 0;
+  int64_t elapsed = 0;   // Microseconds since the first exported event
+  
+  char piece[PIECE_SIZE];
+  size_t pieceLength = 0;
+  size_t pieceOffset = 0;
+  
+  bool nextPiece();
+};
@@ -0,0 +1,48 @@
+#include "UdpFrameReceiver.h"
+
+UdpFrameReceiver::UdpFrameReceiver(ServoController& controller) : controller(controller) {
+  packetCount = 0;
+  malformedCount = 0;
+}
+
+bool UdpFrameReceiver::begin(uint16_t port) {
+  if (!udp.listen(port)) {
+    DebugConsole::getInstance().logf("error", "UDP frame receiver failed to listen on port %u", port);
+    return false;
+  }
+  
+  udp.onPacket([this](AsyncUDPPacket& packet) {
+    this->handlePacket(packet.data(), packet.length());
+  });
+  
+  DebugConsole::getInstance().logf("success", "UDP frame receiver listening on port %u", port);
+  return true;
+}
+
+bool UdpFrameReceiver::parseFrame(const uint8_t* data, size_t len, UdpFrame& frame) {
+  if (len < HEADER_SIZE) return false;
+  if (data[0] != 'N' || data[1] != 'X' || data[2] != PROTOCOL_VERSION) return false;
+  
+  frame.sequence = (uint32_t)data[4] | ((uint32_t)data[5] << 8) | ((uint32_t)data[6] << 16) | ((uint32_t)data[7] << 24);
+  frame.firstChannel = data[8] | (data[9] << 8);
+  frame.count = data[10] | (data[11] << 8);
+  frame.positions = data + HEADER_SIZE;
+  
+  if (frame.count == 0 || frame.count > MAX_BOARDS * SERVOS_PER_BOARD) return false;
+  return len == HEADER_SIZE + 2 * (size_t)frame.count;
+}
+
+void UdpFrameReceiver::handlePacket(const uint8_t* data, size_t len) {
+  packetCount++;
+  
+  UdpFrame frame;
+  if (!parseFrame(data, len, frame)) {
+    malformedCount++;
+    return;
+  }
+  
+  for (int i = 0; i < frame.count; i++) {
+    positions[i] = frame.positions[2 * i] | (frame.positions[2 * i + 1] << 8);
+  }
+  controller.submitRealtimeFrame(frame.sequence, frame.firstChannel, frame.count, positions);
+}
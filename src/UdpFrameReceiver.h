@@ -0,0 +1,53 @@
+#pragma once
+
+#include <Arduino.h>
+#include <AsyncUDP.h>
+#include "ServoController.h"
+
+// Compact realtime frames over UDP for externally generated animation.
+//
+// Packet layout (little endian):
+//   0  u8[2] magic 'N' 'X'
+//   2  u8    version (1)
+//   3  u8    flags (reserved, 0)
+//   4  u32   sequence number, incremented by the sender for every frame
+//   8  u16   first channel (board * 16 + servo)
+//  10  u16   channel count
+//  12  u16[] positions, 0-65535 = 0-100%
+//
+// Frames older than the newest accepted one are dropped. The newest frame is staged in
+// the controller and applied on the next motion tick; see "stream timeout" for what
+// happens when the sender stops.
+
+struct UdpFrame {
+  uint32_t sequence;
+  uint16_t firstChannel;
+  uint16_t count;
+  const uint8_t* positions;  // count x u16 LE, points into the packet
+};
+
+class UdpFrameReceiver {
+public:
+  static const uint16_t DEFAULT_PORT = 5800;
+  static const uint8_t PROTOCOL_VERSION = 1;
+  static const size_t HEADER_SIZE = 12;
+  
+  UdpFrameReceiver(ServoController& controller);
+  
+  bool begin(uint16_t port = DEFAULT_PORT);
+  
+  // Validates a packet and fills frame; no allocation, safe to call from the network task
+  static bool parseFrame(const uint8_t* data, size_t len, UdpFrame& frame);
+  
+  void handlePacket(const uint8_t* data, size_t len);
+  
+  uint32_t getPacketCount() const { return packetCount; }
+  uint32_t getMalformedCount() const { return malformedCount; }
+  
+private:
+  AsyncUDP udp;
+  ServoController& controller;
+  uint16_t positions[MAX_BOARDS * SERVOS_PER_BOARD];
+  uint32_t packetCount;
+  uint32_t malformedCount;
+};
@@ -4,12 +4,20 @@
 // WEB SERVER MANAGER - CORE FUNCTIONALITY
 // ============================================================================
 
-WebServerManager::WebServerManager(ServoController* controller) : servoController(controller) {
+WebServerManager::WebServerManager(ServoController* controller, DmxInput* dmx) : servoController(controller), dmxInput(dmx) {
   server = new AsyncWebServer(80);
+  controlSocket = new AsyncWebSocket("/ws");
+  for (int i = 0; i < BODY_BUFFER_COUNT; i++) {
+    bodyBuffers[i] = {nullptr, false};
+  }
 }
 
 WebServerManager::~WebServerManager() {
+  delete controlSocket;
   delete server;
+  for (int i = 0; i < BODY_BUFFER_COUNT; i++) {
+    free(bodyBuffers[i].data);
+  }
 }
 
 void WebServerManager::begin() {
@@ -19,8 +27,97 @@ void WebServerManager::begin() {
   DebugConsole::getInstance().log("Web server started on port 80", "success");
 }
 
+void WebServerManager::update() {
+  // Drop WebSocket clients that disconnected without a close frame
+  controlSocket->cleanupClients();
+}
+
+// ============================================================================
+// REQUEST BODIES
+// ============================================================================
+
+char* WebServerManager::acquireBodyBuffer(size_t size) {
+  if (size <= BODY_BUFFER_SIZE) {
+    for (int i = 0; i < BODY_BUFFER_COUNT; i++) {
+      if (bodyBuffers[i].inUse) continue;
+      
+      // Allocated on first use and then kept for the life of the server
+      if (!bodyBuffers[i].data) {
+        bodyBuffers[i].data = (char*)malloc(BODY_BUFFER_SIZE);
+        if (!bodyBuffers[i].data) return nullptr;
+      }
+      bodyBuffers[i].inUse = true;
+      return bodyBuffers[i].data;
+    }
+  }
+  return (char*)malloc(size);
+}
+
+void WebServerManager::releaseBody(AsyncWebServerRequest *request) {
+  char* body = (char*)request->_tempObject;
+  if (!body) return;
+  
+  // Cleared so the request's destructor never frees a pooled buffer
+  request->_tempObject = nullptr;
+  for (int i = 0; i < BODY_BUFFER_COUNT; i++) {
+    if (bodyBuffers[i].data == body) {
+      bodyBuffers[i].inUse = false;
+      return;
+    }
+  }
+  free(body);
+}
+
+char* WebServerManager::collectBody(AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total) {
+  // Bodies larger than one TCP segment arrive in several calls; data is not terminated,
+  // so each chunk is copied straight to its offset and the body is terminated once complete
+  if (index == 0) {
+    if (total > MAX_REQUEST_BODY_SIZE) {
+      String response = "{\"success\":false,\"message\":\"Request body too large\"}";
+      request->send(413, "application/json", response);
+      return nullptr;
+    }
+    request->_tempObject = acquireBodyBuffer(total + 1);
+    if (!request->_tempObject) {
+      String response = "{\"success\":false,\"message\":\"Out of memory\"}";
+      request->send(500, "application/json", response);
+      return nullptr;
+    }
+    // Returns the buffer even if the client goes away mid-upload
+    request->onDisconnect([this, request]() {
+      this->releaseBody(request);
+    });
+  }
+  
+  char* body = (char*)request->_tempObject;
+  if (!body || index + len > total) {
+    return nullptr; // Rejected on its first chunk, or a chunk past the declared length
+  }
+  memcpy(body + index, data, len);
+  if (index + len < total) {
+    return nullptr;
+  }
+  body[total] = '\0';
+  return body;
+}
+
+bool WebServerManager::parseJsonBody(AsyncWebServerRequest *request, char *body, size_t length, JsonDocument &doc, const char *context) {
+  // The document keeps its own copies of strings, so the buffer can go back to the pool now
+  DeserializationError error = deserializeJson(doc, body, length);
+  releaseBody(request);
+  
+  if (error) {
+    DebugConsole::getInstance().logf("error", "JSON parsing error in %s: %s", context, error.c_str());
+    String response = "{\"success\":false,\"message\":\"Invalid JSON format\"}";
+    request->send(400, "application/json", response);
+    return false;
+  }
+  return true;
+}
+
 // Route setup is implemented in WebServerRoutes.cpp
 // Handler implementations are split across:
 // - WebServerServoHandlers.cpp (servo control endpoints)
 // - WebServerScriptHandlers.cpp (script management endpoints) 
-// - WebServerDebugHandlers.cpp (debug and utility endpoints)
\ No newline at end of file
+// - WebServerDmxHandlers.cpp (Art-Net / sACN mapping endpoints)
+// - WebServerDebugHandlers.cpp (debug and utility endpoints, static pages)
\ No newline at end of file
@@ -4,31 +4,84 @@
 #include <LittleFS.h>
 #include "ServoController.h"
 #include "DebugConsole.h"
+#include "DmxInput.h"
+#include "ConfigJsonStream.h"
+#include "TraceJsonStream.h"
+#include "JsonArena.h"
+
+const size_t MAX_REQUEST_BODY_SIZE = 16384; // Largest request body accepted
+const size_t BODY_BUFFER_SIZE = 4096;       // Pooled body buffers cover typical requests
+const int BODY_BUFFER_COUNT = 2;
+const char* const ASSET_MANIFEST_FILE = "/asset-manifest.json";  // Written by build_web.py
 
 class WebServerManager {
 private:
   AsyncWebServer* server;
+  AsyncWebSocket* controlSocket;
   ServoController* servoController;
+  DmxInput* dmxInput;
+  
+  // Reusable request body buffers. Body callbacks all run on the async_tcp task, so the
+  // pool needs no lock. Bodies that don't fit, or arrive while both are busy, get their own.
+  struct BodyBuffer {
+    char* data;
+    bool inUse;
+  };
+  BodyBuffer bodyBuffers[BODY_BUFFER_COUNT];
+  
+  char* acquireBodyBuffer(size_t size);
+  void releaseBody(AsyncWebServerRequest *request);
   
 public:
-  WebServerManager(ServoController* controller);
+  WebServerManager(ServoController* controller, DmxInput* dmx);
   ~WebServerManager();
   
   void begin();
+  void update();  // Call from loop() for periodic housekeeping
   void setupRoutes();
+  // server->on() with the handler timed by LoopProfiler as "<METHOD> <uri>"
+  AsyncCallbackWebHandler& route(const char *uri, WebRequestMethodComposite method, ArRequestHandlerFunction onRequest);
+  AsyncCallbackWebHandler& route(const char *uri, WebRequestMethodComposite method, ArRequestHandlerFunction onRequest,
+                                 ArUploadHandlerFunction onUpload, ArBodyHandlerFunction onBody);
+  void setupStaticRoutes();
   void handleNotFound(AsyncWebServerRequest *request);
+  void handleStaticPage(AsyncWebServerRequest *request, const String &path, const String &etag);
   
   // API handlers
   void handleGetInfo(AsyncWebServerRequest *request);
   void handleGetConfig(AsyncWebServerRequest *request);
+  void handleGetConfigChanges(AsyncWebServerRequest *request);
+  void handlePatchConfig(AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total);
+  void handleSaveConfig(AsyncWebServerRequest *request);
+  bool parseConfigFilter(AsyncWebServerRequest *request, ConfigJsonStream::Filter &filter, String &error);
+  void sendConfigStream(AsyncWebServerRequest *request, ConfigJsonStream::Content content, uint32_t since,
+                        const ConfigJsonStream::Filter &filter);
   void handlePostConfig(AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total);
   void handleTestServo(AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total);
+  void handleBatch(AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total);
+  // Body handlers collect first and only then lease a pooled document, so the chunks of a
+  // slow upload do not each take a JSON slab
+  char* collectBody(AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total);
+  bool parseJsonBody(AsyncWebServerRequest *request, char *body, size_t length, JsonDocument &doc, const char *context);
+  void handleControlSocketEvent(AsyncWebSocket *socket, AsyncWebSocketClient *client, AwsEventType type, void *arg, uint8_t *data, size_t len);
   void handleInitServos(AsyncWebServerRequest *request);
   void handleSaveOffline(AsyncWebServerRequest *request);
   void handleLoadOffline(AsyncWebServerRequest *request);
   void handleGetDebug(AsyncWebServerRequest *request);
   void handleClearDebug(AsyncWebServerRequest *request);
   void handleCommand(AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total);
+  void handleGetRecording(AsyncWebServerRequest *request);
+  void handleClearRecording(AsyncWebServerRequest *request);
+  void handleGetProfile(AsyncWebServerRequest *request);
+  void handleResetProfile(AsyncWebServerRequest *request);
+  void handleGetTrace(AsyncWebServerRequest *request);
+  void handleClearTrace(AsyncWebServerRequest *request);
+  void handleGetHeap(AsyncWebServerRequest *request);
+  void handleResetHeap(AsyncWebServerRequest *request);
+  
+  // DMX input handlers
+  void handleGetDmx(AsyncWebServerRequest *request);
+  void handlePostDmx(AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total);
   
   // Script management handlers
   void handleGetScripts(AsyncWebServerRequest *request);
@@ -1,5 +1,6 @@
 #include "WebServer.h"
 #include <ArduinoJson.h>
+#include <memory>
 
 // ============================================================================
 // DEBUG AND UTILITY HANDLERS
@@ -12,6 +13,22 @@ void WebServerManager::handleNotFound(AsyncWebServerRequest *request) {
   request->send(404, "application/json", response);
 }
 
+void WebServerManager::handleStaticPage(AsyncWebServerRequest *request, const String &path, const String &etag) {
+  // Pages keep their names, so they are revalidated on every load; a match costs one small 304
+  if (request->hasHeader("If-None-Match") && request->header("If-None-Match") == etag) {
+    AsyncWebServerResponse *response = request->beginResponse(304);
+    response->addHeader("ETag", etag);
+    request->send(response);
+    return;
+  }
+  
+  // Only the .gz is stored; the file response finds it and adds Content-Encoding: gzip
+  AsyncWebServerResponse *response = request->beginResponse(LittleFS, path, "text/html");
+  response->addHeader("Cache-Control", "no-cache");
+  response->addHeader("ETag", etag);
+  request->send(response);
+}
+
 void WebServerManager::handleGetDebug(AsyncWebServerRequest *request) {
   String response = DebugConsole::getInstance().getMessagesJson();
   request->send(200, "application/json", response);
@@ -25,18 +42,93 @@ void WebServerManager::handleClearDebug(AsyncWebServerRequest *request) {
   request->send(200, "application/json", response);
 }
 
+void WebServerManager::handleGetRecording(AsyncWebServerRequest *request) {
+  DebugConsole::getInstance().log("GET /api/recorder - Downloading command recording", "info");
+  
+  // Binary CommandRecordFileHeader + entries, for native_sim --replay
+  AsyncResponseStream *response = request->beginResponseStream("application/octet-stream", CommandRecorder::getInstance().getRecordedBytes());
+  CommandRecorder::getInstance().writeTo(*response);
+  response->addHeader("Content-Disposition", "attachment; filename=\"commands.nxrc\"");
+  response->addHeader("Cache-Control", "no-store");
+  request->send(response);
+}
+
+void WebServerManager::handleClearRecording(AsyncWebServerRequest *request) {
+  DebugConsole::getInstance().log("DELETE /api/recorder - Clearing command recording", "info");
+  CommandRecorder::getInstance().clear();
+  
+  String response = "{\"success\":true,\"message\":\"Command recording cleared\"}";
+  request->send(200, "application/json", response);
+}
+
+void WebServerManager::handleGetProfile(AsyncWebServerRequest *request) {
+  PooledJsonDocument doc;
+  LoopProfiler::getInstance().writeStats(doc.to<JsonObject>());
+  
+  String response;
+  serializeJson(doc, response);
+  request->send(200, "application/json", response);
+}
+
+void WebServerManager::handleResetProfile(AsyncWebServerRequest *request) {
+  DebugConsole::getInstance().log("DELETE /api/profile - Resetting profiler statistics", "info");
+  LoopProfiler::getInstance().reset();
+  
+  String response = "{\"success\":true,\"message\":\"Profiler statistics cleared\"}";
+  request->send(200, "application/json", response);
+}
+
+void WebServerManager::handleGetTrace(AsyncWebServerRequest *request) {
+  DebugConsole::getInstance().log("GET /api/trace - Exporting event trace", "info");
+  
+  // Chrome Trace Event JSON, streamed from the ring one event at a time
+  auto stream = std::make_shared<TraceJsonStream>();
+  AsyncWebServerResponse *response = request->beginChunkedResponse("application/json",
+    [stream](uint8_t *buffer, size_t maxLen, size_t index) -> size_t {
+      return stream->read(buffer, maxLen);
+    });
+  response->addHeader("Content-Disposition", "attachment; filename=\"trace.json\"");
+  response->addHeader("Cache-Control", "no-store");
+  request->send(response);
+}
+
+void WebServerManager::handleClearTrace(AsyncWebServerRequest *request) {
+  DebugConsole::getInstance().log("DELETE /api/trace - Clearing event trace", "info");
+  EventTrace::getInstance().clear();
+  
+  String response = "{\"success\":true,\"message\":\"Event trace cleared\"}";
+  request->send(200, "application/json", response);
+}
+
+void WebServerManager::handleGetHeap(AsyncWebServerRequest *request) {
+  PooledJsonDocument doc;
+  HeapTracker::getInstance().writeStats(doc.to<JsonObject>());
+  
+  String response;
+  serializeJson(doc, response);
+  request->send(200, "application/json", response);
+}
+
+void WebServerManager::handleResetHeap(AsyncWebServerRequest *request) {
+  DebugConsole::getInstance().log("DELETE /api/heap - Resetting heap accounting", "info");
+  HeapTracker::getInstance().reset();
+  
+  String response = "{\"success\":true,\"message\":\"Heap accounting cleared\"}";
+  request->send(200, "application/json", response);
+}
+
 void WebServerManager::handleCommand(AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total) {
-  DebugConsole::getInstance().log("POST /api/command - Execute command", "info");
+  if (index == 0) {
+    DebugConsole::getInstance().log("POST /api/command - Execute command", "info");
+  }
   
-  // Simple approach - just use the current chunk (works for most cases)
-  String body = String((char*)data).substring(0, len);
-  JsonDocument doc;
-  DeserializationError error = deserializeJson(doc, body);
+  char *body = collectBody(request, data, len, index, total);
+  if (!body) {
+    return;
+  }
   
-  if (error) {
-    DebugConsole::getInstance().log("JSON parsing error in command: " + String(error.c_str()), "error");
-    String response = "{\"success\":false,\"message\":\"Invalid JSON format\"}";
-    request->send(400, "application/json", response);
+  PooledJsonDocument doc;
+  if (!parseJsonBody(request, body, total, doc, "command")) {
     return;
   }
   
@@ -44,6 +136,7 @@ void WebServerManager::handleCommand(AsyncWebServerRequest *request, uint8_t *da
     String command = doc["command"];
     
     // Execute the command
+    CommandRecorder::SourceScope source(COMMAND_SOURCE_HTTP);
     String result = servoController->executeCommand(command);
     
     // Log the command and result to debug console
@@ -51,7 +144,7 @@ void WebServerManager::handleCommand(AsyncWebServerRequest *request, uint8_t *da
     DebugConsole::getInstance().log("Result: " + result, "info");
     
     // Create response
-    JsonDocument response;
+    PooledJsonDocument response;
     response["success"] = true;
     response["command"] = command;
     response["result"] = result;
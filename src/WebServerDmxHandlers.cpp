@@ -0,0 +1,60 @@
+#include "WebServer.h"
+#include <ArduinoJson.h>
+
+// ============================================================================
+// DMX INPUT HANDLERS
+// ============================================================================
+
+void WebServerManager::handleGetDmx(AsyncWebServerRequest *request) {
+  DebugConsole::getInstance().log("GET /api/dmx - DMX mappings", "info");
+  String response = dmxInput->getConfigJson();
+  request->send(200, "application/json", response);
+}
+
+void WebServerManager::handlePostDmx(AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total) {
+  if (index == 0) {
+    DebugConsole::getInstance().log("POST /api/dmx - Update DMX mappings", "info");
+  }
+  
+  char *body = collectBody(request, data, len, index, total);
+  if (!body) {
+    return;
+  }
+  
+  PooledJsonDocument doc;
+  if (!parseJsonBody(request, body, total, doc, "DMX update")) {
+    return;
+  }
+  
+  if (!doc["mappings"].is<JsonArray>()) {
+    String response = "{\"success\":false,\"message\":\"Invalid format. Expected: {\\\"mappings\\\": [{\\\"universe\\\": 1, \\\"address\\\": 1, \\\"board\\\": 0, \\\"servo\\\": 0, \\\"count\\\": 16, \\\"sixteenBit\\\": false}]}\"}";
+    request->send(400, "application/json", response);
+    return;
+  }
+  
+  DmxMapping mappings[MAX_DMX_MAPPINGS];
+  int count = 0;
+  for (JsonObject mappingObj : doc["mappings"].as<JsonArray>()) {
+    if (count >= MAX_DMX_MAPPINGS) {
+      String response = "{\"success\":false,\"message\":\"Too many DMX mappings (max " + String(MAX_DMX_MAPPINGS) + ")\"}";
+      request->send(400, "application/json", response);
+      return;
+    }
+    mappings[count].universe = mappingObj["universe"] | 0;
+    mappings[count].address = mappingObj["address"] | 1;
+    mappings[count].boardIndex = mappingObj["board"] | 0;
+    mappings[count].servoIndex = mappingObj["servo"] | 0;
+    mappings[count].count = mappingObj["count"] | 0;
+    mappings[count].sixteenBit = mappingObj["sixteenBit"] | false;
+    count++;
+  }
+  
+  if (dmxInput->setMappings(mappings, count)) {
+    dmxInput->saveConfiguration();
+    String response = "{\"success\":true,\"message\":\"DMX mappings updated successfully\"}";
+    request->send(200, "application/json", response);
+  } else {
+    String response = "{\"success\":false,\"message\":\"Invalid DMX mapping. Check address range and servo targets.\"}";
+    request->send(400, "application/json", response);
+  }
+}
@@ -7,8 +7,8 @@
 void WebServerManager::setupRoutes() {
   DebugConsole::getInstance().log("Setting up web server routes", "info");
   
-  // Serve static files from LittleFS
-  server->serveStatic("/", LittleFS, "/").setDefaultFile("index.html");
+  // Serve the web UI from LittleFS
+  setupStaticRoutes();
   
   // Add error handling
   server->onNotFound([this](AsyncWebServerRequest *request) {
@@ -19,60 +19,104 @@ void WebServerManager::setupRoutes() {
   // SERVO CONTROL ENDPOINTS
   // ========================================================================
   
-  server->on("/api/info", HTTP_GET, [this](AsyncWebServerRequest *request) {
+  route("/api/info", HTTP_GET, [this](AsyncWebServerRequest *request) {
     this->handleGetInfo(request);
   });
   
-  server->on("/api/config", HTTP_GET, [this](AsyncWebServerRequest *request) {
+  // Registered before /api/config, which would otherwise match these paths as a prefix
+  route("/api/config/changes", HTTP_GET, [this](AsyncWebServerRequest *request) {
+    this->handleGetConfigChanges(request);
+  });
+  
+  route("/api/config/save", HTTP_POST, [this](AsyncWebServerRequest *request) {
+    this->handleSaveConfig(request);
+  });
+  
+  route("/api/config", HTTP_GET, [this](AsyncWebServerRequest *request) {
     this->handleGetConfig(request);
   });
   
-  server->on("/api/config", HTTP_POST, [](AsyncWebServerRequest *request){}, NULL,
+  route("/api/config", HTTP_POST, [](AsyncWebServerRequest *request){}, NULL,
     [this](AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total) {
       this->handlePostConfig(request, data, len, index, total);
     });
   
-  server->on("/api/test", HTTP_POST, [](AsyncWebServerRequest *request){}, NULL,
+  route("/api/config", HTTP_PATCH, [](AsyncWebServerRequest *request){}, NULL,
+    [this](AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total) {
+      this->handlePatchConfig(request, data, len, index, total);
+    });
+  
+  route("/api/test", HTTP_POST, [](AsyncWebServerRequest *request){}, NULL,
     [this](AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total) {
       this->handleTestServo(request, data, len, index, total);
     });
   
-  server->on("/api/init", HTTP_POST, [this](AsyncWebServerRequest *request) {
+  // Persistent control channel for sliders; targets are coalesced per motion tick
+  int socketSlot = LoopProfiler::getInstance().registerHandler("WS /ws");
+  uint16_t socketTrace = EventTrace::getInstance().intern("WS /ws");
+  controlSocket->onEvent([this, socketSlot, socketTrace](AsyncWebSocket *socket, AsyncWebSocketClient *client, AwsEventType type, void *arg, uint8_t *data, size_t len) {
+    LoopProfiler::HandlerScope profile(socketSlot);
+    EventTrace::TrackScope track(TRACE_TRACK_HTTP);
+    HeapTracker::Scope heap(HEAP_TAG_HTTP);
+    EventTrace::Span span(socketTrace, type);
+    this->handleControlSocketEvent(socket, client, type, arg, data, len);
+  });
+  server->addHandler(controlSocket);
+  
+  route("/api/batch", HTTP_POST, [](AsyncWebServerRequest *request){}, NULL,
+    [this](AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total) {
+      this->handleBatch(request, data, len, index, total);
+    });
+  
+  route("/api/init", HTTP_POST, [this](AsyncWebServerRequest *request) {
     this->handleInitServos(request);
   });
   
-  server->on("/api/save-offline", HTTP_POST, [this](AsyncWebServerRequest *request) {
+  route("/api/save-offline", HTTP_POST, [this](AsyncWebServerRequest *request) {
     this->handleSaveOffline(request);
   });
   
-  server->on("/api/load-offline", HTTP_POST, [this](AsyncWebServerRequest *request) {
+  route("/api/load-offline", HTTP_POST, [this](AsyncWebServerRequest *request) {
     this->handleLoadOffline(request);
   });
   
+  // ========================================================================
+  // DMX INPUT ENDPOINTS
+  // ========================================================================
+  
+  route("/api/dmx", HTTP_GET, [this](AsyncWebServerRequest *request) {
+    this->handleGetDmx(request);
+  });
+  
+  route("/api/dmx", HTTP_POST, [](AsyncWebServerRequest *request){}, NULL,
+    [this](AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total) {
+      this->handlePostDmx(request, data, len, index, total);
+    });
+  
   // ========================================================================
   // SCRIPT MANAGEMENT ENDPOINTS
   // ========================================================================
   
-  server->on("/api/scripts", HTTP_GET, [this](AsyncWebServerRequest *request) {
+  route("/api/scripts", HTTP_GET, [this](AsyncWebServerRequest *request) {
     this->handleGetScripts(request);
   });
   
-  server->on("/api/scripts", HTTP_POST, [](AsyncWebServerRequest *request){}, NULL,
+  route("/api/scripts", HTTP_POST, [](AsyncWebServerRequest *request){}, NULL,
     [this](AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total) {
       this->handlePostScript(request, data, len, index, total);
     });
   
-  server->on("/api/scripts", HTTP_PUT, [](AsyncWebServerRequest *request){}, NULL,
+  route("/api/scripts", HTTP_PUT, [](AsyncWebServerRequest *request){}, NULL,
     [this](AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total) {
       this->handlePutScript(request, data, len, index, total);
     });
   
-  server->on("/api/scripts", HTTP_DELETE, [](AsyncWebServerRequest *request){}, NULL,
+  route("/api/scripts", HTTP_DELETE, [](AsyncWebServerRequest *request){}, NULL,
     [this](AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total) {
       this->handleDeleteScript(request, data, len, index, total);
     });
   
-  server->on("/api/execute-script", HTTP_POST, [](AsyncWebServerRequest *request){}, NULL,
+  route("/api/execute-script", HTTP_POST, [](AsyncWebServerRequest *request){}, NULL,
     [this](AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total) {
       this->handleExecuteScript(request, data, len, index, total);
     });
@@ -81,25 +125,128 @@ void WebServerManager::setupRoutes() {
   // DEBUG AND UTILITY ENDPOINTS
   // ========================================================================
   
-  server->on("/api/debug", HTTP_GET, [this](AsyncWebServerRequest *request) {
+  route("/api/debug", HTTP_GET, [this](AsyncWebServerRequest *request) {
     this->handleGetDebug(request);
   });
   
-  server->on("/api/debug", HTTP_DELETE, [this](AsyncWebServerRequest *request) {
+  route("/api/debug", HTTP_DELETE, [this](AsyncWebServerRequest *request) {
     this->handleClearDebug(request);
   });
   
-  server->on("/api/debug/test", HTTP_GET, [this](AsyncWebServerRequest *request) {
+  route("/api/debug/test", HTTP_GET, [this](AsyncWebServerRequest *request) {
     DebugConsole::getInstance().log("Debug test endpoint called", "info");
-    Serial.println("Debug test endpoint called");
     String response = "{\"success\":true,\"message\":\"Debug test successful\"}";
     request->send(200, "application/json", response);
   });
   
-  server->on("/api/command", HTTP_POST, [](AsyncWebServerRequest *request){}, NULL,
+  route("/api/recorder", HTTP_GET, [this](AsyncWebServerRequest *request) {
+    this->handleGetRecording(request);
+  });
+  
+  route("/api/recorder", HTTP_DELETE, [this](AsyncWebServerRequest *request) {
+    this->handleClearRecording(request);
+  });
+  
+  route("/api/profile", HTTP_GET, [this](AsyncWebServerRequest *request) {
+    this->handleGetProfile(request);
+  });
+  
+  route("/api/profile", HTTP_DELETE, [this](AsyncWebServerRequest *request) {
+    this->handleResetProfile(request);
+  });
+  
+  route("/api/trace", HTTP_GET, [this](AsyncWebServerRequest *request) {
+    this->handleGetTrace(request);
+  });
+  
+  route("/api/trace", HTTP_DELETE, [this](AsyncWebServerRequest *request) {
+    this->handleClearTrace(request);
+  });
+  
+  route("/api/heap", HTTP_GET, [this](AsyncWebServerRequest *request) {
+    this->handleGetHeap(request);
+  });
+  
+  route("/api/heap", HTTP_DELETE, [this](AsyncWebServerRequest *request) {
+    this->handleResetHeap(request);
+  });
+  
+  route("/api/command", HTTP_POST, [](AsyncWebServerRequest *request){}, NULL,
     [this](AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total) {
       this->handleCommand(request, data, len, index, total);
     });
   
   DebugConsole::getInstance().log("Web server routes configured successfully", "success");
-}
\ No newline at end of file
+}
+
+static const char* methodName(WebRequestMethodComposite method) {
+  switch (method) {
+    case HTTP_GET: return "GET";
+    case HTTP_POST: return "POST";
+    case HTTP_PUT: return "PUT";
+    case HTTP_PATCH: return "PATCH";
+    case HTTP_DELETE: return "DELETE";
+    default: return "ANY";
+  }
+}
+
+AsyncCallbackWebHandler& WebServerManager::route(const char *uri, WebRequestMethodComposite method, ArRequestHandlerFunction onRequest) {
+  String name = String(methodName(method)) + " " + uri;
+  int slot = LoopProfiler::getInstance().registerHandler(name);
+  uint16_t traceName = EventTrace::getInstance().intern(name);
+  return server->on(uri, method, [slot, traceName, onRequest](AsyncWebServerRequest *request) {
+    LoopProfiler::HandlerScope profile(slot);
+    EventTrace::TrackScope track(TRACE_TRACK_HTTP);
+    HeapTracker::Scope heap(HEAP_TAG_HTTP);
+    EventTrace::Span span(traceName);
+    onRequest(request);
+  });
+}
+
+AsyncCallbackWebHandler& WebServerManager::route(const char *uri, WebRequestMethodComposite method, ArRequestHandlerFunction onRequest,
+                                                 ArUploadHandlerFunction onUpload, ArBodyHandlerFunction onBody) {
+  // Body routes do their work per body chunk; the request callback is empty
+  String name = String(methodName(method)) + " " + uri;
+  int slot = LoopProfiler::getInstance().registerHandler(name);
+  uint16_t traceName = EventTrace::getInstance().intern(name);
+  return server->on(uri, method, onRequest, onUpload,
+    [slot, traceName, onBody](AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total) {
+      LoopProfiler::HandlerScope profile(slot);
+      EventTrace::TrackScope track(TRACE_TRACK_HTTP);
+      HeapTracker::Scope heap(HEAP_TAG_HTTP);
+      EventTrace::Span span(traceName, index);
+      onBody(request, data, len, index, total);
+    });
+}
+
+void WebServerManager::setupStaticRoutes() {
+  // build_web.py lists each page with an ETag of its content. Without the manifest (data/
+  // uploaded as-is) everything falls through to the plain static handler below.
+  File manifestFile = LittleFS.open(ASSET_MANIFEST_FILE, "r");
+  if (manifestFile) {
+    JsonDocument manifest;
+    DeserializationError error = deserializeJson(manifest, manifestFile);
+    manifestFile.close();
+    
+    if (!error) {
+      for (JsonPair page : manifest["pages"].as<JsonObject>()) {
+        String path = page.key().c_str();
+        String etag = page.value().as<String>();
+        auto handler = [this, path, etag](AsyncWebServerRequest *request) {
+          this->handleStaticPage(request, path, etag);
+        };
+        server->on(path.c_str(), HTTP_GET, handler);
+        if (path == "/index.html") {
+          server->on("/", HTTP_GET, handler);
+        }
+      }
+    } else {
+      DebugConsole::getInstance().log("Failed to parse " + String(ASSET_MANIFEST_FILE), "error");
+    }
+  }
+  
+  // Bundles and stylesheets are named after their content hash, so a URL never changes meaning
+  server->serveStatic("/assets/", LittleFS, "/assets/").setCacheControl("public, max-age=31536000, immutable");
+  
+  server->serveStatic("/", LittleFS, "/").setDefaultFile("index.html");
+}
@@ -1,5 +1,6 @@
 #include "WebServer.h"
 #include <ArduinoJson.h>
+#include <memory>
 
 // ============================================================================
 // SCRIPT MANAGEMENT HANDLERS
@@ -7,27 +8,27 @@
 
 void WebServerManager::handleGetScripts(AsyncWebServerRequest *request) {
   DebugConsole::getInstance().log("GET /api/scripts - Listing scripts", "info");
-  String response = servoController->getScriptsJson();
-  request->send(200, "application/json", response);
+  
+  auto stream = std::make_shared<ConfigJsonStream>(*servoController, ConfigJsonStream::SCRIPTS);
+  AsyncWebServerResponse *response = request->beginChunkedResponse("application/json",
+    [stream](uint8_t *buffer, size_t maxLen, size_t index) -> size_t {
+      return stream->read(buffer, maxLen);
+    });
+  request->send(response);
 }
 
 void WebServerManager::handlePostScript(AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total) {
-  // Log to both debug console and serial
-  DebugConsole::getInstance().log("POST /api/scripts - Creating script", "info");
-  Serial.println("POST /api/scripts - Creating script");
-  
-  // Simple approach - just use the current chunk (works for most cases)  
-  String body = String((char*)data).substring(0, len);
-  DebugConsole::getInstance().log("Create script request body: " + body, "info");
-  Serial.println("Create script request body: " + body);
+  if (index == 0) {
+    DebugConsole::getInstance().logf("info", "POST /api/scripts - Creating script (%u bytes)", (unsigned)total);
+  }
   
-  JsonDocument doc;
-  DeserializationError error = deserializeJson(doc, body);
+  char *body = collectBody(request, data, len, index, total);
+  if (!body) {
+    return;
+  }
   
-  if (error) {
-    DebugConsole::getInstance().log("JSON parsing error in create script: " + String(error.c_str()), "error");
-    String response = "{\"success\":false,\"message\":\"Invalid JSON format\"}";
-    request->send(400, "application/json", response);
+  PooledJsonDocument doc;
+  if (!parseJsonBody(request, body, total, doc, "create script")) {
     return;
   }
   
@@ -37,7 +38,7 @@ void WebServerManager::handlePostScript(AsyncWebServerRequest *request, uint8_t
     String commands = doc["commands"];
     
     if (servoController->addScript(name, description, commands)) {
-      servoController->saveConfiguration();
+      servoController->requestSave();
       String response = "{\"success\":true,\"message\":\"Script added successfully\"}";
       request->send(200, "application/json", response);
     } else {
@@ -51,19 +52,17 @@ void WebServerManager::handlePostScript(AsyncWebServerRequest *request, uint8_t
 }
 
 void WebServerManager::handlePutScript(AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total) {
-  DebugConsole::getInstance().log("PUT /api/scripts - Updating script", "info");
-  
-  // Simple approach - just use the current chunk (works for most cases)
-  String body = String((char*)data).substring(0, len);
-  DebugConsole::getInstance().log("Update script request body: " + body, "info");
+  if (index == 0) {
+    DebugConsole::getInstance().logf("info", "PUT /api/scripts - Updating script (%u bytes)", (unsigned)total);
+  }
   
-  JsonDocument doc;
-  DeserializationError error = deserializeJson(doc, body);
+  char *body = collectBody(request, data, len, index, total);
+  if (!body) {
+    return;
+  }
   
-  if (error) {
-    DebugConsole::getInstance().log("JSON parsing error in update script: " + String(error.c_str()), "error");
-    String response = "{\"success\":false,\"message\":\"Invalid JSON format\"}";
-    request->send(400, "application/json", response);
+  PooledJsonDocument doc;
+  if (!parseJsonBody(request, body, total, doc, "update script")) {
     return;
   }
   
@@ -74,7 +73,7 @@ void WebServerManager::handlePutScript(AsyncWebServerRequest *request, uint8_t *
     String commands = doc["commands"];
     
     if (servoController->updateScript(scriptIndex, name, description, commands)) {
-      servoController->saveConfiguration();
+      servoController->requestSave();
       String response = "{\"success\":true,\"message\":\"Script updated successfully\"}";
       request->send(200, "application/json", response);
     } else {
@@ -88,19 +87,17 @@ void WebServerManager::handlePutScript(AsyncWebServerRequest *request, uint8_t *
 }
 
 void WebServerManager::handleDeleteScript(AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total) {
-  DebugConsole::getInstance().log("DELETE /api/scripts - Deleting script", "info");
-  
-  // Simple approach - just use the current chunk (works for most cases)
-  String body = String((char*)data).substring(0, len);
-  DebugConsole::getInstance().log("Delete script request body: " + body, "info");
+  if (index == 0) {
+    DebugConsole::getInstance().log("DELETE /api/scripts - Deleting script", "info");
+  }
   
-  JsonDocument doc;
-  DeserializationError error = deserializeJson(doc, body);
+  char *body = collectBody(request, data, len, index, total);
+  if (!body) {
+    return;
+  }
   
-  if (error) {
-    DebugConsole::getInstance().log("JSON parsing error in delete script: " + String(error.c_str()), "error");
-    String response = "{\"success\":false,\"message\":\"Invalid JSON format\"}";
-    request->send(400, "application/json", response);
+  PooledJsonDocument doc;
+  if (!parseJsonBody(request, body, total, doc, "delete script")) {
     return;
   }
   
@@ -108,7 +105,7 @@ void WebServerManager::handleDeleteScript(AsyncWebServerRequest *request, uint8_
     int scriptIndex = doc["index"];
     
     if (servoController->deleteScript(scriptIndex)) {
-      servoController->saveConfiguration();
+      servoController->requestSave();
       String response = "{\"success\":true,\"message\":\"Script deleted successfully\"}";
       request->send(200, "application/json", response);
     } else {
@@ -122,26 +119,22 @@ void WebServerManager::handleDeleteScript(AsyncWebServerRequest *request, uint8_
 }
 
 void WebServerManager::handleExecuteScript(AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total) {
-  // Log to both debug console and serial
-  DebugConsole::getInstance().log("POST /api/execute-script - Executing script", "info");
-  Serial.println("POST /api/execute-script - Executing script");
-  
-  // Simple approach - just use the current chunk (works for most cases)
-  String body = String((char*)data).substring(0, len);
-  JsonDocument doc;
-  DeserializationError error = deserializeJson(doc, body);
+  if (index == 0) {
+    DebugConsole::getInstance().log("POST /api/execute-script - Executing script", "info");
+  }
   
-  // Debug logging
-  DebugConsole::getInstance().log("Execute script request body: " + body, "info");
-  Serial.println("Execute script request body: " + body);
+  char *body = collectBody(request, data, len, index, total);
+  if (!body) {
+    return;
+  }
   
-  if (error) {
-    DebugConsole::getInstance().log("JSON parsing error: " + String(error.c_str()), "error");
-    String response = "{\"success\":false,\"message\":\"Invalid JSON format\"}";
-    request->send(400, "application/json", response);
+  PooledJsonDocument doc;
+  if (!parseJsonBody(request, body, total, doc, "execute script")) {
     return;
   }
   
+  CommandRecorder::SourceScope source(COMMAND_SOURCE_HTTP);
+  
   if (doc["name"].is<const char*>()) {
     String scriptName = doc["name"];
     DebugConsole::getInstance().log("Executing script by name: " + scriptName, "info");
@@ -1,5 +1,7 @@
 #include "WebServer.h"
 #include <ArduinoJson.h>
+#include <vector>
+#include <memory>
 
 // ============================================================================
 // SERVO CONTROL HANDLERS
@@ -13,62 +15,126 @@ void WebServerManager::handleGetInfo(AsyncWebServerRequest *request) {
 
 void WebServerManager::handleGetConfig(AsyncWebServerRequest *request) {
   DebugConsole::getInstance().log("GET /api/config - Configuration", "info");
-  String response = servoController->getConfigurationJson();
-  request->send(200, "application/json", response);
-}
-
-void WebServerManager::handlePostConfig(AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total) {
-  DebugConsole::getInstance().log("POST /api/config - Update configuration", "info");
-  Serial.println("POST /api/config - Update configuration");
   
-  String body = String((char*)data).substring(0, len);
-  DebugConsole::getInstance().log("Config request body: " + body, "info");
-  Serial.println("Config request body: " + body);
+  ConfigJsonStream::Filter filter;
+  String filterError;
+  if (!parseConfigFilter(request, filter, filterError)) {
+    String response = "{\"success\":false,\"message\":\"" + filterError + "\"}";
+    request->send(400, "application/json", response);
+    return;
+  }
+  
+  String etag = servoController->getConfigEtag();
+  if (request->hasHeader("If-None-Match") && request->header("If-None-Match") == etag) {
+    AsyncWebServerResponse *response = request->beginResponse(304);
+    response->addHeader("ETag", etag);
+    request->send(response);
+    return;
+  }
   
-  JsonDocument doc;
-  DeserializationError error = deserializeJson(doc, body);
+  sendConfigStream(request, ConfigJsonStream::CONFIGURATION, 0, filter);
+}
+
+void WebServerManager::handleGetConfigChanges(AsyncWebServerRequest *request) {
+  DebugConsole::getInstance().log("GET /api/config/changes - Configuration changes", "info");
   
-  if (error) {
-    DebugConsole::getInstance().log("JSON parsing error in config update: " + String(error.c_str()), "error");
-    Serial.println("JSON parsing error in config update: " + String(error.c_str()));
-    String response = "{\"success\":false,\"message\":\"Invalid JSON format\"}";
+  ConfigJsonStream::Filter filter;
+  String filterError;
+  if (!parseConfigFilter(request, filter, filterError)) {
+    String response = "{\"success\":false,\"message\":\"" + filterError + "\"}";
     request->send(400, "application/json", response);
     return;
   }
   
-  DebugConsole::getInstance().log("Parsed JSON successfully", "info");
-  Serial.println("Parsed JSON successfully");
+  // Fall back to the full document when the client's version is from another boot or the future
+  bool delta = request->hasParam("since");
+  uint32_t since = delta ? strtoul(request->getParam("since")->value().c_str(), NULL, 10) : 0;
+  if (request->hasParam("boot") &&
+      strtoul(request->getParam("boot")->value().c_str(), NULL, 16) != servoController->getConfigBootId()) {
+    delta = false;
+  }
+  if (since > servoController->getConfigVersion()) {
+    delta = false;
+  }
   
-  // Debug all JSON fields
-  DebugConsole::getInstance().logf("info", "JSON fields: board=%s, servo=%s, field=%s, value=%s", 
-    doc["board"].is<int>() ? "int" : "missing/invalid",
-    doc["servo"].is<int>() ? "int" : "missing/invalid", 
-    doc["field"].is<const char*>() ? "string" : "missing/invalid",
-    doc["value"].is<const char*>() ? "string" : "missing/invalid");
-  Serial.printf("JSON fields: board=%s, servo=%s, field=%s, value=%s\n",
-    doc["board"].is<int>() ? "int" : "missing/invalid",
-    doc["servo"].is<int>() ? "int" : "missing/invalid", 
-    doc["field"].is<const char*>() ? "string" : "missing/invalid",
-    doc["value"].is<const char*>() ? "string" : "missing/invalid");
+  sendConfigStream(request, delta ? ConfigJsonStream::CHANGES : ConfigJsonStream::CONFIGURATION, since, filter);
+}
+
+bool WebServerManager::parseConfigFilter(AsyncWebServerRequest *request, ConfigJsonStream::Filter &filter, String &error) {
+  // ?board=N
+  if (request->hasParam("board")) {
+    filter.board = request->getParam("board")->value().toInt();
+    if (filter.board < 0 || filter.board >= servoController->getDetectedBoardCount()) {
+      error = "Invalid board index " + String(filter.board);
+      return false;
+    }
+  }
+  
+  // ?servos=N or ?servos=A-B
+  if (request->hasParam("servos")) {
+    String range = request->getParam("servos")->value();
+    int dash = range.indexOf('-');
+    filter.firstServo = range.substring(0, dash < 0 ? range.length() : dash).toInt();
+    filter.lastServo = dash < 0 ? filter.firstServo : range.substring(dash + 1).toInt();
+    if (filter.firstServo < 0 || filter.lastServo >= SERVOS_PER_BOARD || filter.firstServo > filter.lastServo) {
+      error = "Invalid servo range " + String(filter.firstServo) + "-" + String(filter.lastServo);
+      return false;
+    }
+  }
   
-  // Debug actual values
-  if (doc["board"].is<int>()) {
-    DebugConsole::getInstance().logf("info", "Board value: %d", doc["board"].as<int>());
-    Serial.printf("Board value: %d\n", doc["board"].as<int>());
+  // ?enabled=true
+  if (request->hasParam("enabled")) {
+    String enabled = request->getParam("enabled")->value();
+    filter.enabledOnly = (enabled == "true" || enabled == "1");
   }
-  if (doc["servo"].is<int>()) {
-    DebugConsole::getInstance().logf("info", "Servo value: %d", doc["servo"].as<int>());
-    Serial.printf("Servo value: %d\n", doc["servo"].as<int>());
+  
+  // ?fields=center,range
+  if (request->hasParam("fields")) {
+    if (!ConfigJsonStream::parseFields(request->getParam("fields")->value(), filter.fields, error)) {
+      return false;
+    }
+  }
+  
+  // ?scripts=false
+  if (request->hasParam("scripts")) {
+    String scripts = request->getParam("scripts")->value();
+    filter.scripts = !(scripts == "false" || scripts == "0");
+  }
+  
+  return true;
+}
+
+void WebServerManager::sendConfigStream(AsyncWebServerRequest *request, ConfigJsonStream::Content content, uint32_t since,
+                                        const ConfigJsonStream::Filter &filter) {
+  String etag = servoController->getConfigEtag();
+  
+  // Stream the document element by element so peak heap does not scale with board count
+  auto stream = std::make_shared<ConfigJsonStream>(*servoController, content, since, filter);
+  AsyncWebServerResponse *response = request->beginChunkedResponse("application/json",
+    [stream](uint8_t *buffer, size_t maxLen, size_t index) -> size_t {
+      return stream->read(buffer, maxLen);
+    });
+  response->addHeader("ETag", etag);
+  response->addHeader("Cache-Control", "no-cache");
+  request->send(response);
+}
+
+void WebServerManager::handlePostConfig(AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total) {
+  if (index == 0) {
+    DebugConsole::getInstance().log("POST /api/config - Update configuration", "info");
   }
-  if (doc["field"].is<const char*>()) {
-    DebugConsole::getInstance().logf("info", "Field value: %s", doc["field"].as<const char*>());
-    Serial.printf("Field value: %s\n", doc["field"].as<const char*>());
+  
+  char *body = collectBody(request, data, len, index, total);
+  if (!body) {
+    return;
   }
-  if (doc["value"].is<const char*>()) {
-    DebugConsole::getInstance().logf("info", "Value: %s", doc["value"].as<const char*>());
-    Serial.printf("Value: %s\n", doc["value"].as<const char*>());
+  
+  PooledJsonDocument doc;
+  if (!parseJsonBody(request, body, total, doc, "config update")) {
+    return;
   }
   
+  // updateServoConfig logs the board, servo, field and value it is given
   if (doc["board"].is<int>() && doc["servo"].is<int>() && doc["field"].is<const char*>() && (doc["value"].is<const char*>() || doc["value"].is<bool>())) {
     int boardIndex = doc["board"];
     int servoIndex = doc["servo"];
@@ -83,8 +149,8 @@ void WebServerManager::handlePostConfig(AsyncWebServerRequest *request, uint8_t
     }
     
     if (servoController->updateServoConfig(boardIndex, servoIndex, field, value)) {
-      servoController->saveConfiguration();
-      String response = "{\"success\":true,\"message\":\"Configuration updated successfully\"}";
+      servoController->requestSave();
+      String response = "{\"success\":true,\"message\":\"Configuration updated successfully\",\"version\":" + String(servoController->getConfigVersion()) + "}";
       request->send(200, "application/json", response);
     } else {
       String response = "{\"success\":false,\"message\":\"Failed to update configuration\"}";
@@ -96,20 +162,70 @@ void WebServerManager::handlePostConfig(AsyncWebServerRequest *request, uint8_t
   }
 }
 
-void WebServerManager::handleTestServo(AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total) {
-  DebugConsole::getInstance().log("POST /api/test - Test servo", "info");
+void WebServerManager::handlePatchConfig(AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total) {
+  if (index == 0) {
+    DebugConsole::getInstance().logf("info", "PATCH /api/config - Patch of %u bytes", (unsigned)total);
+  }
   
-  String body = String((char*)data).substring(0, len);
-  JsonDocument doc;
-  DeserializationError error = deserializeJson(doc, body);
+  char *body = collectBody(request, data, len, index, total);
+  if (!body) {
+    return;
+  }
   
-  if (error) {
-    DebugConsole::getInstance().log("JSON parsing error in servo test: " + String(error.c_str()), "error");
-    String response = "{\"success\":false,\"message\":\"Invalid JSON format\"}";
+  PooledJsonDocument doc;
+  if (!parseJsonBody(request, body, total, doc, "config patch")) {
+    return;
+  }
+  
+  if (!doc["servos"].is<JsonArray>()) {
+    String response = "{\"success\":false,\"message\":\"Patch requires a 'servos' array\"}";
     request->send(400, "application/json", response);
     return;
   }
   
+  // All or nothing: any rejected entry or field leaves the configuration untouched
+  PooledJsonDocument response;
+  JsonArray errors = response["errors"].to<JsonArray>();
+  int applied = servoController->applyConfigPatch(doc["servos"].as<JsonArrayConst>(), errors);
+  
+  // Persisted by the write-behind task, so the response does not wait for flash
+  if (applied > 0) {
+    servoController->requestSave();
+  }
+  
+  response["success"] = (errors.size() == 0);
+  response["applied"] = applied;
+  response["version"] = servoController->getConfigVersion();
+  
+  String responseStr;
+  serializeJson(response, responseStr);
+  request->send(errors.size() == 0 ? 200 : 400, "application/json", responseStr);
+}
+
+void WebServerManager::handleSaveConfig(AsyncWebServerRequest *request) {
+  DebugConsole::getInstance().log("POST /api/config/save - Flush configuration", "info");
+  
+  servoController->flushConfiguration();
+  
+  String response = "{\"success\":true,\"message\":\"Configuration save started\"}";
+  request->send(200, "application/json", response);
+}
+
+void WebServerManager::handleTestServo(AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total) {
+  if (index == 0) {
+    DebugConsole::getInstance().log("POST /api/test - Test servo", "info");
+  }
+  
+  char *body = collectBody(request, data, len, index, total);
+  if (!body) {
+    return;
+  }
+  
+  PooledJsonDocument doc;
+  if (!parseJsonBody(request, body, total, doc, "servo test")) {
+    return;
+  }
+  
   if (doc["board"].is<int>() && doc["servo"].is<int>() && doc["position"].is<float>()) {
     int boardIndex = doc["board"];
     int servoIndex = doc["servo"];
@@ -125,6 +241,179 @@ void WebServerManager::handleTestServo(AsyncWebServerRequest *request, uint8_t *
   }
 }
 
+void WebServerManager::handleBatch(AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total) {
+  if (index == 0) {
+    DebugConsole::getInstance().logf("info", "POST /api/batch - Batch of %u bytes", (unsigned)total);
+  }
+  
+  char *body = collectBody(request, data, len, index, total);
+  if (!body) {
+    return;
+  }
+  
+  PooledJsonDocument doc;
+  if (!parseJsonBody(request, body, total, doc, "batch")) {
+    return;
+  }
+  
+  PooledJsonDocument response;
+  JsonArray results = response["results"].to<JsonArray>();
+  
+  if (doc["positions"].is<JsonArray>()) {
+    // Parse and validate every item first; nothing moves unless the whole frame is valid
+    JsonArray items = doc["positions"].as<JsonArray>();
+    if (items.size() == 0 || items.size() > MAX_BATCH_ITEMS) {
+      String message = "{\"success\":false,\"message\":\"Batch must contain 1-" + String(MAX_BATCH_ITEMS) + " positions\"}";
+      request->send(400, "application/json", message);
+      return;
+    }
+    
+    std::vector<PositionTarget> targets(items.size());
+    bool allValid = true;
+    int i = 0;
+    for (JsonVariant item : items) {
+      PositionTarget& target = targets[i];
+      String itemError;
+      bool valid;
+      
+      // Accept either compact [board, servo, position] triples or objects
+      if (item.is<JsonArray>() && item.size() == 3) {
+        target.boardIndex = item[0] | -1;
+        target.servoIndex = item[1] | -1;
+        target.position = item[2] | -1.0f;
+        valid = servoController->validatePositionTarget(target, itemError);
+      } else if (item["board"].is<int>() && item["servo"].is<int>() && item["position"].is<float>()) {
+        target.boardIndex = item["board"];
+        target.servoIndex = item["servo"];
+        target.position = item["position"];
+        valid = servoController->validatePositionTarget(target, itemError);
+      } else {
+        itemError = "Invalid position format";
+        valid = false;
+      }
+      
+      JsonObject result = results.add<JsonObject>();
+      result["index"] = i;
+      result["success"] = valid;
+      if (!valid) {
+        result["message"] = itemError;
+        allValid = false;
+      }
+      i++;
+    }
+    
+    if (allValid) {
+      servoController->applyPositionFrame(targets.data(), targets.size());
+    }
+    response["success"] = allValid;
+    response["applied"] = allValid ? (int)targets.size() : 0;
+    
+    String responseStr;
+    serializeJson(response, responseStr);
+    request->send(allValid ? 200 : 400, "application/json", responseStr);
+  } else if (doc["commands"].is<JsonArray>()) {
+    JsonArray items = doc["commands"].as<JsonArray>();
+    if (items.size() == 0 || items.size() > MAX_BATCH_ITEMS) {
+      String message = "{\"success\":false,\"message\":\"Batch must contain 1-" + String(MAX_BATCH_ITEMS) + " commands\"}";
+      request->send(400, "application/json", message);
+      return;
+    }
+    
+    std::vector<String> commands(items.size());
+    int i = 0;
+    for (JsonVariant item : items) {
+      if (!item.is<const char*>()) {
+        String message = "{\"success\":false,\"message\":\"Command " + String(i) + " is not a string\"}";
+        request->send(400, "application/json", message);
+        return;
+      }
+      commands[i++] = item.as<const char*>();
+    }
+    
+    std::vector<String> commandResults(commands.size());
+    CommandRecorder::SourceScope source(COMMAND_SOURCE_HTTP);
+    servoController->executeCommandBatch(commands.data(), commands.size(), commandResults.data());
+    
+    for (size_t c = 0; c < commandResults.size(); c++) {
+      JsonObject result = results.add<JsonObject>();
+      result["index"] = c;
+      result["success"] = !commandResults[c].startsWith("Error");
+      result["result"] = commandResults[c];
+    }
+    response["success"] = true;
+    response["applied"] = (int)commands.size();
+    
+    String responseStr;
+    serializeJson(response, responseStr);
+    request->send(200, "application/json", responseStr);
+  } else {
+    String message = "{\"success\":false,\"message\":\"Invalid batch format. Expected: {\\\"positions\\\": [[board, servo, position], ...]} or {\\\"commands\\\": [\\\"...\\\"]}\"}";
+    request->send(400, "application/json", message);
+  }
+}
+
+// Parses one "<board> <servo> <position>" entry; false if anything is missing or left over
+static bool parseControlEntry(const uint8_t *data, size_t len, long &boardIndex, long &servoIndex, float &position) {
+  char entry[48];
+  if (len >= sizeof(entry)) return false;
+  memcpy(entry, data, len);
+  entry[len] = '\0';
+  
+  char *cursor = entry;
+  char *end;
+  boardIndex = strtol(cursor, &end, 10);
+  if (end == cursor) return false;
+  cursor = end;
+  servoIndex = strtol(cursor, &end, 10);
+  if (end == cursor) return false;
+  cursor = end;
+  position = strtof(cursor, &end);
+  if (end == cursor) return false;
+  cursor = end;
+  
+  while (*cursor == ' ' || *cursor == '\r' || *cursor == '\t') {
+    cursor++;
+  }
+  return *cursor == '\0';
+}
+
+void WebServerManager::handleControlSocketEvent(AsyncWebSocket *socket, AsyncWebSocketClient *client, AwsEventType type, void *arg, uint8_t *data, size_t len) {
+  if (type == WS_EVT_CONNECT) {
+    DebugConsole::getInstance().logf("info", "WebSocket client %u connected", client->id());
+    return;
+  }
+  if (type == WS_EVT_DISCONNECT) {
+    DebugConsole::getInstance().logf("info", "WebSocket client %u disconnected", client->id());
+    return;
+  }
+  if (type != WS_EVT_DATA) return;
+  
+  // Only single-frame text messages; slider updates are a few bytes each
+  AwsFrameInfo *info = (AwsFrameInfo*)arg;
+  if (!info->final || info->index != 0 || info->len != len || info->opcode != WS_TEXT) return;
+  
+  // Message: one or more "<board> <servo> <position>" entries, each ended by a newline,
+  // ';' or the end of the message. Entries are parsed in place over the whole message, so
+  // a long one is never cut short and only well-formed entries move anything. Targets are
+  // staged and the newest one per servo is applied on the next motion tick, so fast drags
+  // never queue up.
+  size_t start = 0;
+  while (start < len) {
+    size_t end = start;
+    while (end < len && data[end] != '\n' && data[end] != ';') {
+      end++;
+    }
+    
+    long boardIndex, servoIndex;
+    float position;
+    if (parseControlEntry(data + start, end - start, boardIndex, servoIndex, position) &&
+        position >= 0.0 && position <= 100.0) {
+      servoController->stageServoTarget(boardIndex, servoIndex, position);
+    }
+    start = end + 1;
+  }
+}
+
 void WebServerManager::handleInitServos(AsyncWebServerRequest *request) {
   DebugConsole::getInstance().log("POST /api/init - Initialize servos", "info");
   
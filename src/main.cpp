@@ -4,10 +4,17 @@
 #include "wifi_credentials.h"
 #include "ServoController.h"
 #include "WebServer.h"
+#include "SerialStream.h"
+#include "UdpFrameReceiver.h"
+#include "DmxInput.h"
+#include "JsonArena.h"
 
 // Global objects
 ServoController* servoController;
 WebServerManager* webServer;
+SerialStream* serialStream;
+UdpFrameReceiver* udpReceiver;
+DmxInput* dmxInput;
 
 // Serial command buffer
 String serialCommand = "";
@@ -49,9 +56,13 @@ void initWiFi() {
 
 void setup()
 {
-  Serial.begin(115200);
+  Serial.setRxBufferSize(SerialStream::RX_BUFFER_SIZE);
+  Serial.begin(SerialStream::CONSOLE_BAUD);
   Serial.println("Starting ESP32 Multi-Board Servo Controller...");
   
+  // JSON slabs are taken first, while the heap is still one contiguous block
+  JsonArenaPool::getInstance().begin();
+  
   // Initialize I2C
   Wire.begin();
   
@@ -73,8 +84,22 @@ void setup()
   // Load configuration
   servoController->loadConfiguration();
   
+  // Config edits are persisted by a background task once they pause
+  servoController->startPersistence();
+  
+  // Binary streaming shares the serial port with the command console
+  serialStream = new SerialStream(Serial, *servoController);
+  
+  // Realtime animation frames over UDP
+  udpReceiver = new UdpFrameReceiver(*servoController);
+  udpReceiver->begin();
+  
+  // Art-Net / sACN lighting desk input
+  dmxInput = new DmxInput(*servoController);
+  dmxInput->begin();
+  
   // Create and start web server
-  webServer = new WebServerManager(servoController);
+  webServer = new WebServerManager(servoController, dmxInput);
   webServer->begin();
   
   // Apply initial positions
@@ -88,10 +113,24 @@ void setup()
 }
 
 void processSerialInput() {
+  // Binary stream mode owns the port until the host sends an exit frame
+  if (serialStream->isActive()) {
+    serialStream->poll();
+    return;
+  }
+  
   // Read serial input character by character
   while (Serial.available() > 0) {
     char inChar = (char)Serial.read();
     
+    if (serialStream->matchEntryMagic((uint8_t)inChar)) {
+      // Discard any partly typed command and hand the port to the binary decoder
+      serialCommand = "";
+      serialCommandReady = false;
+      serialStream->begin();
+      return;
+    }
+    
     if (inChar == '\n' || inChar == '\r') {
       // End of command
       if (serialCommand.length() > 0) {
@@ -121,6 +160,7 @@ void executeSerialCommand() {
       Serial.println(serialCommand);
       
       // Execute command through ServoController
+      CommandRecorder::SourceScope source(COMMAND_SOURCE_SERIAL);
       String result = servoController->executeCommand(serialCommand);
       
       // Print result
@@ -142,12 +182,29 @@ void loop()
   // Main loop - servos are now controlled via HTTP API
   // The web server handles requests asynchronously
   
+  LoopProfiler::getInstance().beginFrame();
+  
   // Process queued commands with timers
   servoController->update();
   
+  // WebSocket housekeeping
+  {
+    LoopProfiler::PhaseScope phase(PROFILE_WEB_UPDATE);
+    webServer->update();
+  }
+  
   // Handle serial command input
-  processSerialInput();
-  executeSerialCommand();
+  {
+    LoopProfiler::PhaseScope phase(PROFILE_SERIAL_INPUT);
+    processSerialInput();
+  }
+  {
+    LoopProfiler::PhaseScope phase(PROFILE_SERIAL_COMMAND);
+    executeSerialCommand();
+  }
+  
+  LoopProfiler::getInstance().endFrame();
+  HeapTracker::getInstance().sample();
   
   // Small delay to prevent watchdog issues
   delay(1);
@@ -0,0 +1,216 @@
+#!/usr/bin/env python3
+"""
+Host-side sender for the binary serial streaming protocol (see src/SerialStream.h).
+
+Streams packed channel positions to the ESP32 at a fixed frame rate:
+    python3 stream_serial.py --port /dev/ttyUSB0 --channels 128 --rate 50
+
+Loopback check without hardware: the host console build runs the firmware's own decoder
+with a pseudo-terminal as its UART, and the frames it counts must match the frames sent:
+    pio run -e native
+    python3 stream_serial.py --selftest --channels 128 --rate 200 --seconds 5
+"""
+
+import argparse
+import math
+import os
+import select
+import struct
+import subprocess
+import sys
+import time
+import tty
+
+ENTRY_MAGIC = bytes([0xFE, 0xED, 0xBE, 0xEF])
+FRAME_SYNC = 0xA5
+FRAME_ACK = 0x06
+FRAME_POSITIONS = 0x01
+FRAME_STATS = 0x02
+FRAME_EXIT = 0x03
+FRAME_STATS_REPLY = 0x82
+
+CONSOLE_BAUD = 115200
+STREAM_BAUD = 921600
+INACTIVITY_TIMEOUT = 2.0  # SerialStream::INACTIVITY_TIMEOUT_MS
+
+DEFAULT_PROGRAM = ".pio/build/native/program"
+
+
+def crc16(data, crc=0xFFFF):
+    """CRC-16/CCITT-FALSE, matching SerialStream::crc16."""
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if (crc & 0x8000) else (crc << 1)
+            crc &= 0xFFFF
+    return crc
+
+
+def encode_frame(frame_type, payload=b""):
+    header = struct.pack("<HB", len(payload), frame_type)
+    crc = crc16(header + payload)
+    return bytes([FRAME_SYNC]) + header + payload + struct.pack("<H", crc)
+
+
+def encode_positions(first_channel, positions):
+    """positions are percentages (0-100), packed as u16 0-65535."""
+    values = [max(0, min(65535, int(round(p * 655.35)))) for p in positions]
+    payload = struct.pack("<H", first_channel) + struct.pack("<%dH" % len(values), *values)
+    return encode_frame(FRAME_POSITIONS, payload)
+
+
+def animation_frame(channels, t):
+    """Sine wave across all channels, phase-shifted per channel."""
+    return [50.0 + 40.0 * math.sin(2 * math.pi * 0.5 * t + ch * 0.2) for ch in range(channels)]
+
+
+def find_stats_reply(data):
+    """(frames, crc_errors, overflows) from the first valid FRAME_STATS_REPLY in data, or None."""
+    start = data.find(bytes([FRAME_SYNC, 12, 0, FRAME_STATS_REPLY]))
+    while start >= 0 and len(data) >= start + 18:
+        (crc,) = struct.unpack_from("<H", data, start + 16)
+        if crc16(data[start + 1:start + 16]) == crc:
+            return struct.unpack_from("<III", data, start + 4)
+        start = data.find(bytes([FRAME_SYNC, 12, 0, FRAME_STATS_REPLY]), start + 1)
+    return None
+
+
+def stream(write, channels, rate, seconds):
+    period = 1.0 / rate
+    start = time.monotonic()
+    next_frame = start
+    sent = 0
+    sent_bytes = 0
+    while seconds <= 0 or time.monotonic() - start < seconds:
+        t = time.monotonic() - start
+        frame = encode_positions(0, animation_frame(channels, t))
+        write(frame)
+        sent += 1
+        sent_bytes += len(frame)
+        next_frame += period
+        delay = next_frame - time.monotonic()
+        if delay > 0:
+            time.sleep(delay)
+    elapsed = time.monotonic() - start
+    return sent, sent_bytes, elapsed
+
+
+def run_device(args):
+    import serial  # pyserial
+
+    port = serial.Serial(args.port, CONSOLE_BAUD, timeout=1)
+    port.write(ENTRY_MAGIC)
+    ack = port.read(1)
+    if ack != bytes([FRAME_ACK]):
+        # Skip console echo until the ACK arrives
+        deadline = time.monotonic() + 2
+        while ack != bytes([FRAME_ACK]) and time.monotonic() < deadline:
+            ack = port.read(1)
+        if ack != bytes([FRAME_ACK]):
+            print("[STREAM] No ACK from device; is the firmware running?")
+            return 1
+    port.baudrate = STREAM_BAUD
+    print(f"[STREAM] Binary mode at {STREAM_BAUD} baud, {args.channels} channels @ {args.rate} Hz")
+
+    try:
+        sent, sent_bytes, elapsed = stream(port.write, args.channels, args.rate, args.seconds)
+    except KeyboardInterrupt:
+        sent, sent_bytes, elapsed = 0, 0, 0
+
+    port.reset_input_buffer()
+    port.write(encode_frame(FRAME_STATS))
+    reply = port.read(18)
+    if len(reply) == 18 and reply[3] == FRAME_STATS_REPLY:
+        frames, crc_errors, overflows = struct.unpack_from("<III", reply, 4)
+        print(f"[STREAM] Device: {frames} frames, {crc_errors} CRC errors, {overflows} overflows")
+
+    port.write(encode_frame(FRAME_EXIT))
+    port.flush()
+    port.close()
+    if elapsed > 0:
+        print(f"[STREAM] Sent {sent} frames ({sent_bytes} bytes) in {elapsed:.2f}s: "
+              f"{sent / elapsed:.1f} frames/s, {sent_bytes * 10 / elapsed / 1000:.1f} kbit/s on the wire")
+    return 0
+
+
+def read_until(fd, received, done, timeout):
+    """Appends what fd delivers to received until done(received) or the timeout."""
+    deadline = time.monotonic() + timeout
+    while not done(received):
+        remaining = deadline - time.monotonic()
+        if remaining <= 0 or not select.select([fd], [], [], remaining)[0]:
+            return False
+        received.extend(os.read(fd, 4096))
+    return True
+
+
+def run_selftest(args):
+    if not os.path.exists(args.program):
+        print(f"[SELFTEST] {args.program} not found; build it with 'pio run -e native'")
+        return 1
+
+    master, slave = os.openpty()
+    tty.setraw(slave)
+    device = subprocess.Popen([args.program, "--serial", os.ttyname(slave)],
+                              stdin=subprocess.PIPE, stdout=subprocess.DEVNULL)
+
+    def write(frame):
+        view = memoryview(frame)
+        while view:
+            written = os.write(master, view)
+            view = view[written:]
+
+    received = bytearray()
+    try:
+        write(ENTRY_MAGIC)
+        if not read_until(master, received, lambda data: FRAME_ACK in data, 5):
+            print("[SELFTEST] No ACK from the host console")
+            return 1
+
+        sent, sent_bytes, elapsed = stream(write, args.channels, args.rate, args.seconds)
+
+        received.clear()
+        write(encode_frame(FRAME_STATS))
+        if not read_until(master, received, lambda data: find_stats_reply(data) is not None, 2):
+            print("[SELFTEST] No stats reply")
+            return 1
+        frames, crc_errors, overflows = find_stats_reply(received)
+        frames -= 1  # The device counts the stats request itself
+
+        # Leave without FRAME_EXIT: the console must come back on its own
+        time.sleep(INACTIVITY_TIMEOUT + 0.5)
+        received.clear()
+        write(b"stream status\n")
+        text_mode = read_until(master, received, lambda data: b"Result:" in data, 2)
+    finally:
+        device.stdin.close()
+        device.wait(timeout=5)
+        os.close(master)
+        os.close(slave)
+
+    required_bps = sent_bytes * 10 / elapsed
+    print(f"[SELFTEST] Sent {sent} frames; device decoded {frames}, CRC errors {crc_errors}, overflows {overflows}")
+    print(f"[SELFTEST] {sent / elapsed:.1f} frames/s, needs {required_bps / 1000:.1f} kbit/s "
+          f"({100 * required_bps / STREAM_BAUD:.1f}% of {STREAM_BAUD} baud)")
+    print(f"[SELFTEST] Text console after {INACTIVITY_TIMEOUT:.0f} s without frames: {'yes' if text_mode else 'NO'}")
+    return 0 if frames == sent and crc_errors == 0 and overflows == 0 and text_mode else 1
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Stream servo positions over the binary serial protocol")
+    parser.add_argument("--port", default="/dev/ttyUSB0", help="serial port of the ESP32")
+    parser.add_argument("--channels", type=int, default=128, help="number of channels per frame")
+    parser.add_argument("--rate", type=float, default=50, help="frames per second")
+    parser.add_argument("--seconds", type=float, default=10, help="duration (0 = until Ctrl-C)")
+    parser.add_argument("--selftest", action="store_true",
+                        help="stream into the host console build over a pty instead of a device")
+    parser.add_argument("--program", default=DEFAULT_PROGRAM, help="host console build used by --selftest")
+    args = parser.parse_args()
+
+    if args.selftest:
+        return run_selftest(args)
+    return run_device(args)
+
+
+if __name__ == "__main__":
+    sys.exit(main())
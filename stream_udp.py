@@ -0,0 +1,80 @@
+#!/usr/bin/env python3
+"""
+Host-side sender for UDP realtime frames (see src/UdpFrameReceiver.h).
+
+Streams an animation to the controller at a fixed frame rate:
+    python3 stream_udp.py --host 192.168.4.1 --channels 128 --rate 50
+
+--reorder sends every few frames out of order so the controller's drop counter
+can be checked with the 'stream status' command.
+"""
+
+import argparse
+import socket
+import struct
+import sys
+import time
+
+from stream_serial import animation_frame
+
+DEFAULT_PORT = 5800
+PROTOCOL_VERSION = 1
+
+
+def encode_frame(sequence, first_channel, positions):
+    """positions are percentages (0-100), packed as u16 0-65535."""
+    values = [max(0, min(65535, int(round(p * 655.35)))) for p in positions]
+    header = struct.pack("<2sBBIHH", b"NX", PROTOCOL_VERSION, 0, sequence & 0xFFFFFFFF,
+                         first_channel, len(values))
+    return header + struct.pack("<%dH" % len(values), *values)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Stream servo positions as UDP realtime frames")
+    parser.add_argument("--host", default="192.168.4.1", help="controller IP address")
+    parser.add_argument("--port", type=int, default=DEFAULT_PORT, help="controller UDP port")
+    parser.add_argument("--channels", type=int, default=16, help="number of channels per frame")
+    parser.add_argument("--first", type=int, default=0, help="first channel (board * 16 + servo)")
+    parser.add_argument("--rate", type=float, default=50, help="frames per second")
+    parser.add_argument("--seconds", type=float, default=10, help="duration (0 = until Ctrl-C)")
+    parser.add_argument("--reorder", type=int, default=0, metavar="N",
+                        help="swap every Nth pair of frames to exercise out-of-order dropping")
+    args = parser.parse_args()
+
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    target = (args.host, args.port)
+    period = 1.0 / args.rate
+    start = time.monotonic()
+    next_frame = start
+    sequence = 0
+    held = None
+
+    try:
+        while args.seconds <= 0 or time.monotonic() - start < args.seconds:
+            t = time.monotonic() - start
+            packet = encode_frame(sequence, args.first, animation_frame(args.channels, t))
+            sequence += 1
+
+            if args.reorder and held is None and sequence % args.reorder == 0:
+                held = packet
+            else:
+                sock.sendto(packet, target)
+                if held is not None:
+                    sock.sendto(held, target)
+                    held = None
+
+            next_frame += period
+            delay = next_frame - time.monotonic()
+            if delay > 0:
+                time.sleep(delay)
+    except KeyboardInterrupt:
+        pass
+
+    elapsed = time.monotonic() - start
+    print(f"[UDP] Sent {sequence} frames to {args.host}:{args.port} in {elapsed:.2f}s "
+          f"({sequence / elapsed:.1f} frames/s, {args.channels} channels)")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,188 @@
+// Command parsing and validation through executeCommand(), checked against the pulses
+// the simulated boards produce.
+
+#include <Arduino.h>
+#include <Wire.h>
+#include <LittleFS.h>
+#include <VirtualPCA9685.h>
+#include <unity.h>
+#include <memory>
+#include <vector>
+#include "ServoController.h"
+#include "CommandRecorder.h"
+
+static const int BOARD_COUNT = 2;
+static std::vector<std::unique_ptr<VirtualPCA9685>> chips;
+static ServoController* controller;
+
+void setUp() {
+  LittleFS.format();
+  for (int b = 0; b < BOARD_COUNT; b++) {
+    chips.emplace_back(new VirtualPCA9685(0x40 + b));
+  }
+  controller = new ServoController();
+  controller->scanForBoards();
+  controller->initializeBoards();
+}
+
+void tearDown() {
+  delete controller;
+  chips.clear();
+}
+
+// High time of a simulated channel; one PCA9685 tick is about 4.9 us at 50 Hz
+static float pulse(int board, int channel) {
+  return chips[board]->pulseMicroseconds(channel, PCA9685_OSC_FREQ);
+}
+
+static void assertSuccess(const String& result) {
+  TEST_ASSERT_TRUE_MESSAGE(result.startsWith("Success"), result.c_str());
+}
+
+static void assertError(const char* prefix, const String& result) {
+  TEST_ASSERT_TRUE_MESSAGE(result.startsWith(prefix), result.c_str());
+}
+
+void test_empty_and_unknown_commands() {
+  TEST_ASSERT_EQUAL_STRING("Error: Empty command", controller->executeCommand("   ").c_str());
+  assertError("Error: Unknown command 'wiggle'", controller->executeCommand("wiggle 0 0"));
+}
+
+void test_servo_command_moves_enabled_servo() {
+  assertSuccess(controller->executeCommand("config 0 3 enabled true"));
+  assertSuccess(controller->executeCommand("servo 0 3 75"));
+  controller->update();
+  TEST_ASSERT_FLOAT_WITHIN(5, 1750, pulse(0, 3));
+  
+  // Commands are case-insensitive
+  assertSuccess(controller->executeCommand("SERVO 0 3 25"));
+  controller->update();
+  TEST_ASSERT_FLOAT_WITHIN(5, 1250, pulse(0, 3));
+}
+
+void test_servo_command_validates_arguments() {
+  assertError("Error: servo command requires 3 arguments", controller->executeCommand("servo 0 3"));
+  assertError("Error: Invalid board index 2", controller->executeCommand("servo 2 0 50"));
+  assertError("Error: Invalid servo index 16", controller->executeCommand("servo 0 16 50"));
+  assertError("Error: Position must be between", controller->executeCommand("servo 0 0 100.5"));
+}
+
+void test_disabled_servo_is_not_driven() {
+  controller->executeCommand("servo 0 4 50");
+  controller->update();
+  TEST_ASSERT_EQUAL_UINT32(0, chips[0]->getChannelWrites(4));
+}
+
+void test_position_is_clamped_to_configured_range() {
+  controller->executeCommand("config 1 0 enabled true");
+  assertSuccess(controller->executeCommand("config 1 0 center 40"));
+  assertSuccess(controller->executeCommand("config 1 0 range 10"));
+  controller->executeCommand("servo 1 0 90");
+  controller->update();
+  TEST_ASSERT_FLOAT_WITHIN(5, 1500, pulse(1, 0));
+}
+
+void test_config_command_rejects_bad_fields_and_values() {
+  assertError("Error: config command requires 4 arguments", controller->executeCommand("config 0 0 center"));
+  assertError("Error: Unknown field bogus", controller->executeCommand("config 0 0 bogus 1"));
+  assertError("Error: Invalid value 150 for center", controller->executeCommand("config 0 0 center 150"));
+  TEST_ASSERT_FLOAT_WITHIN(0.001, 50, controller->getServoConfig(0, 0)->center);
+}
+
+void test_pair_drives_slave_inversely() {
+  controller->executeCommand("config 0 0 enabled true");
+  controller->executeCommand("config 1 5 enabled true");
+  assertSuccess(controller->executeCommand("pair 0 0 1 5"));
+  
+  const ServoConfig* master = controller->getServoConfig(0, 0);
+  TEST_ASSERT_TRUE(master->isPair && master->isPairMaster);
+  TEST_ASSERT_EQUAL_INT(1, master->pairBoard);
+  TEST_ASSERT_EQUAL_INT(5, master->pairServo);
+  
+  controller->executeCommand("servo 0 0 70");
+  controller->update();
+  TEST_ASSERT_FLOAT_WITHIN(5, 1700, pulse(0, 0));
+  TEST_ASSERT_FLOAT_WITHIN(5, 1300, pulse(1, 5));
+}
+
+void test_sleep_and_repeat_validation() {
+  assertError("Error: Sleep time must be a positive number", controller->executeCommand("sleep 0"));
+  assertError("Error: Sleep time cannot exceed", controller->executeCommand("sleep 20000"));
+  assertSuccess(controller->executeCommand("sleep 100"));
+  TEST_ASSERT_FALSE(controller->isIdle());
+  
+  assertError("Error: Repeat count cannot exceed 100", controller->executeCommand("repeat 101 servo 0 0 50"));
+  assertError("Error: Repeat count must be greater than 0", controller->executeCommand("repeat 0 servo 0 0 50"));
+}
+
+void test_script_command_reports_missing_script() {
+  assertError("Error: script command requires a script name", controller->executeCommand("script"));
+  assertError("Error: Script 'nothing' not found", controller->executeCommand("script nothing"));
+}
+
+void test_batch_runs_motion_and_system_commands() {
+  assertSuccess(controller->executeCommand("config 0 3 enabled true"));
+  assertSuccess(controller->executeCommand("config 0 4 enabled true"));
+  
+  // The system command runs between the two motion frames; both moves still land
+  String commands[] = {"servo 0 3 75", "system save", "SERVO 0 4 25", "wiggle"};
+  String results[4];
+  controller->executeCommandBatch(commands, 4, results);
+  assertSuccess(results[0]);
+  assertSuccess(results[1]);
+  assertSuccess(results[2]);
+  assertError("Error: Unknown command 'wiggle'", results[3]);
+  
+  controller->update();
+  TEST_ASSERT_FLOAT_WITHIN(5, 1750, pulse(0, 3));
+  TEST_ASSERT_FLOAT_WITHIN(5, 1250, pulse(0, 4));
+}
+
+// Collects a recording download
+class CaptureOutput : public Print {
+public:
+  std::vector<uint8_t> bytes;
+  size_t write(uint8_t c) override {
+    bytes.push_back(c);
+    return 1;
+  }
+};
+
+void test_recorder_marks_truncated_commands() {
+  CommandRecorder& recorder = CommandRecorder::getInstance();
+  recorder.clear();
+  String padded = "servo 0 3 75";
+  while (padded.length() < COMMAND_RECORD_SIZE / 2) padded += ' ';
+  controller->executeCommand("servo 0 3 75");
+  controller->executeCommand(padded);
+  
+  CaptureOutput output;
+  recorder.writeTo(output);
+  size_t offset = sizeof(CommandRecordFileHeader);
+  CommandRecordHeader first, second;
+  memcpy(&first, output.bytes.data() + offset, sizeof(first));
+  offset += sizeof(first) + first.length;
+  memcpy(&second, output.bytes.data() + offset, sizeof(second));
+  
+  TEST_ASSERT_EQUAL_UINT8(RECORD_EXECUTE, first.kind);
+  TEST_ASSERT_EQUAL_UINT16(12, first.length);
+  TEST_ASSERT_EQUAL_UINT8(RECORD_EXECUTE | RECORD_TRUNCATED, second.kind);
+  TEST_ASSERT_EQUAL_UINT16(COMMAND_RECORD_SIZE / 4, second.length);
+}
+
+int main(int argc, char** argv) {
+  LittleFS.begin(true);
+  UNITY_BEGIN();
+  RUN_TEST(test_empty_and_unknown_commands);
+  RUN_TEST(test_servo_command_moves_enabled_servo);
+  RUN_TEST(test_servo_command_validates_arguments);
+  RUN_TEST(test_disabled_servo_is_not_driven);
+  RUN_TEST(test_position_is_clamped_to_configured_range);
+  RUN_TEST(test_config_command_rejects_bad_fields_and_values);
+  RUN_TEST(test_pair_drives_slave_inversely);
+  RUN_TEST(test_sleep_and_repeat_validation);
+  RUN_TEST(test_script_command_reports_missing_script);
+  RUN_TEST(test_batch_runs_motion_and_system_commands);
+  RUN_TEST(test_recorder_marks_truncated_commands);
+  return UNITY_END();
+}
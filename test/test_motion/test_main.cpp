@@ -0,0 +1,131 @@
+// Sweeps, script sleeps and the command queue stepped on a VirtualClock, so every
+// timing check is exact and runs instantly.
+
+#include <Arduino.h>
+#include <Wire.h>
+#include <LittleFS.h>
+#include <VirtualPCA9685.h>
+#include <VirtualClock.h>
+#include <unity.h>
+#include <memory>
+#include "ServoController.h"
+
+static std::unique_ptr<VirtualPCA9685> chip;
+static VirtualClock* virtualClock;
+static ServoController* controller;
+
+void setUp() {
+  LittleFS.format();
+  virtualClock = new VirtualClock(1000);
+  Clock::install(virtualClock);
+  chip.reset(new VirtualPCA9685(0x40));
+  controller = new ServoController();
+  controller->scanForBoards();
+  controller->initializeBoards();
+  controller->executeCommand("config 0 0 enabled true");
+  controller->executeCommand("config 0 1 enabled true");
+}
+
+void tearDown() {
+  delete controller;
+  chip.reset();
+  Clock::install(nullptr);
+  delete virtualClock;
+}
+
+static float pulse(int channel) {
+  return chip->pulseMicroseconds(channel, PCA9685_OSC_FREQ);
+}
+
+// Runs the motion loop every 10 ms for the given time
+static void run(unsigned long ms) {
+  for (unsigned long t = 0; t < ms; t += 10) {
+    virtualClock->advance(10);
+    controller->update();
+  }
+}
+
+void test_sweep_interpolates_linearly() {
+  TEST_ASSERT_TRUE(controller->startSweep(0, 0, 0, 100, 2000));
+  controller->update();
+  TEST_ASSERT_FLOAT_WITHIN(5, 1000, pulse(0));
+  
+  run(500);
+  TEST_ASSERT_FLOAT_WITHIN(5, 1250, pulse(0));
+  run(500);
+  TEST_ASSERT_FLOAT_WITHIN(5, 1500, pulse(0));
+  run(990);
+  TEST_ASSERT_FLOAT_WITHIN(10, 1995, pulse(0));
+}
+
+void test_sweep_lands_exactly_on_end_position() {
+  TEST_ASSERT_TRUE(controller->startSweep(0, 0, 80, 20, 300));
+  virtualClock->advance(5000);  // One late update must not overshoot
+  controller->update();
+  TEST_ASSERT_FLOAT_WITHIN(5, 1200, pulse(0));
+  
+  // A finished sweep no longer drives the servo
+  controller->setServoToConfiguredPosition(0, 0, 60);
+  run(100);
+  TEST_ASSERT_FLOAT_WITHIN(5, 1600, pulse(0));
+}
+
+void test_sweep_is_clamped_to_configured_range() {
+  controller->executeCommand("config 0 0 center 50");
+  controller->executeCommand("config 0 0 range 20");
+  TEST_ASSERT_TRUE(controller->startSweep(0, 0, 0, 100, 1000));
+  controller->update();
+  TEST_ASSERT_FLOAT_WITHIN(5, 1300, pulse(0));
+  run(1000);
+  TEST_ASSERT_FLOAT_WITHIN(5, 1700, pulse(0));
+}
+
+void test_sweep_rejects_disabled_servo_and_zero_duration() {
+  TEST_ASSERT_FALSE(controller->startSweep(0, 5, 0, 100, 1000));
+  TEST_ASSERT_FALSE(controller->startSweep(0, 0, 0, 100, 0));
+}
+
+void test_stop_sweep_holds_position() {
+  controller->startSweep(0, 0, 0, 100, 1000);
+  run(500);
+  controller->stopSweep(0, 0);
+  float held = pulse(0);
+  run(1000);
+  TEST_ASSERT_FLOAT_WITHIN(0.01, held, pulse(0));
+}
+
+void test_script_sleep_delays_following_commands() {
+  controller->addScript("wave", "", "servo 0 1 10; sleep 400; servo 0 1 90");
+  TEST_ASSERT_TRUE(controller->executeScript("wave"));
+  run(100);
+  TEST_ASSERT_FLOAT_WITHIN(5, 1100, pulse(1));
+  
+  run(200);
+  TEST_ASSERT_FLOAT_WITHIN(5, 1100, pulse(1));
+  run(300);
+  TEST_ASSERT_FLOAT_WITHIN(5, 1900, pulse(1));
+}
+
+void test_script_waits_for_sweep_to_finish() {
+  controller->addScript("swing", "", "sweep 0 0 0 100 500; servo 0 1 30");
+  TEST_ASSERT_TRUE(controller->executeScript("swing"));
+  run(300);
+  TEST_ASSERT_EQUAL_UINT32(0, chip->getChannelWrites(1));
+  
+  run(400);
+  TEST_ASSERT_FLOAT_WITHIN(5, 2000, pulse(0));
+  TEST_ASSERT_FLOAT_WITHIN(5, 1300, pulse(1));
+}
+
+int main(int argc, char** argv) {
+  LittleFS.begin(true);
+  UNITY_BEGIN();
+  RUN_TEST(test_sweep_interpolates_linearly);
+  RUN_TEST(test_sweep_lands_exactly_on_end_position);
+  RUN_TEST(test_sweep_is_clamped_to_configured_range);
+  RUN_TEST(test_sweep_rejects_disabled_servo_and_zero_duration);
+  RUN_TEST(test_stop_sweep_holds_position);
+  RUN_TEST(test_script_sleep_delays_following_commands);
+  RUN_TEST(test_script_waits_for_sweep_to_finish);
+  return UNITY_END();
+}
@@ -0,0 +1,163 @@
+// Output frames: staged pulses reach the simulated boards only on flushOutputs(), as
+// one auto-increment burst per run of changed channels.
+
+#include <Arduino.h>
+#include <Wire.h>
+#include <LittleFS.h>
+#include <VirtualPCA9685.h>
+#include <VirtualTCA9548A.h>
+#include <unity.h>
+#include <memory>
+#include <vector>
+#include "ServoController.h"
+
+static std::unique_ptr<VirtualTCA9548A> mux;  // Declared first so it outlives the chips behind it
+static std::vector<std::unique_ptr<VirtualPCA9685>> chips;
+static ServoController* controller;
+
+static void start() {
+  controller = new ServoController();
+  controller->scanForBoards();
+  controller->initializeBoards();
+  controller->flushOutputs();
+  Wire.resetStats();
+}
+
+static void enableServos(int board) {
+  for (int s = 0; s < SERVOS_PER_BOARD; s++) {
+    controller->executeCommand("config " + String(board) + " " + String(s) + " enabled true");
+  }
+}
+
+// Each channel update writes its four LEDn_ON/OFF registers
+static const uint32_t CHANNEL_REGISTERS = 4;
+
+static float pulse(int board, int channel) {
+  return chips[board]->pulseMicroseconds(channel, PCA9685_OSC_FREQ);
+}
+
+void setUp() {
+  LittleFS.format();
+}
+
+void tearDown() {
+  delete controller;
+  controller = nullptr;
+  chips.clear();
+  mux.reset();
+}
+
+void test_pulses_are_staged_until_flush() {
+  chips.emplace_back(new VirtualPCA9685(0x40));
+  start();
+  uint32_t writes = chips[0]->getWriteCount();
+  
+  controller->setServoByPercent(0, 4, 60);
+  TEST_ASSERT_EQUAL_UINT32(writes, chips[0]->getWriteCount());
+  TEST_ASSERT_EQUAL_UINT32(0, Wire.getStats().transactions);
+  
+  controller->flushOutputs();
+  TEST_ASSERT_FLOAT_WITHIN(5, 1600, pulse(0, 4));
+  TEST_ASSERT_EQUAL_UINT32(1, Wire.getStats().transactions);
+}
+
+void test_flush_without_changes_writes_nothing() {
+  chips.emplace_back(new VirtualPCA9685(0x40));
+  start();
+  controller->flushOutputs();
+  controller->flushOutputs();
+  TEST_ASSERT_EQUAL_UINT32(0, Wire.getStats().transactions);
+}
+
+void test_consecutive_channels_share_one_burst() {
+  chips.emplace_back(new VirtualPCA9685(0x40));
+  start();
+  
+  // Channels 2-5 form one run and 9-10 another
+  for (int s : {2, 3, 4, 5, 9, 10}) {
+    controller->setServoByPercent(0, s, s * 5);
+  }
+  controller->flushOutputs();
+  
+  TEST_ASSERT_EQUAL_UINT32(2, Wire.getStats().transactions);
+  for (int s : {2, 3, 4, 5, 9, 10}) {
+    TEST_ASSERT_FLOAT_WITHIN(5, 1000 + s * 50, pulse(0, s));
+    TEST_ASSERT_EQUAL_UINT32(CHANNEL_REGISTERS, chips[0]->getChannelWrites(s));
+  }
+  TEST_ASSERT_EQUAL_UINT32(0, chips[0]->getChannelWrites(6));
+}
+
+void test_last_staged_pulse_wins() {
+  chips.emplace_back(new VirtualPCA9685(0x40));
+  start();
+  controller->setServoByPercent(0, 0, 10);
+  controller->setServoByPercent(0, 0, 90);
+  controller->flushOutputs();
+  TEST_ASSERT_EQUAL_UINT32(CHANNEL_REGISTERS, chips[0]->getChannelWrites(0));
+  TEST_ASSERT_FLOAT_WITHIN(5, 1900, pulse(0, 0));
+}
+
+void test_position_frame_spans_boards() {
+  chips.emplace_back(new VirtualPCA9685(0x40));
+  chips.emplace_back(new VirtualPCA9685(0x41));
+  start();
+  enableServos(0);
+  enableServos(1);
+  Wire.resetStats();
+  
+  std::vector<PositionTarget> frame;
+  for (int b = 0; b < 2; b++) {
+    for (int s = 0; s < SERVOS_PER_BOARD; s++) {
+      frame.push_back({b, s, 25});
+    }
+  }
+  controller->applyPositionFrame(frame.data(), frame.size());
+  controller->flushOutputs();
+  
+  // Sixteen channels per board, written as a single burst each
+  TEST_ASSERT_EQUAL_UINT32(2, Wire.getStats().transactions);
+  for (int b = 0; b < 2; b++) {
+    for (int s = 0; s < SERVOS_PER_BOARD; s++) {
+      TEST_ASSERT_FLOAT_WITHIN(5, 1250, pulse(b, s));
+    }
+  }
+}
+
+void test_multiplexer_segments_switch_once_per_frame() {
+  mux.reset(new VirtualTCA9548A(MUX_BASE_ADDRESS));
+  chips.emplace_back(new VirtualPCA9685(0x40, mux->channel(0)));
+  chips.emplace_back(new VirtualPCA9685(0x40, mux->channel(3)));
+  start();
+  TEST_ASSERT_EQUAL_INT(2, controller->getDetectedBoardCount());
+  
+  uint32_t switches = controller->getMuxSwitchCount();
+  for (int s = 0; s < SERVOS_PER_BOARD; s += 2) {
+    controller->setServoByPercent(0, s, 30);
+    controller->setServoByPercent(1, s, 70);
+  }
+  controller->flushOutputs();
+  TEST_ASSERT_TRUE(controller->getMuxSwitchCount() - switches <= 2);
+  TEST_ASSERT_FLOAT_WITHIN(5, 1300, pulse(0, 14));
+  TEST_ASSERT_FLOAT_WITHIN(5, 1700, pulse(1, 14));
+  
+  // The channel left selected by the last frame is not switched again
+  switches = controller->getMuxSwitchCount();
+  uint8_t selected = mux->getControl();
+  int board = selected == (1 << 3) ? 1 : 0;
+  controller->setServoByPercent(board, 1, 50);
+  controller->flushOutputs();
+  TEST_ASSERT_EQUAL_UINT32(switches, controller->getMuxSwitchCount());
+  TEST_ASSERT_FLOAT_WITHIN(5, 1500, pulse(board, 1));
+}
+
+int main(int argc, char** argv) {
+  LittleFS.begin(true);
+  UNITY_BEGIN();
+  RUN_TEST(test_pulses_are_staged_until_flush);
+  RUN_TEST(test_flush_without_changes_writes_nothing);
+  RUN_TEST(test_consecutive_channels_share_one_burst);
+  RUN_TEST(test_last_staged_pulse_wins);
+  RUN_TEST(test_position_frame_spans_boards);
+  RUN_TEST(test_multiplexer_segments_switch_once_per_frame);
+  return UNITY_END();
+}
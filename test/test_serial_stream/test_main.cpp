@@ -0,0 +1,171 @@
+// The binary serial stream decoder: frame validation, and the fall back to the text
+// console when the host goes quiet.
+
+#include <Arduino.h>
+#include <Wire.h>
+#include <LittleFS.h>
+#include <VirtualPCA9685.h>
+#include <VirtualClock.h>
+#include <unity.h>
+#include <memory>
+#include <vector>
+#include "ServoController.h"
+#include "SerialStream.h"
+
+static std::unique_ptr<VirtualPCA9685> chip;
+static VirtualClock* virtualClock;
+static ServoController* controller;
+static HardwareSerial* uart;  // Not attached: writes go to stdout, reads are empty
+static SerialStream* serialStream;
+
+void setUp() {
+  LittleFS.format();
+  virtualClock = new VirtualClock(1000);
+  Clock::install(virtualClock);
+  chip.reset(new VirtualPCA9685(0x40));
+  controller = new ServoController();
+  controller->scanForBoards();
+  controller->initializeBoards();
+  controller->executeCommand("config 0 0 enabled true");
+  controller->executeCommand("config 0 1 enabled true");
+  uart = new HardwareSerial();
+  uart->begin(SerialStream::CONSOLE_BAUD);
+  serialStream = new SerialStream(*uart, *controller);
+}
+
+void tearDown() {
+  delete serialStream;
+  delete uart;
+  delete controller;
+  chip.reset();
+  Clock::install(nullptr);
+  delete virtualClock;
+}
+
+// The frame stream_serial.py's encode_frame() builds
+static std::vector<uint8_t> encodeFrame(uint8_t type, const std::vector<uint8_t>& payload) {
+  std::vector<uint8_t> frame = {SerialStream::FRAME_SYNC, uint8_t(payload.size()), uint8_t(payload.size() >> 8), type};
+  frame.insert(frame.end(), payload.begin(), payload.end());
+  uint16_t crc = SerialStream::crc16(0xFFFF, frame.data() + 1, frame.size() - 1);
+  frame.push_back(crc & 0xFF);
+  frame.push_back(crc >> 8);
+  return frame;
+}
+
+static std::vector<uint8_t> encodePositions(uint16_t firstChannel, std::vector<float> positions) {
+  std::vector<uint8_t> payload = {uint8_t(firstChannel), uint8_t(firstChannel >> 8)};
+  for (float p : positions) {
+    uint16_t value = uint16_t(p * 655.35f + 0.5f);
+    payload.push_back(value & 0xFF);
+    payload.push_back(value >> 8);
+  }
+  return encodeFrame(SerialStream::FRAME_POSITIONS, payload);
+}
+
+static void feed(const std::vector<uint8_t>& bytes) {
+  serialStream->feed(bytes.data(), bytes.size());
+}
+
+static float pulse(int channel) {
+  return chip->pulseMicroseconds(channel, PCA9685_OSC_FREQ);
+}
+
+void test_entry_magic_switches_to_stream_baud() {
+  for (uint8_t byte : {0xFE, 0xFE, 0xED, 0xBE}) {
+    TEST_ASSERT_FALSE(serialStream->matchEntryMagic(byte));
+  }
+  TEST_ASSERT_TRUE(serialStream->matchEntryMagic(0xEF));
+  serialStream->begin();
+  TEST_ASSERT_TRUE(serialStream->isActive());
+  TEST_ASSERT_EQUAL_UINT32(SerialStream::STREAM_BAUD, uart->getBaudRate());
+}
+
+void test_position_frames_move_servos() {
+  serialStream->begin();
+  feed(encodePositions(0, {25, 75}));
+  controller->update();
+  TEST_ASSERT_EQUAL_UINT32(1, serialStream->getFrameCount());
+  TEST_ASSERT_FLOAT_WITHIN(5, 1250, pulse(0));
+  TEST_ASSERT_FLOAT_WITHIN(5, 1750, pulse(1));
+}
+
+void test_corrupt_frame_is_dropped_and_decoder_resyncs() {
+  serialStream->begin();
+  std::vector<uint8_t> corrupt = encodePositions(0, {90});
+  corrupt[5] ^= 0x01;
+  std::vector<uint8_t> bytes = {0x00, 0x42};  // Line noise before the first sync byte
+  bytes.insert(bytes.end(), corrupt.begin(), corrupt.end());
+  std::vector<uint8_t> good = encodePositions(0, {30});
+  bytes.insert(bytes.end(), good.begin(), good.end());
+  
+  // Split mid-frame, as UART reads are
+  serialStream->feed(bytes.data(), 7);
+  serialStream->feed(bytes.data() + 7, bytes.size() - 7);
+  controller->update();
+  TEST_ASSERT_EQUAL_UINT32(1, serialStream->getCrcErrorCount());
+  TEST_ASSERT_EQUAL_UINT32(1, serialStream->getFrameCount());
+  TEST_ASSERT_FLOAT_WITHIN(5, 1300, pulse(0));
+}
+
+void test_oversized_length_is_counted() {
+  serialStream->begin();
+  uint16_t length = SerialStream::MAX_PAYLOAD + 1;
+  feed({SerialStream::FRAME_SYNC, uint8_t(length), uint8_t(length >> 8)});
+  TEST_ASSERT_EQUAL_UINT32(1, serialStream->getOverflowCount());
+}
+
+void test_exit_frame_returns_to_console() {
+  serialStream->begin();
+  feed(encodeFrame(SerialStream::FRAME_EXIT, {}));
+  TEST_ASSERT_FALSE(serialStream->isActive());
+  TEST_ASSERT_EQUAL_UINT32(SerialStream::CONSOLE_BAUD, uart->getBaudRate());
+}
+
+void test_silent_host_times_out_to_console() {
+  serialStream->begin();
+  virtualClock->advance(SerialStream::INACTIVITY_TIMEOUT_MS - 1);
+  serialStream->poll();
+  TEST_ASSERT_TRUE(serialStream->isActive());
+  
+  virtualClock->advance(1);
+  serialStream->poll();
+  TEST_ASSERT_FALSE(serialStream->isActive());
+  TEST_ASSERT_EQUAL_UINT32(1, serialStream->getTimeoutCount());
+  TEST_ASSERT_EQUAL_UINT32(SerialStream::CONSOLE_BAUD, uart->getBaudRate());
+}
+
+void test_valid_frames_keep_stream_alive() {
+  serialStream->begin();
+  for (int i = 0; i < 5; i++) {
+    virtualClock->advance(SerialStream::INACTIVITY_TIMEOUT_MS / 2);
+    feed(encodePositions(0, {50}));
+    serialStream->poll();
+  }
+  TEST_ASSERT_TRUE(serialStream->isActive());
+}
+
+void test_noise_does_not_keep_stream_alive() {
+  serialStream->begin();
+  std::vector<uint8_t> corrupt = encodePositions(0, {50});
+  corrupt.back() ^= 0xFF;
+  for (int i = 0; i < 5; i++) {
+    virtualClock->advance(SerialStream::INACTIVITY_TIMEOUT_MS / 2);
+    feed(corrupt);
+    serialStream->poll();
+  }
+  TEST_ASSERT_FALSE(serialStream->isActive());
+}
+
+int main(int argc, char** argv) {
+  LittleFS.begin(true);
+  UNITY_BEGIN();
+  RUN_TEST(test_entry_magic_switches_to_stream_baud);
+  RUN_TEST(test_position_frames_move_servos);
+  RUN_TEST(test_corrupt_frame_is_dropped_and_decoder_resyncs);
+  RUN_TEST(test_oversized_length_is_counted);
+  RUN_TEST(test_exit_frame_returns_to_console);
+  RUN_TEST(test_silent_host_times_out_to_console);
+  RUN_TEST(test_valid_frames_keep_stream_alive);
+  RUN_TEST(test_noise_does_not_keep_stream_alive);
+  return UNITY_END();
+}
@@ -0,0 +1,247 @@
+// Servo config schema, the binary slot encoding, and A/B slot recovery after a damaged
+// save.
+
+#include <Arduino.h>
+#include <Wire.h>
+#include <LittleFS.h>
+#include <VirtualPCA9685.h>
+#include <unity.h>
+#include <memory>
+#include <vector>
+#include "ServoController.h"
+#include "ServoConfigSchema.h"
+
+static const char* SLOT_A = "/servo_config_a.cfg";
+static const char* SLOT_B = "/servo_config_b.cfg";
+
+static std::vector<std::unique_ptr<VirtualPCA9685>> chips;
+
+static void attachBoards(int count) {
+  for (int b = 0; b < count; b++) {
+    chips.emplace_back(new VirtualPCA9685(0x40 + b));
+  }
+}
+
+// A controller over the attached boards, with whatever configuration the slots hold
+static std::unique_ptr<ServoController> boot() {
+  std::unique_ptr<ServoController> controller(new ServoController());
+  controller->scanForBoards();
+  controller->initializeBoards();
+  controller->loadConfiguration();
+  return controller;
+}
+
+static std::vector<uint8_t> readFile(const char* path) {
+  File file = LittleFS.open(path, "r");
+  std::vector<uint8_t> content(file.size());
+  file.read(content.data(), content.size());
+  file.close();
+  return content;
+}
+
+static void writeFile(const char* path, const std::vector<uint8_t>& content) {
+  File file = LittleFS.open(path, "w");
+  file.write(content.data(), content.size());
+  file.close();
+}
+
+void setUp() {
+  LittleFS.format();
+  attachBoards(2);
+}
+
+void tearDown() {
+  chips.clear();
+}
+
+void test_schema_finds_fields_by_name() {
+  for (int i = 0; i < SERVO_FIELD_COUNT; i++) {
+    TEST_ASSERT_EQUAL_INT(i, findServoField(String(SERVO_FIELDS[i].name)));
+  }
+  TEST_ASSERT_EQUAL_INT(-1, findServoField(String("centre")));
+  TEST_ASSERT_EQUAL_INT(-1, findServoField(String("")));
+}
+
+void test_schema_rejects_out_of_range_values() {
+  ServoConfig config = {};
+  config.center = 50;
+  int center = findServoField(String("center"));
+  TEST_ASSERT_TRUE(setServoField(config, center, "12.5"));
+  TEST_ASSERT_FLOAT_WITHIN(0.001, 12.5, config.center);
+  TEST_ASSERT_FALSE(setServoField(config, center, "101"));
+  TEST_ASSERT_FLOAT_WITHIN(0.001, 12.5, config.center);
+  
+  int pairServo = findServoField(String("pairServo"));
+  TEST_ASSERT_FALSE(setServoField(config, pairServo, "16"));
+  TEST_ASSERT_TRUE(setServoField(config, pairServo, "-1"));
+  TEST_ASSERT_EQUAL_INT(-1, config.pairServo);
+}
+
+void test_packed_record_round_trip() {
+  ServoConfig config = {};
+  config.enabled = true;
+  config.center = 42.25;
+  config.range = 17.5;
+  config.initPosition = 63;
+  config.isPair = true;
+  config.pairBoard = 1;
+  config.pairServo = 15;
+  config.isPairMaster = true;
+  strcpy(config.name, "Left elbow");
+  
+  uint8_t record[SERVO_PACKED_SIZE];
+  packServoRecord(config, record);
+  ServoConfig decoded = {};
+  unpackServoRecord(decoded, record);
+  
+  TEST_ASSERT_TRUE(decoded.enabled && decoded.isPair && decoded.isPairMaster);
+  TEST_ASSERT_FLOAT_WITHIN(0.0001, 42.25, decoded.center);
+  TEST_ASSERT_FLOAT_WITHIN(0.0001, 17.5, decoded.range);
+  TEST_ASSERT_FLOAT_WITHIN(0.0001, 63, decoded.initPosition);
+  TEST_ASSERT_EQUAL_INT(1, decoded.pairBoard);
+  TEST_ASSERT_EQUAL_INT(15, decoded.pairServo);
+  TEST_ASSERT_EQUAL_STRING("Left elbow", decoded.name);
+}
+
+void test_binary_configuration_round_trip() {
+  {
+    std::unique_ptr<ServoController> controller = boot();
+    controller->executeCommand("config 1 7 enabled true");
+    controller->executeCommand("config 1 7 center 30");
+    controller->executeCommand("config 1 7 name Jaw");
+    controller->addScript("nod", "Nod twice", "servo 1 7 20; sleep 200; servo 1 7 40");
+    controller->saveConfiguration();
+  }
+  
+  std::unique_ptr<ServoController> controller = boot();
+  const ServoConfig* servo = controller->getServoConfig(1, 7);
+  TEST_ASSERT_TRUE(servo->enabled);
+  TEST_ASSERT_FLOAT_WITHIN(0.0001, 30, servo->center);
+  TEST_ASSERT_EQUAL_STRING("jaw", servo->name);  // Commands are lowercased
+  TEST_ASSERT_FALSE(controller->getServoConfig(0, 7)->enabled);
+  
+  TEST_ASSERT_EQUAL_INT(1, controller->getScriptCount());
+  TEST_ASSERT_EQUAL_STRING("nod", controller->getScript(0)->name);
+  TEST_ASSERT_EQUAL_STRING("servo 1 7 20; sleep 200; servo 1 7 40", controller->getScript(0)->commands);
+}
+
+void test_saves_alternate_between_slots() {
+  std::unique_ptr<ServoController> controller = boot();
+  controller->saveConfiguration();
+  TEST_ASSERT_TRUE(LittleFS.exists(SLOT_A));
+  TEST_ASSERT_FALSE(LittleFS.exists(SLOT_B));
+  controller->saveConfiguration();
+  TEST_ASSERT_TRUE(LittleFS.exists(SLOT_B));
+}
+
+// Saves center 20 (slot A), then center 80 (slot B, the newest)
+static void saveTwoGenerations() {
+  std::unique_ptr<ServoController> controller = boot();
+  controller->executeCommand("config 0 0 center 20");
+  controller->saveConfiguration();
+  controller->executeCommand("config 0 0 center 80");
+  controller->saveConfiguration();
+}
+
+void test_newest_slot_wins() {
+  saveTwoGenerations();
+  TEST_ASSERT_FLOAT_WITHIN(0.0001, 80, boot()->getServoConfig(0, 0)->center);
+}
+
+void test_corrupt_newest_slot_falls_back_to_previous() {
+  saveTwoGenerations();
+  std::vector<uint8_t> slot = readFile(SLOT_B);
+  slot[slot.size() - 1] ^= 0x55;  // Fails the CRC
+  writeFile(SLOT_B, slot);
+  
+  TEST_ASSERT_FLOAT_WITHIN(0.0001, 20, boot()->getServoConfig(0, 0)->center);
+}
+
+void test_truncated_newest_slot_falls_back_to_previous() {
+  saveTwoGenerations();
+  std::vector<uint8_t> slot = readFile(SLOT_B);
+  slot.resize(slot.size() / 2);  // A reset part-way through the write
+  writeFile(SLOT_B, slot);
+  
+  std::unique_ptr<ServoController> controller = boot();
+  TEST_ASSERT_FLOAT_WITHIN(0.0001, 20, controller->getServoConfig(0, 0)->center);
+  
+  // The next save replaces the damaged slot, not the good one
+  controller->executeCommand("config 0 0 center 55");
+  controller->saveConfiguration();
+  TEST_ASSERT_FLOAT_WITHIN(0.0001, 55, boot()->getServoConfig(0, 0)->center);
+  LittleFS.remove(SLOT_B);
+  TEST_ASSERT_FLOAT_WITHIN(0.0001, 20, boot()->getServoConfig(0, 0)->center);
+}
+
+void test_no_valid_slot_keeps_defaults() {
+  saveTwoGenerations();
+  for (const char* path : {SLOT_A, SLOT_B}) {
+    std::vector<uint8_t> slot = readFile(path);
+    slot[0] ^= 0xFF;  // Bad magic
+    writeFile(path, slot);
+  }
+  TEST_ASSERT_FLOAT_WITHIN(0.0001, 50, boot()->getServoConfig(0, 0)->center);
+}
+
+void test_pair_follows_board_after_index_shift() {
+  // Saved with 0x41 as board 0 and 0x42 as board 1
+  chips.clear();
+  chips.emplace_back(new VirtualPCA9685(0x41));
+  chips.emplace_back(new VirtualPCA9685(0x42));
+  {
+    std::unique_ptr<ServoController> controller = boot();
+    controller->executeCommand("config 0 5 enabled true");
+    controller->executeCommand("config 1 3 enabled true");
+    TEST_ASSERT_TRUE(controller->executeCommand("pair 1 3 0 5").startsWith("Success"));
+    controller->saveConfiguration();
+  }
+  
+  // A board at 0x40 now scans first, so 0x41 is board 1 and 0x42 board 2
+  chips.emplace_back(new VirtualPCA9685(0x40));
+  std::unique_ptr<ServoController> controller = boot();
+  const ServoConfig* master = controller->getServoConfig(2, 3);
+  TEST_ASSERT_TRUE(master->isPair && master->isPairMaster);
+  TEST_ASSERT_EQUAL_INT(1, master->pairBoard);
+  TEST_ASSERT_EQUAL_INT(5, master->pairServo);
+  
+  controller->executeCommand("servo 2 3 70");
+  controller->update();
+  TEST_ASSERT_FLOAT_WITHIN(5, 1300, chips[0]->pulseMicroseconds(5, PCA9685_OSC_FREQ));
+  TEST_ASSERT_EQUAL_UINT32(0, chips[2]->getChannelWrites(5));
+}
+
+void test_pair_to_missing_board_is_dropped() {
+  chips.clear();
+  chips.emplace_back(new VirtualPCA9685(0x41));
+  chips.emplace_back(new VirtualPCA9685(0x42));
+  {
+    std::unique_ptr<ServoController> controller = boot();
+    controller->executeCommand("config 0 5 enabled true");
+    controller->executeCommand("config 1 3 enabled true");
+    controller->executeCommand("pair 1 3 0 5");
+    controller->saveConfiguration();
+  }
+  
+  // 0x41 is gone and 0x42 is now board 0
+  chips.erase(chips.begin());
+  std::unique_ptr<ServoController> controller = boot();
+  TEST_ASSERT_EQUAL_INT(-1, controller->getServoConfig(0, 3)->pairBoard);
+}
+
+int main(int argc, char** argv) {
+  LittleFS.begin(true);
+  UNITY_BEGIN();
+  RUN_TEST(test_schema_finds_fields_by_name);
+  RUN_TEST(test_schema_rejects_out_of_range_values);
+  RUN_TEST(test_packed_record_round_trip);
+  RUN_TEST(test_binary_configuration_round_trip);
+  RUN_TEST(test_saves_alternate_between_slots);
+  RUN_TEST(test_newest_slot_wins);
+  RUN_TEST(test_corrupt_newest_slot_falls_back_to_previous);
+  RUN_TEST(test_truncated_newest_slot_falls_back_to_previous);
+  RUN_TEST(test_no_valid_slot_keeps_defaults);
+  RUN_TEST(test_pair_follows_board_after_index_shift);
+  RUN_TEST(test_pair_to_missing_board_is_dropped);
+  return UNITY_END();
+}
@@ -0,0 +1,94 @@
+// Event trace naming and the Chrome trace JSON export.
+
+#include <Arduino.h>
+#include <Wire.h>
+#include <LittleFS.h>
+#include <VirtualPCA9685.h>
+#include <unity.h>
+#include <memory>
+#include "ServoController.h"
+#include "EventTrace.h"
+#include "TraceJsonStream.h"
+
+static std::unique_ptr<VirtualPCA9685> chip;
+static ServoController* controller;
+
+void setUp() {
+  LittleFS.format();
+  chip.reset(new VirtualPCA9685(0x40));
+  controller = new ServoController();
+  controller->scanForBoards();
+  controller->initializeBoards();
+  TEST_ASSERT_TRUE(EventTrace::getInstance().setEnabled(true));
+  EventTrace::getInstance().clear();
+}
+
+void tearDown() {
+  EventTrace::getInstance().setEnabled(false);
+  delete controller;
+  chip.reset();
+}
+
+// The whole document, read in small chunks as the web server does
+static String exportTrace() {
+  TraceJsonStream stream;
+  String document;
+  uint8_t buffer[37];
+  size_t count;
+  while ((count = stream.read(buffer, sizeof(buffer))) > 0) {
+    document.concat((const char*)buffer, count);
+  }
+  return document;
+}
+
+void test_unknown_verbs_share_one_name() {
+  EventTrace& trace = EventTrace::getInstance();
+  for (int i = 0; i < 200; i++) {
+    controller->executeCommand("verb" + String(i) + " 1 2");
+  }
+  
+  // The name table still has room, and the commands were traced under "cmd other"
+  TEST_ASSERT_TRUE(trace.intern("fresh name") != TRACE_NAME_OTHER);
+  String document = exportTrace();
+  TEST_ASSERT_TRUE(document.indexOf("\"name\":\"cmd other\"") >= 0);
+  TEST_ASSERT_TRUE(document.indexOf("verb") < 0);
+}
+
+void test_known_verbs_are_named() {
+  controller->executeCommand("help");
+  TEST_ASSERT_TRUE(exportTrace().indexOf("\"name\":\"cmd help\"") >= 0);
+}
+
+void test_names_are_json_escaped() {
+  EventTrace& trace = EventTrace::getInstance();
+  trace.instant(trace.intern("GET /a\"b\\c\nd"));
+  
+  String document = exportTrace();
+  TEST_ASSERT_TRUE_MESSAGE(document.indexOf("\"name\":\"GET /a\\\"b\\\\c\\u000ad\"") >= 0, document.c_str());
+  TEST_ASSERT_TRUE(document.endsWith("]}"));
+}
+
+void test_long_names_keep_events_whole() {
+  EventTrace& trace = EventTrace::getInstance();
+  String name;
+  for (int i = 0; i < 100; i++) {
+    name += "\"x";  // 300 bytes once escaped
+  }
+  trace.instant(trace.intern(name), 7);
+  
+  // The name is shortened, never the event, and no escape is split
+  String document = exportTrace();
+  TEST_ASSERT_TRUE_MESSAGE(document.indexOf("\"args\":{\"value\":7}}") >= 0, document.c_str());
+  TEST_ASSERT_TRUE(document.indexOf("\\\",\"ph\"") < 0);
+  TEST_ASSERT_TRUE(document.endsWith("]}"));
+}
+
+int main(int argc, char** argv) {
+  LittleFS.begin(true);
+  UNITY_BEGIN();
+  RUN_TEST(test_unknown_verbs_share_one_name);
+  RUN_TEST(test_known_verbs_are_named);
+  RUN_TEST(test_names_are_json_escaped);
+  RUN_TEST(test_long_names_keep_events_whole);
+  return UNITY_END();
+}
@@ -0,0 +1,197 @@
+// UDP realtime frames: packet validation, sequence dropping and the stream timeout, with
+// packets handed to the receiver directly and sent over loopback as stream_udp.py does.
+
+#include <Arduino.h>
+#include <Wire.h>
+#include <LittleFS.h>
+#include <VirtualPCA9685.h>
+#include <VirtualClock.h>
+#include <unity.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <memory>
+#include <vector>
+#include "ServoController.h"
+#include "UdpFrameReceiver.h"
+
+static const uint16_t LOOPBACK_PORT = 5899;
+
+static std::unique_ptr<VirtualPCA9685> chip;
+static VirtualClock* virtualClock;
+static ServoController* controller;
+static UdpFrameReceiver* receiver;
+
+void setUp() {
+  LittleFS.format();
+  virtualClock = new VirtualClock(1000);
+  Clock::install(virtualClock);
+  chip.reset(new VirtualPCA9685(0x40));
+  controller = new ServoController();
+  controller->scanForBoards();
+  controller->initializeBoards();
+  for (int s = 0; s < 4; s++) {
+    controller->executeCommand("config 0 " + String(s) + " enabled true");
+  }
+  receiver = new UdpFrameReceiver(*controller);
+}
+
+void tearDown() {
+  delete receiver;
+  delete controller;
+  chip.reset();
+  Clock::install(nullptr);
+  delete virtualClock;
+}
+
+// The packet stream_udp.py's encode_frame() builds, positions in percent
+static std::vector<uint8_t> encodeFrame(uint32_t sequence, uint16_t firstChannel, std::vector<float> positions) {
+  std::vector<uint8_t> packet = {'N', 'X', UdpFrameReceiver::PROTOCOL_VERSION, 0,
+                                 uint8_t(sequence), uint8_t(sequence >> 8), uint8_t(sequence >> 16), uint8_t(sequence >> 24),
+                                 uint8_t(firstChannel), uint8_t(firstChannel >> 8),
+                                 uint8_t(positions.size()), uint8_t(positions.size() >> 8)};
+  for (float p : positions) {
+    uint16_t value = uint16_t(p * 655.35f + 0.5f);
+    packet.push_back(value & 0xFF);
+    packet.push_back(value >> 8);
+  }
+  return packet;
+}
+
+static void deliver(const std::vector<uint8_t>& packet) {
+  receiver->handlePacket(packet.data(), packet.size());
+}
+
+static float pulse(int channel) {
+  return chip->pulseMicroseconds(channel, PCA9685_OSC_FREQ);
+}
+
+static void assertStatus(const char* expected) {
+  String status = controller->executeCommand("stream status");
+  TEST_ASSERT_TRUE_MESSAGE(status.indexOf(expected) >= 0, status.c_str());
+}
+
+void test_malformed_packets_are_counted() {
+  std::vector<uint8_t> good = encodeFrame(1, 0, {50, 50});
+  UdpFrame frame;
+  TEST_ASSERT_TRUE(UdpFrameReceiver::parseFrame(good.data(), good.size(), frame));
+  TEST_ASSERT_EQUAL_UINT16(2, frame.count);
+  
+  std::vector<uint8_t> badMagic = good;
+  badMagic[1] = 'Y';
+  std::vector<uint8_t> badVersion = good;
+  badVersion[2] = 2;
+  std::vector<uint8_t> shortPacket(good.begin(), good.end() - 1);
+  std::vector<uint8_t> empty = encodeFrame(1, 0, {});
+  for (const auto& packet : {badMagic, badVersion, shortPacket, empty}) {
+    TEST_ASSERT_FALSE(UdpFrameReceiver::parseFrame(packet.data(), packet.size(), frame));
+    deliver(packet);
+  }
+  TEST_ASSERT_EQUAL_UINT32(4, receiver->getMalformedCount());
+  assertStatus("Accepted: 0");
+}
+
+void test_stale_sequences_are_dropped() {
+  deliver(encodeFrame(10, 0, {20}));
+  deliver(encodeFrame(9, 0, {80}));   // Older
+  deliver(encodeFrame(10, 0, {80}));  // Repeated
+  controller->update();
+  TEST_ASSERT_FLOAT_WITHIN(5, 1200, pulse(0));
+  
+  deliver(encodeFrame(11, 0, {30}));
+  controller->update();
+  TEST_ASSERT_FLOAT_WITHIN(5, 1300, pulse(0));
+  assertStatus("Accepted: 2, Dropped: 2");
+}
+
+void test_newest_frame_wins_within_a_tick() {
+  deliver(encodeFrame(1, 0, {10, 10, 10}));
+  deliver(encodeFrame(2, 1, {60, 70}));
+  controller->update();
+  TEST_ASSERT_FLOAT_WITHIN(5, 1100, pulse(0));
+  TEST_ASSERT_FLOAT_WITHIN(5, 1600, pulse(1));
+  TEST_ASSERT_FLOAT_WITHIN(5, 1700, pulse(2));
+}
+
+void test_timeout_returns_to_initial_positions() {
+  controller->updateServoConfig(0, 0, "initPosition", "40");
+  controller->executeCommand("stream timeout 200 init");
+  deliver(encodeFrame(1, 0, {90}));
+  controller->update();
+  TEST_ASSERT_FLOAT_WITHIN(5, 1900, pulse(0));
+  
+  virtualClock->advance(150);
+  controller->update();
+  TEST_ASSERT_FLOAT_WITHIN(5, 1900, pulse(0));
+  
+  virtualClock->advance(100);
+  controller->update();
+  controller->update();
+  TEST_ASSERT_FLOAT_WITHIN(5, 1400, pulse(0));
+  assertStatus("Active: no");
+}
+
+void test_timeout_hold_keeps_positions() {
+  controller->executeCommand("stream timeout 200 hold");
+  deliver(encodeFrame(1, 0, {90}));
+  controller->update();
+  virtualClock->advance(500);
+  controller->update();
+  controller->update();
+  TEST_ASSERT_FLOAT_WITHIN(5, 1900, pulse(0));
+  assertStatus("Active: no");
+}
+
+void test_restarted_sender_is_accepted_after_timeout() {
+  controller->executeCommand("stream timeout 200 hold");
+  deliver(encodeFrame(5000, 0, {90}));
+  controller->update();
+  virtualClock->advance(300);
+  controller->update();
+  
+  // A sender restarted from sequence 0 would be stale within a session
+  deliver(encodeFrame(0, 0, {25}));
+  controller->update();
+  TEST_ASSERT_FLOAT_WITHIN(5, 1250, pulse(0));
+  assertStatus("Dropped: 0");
+}
+
+void test_frames_over_loopback() {
+  TEST_ASSERT_TRUE(receiver->begin(LOOPBACK_PORT));
+  
+  int sock = socket(AF_INET, SOCK_DGRAM, 0);
+  TEST_ASSERT_TRUE(sock >= 0);
+  sockaddr_in target = {};
+  target.sin_family = AF_INET;
+  target.sin_port = htons(LOOPBACK_PORT);
+  target.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  
+  // Sent out of order, as stream_udp.py --reorder does
+  for (uint32_t sequence : {1u, 3u, 2u, 4u}) {
+    std::vector<uint8_t> packet = encodeFrame(sequence, 0, {float(sequence * 10)});
+    sendto(sock, packet.data(), packet.size(), 0, (sockaddr*)&target, sizeof(target));
+    ::delay(5);  // One receive thread; keep the packets in send order
+  }
+  close(sock);
+  
+  for (int wait = 0; wait < 200 && receiver->getPacketCount() < 4; wait++) {
+    ::delay(5);
+  }
+  TEST_ASSERT_EQUAL_UINT32(4, receiver->getPacketCount());
+  controller->update();
+  TEST_ASSERT_FLOAT_WITHIN(5, 1400, pulse(0));
+  assertStatus("Accepted: 3, Dropped: 1");
+}
+
+int main(int argc, char** argv) {
+  LittleFS.begin(true);
+  UNITY_BEGIN();
+  RUN_TEST(test_malformed_packets_are_counted);
+  RUN_TEST(test_stale_sequences_are_dropped);
+  RUN_TEST(test_newest_frame_wins_within_a_tick);
+  RUN_TEST(test_timeout_returns_to_initial_positions);
+  RUN_TEST(test_timeout_hold_keeps_positions);
+  RUN_TEST(test_restarted_sender_is_accepted_after_timeout);
+  RUN_TEST(test_frames_over_loopback);
+  return UNITY_END();
+}